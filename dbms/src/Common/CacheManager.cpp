@@ -0,0 +1,173 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/CacheManager.h>
+#include <Common/Exception.h>
+#include <Common/Logger.h>
+#include <Common/TiFlashMetrics.h>
+#include <common/logger_useful.h>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+extern const int LOGICAL_ERROR;
+} // namespace ErrorCodes
+
+namespace
+{
+/// The counters could be decreased when the cache is reset.
+inline size_t delta(size_t current, size_t last)
+{
+    return current >= last ? current - last : current;
+}
+
+void updateMetrics(CacheManager::CacheType type, const CacheStats & stats, const CacheStats & last_stats)
+{
+#define UPDATE_METRICS(NAME)                                                                                     \
+    do                                                                                                           \
+    {                                                                                                            \
+        GET_METRIC(tiflash_cache_bytes, type_##NAME##_used).Set(stats.bytes);                                    \
+        GET_METRIC(tiflash_cache_bytes, type_##NAME##_limit).Set(stats.max_bytes);                               \
+        GET_METRIC(tiflash_cache_request, type_##NAME##_hit).Increment(delta(stats.hits, last_stats.hits));      \
+        GET_METRIC(tiflash_cache_request, type_##NAME##_miss).Increment(delta(stats.misses, last_stats.misses)); \
+        GET_METRIC(tiflash_cache_evicted_bytes, type_##NAME##_capacity)                                          \
+            .Increment(delta(stats.evicted_bytes_by_capacity, last_stats.evicted_bytes_by_capacity));            \
+        GET_METRIC(tiflash_cache_evicted_bytes, type_##NAME##_resize)                                            \
+            .Increment(delta(stats.evicted_bytes_by_resize, last_stats.evicted_bytes_by_resize));                \
+    } while (false)
+
+    switch (type)
+    {
+    case CacheManager::CacheType::Mark:
+        UPDATE_METRICS(mark);
+        break;
+    case CacheManager::CacheType::MinMaxIndex:
+        UPDATE_METRICS(minmax_index);
+        break;
+    case CacheManager::CacheType::Uncompressed:
+        UPDATE_METRICS(uncompressed);
+        break;
+    case CacheManager::CacheType::DeltaIndex:
+        UPDATE_METRICS(delta_index);
+        break;
+    case CacheManager::CacheType::SegmentResult:
+        UPDATE_METRICS(segment_result);
+        break;
+    }
+
+#undef UPDATE_METRICS
+}
+} // namespace
+
+const char * CacheManager::typeToString(CacheType type)
+{
+    switch (type)
+    {
+    case CacheType::Mark:
+        return "mark";
+    case CacheType::MinMaxIndex:
+        return "minmax_index";
+    case CacheType::Uncompressed:
+        return "uncompressed";
+    case CacheType::DeltaIndex:
+        return "delta_index";
+    case CacheType::SegmentResult:
+        return "segment_result";
+    }
+    return "unknown";
+}
+
+CacheManager::CacheManager(size_t memory_budget_)
+    : memory_budget(memory_budget_)
+    , log(Logger::get("CacheManager"))
+{}
+
+size_t CacheManager::getInitialBytes(double weight) const
+{
+    std::lock_guard lock(mutex);
+    double total_weight = weight;
+    for (const auto & entry : caches)
+        total_weight += entry.weight;
+    return total_weight > 0 ? static_cast<size_t>(memory_budget * weight / total_weight) : 0;
+}
+
+void CacheManager::registerCache(CacheType type, double weight, const ManagedCachePtr & cache)
+{
+    if (unlikely(weight <= 0))
+        throw Exception(fmt::format("The weight of {} cache must be positive, but got {}", typeToString(type), weight), ErrorCodes::LOGICAL_ERROR);
+
+    {
+        std::lock_guard lock(mutex);
+        for (const auto & entry : caches)
+        {
+            if (entry.type == type)
+                throw Exception(fmt::format("The {} cache has been already registered", typeToString(type)), ErrorCodes::LOGICAL_ERROR);
+        }
+        caches.push_back(Entry{type, weight, cache, cache->getCacheStats()});
+        LOG_FMT_INFO(log, "Register {} cache, weight: {}", typeToString(type), weight);
+    }
+    rebalance();
+}
+
+void CacheManager::rebalance()
+{
+    std::lock_guard lock(mutex);
+    if (caches.empty())
+        return;
+
+    double total_weight = 0;
+    double total_demand = 0;
+    std::vector<CacheStats> stats(caches.size());
+    for (size_t i = 0; i < caches.size(); ++i)
+    {
+        auto & entry = caches[i];
+        stats[i] = entry.cache->getCacheStats();
+        // Smooth the demand, so that the sizes of caches don't swing with one burst of loading.
+        auto loaded_bytes = delta(stats[i].inserted_bytes, entry.last_stats.inserted_bytes);
+        entry.demand = entry.demand / 2 + entry.weight * loaded_bytes / 2;
+        total_weight += entry.weight;
+        total_demand += entry.demand;
+    }
+
+    const size_t shared_by_weight = memory_budget / 2;
+    const size_t shared_by_demand = memory_budget - shared_by_weight;
+    for (size_t i = 0; i < caches.size(); ++i)
+    {
+        auto & entry = caches[i];
+        double ratio = total_demand > 0 ? entry.demand / total_demand : entry.weight / total_weight;
+        auto max_bytes = static_cast<size_t>(shared_by_weight * entry.weight / total_weight + shared_by_demand * ratio);
+        if (max_bytes != stats[i].max_bytes)
+        {
+            LOG_FMT_DEBUG(log, "Resize {} cache from {} to {} bytes", typeToString(entry.type), stats[i].max_bytes, max_bytes);
+            entry.cache->setMaxBytes(max_bytes);
+            stats[i] = entry.cache->getCacheStats();
+        }
+
+        updateMetrics(entry.type, stats[i], entry.last_stats);
+        entry.last_stats = stats[i];
+    }
+}
+
+std::vector<CacheManager::CacheInfo> CacheManager::getCacheInfos() const
+{
+    std::lock_guard lock(mutex);
+    std::vector<CacheInfo> infos;
+    infos.reserve(caches.size());
+    for (const auto & entry : caches)
+        infos.push_back(CacheInfo{entry.type, entry.weight, entry.cache->getCacheStats()});
+    return infos;
+}
+
+} // namespace DB
@@ -0,0 +1,118 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <common/types.h>
+
+#include <boost/noncopyable.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DB
+{
+class Logger;
+using LoggerPtr = std::shared_ptr<Logger>;
+
+struct CacheStats
+{
+    size_t bytes = 0;
+    size_t max_bytes = 0;
+    size_t count = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    /// The bytes of the entries inserted into cache, which are loaded because of the misses.
+    size_t inserted_bytes = 0;
+    /// The bytes of the entries evicted because the cache is full.
+    size_t evicted_bytes_by_capacity = 0;
+    /// The bytes of the entries evicted because the cache is shrunk by CacheManager.
+    size_t evicted_bytes_by_resize = 0;
+};
+
+/// The interface of caches whose memory is managed by CacheManager.
+class IManagedCache
+{
+public:
+    virtual ~IManagedCache() = default;
+
+    virtual void setMaxBytes(size_t max_bytes) = 0;
+
+    virtual CacheStats getCacheStats() const = 0;
+};
+using ManagedCachePtr = std::shared_ptr<IManagedCache>;
+
+/// Share one memory budget among the node-level caches, so that the memory is not stranded in one cache while
+/// another one thrashes.
+///
+/// Half of the budget is shared by the weights of caches, so that every cache keeps a reasonable size. The other half
+/// follows the demands: the bytes loaded into every cache recently multiplied by its weight. The weight stands for
+/// the cost to load one byte into the cache, e.g. rebuilding a delta index is more expensive than reading a mark.
+class CacheManager : private boost::noncopyable
+{
+public:
+    enum class CacheType
+    {
+        Mark,
+        MinMaxIndex,
+        Uncompressed,
+        DeltaIndex,
+        SegmentResult,
+    };
+    static const char * typeToString(CacheType type);
+
+    struct CacheInfo
+    {
+        CacheType type;
+        double weight;
+        CacheStats stats;
+    };
+
+    explicit CacheManager(size_t memory_budget_);
+
+    /// The initial size of a cache before it is registered.
+    size_t getInitialBytes(double weight) const;
+
+    void registerCache(CacheType type, double weight, const ManagedCachePtr & cache);
+
+    /// Redistribute the memory budget among caches, and update the metrics of caches.
+    /// It should be called periodically.
+    void rebalance();
+
+    std::vector<CacheInfo> getCacheInfos() const;
+
+    size_t getMemoryBudget() const { return memory_budget; }
+
+private:
+    struct Entry
+    {
+        CacheType type;
+        double weight;
+        ManagedCachePtr cache;
+
+        CacheStats last_stats;
+        /// The moving average of the weighted bytes loaded into cache between two rebalances.
+        double demand = 0;
+    };
+
+    const size_t memory_budget;
+
+    mutable std::mutex mutex;
+    std::vector<Entry> caches;
+
+    LoggerPtr log;
+};
+using CacheManagerPtr = std::shared_ptr<CacheManager>;
+
+} // namespace DB
@@ -347,6 +347,9 @@ struct HashMethodSerialized
     using Self = HashMethodSerialized<Value, Mapped>;
     using Base = columns_hashing_impl::HashMethodBase<Self, Value, Mapped, false>;
 
+    /// Serializing the keys twice is as expensive as the cache misses.
+    static constexpr bool support_two_pass_lookup = false;
+
     ColumnRawPtrs key_columns;
     size_t keys_size;
     TiDB::TiDBCollators collators;
@@ -377,6 +380,9 @@ struct HashMethodHashed
     using Self = HashMethodHashed<Value, Mapped, use_cache>;
     using Base = columns_hashing_impl::HashMethodBase<Self, Value, Mapped, use_cache>;
 
+    /// The key itself is a hash of all the key columns, which is too expensive to compute twice.
+    static constexpr bool support_two_pass_lookup = false;
+
     ColumnRawPtrs key_columns;
     TiDB::TiDBCollators collators;
 
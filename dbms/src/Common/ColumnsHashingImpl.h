@@ -118,6 +118,38 @@ public:
     bool isFound() const { return found; }
 };
 
+/// Whether the hash table `Data` supports `prefetch(hash_value)`.
+template <typename Data, typename = void>
+struct HasPrefetch : std::false_type
+{
+};
+
+template <typename Data>
+struct HasPrefetch<Data, std::void_t<decltype(std::declval<const Data &>().prefetch(size_t{}))>> : std::true_type
+{
+};
+
+/// The hash tables smaller than this mostly stay in the CPU cache, for which the extra pass computing
+/// the hashes costs more than the cache misses hidden by prefetching. It is the default of `min_buffer_bytes`
+/// of `getPrefetchDistance`.
+static constexpr size_t prefetch_min_hash_table_bytes = 2 * 1024 * 1024;
+
+/// Whether to look up the keys of `State` in the hash table `Data` in two passes, see `HashMethodBase::emplaceKey`.
+template <typename State, typename Data>
+constexpr bool canLookupInTwoPasses()
+{
+    return State::support_two_pass_lookup && HasPrefetch<Data>::value;
+}
+
+/// Return how many rows ahead to prefetch the cells when looking up the keys in a hash table of `buffer_bytes`,
+/// 0 means to look up the keys row by row, which is the case for the tables smaller than `min_buffer_bytes`.
+inline size_t getPrefetchDistance(size_t buffer_bytes, size_t rows, size_t prefetch_distance, size_t min_buffer_bytes)
+{
+    if (prefetch_distance == 0 || buffer_bytes < min_buffer_bytes || rows <= prefetch_distance)
+        return 0;
+    return prefetch_distance;
+}
+
 template <typename Derived, typename Value, typename Mapped, bool consecutive_keys_optimization>
 class HashMethodBase
 {
@@ -126,6 +158,8 @@ public:
     using FindResult = FindResultImpl<Mapped>;
     static constexpr bool has_mapped = !std::is_same<Mapped, void>::value;
     using Cache = LastElementCache<Value, consecutive_keys_optimization>;
+    /// Whether getting the key holder is cheap enough to do it twice for the two-pass lookup.
+    static constexpr bool support_two_pass_lookup = true;
 
     template <typename Data>
     ALWAYS_INLINE EmplaceResult emplaceKey(Data & data, size_t row, Arena & pool, std::vector<String> & sort_key_containers)
@@ -141,6 +175,24 @@ public:
         return findKeyImpl(keyHolderGetKey(key_holder), data);
     }
 
+    /// The same as above, but with the `hash_value` of the key got by `getHash` before.
+    /// When the hash table doesn't fit in the CPU cache, the keys of a block are looked up in two passes:
+    /// the hashes of all rows are computed first, then the keys are looked up while prefetching the cells
+    /// of the rows some distance ahead, so that the cache misses of different rows overlap with each other.
+    template <typename Data>
+    ALWAYS_INLINE EmplaceResult emplaceKey(Data & data, size_t row, Arena & pool, std::vector<String> & sort_key_containers, size_t hash_value)
+    {
+        auto key_holder = static_cast<Derived &>(*this).getKeyHolder(row, &pool, sort_key_containers);
+        return emplaceImpl(key_holder, data, hash_value);
+    }
+
+    template <typename Data>
+    ALWAYS_INLINE FindResult findKey(Data & data, size_t row, Arena & pool, std::vector<String> & sort_key_containers, size_t hash_value)
+    {
+        auto key_holder = static_cast<Derived &>(*this).getKeyHolder(row, &pool, sort_key_containers);
+        return findKeyImpl(keyHolderGetKey(key_holder), data, hash_value);
+    }
+
     template <typename Data>
     ALWAYS_INLINE size_t getHash(const Data & data, size_t row, Arena & pool, std::vector<String> & sort_key_containers)
     {
@@ -166,8 +218,9 @@ protected:
         }
     }
 
-    template <typename Data, typename KeyHolder>
-    ALWAYS_INLINE EmplaceResult emplaceImpl(KeyHolder & key_holder, Data & data)
+    /// `hash_value` is either empty or the precomputed hash value of the key.
+    template <typename Data, typename KeyHolder, typename... HashValue>
+    ALWAYS_INLINE EmplaceResult emplaceImpl(KeyHolder & key_holder, Data & data, HashValue... hash_value)
     {
         if constexpr (Cache::consecutive_keys_optimization)
         {
@@ -182,7 +235,7 @@ protected:
 
         typename Data::LookupResult it;
         bool inserted = false;
-        data.emplace(key_holder, it, inserted);
+        data.emplace(key_holder, it, inserted, hash_value...);
 
         [[maybe_unused]] Mapped * cached = nullptr;
         if constexpr (has_mapped)
@@ -219,8 +272,8 @@ protected:
             return EmplaceResult(inserted);
     }
 
-    template <typename Data, typename Key>
-    ALWAYS_INLINE FindResult findKeyImpl(Key key, Data & data)
+    template <typename Data, typename Key, typename... HashValue>
+    ALWAYS_INLINE FindResult findKeyImpl(Key key, Data & data, HashValue... hash_value)
     {
         if constexpr (Cache::consecutive_keys_optimization)
         {
@@ -233,7 +286,7 @@ protected:
             }
         }
 
-        auto it = data.find(key);
+        auto it = data.find(key, hash_value...);
 
         if constexpr (consecutive_keys_optimization)
         {
@@ -1075,6 +1075,13 @@ public:
         return const_cast<std::decay_t<decltype(*this)> *>(this)->find(x, hash_value);
     }
 
+    /// Prefetch the cell where the lookup of a key with `hash_value` starts, so that a later `emplace` or `find`
+    /// with the same hash value doesn't stall on the cache miss. Any resize in between makes it a no-op.
+    void ALWAYS_INLINE prefetch(size_t hash_value) const
+    {
+        __builtin_prefetch(&buf[grower.place(hash_value)]);
+    }
+
     std::enable_if_t<Grower::performs_linear_probing_with_single_step, bool>
         ALWAYS_INLINE erase(const Key & x)
     {
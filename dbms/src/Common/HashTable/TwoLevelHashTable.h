@@ -294,6 +294,12 @@ public:
 
     ConstLookupResult ALWAYS_INLINE find(Key x) const { return find(x, hash(x)); }
 
+    void ALWAYS_INLINE prefetch(size_t hash_value) const
+    {
+        size_t buck = getBucketFromHash(hash_value);
+        impls[buck].prefetch(hash_value);
+    }
+
 
     void write(DB::WriteBuffer & wb) const
     {
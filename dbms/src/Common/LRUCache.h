@@ -39,6 +39,10 @@ struct TrivialWeightFunction
 /// Cache starts to evict entries when their total weight exceeds max_size and when expiration time of these
 /// entries is due.
 /// Value weight should not change after insertion.
+///
+/// If `segmented` is true, the entries are kept in two segments (SLRU) to resist scans: the new entries are put into
+/// the probationary segment, and they are promoted to the protected segment when they are hit. The entries are evicted
+/// from the probationary segment first, so that a large scan reading every entry only once won't flush the hot entries.
 template <typename TKey,
           typename TMapped,
           typename HashFunction = std::hash<TKey>,
@@ -56,9 +60,25 @@ private:
     using Timestamp = Clock::time_point;
 
 public:
-    explicit LRUCache(size_t max_size_, const Delay & expiration_delay_ = Delay::zero())
+    /// The statistics of the weights of entries.
+    struct WeightStats
+    {
+        size_t weight = 0;
+        size_t max_weight = 0;
+        size_t count = 0;
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t inserted_weight = 0;
+        /// The weight of the entries evicted because the cache is full.
+        size_t evicted_weight_by_capacity = 0;
+        /// The weight of the entries evicted by `setMaxSize`.
+        size_t evicted_weight_by_resize = 0;
+    };
+
+    explicit LRUCache(size_t max_size_, const Delay & expiration_delay_ = Delay::zero(), bool segmented_ = false)
         : max_size(std::max(static_cast<size_t>(1), max_size_))
         , expiration_delay(expiration_delay_)
+        , segmented(segmented_)
     {}
 
     MappedPtr get(const Key & key)
@@ -148,7 +168,16 @@ public:
             return;
 
         Cell & cell = it->second;
-        queue.erase(cell.queue_iterator);
+        current_size -= cell.size;
+        if (cell.is_protected)
+        {
+            protected_size -= cell.size;
+            protected_queue.erase(cell.queue_iterator);
+        }
+        else
+        {
+            probation_queue.erase(cell.queue_iterator);
+        }
         cells.erase(it);
     }
 
@@ -171,13 +200,38 @@ public:
         return cells.size();
     }
 
+    void setMaxSize(size_t max_size_)
+    {
+        std::lock_guard cache_lock(mutex);
+        max_size = std::max(static_cast<size_t>(1), max_size_);
+        shrinkProtected();
+        removeOverflow(Clock::now(), /*is_resize*/ true);
+    }
+
+    WeightStats getWeightStats() const
+    {
+        std::lock_guard cache_lock(mutex);
+        WeightStats stats;
+        stats.weight = current_size;
+        stats.max_weight = max_size;
+        stats.count = cells.size();
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.inserted_weight = inserted_size;
+        stats.evicted_weight_by_capacity = evicted_size_by_capacity;
+        stats.evicted_weight_by_resize = evicted_size_by_resize;
+        return stats;
+    }
+
     void reset()
     {
         std::lock_guard cache_lock(mutex);
-        queue.clear();
+        probation_queue.clear();
+        protected_queue.clear();
         cells.clear();
         insert_tokens.clear();
         current_size = 0;
+        protected_size = 0;
         hits = 0;
         misses = 0;
     }
@@ -266,7 +320,10 @@ private:
 
         MappedPtr value;
         size_t size;
+        /// The iterator of `protected_queue` if `is_protected`, or of `probation_queue` otherwise.
+        /// The entries are never protected if the cache is not segmented.
         LRUQueueIterator queue_iterator;
+        bool is_protected = false;
         Timestamp timestamp;
     };
 
@@ -274,18 +331,27 @@ private:
 
     InsertTokenById insert_tokens;
 
-    LRUQueue queue;
+    /// The only queue if the cache is not segmented.
+    LRUQueue probation_queue;
+    LRUQueue protected_queue;
     Cells cells;
 
     /// Total weight of values.
     size_t current_size = 0;
-    const size_t max_size;
+    /// Total weight of values in the protected segment.
+    size_t protected_size = 0;
+    size_t max_size;
     const Delay expiration_delay;
+    const bool segmented;
 
     mutable std::mutex mutex;
     std::atomic<size_t> hits{0};
     std::atomic<size_t> misses{0};
 
+    size_t inserted_size = 0;
+    size_t evicted_size_by_capacity = 0;
+    size_t evicted_size_by_resize = 0;
+
     WeightFunction weight_function;
 
     MappedPtr getImpl(const Key & key, [[maybe_unused]] std::lock_guard<std::mutex> & cache_lock)
@@ -299,8 +365,23 @@ private:
         Cell & cell = it->second;
         updateCellTimestamp(cell);
 
-        /// Move the key to the end of the queue. The iterator remains valid.
-        queue.splice(queue.end(), queue, cell.queue_iterator);
+        /// Move the key to the end of the protected queue, or the end of the only queue if not segmented.
+        /// The iterator remains valid.
+        if (!segmented)
+        {
+            probation_queue.splice(probation_queue.end(), probation_queue, cell.queue_iterator);
+        }
+        else if (cell.is_protected)
+        {
+            protected_queue.splice(protected_queue.end(), protected_queue, cell.queue_iterator);
+        }
+        else
+        {
+            protected_queue.splice(protected_queue.end(), probation_queue, cell.queue_iterator);
+            cell.is_protected = true;
+            protected_size += cell.size;
+            shrinkProtected();
+        }
 
         return cell.value;
     }
@@ -316,7 +397,7 @@ private:
         {
             try
             {
-                cell.queue_iterator = queue.insert(queue.end(), key);
+                cell.queue_iterator = probation_queue.insert(probation_queue.end(), key);
             }
             catch (std::exception & e)
             {
@@ -335,15 +416,51 @@ private:
         else
         {
             current_size -= cell.size;
-            queue.splice(queue.end(), queue, cell.queue_iterator);
+            if (cell.is_protected)
+            {
+                protected_size -= cell.size;
+                protected_queue.splice(protected_queue.end(), protected_queue, cell.queue_iterator);
+            }
+            else
+            {
+                probation_queue.splice(probation_queue.end(), probation_queue, cell.queue_iterator);
+            }
         }
 
         cell.value = mapped;
         cell.size = cell.value ? weight_function(*cell.value) : 0;
         current_size += cell.size;
+        inserted_size += cell.size;
         updateCellTimestamp(cell);
 
-        removeOverflow(cell.timestamp);
+        if (cell.is_protected)
+        {
+            protected_size += cell.size;
+            shrinkProtected();
+        }
+        removeOverflow(cell.timestamp, /*is_resize*/ false);
+    }
+
+    /// The max weight of the protected segment, the rest is left for the new entries.
+    size_t maxProtectedSize() const { return max_size / 5 * 4; }
+
+    /// Demote the least recently used entries of the protected segment to the probationary segment.
+    void shrinkProtected()
+    {
+        while (protected_size > maxProtectedSize() && !protected_queue.empty())
+        {
+            auto it = cells.find(protected_queue.front());
+            if (it == cells.end())
+            {
+                LOG_FMT_ERROR(&Poco::Logger::get("LRUCache"), "LRUCache became inconsistent. There must be a bug in it.");
+                abort();
+            }
+
+            Cell & cell = it->second;
+            probation_queue.splice(probation_queue.end(), protected_queue, cell.queue_iterator);
+            cell.is_protected = false;
+            protected_size -= cell.size;
+        }
     }
 
     void updateCellTimestamp(Cell & cell)
@@ -352,12 +469,14 @@ private:
             cell.timestamp = Clock::now();
     }
 
-    void removeOverflow(const Timestamp & last_timestamp)
+    void removeOverflow(Timestamp last_timestamp, bool is_resize)
     {
         size_t current_weight_lost = 0;
         size_t queue_size = cells.size();
         while ((current_size > max_size) && (queue_size > 1))
         {
+            /// Evict the entries in the probationary segment first, but keep the newest one.
+            auto & queue = (probation_queue.size() > 1 || protected_queue.empty()) ? probation_queue : protected_queue;
             const Key & key = queue.front();
 
             auto it = cells.find(key);
@@ -372,6 +491,8 @@ private:
                 break;
 
             current_size -= cell.size;
+            if (cell.is_protected)
+                protected_size -= cell.size;
             current_weight_lost += cell.size;
 
             cells.erase(it);
@@ -379,6 +500,10 @@ private:
             --queue_size;
         }
 
+        if (is_resize)
+            evicted_size_by_resize += current_weight_lost;
+        else
+            evicted_size_by_capacity += current_weight_lost;
         onRemoveOverflowWeightLoss(current_weight_lost);
 
         if (current_size > (1ull << 63))
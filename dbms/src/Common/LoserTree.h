@@ -0,0 +1,110 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace DB
+{
+/** Tree of losers for k-way merging.
+  * Every internal node keeps the loser of the match between the winners of its two subtrees, and the overall winner
+  * is kept separately. After the winner source advances, only the matches on the path from its leaf to the root
+  * are replayed, that is log2(k) comparisons, while a binary heap needs up to 2 * log2(k) comparisons for the same.
+  *
+  * `Less(a, b)` returns whether the current row of source `a` should be output before the current row of source `b`,
+  * it is only called for the sources not exhausted, and must never treat two different sources as equal.
+  */
+template <typename Less>
+class LoserTree
+{
+public:
+    LoserTree(size_t num_sources_, Less less_)
+        : num_sources(num_sources_)
+        , less(std::move(less_))
+        , tree(num_sources)
+        , exhausted(num_sources, false)
+    {}
+
+    /// Build the tree, the sources that have no rows must be marked by `setExhausted` before.
+    void init()
+    {
+        if (num_sources == 0)
+            return;
+        std::vector<size_t> winners(2 * num_sources);
+        for (size_t i = 0; i < num_sources; ++i)
+            winners[num_sources + i] = i;
+        for (size_t node = num_sources - 1; node >= 1; --node)
+        {
+            size_t lhs = winners[2 * node];
+            size_t rhs = winners[2 * node + 1];
+            if (beats(lhs, rhs))
+            {
+                winners[node] = lhs;
+                tree[node] = rhs;
+            }
+            else
+            {
+                winners[node] = rhs;
+                tree[node] = lhs;
+            }
+        }
+        tree[0] = num_sources == 1 ? 0 : winners[1];
+    }
+
+    void setExhausted(size_t source) { exhausted[source] = true; }
+
+    bool empty() const { return num_sources == 0 || exhausted[tree[0]]; }
+    size_t top() const { return tree[0]; }
+
+    /// Called after the current row of the winner source changed.
+    void replayTop()
+    {
+        size_t winner = tree[0];
+        for (size_t node = (winner + num_sources) / 2; node >= 1; node /= 2)
+        {
+            if (beats(tree[node], winner))
+                std::swap(tree[node], winner);
+        }
+        tree[0] = winner;
+    }
+
+    /// Called after the winner source has no more rows.
+    void popTop()
+    {
+        exhausted[tree[0]] = true;
+        replayTop();
+    }
+
+private:
+    bool beats(size_t lhs, size_t rhs)
+    {
+        if (exhausted[lhs])
+            return false;
+        if (exhausted[rhs])
+            return true;
+        return less(lhs, rhs);
+    }
+
+    const size_t num_sources;
+    Less less;
+    /// tree[0] is the winner, tree[1, num_sources) are the losers of internal nodes,
+    /// the leaf of source i is the node `num_sources + i`.
+    std::vector<size_t> tree;
+    std::vector<bool> exhausted;
+};
+
+} // namespace DB
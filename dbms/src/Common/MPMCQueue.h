@@ -21,9 +21,11 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <type_traits>
+#include <vector>
 
 namespace DB
 {
@@ -55,14 +57,31 @@ enum class MPMCQueueStatus
 /// waiting list and everyone only wait on its own condition_variable.
 ///
 /// This can significantly reduce contentions and avoid "thundering herd" problem.
+///
+/// Besides the count of objects, MPMCQueue can also be bounded by the total bytes of
+/// objects in it, see the constructor with `max_bytes_`.
 template <typename T>
 class MPMCQueue
 {
 public:
     using Status = MPMCQueueStatus;
+    using ElementBytesGetter = std::function<Int64(const T &)>;
 
     explicit MPMCQueue(Int64 capacity_)
+        : MPMCQueue(capacity_, 0, nullptr)
+    {
+    }
+
+    /// If `max_bytes_` > 0, a push will block while the total bytes of objects in the queue,
+    /// which is calculated by `get_bytes_`, reaches `max_bytes_`.
+    /// A push is allowed as long as the total bytes is below the limit, so that an object
+    /// larger than `max_bytes_` won't block forever.
+    /// `get_bytes_` should not throw.
+    MPMCQueue(Int64 capacity_, Int64 max_bytes_, ElementBytesGetter get_bytes_)
         : capacity(capacity_)
+        , max_bytes(max_bytes_)
+        , get_bytes(std::move(get_bytes_))
+        , element_bytes(get_bytes ? capacity : 0)
         , data(capacity * sizeof(T))
     {
     }
@@ -165,7 +184,7 @@ public:
     bool isNextPushNonBlocking() const
     {
         std::unique_lock lock(mu);
-        return write_pos - read_pos < capacity || !isNormal();
+        return hasSpace() || !isNormal();
     }
 
     MPMCQueueStatus getStatus() const
@@ -181,6 +200,13 @@ public:
         return static_cast<size_t>(write_pos - read_pos);
     }
 
+    /// Total bytes of objects in the queue, always 0 if the queue is not constructed with `get_bytes_`.
+    Int64 bytes() const
+    {
+        std::unique_lock lock(mu);
+        return current_bytes;
+    }
+
 private:
     using TimePoint = std::chrono::time_point<std::chrono::system_clock>;
     using WaitingNode = MPMCQueueDetail::WaitingNode;
@@ -257,6 +283,8 @@ private:
                 destruct(obj);
 
                 /// update pos only after all operations that may throw an exception.
+                if (get_bytes)
+                    current_bytes -= element_bytes[read_pos % capacity];
                 ++read_pos;
 
                 /// Notify next writer within the critical area because:
@@ -281,7 +309,7 @@ private:
         thread_local WaitingNode node;
 #endif
         auto pred = [&] {
-            return write_pos - read_pos < capacity || !isNormal();
+            return hasSpace() || !isNormal();
         };
 
         std::unique_lock lock(mu);
@@ -290,12 +318,18 @@ private:
 
         /// double check status after potential wait
         /// check write_pos because timeouted will also reach here.
-        if (isNormal() && write_pos - read_pos < capacity)
+        if (isNormal() && hasSpace())
         {
             void * addr = getObjAddr(write_pos);
             assigner(addr);
 
             /// update pos only after all operations that may throw an exception.
+            if (get_bytes)
+            {
+                Int64 bytes = get_bytes(getObj(write_pos));
+                element_bytes[write_pos % capacity] = bytes;
+                current_bytes += bytes;
+            }
             ++write_pos;
 
             /// See comments in `popObj`.
@@ -317,6 +351,11 @@ private:
         return assignObj(deadline, [&](void * addr) { new (addr) T(std::forward<Args>(args)...); });
     }
 
+    ALWAYS_INLINE bool hasSpace() const
+    {
+        return write_pos - read_pos < capacity && (max_bytes <= 0 || current_bytes < max_bytes);
+    }
+
     ALWAYS_INLINE bool isNormal() const
     {
         return likely(status == Status::NORMAL);
@@ -346,12 +385,17 @@ private:
 
 private:
     const Int64 capacity;
+    const Int64 max_bytes;
+    const ElementBytesGetter get_bytes;
+    /// bytes of each object in the queue, indexed the same as `data`.
+    std::vector<Int64> element_bytes;
 
     mutable std::mutex mu;
     WaitingNode reader_head;
     WaitingNode writer_head;
     Int64 read_pos = 0;
     Int64 write_pos = 0;
+    Int64 current_bytes = 0;
     Status status = Status::NORMAL;
 
     std::vector<UInt8> data;
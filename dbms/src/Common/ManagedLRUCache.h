@@ -0,0 +1,59 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Common/CacheManager.h>
+#include <Common/LRUCache.h>
+
+namespace DB
+{
+/// A LRUCache whose size could be managed by CacheManager, the weight of entries should be their bytes.
+template <typename TKey,
+          typename TMapped,
+          typename HashFunction = std::hash<TKey>,
+          typename WeightFunction = TrivialWeightFunction<TMapped>>
+class ManagedLRUCache
+    : public LRUCache<TKey, TMapped, HashFunction, WeightFunction>
+    , public IManagedCache
+{
+private:
+    using Base = LRUCache<TKey, TMapped, HashFunction, WeightFunction>;
+
+public:
+    using typename Base::Delay;
+
+    explicit ManagedLRUCache(size_t max_size_in_bytes, const Delay & expiration_delay_ = Delay::zero(), bool segmented_ = false)
+        : Base(max_size_in_bytes, expiration_delay_, segmented_)
+    {}
+
+    void setMaxBytes(size_t max_bytes) override { Base::setMaxSize(max_bytes); }
+
+    CacheStats getCacheStats() const override
+    {
+        auto weight_stats = Base::getWeightStats();
+        CacheStats stats;
+        stats.bytes = weight_stats.weight;
+        stats.max_bytes = weight_stats.max_weight;
+        stats.count = weight_stats.count;
+        stats.hits = weight_stats.hits;
+        stats.misses = weight_stats.misses;
+        stats.inserted_bytes = weight_stats.inserted_weight;
+        stats.evicted_bytes_by_capacity = weight_stats.evicted_weight_by_capacity;
+        stats.evicted_bytes_by_resize = weight_stats.evicted_weight_by_resize;
+        return stats;
+    }
+};
+
+} // namespace DB
@@ -67,6 +67,8 @@
                                                 \
     M(CompileAttempt)                           \
     M(CompileSuccess)                           \
+    M(CompiledExpressionCacheHits)              \
+    M(CompiledExpressionCacheMisses)            \
                                                 \
     M(ExternalSortWritePart)                    \
     M(ExternalSortMerge)                        \
@@ -167,6 +169,7 @@
     M(DMFileFilterNoFilter)                     \
     M(DMFileFilterAftPKAndPackSet)              \
     M(DMFileFilterAftRoughSet)                  \
+    M(DMFileFilterSkippedByTopN)                \
                                                 \
     M(ChecksumDigestBytes)                      \
                                                 \
@@ -185,6 +185,9 @@ namespace DB
     M(tiflash_object_count, "Number of objects", Gauge,                                                                                   \
         F(type_count_of_establish_calldata, {"type", "count_of_establish_calldata"}),                                                     \
         F(type_count_of_mpptunnel, {"type", "count_of_mpptunnel"}))                                                                       \
+    M(tiflash_exchange_queueing_data_bytes, "Bytes of data queueing in the exchange senders and receivers", Gauge,                        \
+        F(type_send, {"type", "send_queue"}),                                                                                             \
+        F(type_receive, {"type", "receive_queue"}))                                                                                       \
     M(tiflash_thread_count, "Number of threads", Gauge,                                                                                   \
         F(type_max_threads_of_thdpool, {"type", "thread_pool_total_max"}),                                                                \
         F(type_active_threads_of_thdpool, {"type", "thread_pool_active"}),                                                                \
@@ -210,9 +213,44 @@ namespace DB
         F(type_estimated_thread_usage, {"type", "estimated_thread_usage"}),                                                               \
         F(type_thread_soft_limit, {"type", "thread_soft_limit"}),                                                                         \
         F(type_thread_hard_limit, {"type", "thread_hard_limit"}),                                                                         \
-        F(type_hard_limit_exceeded_count, {"type", "hard_limit_exceeded_count"}))                                                         \
+        F(type_hard_limit_exceeded_count, {"type", "hard_limit_exceeded_count"}),                                                         \
+        F(type_memory_limit, {"type", "memory_limit"}),                                                                                   \
+        F(type_reserved_memory, {"type", "reserved_memory"}))                                                                             \
     M(tiflash_task_scheduler_waiting_duration_seconds, "Bucketed histogram of task waiting for scheduling duration", Histogram,           \
-        F(type_task_scheduler_waiting_duration, {{"type", "task_waiting_duration"}}, ExpBuckets{0.0005, 2, 20}))
+        F(type_task_scheduler_waiting_duration, {{"type", "task_waiting_duration"}}, ExpBuckets{0.0005, 2, 20}))                          \
+    M(tiflash_cache_bytes, "Bytes of the caches managed by CacheManager", Gauge,                                                          \
+        F(type_mark_used, {"cache", "mark"}, {"type", "used"}),                                                                           \
+        F(type_mark_limit, {"cache", "mark"}, {"type", "limit"}),                                                                         \
+        F(type_minmax_index_used, {"cache", "minmax_index"}, {"type", "used"}),                                                           \
+        F(type_minmax_index_limit, {"cache", "minmax_index"}, {"type", "limit"}),                                                         \
+        F(type_uncompressed_used, {"cache", "uncompressed"}, {"type", "used"}),                                                           \
+        F(type_uncompressed_limit, {"cache", "uncompressed"}, {"type", "limit"}),                                                         \
+        F(type_delta_index_used, {"cache", "delta_index"}, {"type", "used"}),                                                             \
+        F(type_delta_index_limit, {"cache", "delta_index"}, {"type", "limit"}),                                                           \
+        F(type_segment_result_used, {"cache", "segment_result"}, {"type", "used"}),                                                       \
+        F(type_segment_result_limit, {"cache", "segment_result"}, {"type", "limit"}))                                                     \
+    M(tiflash_cache_request, "Total number of requests of the caches managed by CacheManager", Counter,                                   \
+        F(type_mark_hit, {"cache", "mark"}, {"type", "hit"}),                                                                             \
+        F(type_mark_miss, {"cache", "mark"}, {"type", "miss"}),                                                                           \
+        F(type_minmax_index_hit, {"cache", "minmax_index"}, {"type", "hit"}),                                                             \
+        F(type_minmax_index_miss, {"cache", "minmax_index"}, {"type", "miss"}),                                                           \
+        F(type_uncompressed_hit, {"cache", "uncompressed"}, {"type", "hit"}),                                                             \
+        F(type_uncompressed_miss, {"cache", "uncompressed"}, {"type", "miss"}),                                                           \
+        F(type_delta_index_hit, {"cache", "delta_index"}, {"type", "hit"}),                                                               \
+        F(type_delta_index_miss, {"cache", "delta_index"}, {"type", "miss"}),                                                             \
+        F(type_segment_result_hit, {"cache", "segment_result"}, {"type", "hit"}),                                                         \
+        F(type_segment_result_miss, {"cache", "segment_result"}, {"type", "miss"}))                                                       \
+    M(tiflash_cache_evicted_bytes, "Bytes evicted from the caches managed by CacheManager", Counter,                                      \
+        F(type_mark_capacity, {"cache", "mark"}, {"reason", "capacity"}),                                                                 \
+        F(type_mark_resize, {"cache", "mark"}, {"reason", "resize"}),                                                                     \
+        F(type_minmax_index_capacity, {"cache", "minmax_index"}, {"reason", "capacity"}),                                                 \
+        F(type_minmax_index_resize, {"cache", "minmax_index"}, {"reason", "resize"}),                                                     \
+        F(type_uncompressed_capacity, {"cache", "uncompressed"}, {"reason", "capacity"}),                                                 \
+        F(type_uncompressed_resize, {"cache", "uncompressed"}, {"reason", "resize"}),                                                     \
+        F(type_delta_index_capacity, {"cache", "delta_index"}, {"reason", "capacity"}),                                                   \
+        F(type_delta_index_resize, {"cache", "delta_index"}, {"reason", "resize"}),                                                       \
+        F(type_segment_result_capacity, {"cache", "segment_result"}, {"reason", "capacity"}),                                             \
+        F(type_segment_result_resize, {"cache", "segment_result"}, {"reason", "resize"}))
 
 // clang-format on
 
@@ -0,0 +1,60 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/BlockedBloomFilter.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <random>
+
+namespace DB::tests
+{
+TEST(BlockedBloomFilterTest, NoFalseNegative)
+{
+    std::mt19937_64 rng(42);
+    for (size_t num_keys : {1, 100, 10000, 200000})
+    {
+        BlockedBloomFilter filter(num_keys);
+        std::vector<size_t> hashes(num_keys);
+        for (auto & hash : hashes)
+        {
+            // Some hash functions, like CRC32, only have 32 bits.
+            hash = rng() & 0xFFFFFFFF;
+            filter.add(hash);
+        }
+        for (auto hash : hashes)
+            ASSERT_TRUE(filter.mayContain(hash));
+
+        std::vector<UInt8> res(num_keys);
+        filter.mayContain(hashes.data(), hashes.size(), res.data());
+        for (auto may_contain : res)
+            ASSERT_EQ(may_contain, 1);
+    }
+}
+
+TEST(BlockedBloomFilterTest, FalsePositiveRate)
+{
+    std::mt19937_64 rng(42);
+    const size_t num_keys = 100000;
+    BlockedBloomFilter filter(num_keys);
+    for (size_t i = 0; i < num_keys; ++i)
+        filter.add(rng() & 0xFFFFFFFF);
+
+    const size_t num_probes = 100000;
+    size_t false_positives = 0;
+    for (size_t i = 0; i < num_probes; ++i)
+        false_positives += filter.mayContain((rng() & 0xFFFFFFFF) | (1ULL << 32));
+    ASSERT_LT(false_positives, num_probes * 5 / 100);
+}
+
+} // namespace DB::tests
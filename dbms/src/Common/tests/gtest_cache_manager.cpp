@@ -0,0 +1,99 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/CacheManager.h>
+#include <Common/ManagedLRUCache.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+namespace DB::tests
+{
+namespace
+{
+struct StringWeight
+{
+    size_t operator()(const String & s) const { return s.size(); }
+};
+using StringCache = ManagedLRUCache<String, String, std::hash<String>, StringWeight>;
+
+StringCache::MappedPtr value(size_t size)
+{
+    return std::make_shared<String>(size, 'x');
+}
+} // namespace
+
+TEST(CacheManagerTest, ScanResistance)
+{
+    StringCache cache(100, StringCache::Delay::zero(), /*segmented*/ true);
+    // The hot entries are hit after inserted, so they are protected.
+    for (size_t i = 0; i < 4; ++i)
+    {
+        cache.set(fmt::format("hot{}", i), value(10));
+        ASSERT_TRUE(cache.get(fmt::format("hot{}", i)));
+    }
+    // A scan reading every entry only once.
+    for (size_t i = 0; i < 100; ++i)
+        cache.set(fmt::format("scan{}", i), value(10));
+
+    for (size_t i = 0; i < 4; ++i)
+        ASSERT_TRUE(cache.get(fmt::format("hot{}", i))) << i;
+    ASSERT_FALSE(cache.get("scan0"));
+    ASSERT_TRUE(cache.get("scan99"));
+    ASSERT_LE(cache.weight(), 100UL);
+
+    auto stats = cache.getCacheStats();
+    ASSERT_EQ(stats.inserted_bytes, 1040UL);
+    ASSERT_EQ(stats.evicted_bytes_by_capacity, 1040UL - stats.bytes);
+    ASSERT_EQ(stats.evicted_bytes_by_resize, 0UL);
+
+    // Shrink the cache, the protected entries are evicted at last.
+    cache.setMaxBytes(40);
+    stats = cache.getCacheStats();
+    ASSERT_EQ(stats.max_bytes, 40UL);
+    ASSERT_LE(stats.bytes, 40UL);
+    ASSERT_GT(stats.evicted_bytes_by_resize, 0UL);
+    ASSERT_TRUE(cache.get("hot3"));
+}
+
+TEST(CacheManagerTest, Rebalance)
+{
+    auto cold = std::make_shared<StringCache>(1);
+    auto hot = std::make_shared<StringCache>(1);
+
+    CacheManager manager(1000);
+    manager.registerCache(CacheManager::CacheType::Mark, 1, cold);
+    manager.registerCache(CacheManager::CacheType::MinMaxIndex, 1, hot);
+    // Shared by weights when there is no load.
+    ASSERT_EQ(cold->getCacheStats().max_bytes, 500UL);
+    ASSERT_EQ(hot->getCacheStats().max_bytes, 500UL);
+
+    // Only `hot` is loading data, so it gets more memory.
+    for (size_t round = 0; round < 5; ++round)
+    {
+        for (size_t i = 0; i < 100; ++i)
+            hot->set(fmt::format("{}-{}", round, i), value(10));
+        manager.rebalance();
+    }
+    auto cold_stats = cold->getCacheStats();
+    auto hot_stats = hot->getCacheStats();
+    ASSERT_EQ(cold_stats.max_bytes, 250UL);
+    ASSERT_EQ(hot_stats.max_bytes, 750UL);
+    ASSERT_LE(cold_stats.max_bytes + hot_stats.max_bytes, manager.getMemoryBudget());
+
+    auto infos = manager.getCacheInfos();
+    ASSERT_EQ(infos.size(), 2UL);
+    ASSERT_EQ(infos[1].type, CacheManager::CacheType::MinMaxIndex);
+    ASSERT_EQ(infos[1].stats.bytes, hot_stats.bytes);
+}
+
+} // namespace DB::tests
@@ -15,6 +15,7 @@
 #include <Common/HashTable/Hash.h>
 #include <Common/HashTable/HashMap.h>
 #include <Common/HashTable/HashSet.h>
+#include <Common/HashTable/TwoLevelHashMap.h>
 #include <IO/ReadBufferFromString.h>
 #include <IO/WriteHelpers.h>
 #include <Interpreters/AggregationCommon.h>
@@ -382,3 +383,46 @@ TEST(HashTable, Resize)
         ASSERT_EQ(actual, expected);
     }
 }
+
+template <typename Map>
+void testLookupWithPrefetch()
+{
+    /// Contains the zero key, which is stored out of the buffer.
+    std::vector<UInt64> keys;
+    for (UInt64 i = 0; i < 10000; ++i)
+        keys.push_back(i % 3000 * 7);
+
+    std::vector<size_t> hashes;
+    Map map;
+    for (auto key : keys)
+        hashes.push_back(map.hash(key));
+
+    const size_t prefetch_distance = 16;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        if (i + prefetch_distance < keys.size())
+            map.prefetch(hashes[i + prefetch_distance]);
+        typename Map::LookupResult it;
+        bool inserted = false;
+        map.emplace(keys[i], it, inserted, hashes[i]);
+        ASSERT_EQ(inserted, i < 3000);
+        ++it->getMapped();
+    }
+    ASSERT_EQ(map.size(), 3000u);
+
+    for (UInt64 i = 0; i < 3000; ++i)
+    {
+        UInt64 key = i * 7;
+        map.prefetch(map.hash(key + 1));
+        auto it = map.find(key, map.hash(key));
+        ASSERT_TRUE(it != nullptr);
+        ASSERT_EQ(it->getMapped(), i < 10000 % 3000 ? 4u : 3u);
+        ASSERT_TRUE(map.find(key + 1, map.hash(key + 1)) == nullptr);
+    }
+}
+
+TEST(HashTable, LookupWithPrefetch)
+{
+    testLookupWithPrefetch<HashMap<UInt64, UInt64, HashCRC32<UInt64>>>();
+    testLookupWithPrefetch<TwoLevelHashMap<UInt64, UInt64, HashCRC32<UInt64>>>();
+}
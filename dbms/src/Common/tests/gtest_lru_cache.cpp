@@ -0,0 +1,92 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/LRUCache.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+namespace DB::tests
+{
+namespace
+{
+struct StringWeight
+{
+    size_t operator()(const String & s) const { return s.size(); }
+};
+using StringCache = LRUCache<String, String, std::hash<String>, StringWeight>;
+
+StringCache::MappedPtr value(size_t size)
+{
+    return std::make_shared<String>(size, 'x');
+}
+} // namespace
+
+TEST(LRUCacheTest, EvictLeastRecentlyUsed)
+{
+    StringCache cache(100);
+    for (size_t i = 0; i < 10; ++i)
+        cache.set(fmt::format("k{}", i), value(10));
+    ASSERT_TRUE(cache.get("k0"));
+
+    // k0 is moved to the end of queue, so k1 is evicted.
+    cache.set("k10", value(10));
+    ASSERT_FALSE(cache.get("k1"));
+    ASSERT_TRUE(cache.get("k0"));
+    ASSERT_EQ(cache.weight(), 100UL);
+
+    // A scan reading every entry only once flushes all the entries read before.
+    for (size_t i = 0; i < 10; ++i)
+        cache.set(fmt::format("scan{}", i), value(10));
+    ASSERT_FALSE(cache.get("k0"));
+    ASSERT_EQ(cache.count(), 10UL);
+
+    auto stats = cache.getWeightStats();
+    ASSERT_EQ(stats.inserted_weight, 210UL);
+    ASSERT_EQ(stats.evicted_weight_by_capacity, 110UL);
+    ASSERT_EQ(stats.evicted_weight_by_resize, 0UL);
+}
+
+TEST(LRUCacheTest, SegmentedProbationAndProtected)
+{
+    StringCache cache(100, StringCache::Delay::zero(), /*segmented*/ true);
+    for (size_t i = 0; i < 10; ++i)
+        cache.set(fmt::format("k{}", i), value(10));
+
+    // The hit entry is promoted to the protected segment, and the new entries are evicted from
+    // the probationary segment first.
+    ASSERT_TRUE(cache.get("k0"));
+    cache.set("k10", value(10));
+    ASSERT_FALSE(cache.get("k1"));
+    ASSERT_TRUE(cache.get("k0"));
+
+    // The protected segment takes at most 4/5 of the cache, so promoting k2 ~ k9 demotes k0, the least
+    // recently used one in the protected segment, to the end of the probationary segment.
+    for (size_t i = 2; i < 10; ++i)
+        ASSERT_TRUE(cache.get(fmt::format("k{}", i)));
+    cache.set("k11", value(10));
+    ASSERT_FALSE(cache.get("k10"));
+    cache.set("k12", value(10));
+    ASSERT_FALSE(cache.get("k0"));
+    for (size_t i = 2; i < 10; ++i)
+        ASSERT_TRUE(cache.get(fmt::format("k{}", i))) << i;
+    ASSERT_EQ(cache.weight(), 100UL);
+
+    // Shrinking the cache demotes the protected entries too.
+    cache.setMaxSize(30);
+    ASSERT_EQ(cache.weight(), 30UL);
+    ASSERT_TRUE(cache.get("k9"));
+    ASSERT_FALSE(cache.get("k2"));
+    ASSERT_GT(cache.getWeightStats().evicted_weight_by_resize, 0UL);
+}
+
+} // namespace DB::tests
@@ -640,6 +640,43 @@ try
 }
 CATCH
 
+TEST_F(MPMCQueueTest, boundedByBytes)
+try
+{
+    MPMCQueue<String> q(10, 10, [](const String & s) { return static_cast<Int64>(s.size()); });
+    ASSERT_TRUE(q.push(String(6, 'a')));
+    ASSERT_EQ(q.bytes(), 6);
+    /// push is allowed as long as the total bytes is below the limit.
+    ASSERT_TRUE(q.push(String(6, 'b')));
+    ASSERT_EQ(q.bytes(), 12);
+    ASSERT_FALSE(q.isNextPushNonBlocking());
+    ASSERT_FALSE(q.tryPush(String(1, 'c'), std::chrono::microseconds(1)));
+    ASSERT_EQ(q.size(), 2);
+
+    String val;
+    ASSERT_TRUE(q.pop(val));
+    ASSERT_EQ(val, String(6, 'a'));
+    ASSERT_EQ(q.bytes(), 6);
+    ASSERT_TRUE(q.isNextPushNonBlocking());
+
+    /// an object larger than the limit won't block forever.
+    ASSERT_TRUE(q.pop(val));
+    ASSERT_EQ(q.bytes(), 0);
+    ASSERT_TRUE(q.push(String(100, 'd')));
+    ASSERT_EQ(q.bytes(), 100);
+
+    /// a blocked writer is woken up once the bytes are below the limit.
+    auto th = std::thread([&] {
+        String tmp;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        q.pop(tmp);
+    });
+    ASSERT_TRUE(q.push(String(1, 'e')));
+    th.join();
+    ASSERT_EQ(q.bytes(), 1);
+}
+CATCH
+
 struct Counter
 {
     static int count;
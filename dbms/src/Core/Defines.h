@@ -102,6 +102,8 @@
 
 #define DEFAULT_MARK_CACHE_SIZE (5ULL * 1024 * 1024 * 1024)
 
+#define DEFAULT_SEGMENT_RESULT_CACHE_SIZE (256ULL * 1024 * 1024)
+
 #define DEFAULT_METRICS_PORT 8234
 
 #define DEFAULT_HTTP_PORT 8123
@@ -0,0 +1,342 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnDecimal.h>
+#include <Columns/ColumnFixedString.h>
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnString.h>
+#include <Columns/ColumnsNumber.h>
+#include <Common/typeid_cast.h>
+#include <Core/NormalizedSortKeys.h>
+#include <Storages/Transaction/Collator.h>
+#include <ext/bit_cast.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+extern const int LOGICAL_ERROR;
+} // namespace ErrorCodes
+
+namespace
+{
+/// The unsigned integer of the same size as T, which holds the encoded bytes of T.
+template <typename T>
+struct KeyBits
+{
+    using Type = std::make_unsigned_t<T>;
+};
+template <>
+struct KeyBits<Int128>
+{
+    using Type = unsigned __int128;
+};
+template <>
+struct KeyBits<Float32>
+{
+    using Type = UInt32;
+};
+template <>
+struct KeyBits<Float64>
+{
+    using Type = UInt64;
+};
+
+template <typename U>
+inline UInt8 * writeBigEndian(U value, UInt8 * pos)
+{
+    for (size_t i = 0; i < sizeof(U); ++i)
+        pos[i] = static_cast<UInt8>(value >> ((sizeof(U) - 1 - i) * 8));
+    return pos + sizeof(U);
+}
+
+template <typename T>
+inline UInt8 * encodeNumber(T value, int nulls_direction, UInt8 * pos)
+{
+    using Bits = typename KeyBits<T>::Type;
+    constexpr Bits sign_bit = Bits(1) << (sizeof(T) * 8 - 1);
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        /// Same as `compareAt`, NaNs are equal to each other and are placed by `nulls_direction`.
+        if (std::isnan(value))
+        {
+            memset(pos, nulls_direction > 0 ? 0xFF : 0x00, sizeof(T));
+            return pos + sizeof(T);
+        }
+        /// -0.0 equals 0.0
+        Bits bits = value == 0 ? 0 : ext::bit_cast<Bits>(value);
+        return writeBigEndian<Bits>((bits & sign_bit) ? ~bits : (bits | sign_bit), pos);
+    }
+    else if constexpr (std::is_same_v<T, Int128> || std::is_signed_v<T>)
+        return writeBigEndian<Bits>(static_cast<Bits>(value) ^ sign_bit, pos);
+    else
+        return writeBigEndian<Bits>(static_cast<Bits>(value), pos);
+}
+
+template <typename T>
+inline UInt8 * encodeNumber(const Decimal<T> & value, int nulls_direction, UInt8 * pos)
+{
+    return encodeNumber(value.value, nulls_direction, pos);
+}
+
+inline size_t escapedSize(const StringRef & s)
+{
+    return s.size + std::count(s.data, s.data + s.size, '\0') + 2;
+}
+
+inline UInt8 * encodeString(const StringRef & s, UInt8 * pos)
+{
+    const char * begin = s.data;
+    const char * end = s.data + s.size;
+    while (begin < end)
+    {
+        const auto * zero = static_cast<const char *>(memchr(begin, 0, end - begin));
+        if (!zero)
+        {
+            memcpy(pos, begin, end - begin);
+            pos += end - begin;
+            break;
+        }
+        memcpy(pos, begin, zero - begin + 1);
+        pos += zero - begin + 1;
+        *pos++ = 0xFF;
+        begin = zero + 1;
+    }
+    *pos++ = 0x00;
+    *pos++ = 0x00;
+    return pos;
+}
+
+inline StringRef stringAt(const ColumnString::Chars_t & chars, const IColumn::Offsets & offsets, size_t row, size_t terminator_size)
+{
+    size_t begin = row == 0 ? 0 : offsets[row - 1];
+    return StringRef(reinterpret_cast<const char *>(&chars[begin]), offsets[row] - begin - terminator_size);
+}
+
+template <typename... ColumnTypes, typename F>
+bool castColumn(const IColumn & column, F && f)
+{
+    return ((typeid_cast<const ColumnTypes *>(&column) ? (f(static_cast<const ColumnTypes &>(column)), true) : false) || ...);
+}
+
+/// Call `f` with the column casted to its real type, return false if the type is not supported.
+template <typename F>
+bool dispatchColumn(const IColumn & column, F && f)
+{
+    return castColumn<
+        ColumnUInt8,
+        ColumnUInt16,
+        ColumnUInt32,
+        ColumnUInt64,
+        ColumnInt8,
+        ColumnInt16,
+        ColumnInt32,
+        ColumnInt64,
+        ColumnFloat32,
+        ColumnFloat64,
+        ColumnDecimal<Decimal32>,
+        ColumnDecimal<Decimal64>,
+        ColumnDecimal<Decimal128>,
+        ColumnString,
+        ColumnFixedString>(column, std::forward<F>(f));
+}
+
+struct SortColumn
+{
+    /// The nested column if it is nullable, nullptr for a const column, which doesn't affect the order.
+    const IColumn * column = nullptr;
+    const UInt8 * null_map = nullptr;
+    const TiDB::ITiDBCollator * collator = nullptr;
+    int direction = 1;
+    int nulls_direction = 1;
+
+    /// The collation sort keys of the strings.
+    ColumnString::Chars_t collated_chars;
+    IColumn::Offsets collated_offsets;
+};
+
+bool resolveSortColumn(const Block & block, const SortColumnDescription & desc, SortColumn & res)
+{
+    const IColumn * column = !desc.column_name.empty()
+        ? block.getByName(desc.column_name).column.get()
+        : block.safeGetByPosition(desc.column_number).column.get();
+    res.direction = desc.direction;
+    res.nulls_direction = desc.nulls_direction;
+    if (column->isColumnConst())
+        return true;
+
+    if (const auto * nullable = typeid_cast<const ColumnNullable *>(column))
+    {
+        column = &nullable->getNestedColumn();
+        res.null_map = nullable->getNullMapData().data();
+    }
+    if (desc.collator)
+    {
+        res.collator = dynamic_cast<const TiDB::ITiDBCollator *>(desc.collator);
+        if (!res.collator || !typeid_cast<const ColumnString *>(column))
+            return false;
+    }
+    res.column = column;
+    return dispatchColumn(*column, [](const auto &) {});
+}
+
+void collateColumn(SortColumn & sort_column, size_t rows)
+{
+    const auto & column = static_cast<const ColumnString &>(*sort_column.column);
+    std::string container;
+    sort_column.collated_offsets.resize(rows);
+    for (size_t row = 0; row < rows; ++row)
+    {
+        auto s = stringAt(column.getChars(), column.getOffsets(), row, 1);
+        auto key = sort_column.collator->sortKey(s.data, s.size, container);
+        sort_column.collated_chars.insert(key.data, key.data + key.size);
+        sort_column.collated_offsets[row] = sort_column.collated_chars.size();
+    }
+}
+
+/// Call `f(string_at)` for a string column or `f(value_size, encode_value)` for a fixed size column.
+template <typename StringF, typename FixedF>
+void visitSortColumn(const SortColumn & sort_column, StringF && string_f, FixedF && fixed_f)
+{
+    if (sort_column.collator)
+    {
+        string_f([&](size_t row) { return stringAt(sort_column.collated_chars, sort_column.collated_offsets, row, 0); });
+        return;
+    }
+    dispatchColumn(*sort_column.column, [&](const auto & column) {
+        using ColumnType = std::decay_t<decltype(column)>;
+        if constexpr (std::is_same_v<ColumnType, ColumnString>)
+        {
+            string_f([&](size_t row) { return stringAt(column.getChars(), column.getOffsets(), row, 1); });
+        }
+        else if constexpr (std::is_same_v<ColumnType, ColumnFixedString>)
+        {
+            const auto & chars = column.getChars();
+            size_t n = column.getN();
+            fixed_f(n, [&, n](size_t row, UInt8 * pos) {
+                memcpy(pos, &chars[row * n], n);
+                return pos + n;
+            });
+        }
+        else
+        {
+            const auto & data = column.getData();
+            int nulls_direction = sort_column.nulls_direction;
+            fixed_f(sizeof(data[0]), [&, nulls_direction](size_t row, UInt8 * pos) { return encodeNumber(data[row], nulls_direction, pos); });
+        }
+    });
+}
+
+void addKeySizes(const SortColumn & sort_column, size_t rows, IColumn::Offsets & sizes)
+{
+    const UInt8 * null_map = sort_column.null_map;
+    auto add_sizes = [&](auto && value_size) {
+        for (size_t row = 0; row < rows; ++row)
+        {
+            if (null_map)
+            {
+                sizes[row] += 1;
+                if (null_map[row])
+                    continue;
+            }
+            sizes[row] += value_size(row);
+        }
+    };
+    visitSortColumn(
+        sort_column,
+        [&](auto && string_at) { add_sizes([&](size_t row) { return escapedSize(string_at(row)); }); },
+        [&](size_t value_size, auto &&) { add_sizes([value_size](size_t) { return value_size; }); });
+}
+
+void encodeKeys(const SortColumn & sort_column, size_t rows, UInt8 * chars, IColumn::Offsets & write_pos)
+{
+    const UInt8 * null_map = sort_column.null_map;
+    const UInt8 null_byte = sort_column.nulls_direction > 0 ? 2 : 0;
+    const bool descending = sort_column.direction < 0;
+    auto encode_rows = [&](auto && encode_value) {
+        for (size_t row = 0; row < rows; ++row)
+        {
+            UInt8 * begin = chars + write_pos[row];
+            UInt8 * pos = begin;
+            if (null_map && null_map[row])
+                *pos++ = null_byte;
+            else
+            {
+                if (null_map)
+                    *pos++ = 1;
+                pos = encode_value(row, pos);
+            }
+            if (descending)
+            {
+                for (UInt8 * p = begin; p < pos; ++p)
+                    *p = ~*p;
+            }
+            write_pos[row] = pos - chars;
+        }
+    };
+    visitSortColumn(
+        sort_column,
+        [&](auto && string_at) { encode_rows([&](size_t row, UInt8 * pos) { return encodeString(string_at(row), pos); }); },
+        [&](size_t, auto && encode_value) { encode_rows(encode_value); });
+}
+} // namespace
+
+bool NormalizedSortKeys::canNormalize(const Block & block, const SortDescription & description)
+{
+    SortColumn sort_column;
+    return std::all_of(description.begin(), description.end(), [&](const SortColumnDescription & desc) {
+        return resolveSortColumn(block, desc, sort_column);
+    });
+}
+
+NormalizedSortKeys::NormalizedSortKeys(const Block & block, const SortDescription & description)
+{
+    size_t rows = block.rows();
+    std::vector<SortColumn> sort_columns(description.size());
+    for (size_t i = 0; i < description.size(); ++i)
+    {
+        if (!resolveSortColumn(block, description[i], sort_columns[i]))
+            throw Exception("Sort column " + description[i].getID() + " could not be normalized", ErrorCodes::LOGICAL_ERROR);
+        if (sort_columns[i].collator)
+            collateColumn(sort_columns[i], rows);
+    }
+
+    /// Compute the size of every key first, then write the keys a column at a time.
+    offsets.resize_fill(rows, 0);
+    for (const auto & sort_column : sort_columns)
+    {
+        if (sort_column.column)
+            addKeySizes(sort_column, rows, offsets);
+    }
+    IColumn::Offsets write_pos(rows);
+    size_t total_size = 0;
+    for (size_t row = 0; row < rows; ++row)
+    {
+        write_pos[row] = total_size;
+        total_size += offsets[row];
+        offsets[row] = total_size;
+    }
+
+    chars.resize(total_size);
+    for (const auto & sort_column : sort_columns)
+    {
+        if (sort_column.column)
+            encodeKeys(sort_column, rows, chars.data(), write_pos);
+    }
+}
+
+} // namespace DB
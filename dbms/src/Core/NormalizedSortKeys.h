@@ -0,0 +1,67 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Columns/IColumn.h>
+#include <Common/PODArray.h>
+#include <Core/Block.h>
+#include <Core/SortDescription.h>
+#include <common/StringRef.h>
+
+#include <cstring>
+
+namespace DB
+{
+/** Normalized sort keys of the rows of a block.
+  * The sort columns of every row are encoded into one binary key, so that comparing two rows by the sort description
+  * is the same as comparing their keys by `compareNormalizedSortKeys`, i.e. memcmp.
+  *  - integers and decimals are big-endian with the sign bit flipped, floats are ordered the same way as radix sort,
+  *    NaNs are placed by `nulls_direction`;
+  *  - strings are escaped (0x00 -> 0x00 0xFF) and terminated by 0x00 0x00, so a prefix is less than the string,
+  *    the sort key of the collator is used if there is one;
+  *  - a nullable column is prefixed by a byte ordering the NULLs by `nulls_direction`;
+  *  - the bytes of a column are inverted for descending order.
+  * The keys are computed a column at a time, so that sorting and merging don't need the virtual `compareAt`.
+  */
+class NormalizedSortKeys
+{
+public:
+    /// Whether all the sort columns of `block` are of the supported types, and the collators are TiDB collators.
+    static bool canNormalize(const Block & block, const SortDescription & description);
+
+    /// `canNormalize(block, description)` must be true.
+    NormalizedSortKeys(const Block & block, const SortDescription & description);
+
+    size_t size() const { return offsets.size(); }
+
+    StringRef at(size_t row) const
+    {
+        size_t begin = row == 0 ? 0 : offsets[row - 1];
+        return StringRef(reinterpret_cast<const char *>(&chars[begin]), offsets[row] - begin);
+    }
+
+private:
+    PaddedPODArray<UInt8> chars;
+    IColumn::Offsets offsets;
+};
+
+inline int compareNormalizedSortKeys(const StringRef & lhs, const StringRef & rhs)
+{
+    if (int res = memcmp(lhs.data, rhs.data, std::min(lhs.size, rhs.size)); res != 0)
+        return res;
+    return lhs.size == rhs.size ? 0 : (lhs.size < rhs.size ? -1 : 1);
+}
+
+} // namespace DB
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <Columns/ColumnNullable.h>
 #include <Columns/ColumnString.h>
 #include <Columns/IColumn.h>
 #include <Common/typeid_cast.h>
@@ -86,7 +87,10 @@ struct SortCursorImpl
 
             sort_columns.push_back(block.safeGetByPosition(column_number).column.get());
 
-            need_collation[j] = desc[j].collator != nullptr && typeid_cast<const ColumnString *>(sort_columns.back()); /// TODO Nullable(String)
+            const IColumn * not_null_column = sort_columns.back();
+            if (const auto * nullable = typeid_cast<const ColumnNullable *>(not_null_column))
+                not_null_column = &nullable->getNestedColumn();
+            need_collation[j] = desc[j].collator != nullptr && typeid_cast<const ColumnString *>(not_null_column);
             has_collation |= need_collation[j];
         }
 
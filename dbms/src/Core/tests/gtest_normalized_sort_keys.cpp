@@ -0,0 +1,187 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnDecimal.h>
+#include <Core/NormalizedSortKeys.h>
+#include <DataStreams/MergeSortingBlockInputStream.h>
+#include <DataTypes/DataTypeDecimal.h>
+#include <Interpreters/sortBlock.h>
+#include <Storages/Transaction/Collator.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <random>
+
+namespace DB
+{
+namespace tests
+{
+class NormalizedSortKeysTest : public ::testing::Test
+{
+protected:
+    /// Many duplicated values, so that the later sort columns matter.
+    static Block createBlock(size_t rows, UInt64 seed)
+    {
+        std::mt19937_64 rng(seed);
+        auto pick = [&](const auto & values) { return values[rng() % values.size()]; };
+
+        const std::vector<Int64> ints{std::numeric_limits<Int64>::min(), -3, -1, 0, 1, 3, std::numeric_limits<Int64>::max()};
+        const std::vector<Float64> floats{
+            -std::numeric_limits<Float64>::infinity(),
+            -1.5,
+            -0.0,
+            0.0,
+            1.5,
+            std::numeric_limits<Float64>::infinity(),
+            std::numeric_limits<Float64>::quiet_NaN()};
+        const std::vector<std::optional<String>> strings{{}, "", "a", String("a\0", 2), "A ", "ab", "B", "b"};
+        const std::vector<Int64> decimals{-10000, -1, 0, 1, 250, 10000};
+
+        InferredDataVector<Int64> int_data;
+        InferredDataVector<Float64> float_data;
+        InferredDataVector<Nullable<String>> string_data;
+        auto decimal_type = std::make_shared<DataTypeDecimal128>(20, 2);
+        auto decimal_column = decimal_type->createColumn();
+        for (size_t i = 0; i < rows; ++i)
+        {
+            int_data.push_back(pick(ints));
+            float_data.push_back(pick(floats));
+            string_data.push_back(pick(strings));
+            typeid_cast<ColumnDecimal<Decimal128> &>(*decimal_column).getData().push_back(Decimal128(pick(decimals)));
+        }
+        return Block{
+            createColumn<Int64>(int_data, "i"),
+            createColumn<Float64>(float_data, "f"),
+            createColumn<Nullable<String>>(string_data, "s"),
+            ColumnWithTypeAndName(std::move(decimal_column), decimal_type, "d")};
+    }
+
+    static SortDescription createDescription(const std::vector<String> & names, UInt64 seed, bool with_collation)
+    {
+        std::mt19937_64 rng(seed);
+        SortDescription description;
+        for (const auto & name : names)
+        {
+            int direction = rng() % 2 ? 1 : -1;
+            int nulls_direction = rng() % 2 ? 1 : -1;
+            const ICollator * collator = nullptr;
+            if (with_collation && name == "s")
+                collator = TiDB::ITiDBCollator::getCollator(TiDB::ITiDBCollator::UTF8MB4_GENERAL_CI);
+            description.emplace_back(name, direction, nulls_direction, collator);
+        }
+        return description;
+    }
+
+    /// The order of the rows defined by `compareAt`.
+    static int compareRows(const Block & block, const SortDescription & description, size_t lhs, size_t rhs)
+    {
+        for (const auto & desc : description)
+        {
+            const auto & column = *block.getByName(desc.column_name).column;
+            int res = desc.collator
+                ? column.compareAt(lhs, rhs, column, desc.nulls_direction, *desc.collator)
+                : column.compareAt(lhs, rhs, column, desc.nulls_direction);
+            if (res != 0)
+                return res * desc.direction;
+        }
+        return 0;
+    }
+
+    static int sign(int x) { return (x > 0) - (x < 0); }
+
+    static void assertSorted(const Block & block, const SortDescription & description)
+    {
+        for (size_t row = 1; row < block.rows(); ++row)
+            ASSERT_LE(compareRows(block, description, row - 1, row), 0) << "row " << row;
+    }
+
+    const std::vector<std::vector<String>> column_orders{{"s"}, {"i", "f"}, {"s", "d", "i"}, {"f", "s", "i", "d"}};
+};
+
+TEST_F(NormalizedSortKeysTest, OrderSameAsCompareAt)
+try
+{
+    Block block = createBlock(300, 1);
+    for (bool with_collation : {false, true})
+    {
+        for (size_t i = 0; i < column_orders.size(); ++i)
+        {
+            auto description = createDescription(column_orders[i], i, with_collation);
+            ASSERT_TRUE(NormalizedSortKeys::canNormalize(block, description));
+            NormalizedSortKeys keys(block, description);
+            ASSERT_EQ(keys.size(), block.rows());
+            for (size_t lhs = 0; lhs < block.rows(); ++lhs)
+            {
+                for (size_t rhs = 0; rhs < block.rows(); ++rhs)
+                    ASSERT_EQ(sign(compareNormalizedSortKeys(keys.at(lhs), keys.at(rhs))), sign(compareRows(block, description, lhs, rhs)))
+                        << "columns " << i << ", collation " << with_collation << ", rows " << lhs << " " << rhs;
+            }
+        }
+    }
+}
+CATCH
+
+TEST_F(NormalizedSortKeysTest, UnsupportedColumn)
+try
+{
+    Block block{createColumn<Int64>({1, 2}, "i"), createColumn<Int64>({2, 1}, "j")};
+    SortDescription description{SortColumnDescription("i", 1, 1), SortColumnDescription("j", 1, 1)};
+    ASSERT_TRUE(NormalizedSortKeys::canNormalize(block, description));
+    /// Only the TiDB collators on strings are supported.
+    description[1].collator = TiDB::ITiDBCollator::getCollator(TiDB::ITiDBCollator::UTF8MB4_GENERAL_CI);
+    ASSERT_FALSE(NormalizedSortKeys::canNormalize(block, description));
+}
+CATCH
+
+TEST_F(NormalizedSortKeysTest, SortAndMergeBlocks)
+try
+{
+    for (bool with_collation : {false, true})
+    {
+        for (size_t i = 0; i < column_orders.size(); ++i)
+        {
+            auto description = createDescription(column_orders[i], i + 10, with_collation);
+            for (size_t limit : {0, 1, 17, 1000})
+            {
+                Blocks blocks;
+                size_t total_rows = 0;
+                for (size_t b = 0; b < 5; ++b)
+                {
+                    blocks.push_back(createBlock(50 + b * 20, b));
+                    sortBlock(blocks.back(), description, limit);
+                    assertSorted(blocks.back(), description);
+                    total_rows += blocks.back().rows();
+                }
+                size_t expected_rows = limit ? std::min(limit, total_rows) : total_rows;
+
+                MergeSortingBlocksBlockInputStream stream(blocks, description, "", /*max_merged_block_size=*/64, limit);
+                Block merged = stream.getHeader().cloneEmpty();
+                auto merged_columns = merged.mutateColumns();
+                while (Block block = stream.read())
+                {
+                    ASSERT_LE(block.rows(), 64UL);
+                    for (size_t col = 0; col < merged_columns.size(); ++col)
+                        merged_columns[col]->insertRangeFrom(*block.getByPosition(col).column, 0, block.rows());
+                }
+                merged.setColumns(std::move(merged_columns));
+                ASSERT_EQ(merged.rows(), expected_rows);
+                assertSorted(merged, description);
+            }
+        }
+    }
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
@@ -31,7 +31,7 @@ Block ExchangeSenderBlockInputStream::readImpl()
     {
         FAIL_POINT_TRIGGER_EXCEPTION(FailPoints::exception_during_mpp_root_task_run);
     }
-    else
+    else if (writer->dagContext().isMPPTask())
     {
         FAIL_POINT_TRIGGER_EXCEPTION(FailPoints::exception_during_mpp_non_root_task_run);
     }
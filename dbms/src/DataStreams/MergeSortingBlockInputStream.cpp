@@ -19,6 +19,8 @@
 #include <IO/CompressedWriteBuffer.h>
 #include <IO/WriteBufferFromFile.h>
 
+#include <limits>
+
 
 namespace ProfileEvents
 {
@@ -28,9 +30,7 @@ extern const Event ExternalSortMerge;
 
 namespace DB
 {
-/** Remove constant columns from block.
-  */
-static void removeConstantsFromBlock(Block & block)
+void removeConstantsFromBlock(Block & block)
 {
     size_t columns = block.columns();
     size_t i = 0;
@@ -46,7 +46,7 @@ static void removeConstantsFromBlock(Block & block)
     }
 }
 
-static void removeConstantsFromSortDescription(const Block & header, SortDescription & description)
+void removeConstantsFromSortDescription(const Block & header, SortDescription & description)
 {
     description.erase(
         std::remove_if(description.begin(), description.end(), [&](const SortColumnDescription & elem) {
@@ -58,10 +58,7 @@ static void removeConstantsFromSortDescription(const Block & header, SortDescrip
         description.end());
 }
 
-/** Add into block, whose constant columns was removed by previous function,
-  *  constant columns from header (which must have structure as before removal of constants from block).
-  */
-static void enrichBlockWithConstants(Block & block, const Block & header)
+void enrichBlockWithConstants(Block & block, const Block & header)
 {
     size_t rows = block.rows();
     size_t columns = header.columns();
@@ -213,7 +210,18 @@ MergeSortingBlocksBlockInputStream::MergeSortingBlocksBlockInputStream(
 
     blocks.swap(nonempty_blocks);
 
-    if (!has_collation)
+    bool use_normalized_keys = blocks.size() > 1 && std::all_of(blocks.begin(), blocks.end(), [&](const Block & block) {
+        return NormalizedSortKeys::canNormalize(block, description);
+    });
+    if (use_normalized_keys)
+    {
+        sort_keys.reserve(blocks.size());
+        for (const auto & block : blocks)
+            sort_keys.emplace_back(block, description);
+        loser_tree = std::make_unique<LoserTree<NormalizedKeyLess>>(cursors.size(), NormalizedKeyLess{cursors, sort_keys});
+        loser_tree->init();
+    }
+    else if (!has_collation)
     {
         for (auto & cursor : cursors)
             queue.push(SortCursor(&cursor));
@@ -238,6 +246,9 @@ Block MergeSortingBlocksBlockInputStream::readImpl()
         return res;
     }
 
+    if (loser_tree)
+        return mergeWithLoserTree();
+
     return !has_collation
         ? mergeImpl<SortCursor>(queue)
         : mergeImpl<SortCursorWithCollation>(queue_with_collation);
@@ -287,6 +298,51 @@ Block MergeSortingBlocksBlockInputStream::mergeImpl(std::priority_queue<TSortCur
     return blocks[0].cloneWithColumns(std::move(merged_columns));
 }
 
+Block MergeSortingBlocksBlockInputStream::mergeWithLoserTree()
+{
+    size_t num_columns = blocks[0].columns();
+    MutableColumns merged_columns = blocks[0].cloneEmptyColumns();
+
+    size_t max_rows = max_merged_block_size ? max_merged_block_size : std::numeric_limits<size_t>::max();
+    if (limit)
+        max_rows = std::min(max_rows, limit - total_merged_rows);
+
+    size_t merged_rows = 0;
+    while (!loser_tree->empty() && merged_rows < max_rows)
+    {
+        /// Take the rows of the winner until another cursor wins, and copy them at a time.
+        size_t source = loser_tree->top();
+        auto & cursor = cursors[source];
+        size_t begin = cursor.pos;
+        while (true)
+        {
+            ++merged_rows;
+            bool is_last = cursor.isLast();
+            cursor.next();
+            if (is_last)
+            {
+                loser_tree->popTop();
+                break;
+            }
+            loser_tree->replayTop();
+            if (loser_tree->top() != source || merged_rows == max_rows)
+                break;
+        }
+
+        for (size_t i = 0; i < num_columns; ++i)
+            merged_columns[i]->insertRangeFrom(*cursor.all_columns[i], begin, cursor.pos - begin);
+    }
+
+    if (merged_rows == 0)
+        return {};
+
+    total_merged_rows += merged_rows;
+    auto res = blocks[0].cloneWithColumns(std::move(merged_columns));
+    if (limit && total_merged_rows == limit)
+        blocks.clear();
+    return res;
+}
+
 void MergeSortingBlockInputStream::appendInfo(FmtBuffer & buffer) const
 {
     buffer.fmtAppend(", limit = {}", limit);
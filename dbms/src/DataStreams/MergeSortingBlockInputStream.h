@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <Common/LoserTree.h>
+#include <Core/NormalizedSortKeys.h>
 #include <Core/SortCursor.h>
 #include <Core/SortDescription.h>
 #include <DataStreams/IProfilingBlockInputStream.h>
@@ -28,6 +30,16 @@
 
 namespace DB
 {
+/** Remove constant columns from block.
+  */
+void removeConstantsFromBlock(Block & block);
+void removeConstantsFromSortDescription(const Block & header, SortDescription & description);
+
+/** Add into block, whose constant columns was removed by previous function,
+  *  constant columns from header (which must have structure as before removal of constants from block).
+  */
+void enrichBlockWithConstants(Block & block, const Block & header);
+
 /** Merges stream of sorted each-separately blocks to sorted as-a-whole stream of blocks.
   * If data to sort is too much, could use external sorting, with temporary files.
   */
@@ -81,6 +93,24 @@ private:
     template <typename TSortCursor>
     Block mergeImpl(std::priority_queue<TSortCursor> & queue);
 
+    /// If the sort columns of all blocks could be normalized, the blocks are merged by a loser tree comparing the
+    /// normalized keys of the cursors, instead of the priority queues above.
+    struct NormalizedKeyLess
+    {
+        const CursorImpls & cursors;
+        const std::vector<NormalizedSortKeys> & sort_keys;
+
+        bool operator()(size_t lhs, size_t rhs) const
+        {
+            int res = compareNormalizedSortKeys(sort_keys[lhs].at(cursors[lhs].pos), sort_keys[rhs].at(cursors[rhs].pos));
+            return res < 0 || (res == 0 && lhs < rhs);
+        }
+    };
+    std::vector<NormalizedSortKeys> sort_keys;
+    std::unique_ptr<LoserTree<NormalizedKeyLess>> loser_tree;
+
+    Block mergeWithLoserTree();
+
     LoggerPtr log;
 };
 
@@ -0,0 +1,662 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnString.h>
+#include <Common/FailPoint.h>
+#include <Common/Stopwatch.h>
+#include <Common/ThreadManager.h>
+#include <Common/typeid_cast.h>
+#include <DataStreams/BlocksListBlockInputStream.h>
+#include <DataStreams/ConcatBlockInputStream.h>
+#include <DataStreams/MergeSortingBlockInputStream.h>
+#include <DataStreams/MergingSortedBlockInputStream.h>
+#include <DataStreams/NativeBlockInputStream.h>
+#include <DataStreams/NativeBlockOutputStream.h>
+#include <DataStreams/ParallelMergeSortingBlockInputStream.h>
+#include <Encryption/ReadBufferFromFileProvider.h>
+#include <Encryption/WriteBufferFromFileProvider.h>
+#include <IO/CompressedReadBuffer.h>
+#include <IO/CompressedWriteBuffer.h>
+#include <Interpreters/sortBlock.h>
+#include <Poco/TemporaryFile.h>
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+
+namespace ProfileEvents
+{
+extern const Event ExternalSortWritePart;
+extern const Event ExternalSortMerge;
+} // namespace ProfileEvents
+
+namespace DB
+{
+namespace FailPoints
+{
+extern const char exception_during_parallel_merge_sort_range[];
+} // namespace FailPoints
+
+namespace
+{
+/// The samples kept by a thread are between `max_samples_per_thread` and twice of it.
+constexpr size_t max_samples_per_thread = 1024;
+/// Don't split the rows into more ranges if there are too few samples, the ranges would be too small to be worth a thread.
+constexpr size_t min_samples_per_range = 64;
+constexpr size_t range_output_capacity = 1024;
+/// The merged blocks of a range are buffered until all the ranges before it are output, at most these bytes of them.
+constexpr Int64 max_range_output_bytes = 64 * 1024 * 1024;
+
+/// The first index in [begin, end) for which `pred` is false, `pred` must be true for all the indexes before it.
+template <typename Pred>
+size_t partitionPoint(size_t begin, size_t end, Pred && pred)
+{
+    while (begin < end)
+    {
+        size_t mid = begin + (end - begin) / 2;
+        if (pred(mid))
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+    return begin;
+}
+} // namespace
+
+/// A sorted run of blocks, either in memory or spilled into a temporary file.
+struct ParallelMergeSortingBlockInputStream::SortedRun
+{
+    /// The blocks of an in-memory run, a block is released once all the ranges overlapping with it have read it.
+    Blocks blocks;
+    std::vector<std::atomic<size_t>> block_refs;
+
+    /// The temporary file of a spilled run, in which every block starts a compressed frame at `offsets[i]`.
+    std::unique_ptr<Poco::TemporaryFile> file;
+    FileProviderPtr file_provider;
+    std::vector<size_t> offsets;
+
+    /// The sort columns of the first and the last rows of every block.
+    Columns first_rows;
+    Columns last_rows;
+    size_t num_blocks = 0;
+
+    ~SortedRun()
+    {
+        if (file)
+            file_provider->deleteRegularFile(file->path(), EncryptionPath(file->path(), ""));
+    }
+};
+
+/// Reads the rows of a sorted run in a range of splitters, only the blocks in [begin, end) overlap with the range.
+class ParallelMergeSortingBlockInputStream::RangeOfRunBlockInputStream : public IBlockInputStream
+{
+public:
+    RangeOfRunBlockInputStream(
+        const ParallelMergeSortingBlockInputStream & parent_,
+        const SortedRunPtr & run_,
+        size_t range_,
+        size_t begin,
+        size_t end_)
+        : parent(parent_)
+        , run(run_)
+        , range(range_)
+        , pos(begin)
+        , end(end_)
+    {}
+
+    String getName() const override { return "RangeOfRun"; }
+    Block getHeader() const override { return parent.header_without_constants; }
+
+    Block read() override
+    {
+        while (pos < end)
+        {
+            Block block = readBlock();
+            ++pos;
+
+            size_t rows = block.rows();
+            if (!rows)
+                continue;
+
+            /// Only the first and the last blocks could have rows out of the range.
+            ColumnRawPtrs columns = parent.getSortColumns(block);
+            size_t cut_begin = 0;
+            size_t cut_end = rows;
+            if (range > 0 && parent.compareRows(columns, 0, parent.splitters, range - 1) < 0)
+                cut_begin = parent.lowerBound(columns, rows, range - 1);
+            if (range < parent.num_splitters && parent.compareRows(columns, rows - 1, parent.splitters, range) >= 0)
+                cut_end = parent.lowerBound(columns, rows, range);
+
+            if (cut_begin >= cut_end)
+                continue;
+            if (cut_begin > 0 || cut_end < rows)
+            {
+                for (auto & column : block)
+                    column.column = column.column->cut(cut_begin, cut_end - cut_begin);
+            }
+            return block;
+        }
+        return {};
+    }
+
+private:
+    Block readBlock()
+    {
+        if (!run->file)
+        {
+            Block block = run->blocks[pos];
+            if (run->block_refs[pos].fetch_sub(1) == 1)
+                run->blocks[pos] = {};
+            return block;
+        }
+
+        if (!block_in)
+        {
+            const auto & path = run->file->path();
+            file_in = std::make_unique<ReadBufferFromFileProvider>(run->file_provider, path, EncryptionPath(path, ""));
+            file_in->seek(run->offsets[pos]);
+            compressed_in = std::make_unique<CompressedReadBuffer<>>(*file_in);
+            block_in = std::make_unique<NativeBlockInputStream>(*compressed_in, parent.header_without_constants, 0);
+        }
+        return block_in->read();
+    }
+
+    const ParallelMergeSortingBlockInputStream & parent;
+    SortedRunPtr run;
+    size_t range;
+    size_t pos;
+    size_t end;
+
+    std::unique_ptr<ReadBufferFromFileProvider> file_in;
+    std::unique_ptr<CompressedReadBuffer<>> compressed_in;
+    std::unique_ptr<NativeBlockInputStream> block_in;
+};
+
+ParallelMergeSortingBlockInputStream::ParallelMergeSortingBlockInputStream(
+    const BlockInputStreams & inputs,
+    const BlockInputStreamPtr & additional_input_at_end,
+    const SortDescription & description_,
+    size_t max_merged_block_size_,
+    size_t max_bytes_before_external_sort_,
+    const String & tmp_path_,
+    const CompressionSettings & compression_settings_,
+    const FileProviderPtr & file_provider_,
+    size_t max_threads_,
+    const String & req_id)
+    : log(Logger::get(NAME, req_id))
+    , description(description_)
+    , max_merged_block_size(max_merged_block_size_)
+    , max_bytes_before_external_sort(max_bytes_before_external_sort_)
+    , tmp_path(tmp_path_)
+    , compression_settings(compression_settings_)
+    , file_provider(file_provider_)
+    , max_threads(std::min(inputs.size(), max_threads_))
+    , handler(*this)
+    , processor(inputs, additional_input_at_end, max_threads, handler, log)
+{
+    children = inputs;
+    if (additional_input_at_end)
+        children.push_back(additional_input_at_end);
+
+    header = children.at(0)->getHeader();
+    header_without_constants = header;
+    removeConstantsFromBlock(header_without_constants);
+    removeConstantsFromSortDescription(header, description);
+
+    ColumnRawPtrs sort_columns = getSortColumns(header_without_constants);
+    need_collation.resize(description.size());
+    for (size_t i = 0; i < description.size(); ++i)
+    {
+        const IColumn * not_null_column = sort_columns[i];
+        if (const auto * nullable = typeid_cast<const ColumnNullable *>(not_null_column))
+            not_null_column = &nullable->getNestedColumn();
+        need_collation[i] = description[i].collator != nullptr && typeid_cast<const ColumnString *>(not_null_column);
+    }
+}
+
+ParallelMergeSortingBlockInputStream::~ParallelMergeSortingBlockInputStream()
+{
+    try
+    {
+        cancelMerging();
+        if (thread_manager)
+            thread_manager->wait();
+    }
+    catch (...)
+    {
+        tryLogCurrentException(log, __PRETTY_FUNCTION__);
+    }
+}
+
+void ParallelMergeSortingBlockInputStream::cancel(bool kill)
+{
+    if (kill)
+        is_killed = true;
+    bool old_val = false;
+    if (!is_cancelled.compare_exchange_strong(old_val, true, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return;
+
+    if (!executed)
+        processor.cancel(kill);
+    cancelMerging();
+}
+
+void ParallelMergeSortingBlockInputStream::cancelMerging()
+{
+    std::lock_guard lock(merge_mutex);
+    for (auto & output : range_outputs)
+        output->cancel();
+}
+
+Block ParallelMergeSortingBlockInputStream::readImpl()
+{
+    if (!executed)
+    {
+        execute();
+        executed = true;
+    }
+
+    while (!isCancelledOrThrowIfKilled() && current_range < range_outputs.size())
+    {
+        auto & output = *range_outputs[current_range];
+        Block block;
+        if (output.pop(block))
+        {
+            enrichBlockWithConstants(block, header);
+            return block;
+        }
+
+        {
+            std::lock_guard lock(merge_mutex);
+            if (merge_exception)
+                std::rethrow_exception(merge_exception);
+        }
+        if (output.getStatus() == MPMCQueueStatus::CANCELLED)
+            break;
+        ++current_range;
+    }
+    return {};
+}
+
+void ParallelMergeSortingBlockInputStream::Handler::onBlock(Block & block, size_t thread_num)
+{
+    removeConstantsFromBlock(block);
+    if (!block.rows())
+        return;
+
+    auto & data = parent.threads_data[thread_num];
+    parent.sampleBlock(data, block);
+    data.bytes += block.bytes();
+    data.blocks.push_back(block);
+
+    /// Every thread has its share of the memory limit, and spills its blocks as a sorted run once exceeds it.
+    if (parent.max_bytes_before_external_sort && data.bytes > parent.max_bytes_before_external_sort / parent.max_threads)
+    {
+        data.runs.push_back(parent.mergeIntoRun(data.blocks, true));
+        data.blocks.clear();
+        data.bytes = 0;
+    }
+}
+
+void ParallelMergeSortingBlockInputStream::Handler::onFinishThread(size_t thread_num)
+{
+    auto & data = parent.threads_data[thread_num];
+    if (!parent.isCancelled() && !data.blocks.empty())
+    {
+        data.runs.push_back(parent.mergeIntoRun(data.blocks, false));
+        data.blocks.clear();
+        data.bytes = 0;
+    }
+}
+
+void ParallelMergeSortingBlockInputStream::Handler::onException(std::exception_ptr & exception, size_t thread_num)
+{
+    parent.exceptions[thread_num] = exception;
+    Int32 old_value = -1;
+    parent.first_exception_index.compare_exchange_strong(old_value, static_cast<Int32>(thread_num), std::memory_order_seq_cst, std::memory_order_relaxed);
+
+    /// can not cancel parent inputStream or the exception might be lost
+    if (!parent.executed)
+        /// kill the processor so ExchangeReceiver will be closed
+        parent.processor.cancel(true);
+}
+
+void ParallelMergeSortingBlockInputStream::execute()
+{
+    threads_data.resize(max_threads);
+    exceptions.resize(max_threads);
+
+    LOG_FMT_TRACE(log, "Sorting");
+    Stopwatch watch;
+
+    processor.process();
+    processor.wait();
+
+    if (first_exception_index != -1)
+        std::rethrow_exception(exceptions[first_exception_index]);
+
+    if (isCancelledOrThrowIfKilled())
+        return;
+
+    bool has_spilled_run = false;
+    for (auto & data : threads_data)
+    {
+        for (auto & run : data.runs)
+        {
+            has_spilled_run |= run->file != nullptr;
+            runs.push_back(std::move(run));
+        }
+        data.runs.clear();
+    }
+
+    pickSplitters();
+    size_t num_ranges = num_splitters + 1;
+
+    /// The blocks of a sorted run are sorted as a whole, so that the blocks overlapping with a range are continuous.
+    range_blocks.resize(num_ranges);
+    for (const auto & run : runs)
+    {
+        if (!run->file)
+            run->block_refs = std::vector<std::atomic<size_t>>(run->num_blocks);
+        for (size_t range = 0; range < num_ranges; ++range)
+        {
+            size_t begin = 0;
+            size_t end = run->num_blocks;
+            if (range > 0)
+                begin = partitionPoint(0, run->num_blocks, [&](size_t i) { return compareRows(run->last_rows, i, splitters, range - 1) < 0; });
+            if (range < num_splitters)
+                end = partitionPoint(begin, run->num_blocks, [&](size_t i) { return compareRows(run->first_rows, i, splitters, range) < 0; });
+            range_blocks[range].emplace_back(begin, end);
+            if (!run->file)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    ++run->block_refs[i];
+            }
+        }
+    }
+
+    LOG_FMT_DEBUG(
+        log,
+        "Sorted {} runs in {:.3f} sec., will merge them by {} ranges{}",
+        runs.size(),
+        watch.elapsedSeconds(),
+        num_ranges,
+        has_spilled_run ? ", some runs are spilled" : "");
+    if (has_spilled_run)
+        ProfileEvents::increment(ProfileEvents::ExternalSortMerge);
+
+    std::lock_guard lock(merge_mutex);
+    /// `cancel` may be called after the check above, it cancels the outputs created here with the lock held.
+    if (isCancelled())
+        return;
+
+    /// The merging of a range waits once its output is full, so that the runs are not held in memory together with the merged copies of them.
+    Int64 max_output_bytes = max_range_output_bytes;
+    if (max_bytes_before_external_sort)
+        max_output_bytes = std::clamp<Int64>(max_bytes_before_external_sort / num_ranges, 1, max_range_output_bytes);
+    for (size_t i = 0; i < num_ranges; ++i)
+        range_outputs.push_back(std::make_unique<MPMCQueue<Block>>(range_output_capacity, max_output_bytes, [](const Block & block) { return block.bytes(); }));
+
+    thread_manager = newThreadManager();
+    for (size_t i = 0; i < num_ranges; ++i)
+        thread_manager->schedule(true, "ParallelSort", [this, i] { mergeRange(i); });
+}
+
+void ParallelMergeSortingBlockInputStream::sampleBlock(ThreadData & data, const Block & block) const
+{
+    if (description.empty())
+        return;
+
+    ColumnRawPtrs columns = getSortColumns(block);
+    if (data.samples.empty())
+    {
+        for (const auto * column : columns)
+            data.samples.push_back(column->cloneEmpty());
+    }
+
+    size_t rows = block.rows();
+    for (; data.next_sample_row < rows; data.next_sample_row += data.sample_step)
+    {
+        for (size_t i = 0; i < columns.size(); ++i)
+            data.samples[i]->insertFrom(*columns[i], data.next_sample_row);
+    }
+    data.next_sample_row -= rows;
+
+    /// Too many samples, keep half of them and sample half as many rows afterwards.
+    size_t num_samples = data.samples[0]->size();
+    if (num_samples >= 2 * max_samples_per_thread)
+    {
+        IColumn::Filter filter(num_samples);
+        for (size_t i = 0; i < num_samples; ++i)
+            filter[i] = i % 2 == 0;
+        for (auto & sample : data.samples)
+        {
+            ColumnPtr filtered = sample->filter(filter, num_samples / 2 + 1);
+            sample = (*std::move(filtered)).mutate();
+        }
+        data.sample_step *= 2;
+    }
+}
+
+void ParallelMergeSortingBlockInputStream::pickSplitters()
+{
+    if (description.empty())
+        return;
+
+    Block samples;
+    SortDescription samples_description;
+    for (size_t i = 0; i < description.size(); ++i)
+    {
+        const auto & elem = description[i];
+        const auto & column = elem.column_name.empty()
+            ? header_without_constants.safeGetByPosition(elem.column_number)
+            : header_without_constants.getByName(elem.column_name);
+        auto sample = column.column->cloneEmpty();
+        for (auto & data : threads_data)
+        {
+            if (!data.samples.empty())
+                sample->insertRangeFrom(*data.samples[i], 0, data.samples[i]->size());
+        }
+        samples.insert({std::move(sample), column.type, column.name});
+        samples_description.emplace_back(i, elem.direction, elem.nulls_direction, elem.collator);
+    }
+    for (auto & data : threads_data)
+        data.samples.clear();
+
+    size_t num_samples = samples.rows();
+    size_t num_ranges = std::min(max_threads, num_samples / min_samples_per_range);
+    if (num_ranges <= 1)
+        return;
+
+    sortBlock(samples, samples_description);
+    ColumnRawPtrs sample_columns;
+    for (const auto & column : samples)
+        sample_columns.push_back(column.column.get());
+
+    MutableColumns splitter_columns = samples.cloneEmptyColumns();
+    std::optional<size_t> last_row;
+    for (size_t i = 1; i < num_ranges; ++i)
+    {
+        size_t row = i * num_samples / num_ranges;
+        /// Equal splitters would make empty ranges.
+        if (last_row && compareRows(sample_columns, *last_row, sample_columns, row) == 0)
+            continue;
+        for (size_t j = 0; j < splitter_columns.size(); ++j)
+            splitter_columns[j]->insertFrom(*sample_columns[j], row);
+        last_row = row;
+    }
+
+    num_splitters = splitter_columns[0]->size();
+    for (auto & column : splitter_columns)
+        splitters.push_back(std::move(column));
+}
+
+ParallelMergeSortingBlockInputStream::SortedRunPtr ParallelMergeSortingBlockInputStream::mergeIntoRun(Blocks & blocks, bool spill)
+{
+    auto run = std::make_shared<SortedRun>();
+    SortDescription run_description = description;
+    BlockInputStreamPtr block_in;
+    /// Sorted only by the constant columns, the blocks are in order as they are, like MergeSortingBlockInputStream.
+    if (description.empty())
+        block_in = std::make_shared<BlocksListBlockInputStream>(BlocksList(blocks.begin(), blocks.end()));
+    else
+        block_in = std::make_shared<MergeSortingBlocksBlockInputStream>(blocks, run_description, log->identifier(), max_merged_block_size);
+
+    MutableColumns first_rows;
+    MutableColumns last_rows;
+    for (const auto * column : getSortColumns(header_without_constants))
+    {
+        first_rows.push_back(column->cloneEmpty());
+        last_rows.push_back(column->cloneEmpty());
+    }
+    auto add_block = [&](const Block & block) {
+        ColumnRawPtrs columns = getSortColumns(block);
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            first_rows[i]->insertFrom(*columns[i], 0);
+            last_rows[i]->insertFrom(*columns[i], block.rows() - 1);
+        }
+        ++run->num_blocks;
+    };
+
+    if (!spill)
+    {
+        while (Block block = block_in->read())
+        {
+            add_block(block);
+            run->blocks.push_back(std::move(block));
+        }
+    }
+    else
+    {
+        run->file = std::make_unique<Poco::TemporaryFile>(tmp_path);
+        run->file_provider = file_provider;
+        const auto & path = run->file->path();
+        WriteBufferFromFileProvider file_buf(file_provider, path, EncryptionPath(path, ""));
+        CompressedWriteBuffer compressed_buf(file_buf, compression_settings);
+        NativeBlockOutputStream block_out(compressed_buf, 0, header_without_constants);
+
+        LOG_FMT_DEBUG(log, "Sorting and writing part of data into temporary file {}", path);
+        ProfileEvents::increment(ProfileEvents::ExternalSortWritePart);
+
+        while (Block block = block_in->read())
+        {
+            if (isCancelled())
+                break;
+            /// Start a new compressed frame, so that the reading of a range could seek to the block directly.
+            compressed_buf.next();
+            run->offsets.push_back(file_buf.count());
+            add_block(block);
+            block_out.write(block);
+        }
+        compressed_buf.next();
+        file_buf.next();
+    }
+
+    for (size_t i = 0; i < first_rows.size(); ++i)
+    {
+        run->first_rows.push_back(std::move(first_rows[i]));
+        run->last_rows.push_back(std::move(last_rows[i]));
+    }
+    return run;
+}
+
+void ParallelMergeSortingBlockInputStream::mergeRange(size_t range)
+{
+    auto & output = *range_outputs[range];
+    try
+    {
+        BlockInputStreams inputs;
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            auto [begin, end] = range_blocks[range][i];
+            if (begin < end)
+                inputs.push_back(std::make_shared<RangeOfRunBlockInputStream>(*this, runs[i], range, begin, end));
+        }
+
+        if (!inputs.empty())
+        {
+            BlockInputStreamPtr merged;
+            if (inputs.size() == 1)
+                merged = inputs[0];
+            else if (description.empty())
+                merged = std::make_shared<ConcatBlockInputStream>(inputs, log->identifier());
+            else
+                merged = std::make_shared<MergingSortedBlockInputStream>(inputs, description, max_merged_block_size, 0, nullptr, true);
+            merged->readPrefix();
+            while (Block block = merged->read())
+            {
+                FAIL_POINT_TRIGGER_EXCEPTION(FailPoints::exception_during_parallel_merge_sort_range);
+                if (!output.push(std::move(block)))
+                    return;
+            }
+            merged->readSuffix();
+        }
+        output.finish();
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard lock(merge_mutex);
+            if (!merge_exception)
+                merge_exception = std::current_exception();
+        }
+        cancelMerging();
+    }
+}
+
+ColumnRawPtrs ParallelMergeSortingBlockInputStream::getSortColumns(const Block & block) const
+{
+    ColumnRawPtrs columns;
+    columns.reserve(description.size());
+    for (const auto & elem : description)
+    {
+        if (elem.column_name.empty())
+            columns.push_back(block.safeGetByPosition(elem.column_number).column.get());
+        else
+            columns.push_back(block.getByName(elem.column_name).column.get());
+    }
+    return columns;
+}
+
+template <typename LhsColumns, typename RhsColumns>
+int ParallelMergeSortingBlockInputStream::compareRows(const LhsColumns & lhs, size_t lhs_row, const RhsColumns & rhs, size_t rhs_row) const
+{
+    for (size_t i = 0; i < description.size(); ++i)
+    {
+        int nulls_direction = description[i].nulls_direction;
+        int res;
+        if (need_collation[i])
+            res = lhs[i]->compareAt(lhs_row, rhs_row, *rhs[i], nulls_direction, *description[i].collator);
+        else
+            res = lhs[i]->compareAt(lhs_row, rhs_row, *rhs[i], nulls_direction);
+
+        if (res != 0)
+            return res * description[i].direction;
+    }
+    return 0;
+}
+
+size_t ParallelMergeSortingBlockInputStream::lowerBound(const ColumnRawPtrs & columns, size_t rows, size_t splitter) const
+{
+    return partitionPoint(0, rows, [&](size_t i) { return compareRows(columns, i, splitters, splitter) < 0; });
+}
+
+void ParallelMergeSortingBlockInputStream::appendInfo(FmtBuffer & buffer) const
+{
+    buffer.fmtAppend(", max_threads: {}, max_bytes_before_external_sort: {}", max_threads, max_bytes_before_external_sort);
+}
+
+} // namespace DB
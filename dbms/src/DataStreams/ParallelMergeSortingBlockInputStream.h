@@ -0,0 +1,174 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Common/MPMCQueue.h>
+#include <Core/SortDescription.h>
+#include <DataStreams/IProfilingBlockInputStream.h>
+#include <DataStreams/ParallelInputsProcessor.h>
+#include <Encryption/FileProvider.h>
+#include <IO/CompressionSettings.h>
+
+namespace DB
+{
+class ThreadManager;
+
+/** Sorts several streams of sorted blocks in parallel, and outputs all the rows in order as one stream.
+  * If the blocks are too much to be held in memory, they are spilled to temporary files.
+  *
+  * 1. Every thread reads the blocks of its inputs and takes samples of their rows. Once the blocks held by a thread
+  *    exceed its share of `max_bytes_before_external_sort`, they are merged into a sorted run, which is written into
+  *    a temporary file in the compressed native format. The rest blocks of a thread are merged into a sorted run in memory.
+  * 2. The splitters are picked from the samples, which partition the rows into ranges of about the same size.
+  * 3. Every range is merged from its parts of all the sorted runs by a thread, and the ranges are output in order.
+  *    Every block of a spilled run starts a compressed frame, and its offset and its first and last rows are kept,
+  *    so that the merge of a range only reads the blocks overlapping with it. A block of an in-memory run is released
+  *    once all the ranges overlapping with it have read it, and the merged blocks waiting for the ranges before them
+  *    are bounded by bytes.
+  */
+class ParallelMergeSortingBlockInputStream : public IProfilingBlockInputStream
+{
+    static constexpr auto NAME = "ParallelMergeSorting";
+
+public:
+    ParallelMergeSortingBlockInputStream(
+        const BlockInputStreams & inputs,
+        const BlockInputStreamPtr & additional_input_at_end,
+        const SortDescription & description_,
+        size_t max_merged_block_size_,
+        size_t max_bytes_before_external_sort_,
+        const String & tmp_path_,
+        const CompressionSettings & compression_settings_,
+        const FileProviderPtr & file_provider_,
+        size_t max_threads_,
+        const String & req_id);
+
+    ~ParallelMergeSortingBlockInputStream() override;
+
+    String getName() const override { return NAME; }
+
+    bool isGroupedOutput() const override { return true; }
+    bool isSortedOutput() const override { return true; }
+    const SortDescription & getSortDescription() const override { return description; }
+
+    Block getHeader() const override { return header; }
+
+    void cancel(bool kill) override;
+
+    void collectNewThreadCountOfThisLevel(int & cnt) override
+    {
+        cnt += processor.getMaxThreads();
+    }
+
+protected:
+    /// Do nothing that preparation to execution of the query be done in parallel, in ParallelInputsProcessor.
+    void readPrefix() override
+    {
+    }
+
+    Block readImpl() override;
+    void appendInfo(FmtBuffer & buffer) const override;
+
+private:
+    struct SortedRun;
+    using SortedRunPtr = std::shared_ptr<SortedRun>;
+    class RangeOfRunBlockInputStream;
+
+    struct ThreadData
+    {
+        /// The sorted blocks not merged into a run yet.
+        Blocks blocks;
+        size_t bytes = 0;
+        std::vector<SortedRunPtr> runs;
+
+        /// One row of every `sample_step` rows is sampled, and the step is doubled when there are too many samples.
+        MutableColumns samples;
+        size_t sample_step = 1;
+        size_t next_sample_row = 0;
+    };
+
+    struct Handler
+    {
+        explicit Handler(ParallelMergeSortingBlockInputStream & parent_)
+            : parent(parent_)
+        {}
+
+        void onBlock(Block & block, size_t thread_num);
+        void onFinishThread(size_t thread_num);
+        void onFinish() {}
+        void onException(std::exception_ptr & exception, size_t thread_num);
+        static String getName()
+        {
+            return "ParallelSort";
+        }
+
+        ParallelMergeSortingBlockInputStream & parent;
+    };
+
+    /// Read all the inputs into sorted runs, and start the threads merging the ranges of them.
+    void execute();
+
+    void sampleBlock(ThreadData & data, const Block & block) const;
+    void pickSplitters();
+    SortedRunPtr mergeIntoRun(Blocks & blocks, bool spill);
+    void mergeRange(size_t range);
+    void cancelMerging();
+
+    ColumnRawPtrs getSortColumns(const Block & block) const;
+    template <typename LhsColumns, typename RhsColumns>
+    int compareRows(const LhsColumns & lhs, size_t lhs_row, const RhsColumns & rhs, size_t rhs_row) const;
+    /// The first row of the sorted `columns` not less than the splitter.
+    size_t lowerBound(const ColumnRawPtrs & columns, size_t rows, size_t splitter) const;
+
+    const LoggerPtr log;
+
+    SortDescription description;
+    size_t max_merged_block_size;
+    size_t max_bytes_before_external_sort;
+    const String tmp_path;
+    CompressionSettings compression_settings;
+    FileProviderPtr file_provider;
+    size_t max_threads;
+
+    /// The constant columns are removed before sorting, and restored for the output.
+    Block header;
+    Block header_without_constants;
+    /// Whether the sort columns are compared with their collators, see SortCursorImpl.
+    std::vector<UInt8> need_collation;
+
+    std::vector<ThreadData> threads_data;
+    std::vector<SortedRunPtr> runs;
+    /// The sort columns of the splitters, the row i is the upper bound of range i and the lower bound of range i + 1.
+    Columns splitters;
+    size_t num_splitters = 0;
+    /// The blocks [begin, end) of every run overlapping with every range.
+    std::vector<std::vector<std::pair<size_t, size_t>>> range_blocks;
+
+    Handler handler;
+    ParallelInputsProcessor<Handler> processor;
+
+    Exceptions exceptions;
+    std::atomic<Int32> first_exception_index{-1};
+    std::atomic<bool> executed{false};
+
+    /// The merged blocks of every range, which are output one range after another.
+    std::mutex merge_mutex;
+    std::vector<std::unique_ptr<MPMCQueue<Block>>> range_outputs;
+    std::shared_ptr<ThreadManager> thread_manager;
+    std::exception_ptr merge_exception;
+    size_t current_range = 0;
+};
+
+} // namespace DB
@@ -0,0 +1,158 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnString.h>
+#include <Common/FmtUtils.h>
+#include <Common/typeid_cast.h>
+#include <DataStreams/TopNBlockInputStream.h>
+#include <DataStreams/materializeBlock.h>
+#include <Interpreters/sortBlock.h>
+
+namespace DB
+{
+namespace
+{
+const IColumn & getSortColumn(const Block & block, const SortColumnDescription & description)
+{
+    return !description.column_name.empty()
+        ? *block.getByName(description.column_name).column
+        : *block.safeGetByPosition(description.column_number).column;
+}
+
+bool needCollation(const IColumn & column, const SortColumnDescription & description)
+{
+    if (!description.collator)
+        return false;
+    const auto * not_null_column = column.isColumnNullable() ? &static_cast<const ColumnNullable &>(column).getNestedColumn() : &column;
+    return typeid_cast<const ColumnString *>(not_null_column) != nullptr;
+}
+} // namespace
+
+TopNBlockInputStream::TopNBlockInputStream(
+    const BlockInputStreamPtr & input_,
+    const SortDescription & description_,
+    size_t limit_,
+    const DM::TopNThresholdPtr & threshold_,
+    const String & req_id)
+    : description(description_)
+    , limit(limit_)
+    , threshold(threshold_)
+    , log(Logger::get(NAME, req_id))
+{
+    children.push_back(input_);
+}
+
+Block TopNBlockInputStream::readImpl()
+{
+    if (finished)
+        return {};
+    finished = true;
+
+    while (Block block = children.back()->read())
+    {
+        block = materializeBlock(block);
+        if (top_rows.rows() == limit)
+            filterByLastRow(block);
+        if (!block.rows())
+            continue;
+
+        sortBlock(block, description, limit);
+        pending_rows += block.rows();
+        pending_blocks.push_back(std::move(block));
+        if (pending_rows >= limit)
+            mergePendingBlocks();
+    }
+    mergePendingBlocks();
+
+    LOG_FMT_DEBUG(log, "TopN holds {} rows, {} rows are filtered out by the last row held", top_rows.rows(), filtered_rows);
+    return top_rows;
+}
+
+void TopNBlockInputStream::filterByLastRow(Block & block)
+{
+    size_t rows = block.rows();
+    size_t last_row = top_rows.rows() - 1;
+
+    std::vector<std::pair<const IColumn *, const IColumn *>> columns;
+    columns.reserve(description.size());
+    for (const auto & column_description : description)
+        columns.emplace_back(&getSortColumn(block, column_description), &getSortColumn(top_rows, column_description));
+
+    IColumn::Filter filter(rows);
+    size_t kept_rows = 0;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        int res = 0;
+        for (size_t j = 0; j < description.size() && res == 0; ++j)
+        {
+            const auto & [column, top_column] = columns[j];
+            const auto & column_description = description[j];
+            if (needCollation(*column, column_description))
+                res = column->compareAt(i, last_row, *top_column, column_description.nulls_direction, *column_description.collator);
+            else
+                res = column->compareAt(i, last_row, *top_column, column_description.nulls_direction);
+            res *= column_description.direction;
+        }
+        filter[i] = res < 0;
+        kept_rows += filter[i];
+    }
+
+    filtered_rows += rows - kept_rows;
+    if (kept_rows == rows)
+        return;
+    for (auto & column : block)
+        column.column = column.column->filter(filter, kept_rows);
+}
+
+void TopNBlockInputStream::mergePendingBlocks()
+{
+    if (pending_blocks.empty())
+        return;
+    if (top_rows)
+        pending_blocks.push_back(std::move(top_rows));
+
+    auto columns = pending_blocks.front().cloneEmptyColumns();
+    for (const auto & block : pending_blocks)
+    {
+        for (size_t i = 0; i < columns.size(); ++i)
+            columns[i]->insertRangeFrom(*block.getByPosition(i).column, 0, block.rows());
+    }
+    top_rows = pending_blocks.front().cloneWithColumns(std::move(columns));
+    pending_blocks.clear();
+    pending_rows = 0;
+
+    sortBlock(top_rows, description, limit);
+    publishThreshold();
+}
+
+void TopNBlockInputStream::publishThreshold()
+{
+    if (!threshold || top_rows.rows() < limit)
+        return;
+    /// Only the values of integer columns are comparable with the min-max index of the packs.
+    const auto & column = !description[0].column_name.empty()
+        ? top_rows.getByName(description[0].column_name)
+        : top_rows.safeGetByPosition(description[0].column_number);
+    if (!column.type->isInteger() && !column.type->isMyDateOrMyDateTime())
+        return;
+    threshold->publish(column.column->getInt(limit - 1));
+}
+
+void TopNBlockInputStream::appendInfo(FmtBuffer & buffer) const
+{
+    buffer.fmtAppend(": limit = {}", limit);
+    if (threshold)
+        buffer.append(", publish threshold");
+}
+} // namespace DB
@@ -0,0 +1,78 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <Core/SortDescription.h>
+#include <DataStreams/IProfilingBlockInputStream.h>
+#include <Storages/DeltaMerge/Filter/TopNThreshold.h>
+
+namespace DB
+{
+/** Returns the first `limit` rows of the input in the order of `description`, as one sorted block.
+  * Unlike PartialSortingBlockInputStream, which keeps `limit` rows of every block, at most `limit` rows are held
+  *  in total: the sorted blocks are merged into the rows held once they are more than `limit`, and after `limit`
+  *  rows are held, the last of them works as the top of a bounded heap, the rows not ordered before it are
+  *  filtered out before sorting.
+  * If `threshold` is set, the value of the first sort column in the last row held is published to the table scan,
+  *  so that the packs which can not enter the result are skipped.
+  */
+class TopNBlockInputStream : public IProfilingBlockInputStream
+{
+    static constexpr auto NAME = "TopN";
+
+public:
+    TopNBlockInputStream(
+        const BlockInputStreamPtr & input_,
+        const SortDescription & description_,
+        size_t limit_,
+        const DM::TopNThresholdPtr & threshold_,
+        const String & req_id);
+
+    String getName() const override { return NAME; }
+
+    bool isGroupedOutput() const override { return true; }
+    bool isSortedOutput() const override { return true; }
+    const SortDescription & getSortDescription() const override { return description; }
+
+    Block getHeader() const override { return children.at(0)->getHeader(); }
+
+protected:
+    Block readImpl() override;
+    void appendInfo(FmtBuffer & buffer) const override;
+
+private:
+    /// Remove the rows not ordered before the last row of `top_rows`, they can not enter the result.
+    void filterByLastRow(Block & block);
+
+    /// Merge `pending_blocks` into `top_rows` and keep the first `limit` rows.
+    void mergePendingBlocks();
+
+    void publishThreshold();
+
+private:
+    SortDescription description;
+    size_t limit;
+    DM::TopNThresholdPtr threshold;
+    LoggerPtr log;
+
+    /// The first rows in order read so far, sorted, at most `limit` rows.
+    Block top_rows;
+    /// The sorted blocks not merged into `top_rows` yet.
+    Blocks pending_blocks;
+    size_t pending_rows = 0;
+    size_t filtered_rows = 0;
+    bool finished = false;
+};
+
+} // namespace DB
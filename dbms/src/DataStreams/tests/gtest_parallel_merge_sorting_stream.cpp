@@ -0,0 +1,337 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/FailPoint.h>
+#include <DataStreams/BlocksListBlockInputStream.h>
+#include <DataStreams/ParallelMergeSortingBlockInputStream.h>
+#include <Encryption/MockKeyManager.h>
+#include <Interpreters/sortBlock.h>
+#include <Poco/File.h>
+#include <Storages/Transaction/Collator.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <algorithm>
+#include <ext/scope_guard.h>
+#include <random>
+
+namespace DB
+{
+namespace FailPoints
+{
+extern const char exception_during_parallel_merge_sort_range[];
+} // namespace FailPoints
+
+namespace tests
+{
+namespace
+{
+struct Row
+{
+    Int64 a;
+    Int64 b;
+};
+
+/// Split the rows into blocks of (a, b), every block is sorted by `description` like the output of PartialSortingBlockInputStream.
+BlocksList toSortedBlocks(const std::vector<Row> & rows, size_t begin, size_t end, size_t block_rows, const SortDescription & description)
+{
+    BlocksList blocks;
+    for (; begin < end; begin += block_rows)
+    {
+        std::vector<Int64> a, b;
+        for (size_t i = begin; i < std::min(end, begin + block_rows); ++i)
+        {
+            a.push_back(rows[i].a);
+            b.push_back(rows[i].b);
+        }
+        Block block{createColumn<Int64>(a, "a"), createColumn<Int64>(b, "b")};
+        sortBlock(block, description);
+        blocks.push_back(std::move(block));
+    }
+    return blocks;
+}
+/// Split the rows of `block` into `num_inputs` inputs of sorted blocks.
+BlockInputStreams toSortedInputs(const Block & block, size_t num_inputs, size_t block_rows, const SortDescription & description)
+{
+    BlockInputStreams inputs;
+    size_t rows = block.rows();
+    for (size_t i = 0; i < num_inputs; ++i)
+    {
+        BlocksList blocks;
+        for (size_t begin = i * rows / num_inputs, end = (i + 1) * rows / num_inputs; begin < end; begin += block_rows)
+        {
+            Block part = block.cloneEmpty();
+            for (size_t j = 0; j < block.columns(); ++j)
+                part.getByPosition(j).column = block.getByPosition(j).column->cut(begin, std::min(end - begin, block_rows));
+            sortBlock(part, description);
+            blocks.push_back(std::move(part));
+        }
+        inputs.push_back(std::make_shared<BlocksListBlockInputStream>(std::move(blocks)));
+    }
+    return inputs;
+}
+
+std::shared_ptr<ParallelMergeSortingBlockInputStream> createSortingStream(
+    const BlockInputStreams & inputs,
+    const SortDescription & description,
+    size_t max_bytes_before_external_sort)
+{
+    const String tmp_path = TiFlashTestEnv::getTemporaryPath("ParallelMergeSortingBlockInputStreamTest/");
+    Poco::File(tmp_path).createDirectories();
+    auto file_provider = std::make_shared<FileProvider>(std::make_shared<MockKeyManager>(true), true);
+    return std::make_shared<ParallelMergeSortingBlockInputStream>(
+        inputs,
+        nullptr,
+        description,
+        128,
+        max_bytes_before_external_sort,
+        tmp_path,
+        CompressionSettings(),
+        file_provider,
+        inputs.size(),
+        "");
+}
+
+/// Sort `block` by a single thread as the expected result, and check that `stream` outputs the same rows.
+void checkSortedLike(IBlockInputStream & stream, Block block, const SortDescription & description)
+{
+    sortBlock(block, description);
+    size_t row = 0;
+    stream.readPrefix();
+    while (Block res = stream.read())
+    {
+        ASSERT_EQ(res.columns(), block.columns());
+        ASSERT_LE(row + res.rows(), block.rows());
+        for (const auto & expected : block)
+        {
+            const auto & column = res.getByName(expected.name).column;
+            ASSERT_EQ(column->isColumnConst(), expected.column->isColumnConst()) << "column: " << expected.name;
+            for (size_t i = 0; i < res.rows(); ++i)
+                ASSERT_EQ((*column)[i], (*expected.column)[row + i]) << "column: " << expected.name << ", row: " << row + i;
+        }
+        row += res.rows();
+    }
+    stream.readSuffix();
+    ASSERT_EQ(row, block.rows());
+}
+} // namespace
+
+TEST(ParallelMergeSortingBlockInputStreamTest, SortByRanges)
+try
+{
+    const size_t num_rows = 20000;
+    const size_t num_inputs = 4;
+    std::mt19937_64 rng(42);
+    // Lots of ties in a, which are ordered by b descending.
+    std::uniform_int_distribution<Int64> dist(-500, 500);
+    std::vector<Row> rows(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        rows[i] = Row{dist(rng), static_cast<Int64>(i)};
+
+    auto expected = rows;
+    std::sort(expected.begin(), expected.end(), [](const Row & lhs, const Row & rhs) {
+        return lhs.a != rhs.a ? lhs.a < rhs.a : lhs.b > rhs.b;
+    });
+
+    const String tmp_path = TiFlashTestEnv::getTemporaryPath("ParallelMergeSortingBlockInputStreamTest/");
+    TiFlashTestEnv::tryRemovePath(tmp_path);
+    Poco::File(tmp_path).createDirectories();
+    auto file_provider = std::make_shared<FileProvider>(std::make_shared<MockKeyManager>(true), true);
+
+    SortDescription description{SortColumnDescription("a", 1, 1), SortColumnDescription("b", -1, 1)};
+    // Without spilling, and spilling some runs of every thread.
+    for (size_t max_bytes_before_external_sort : {0, 64 * 1024})
+    {
+        SCOPED_TRACE(fmt::format("max_bytes_before_external_sort: {}", max_bytes_before_external_sort));
+        BlockInputStreams inputs;
+        for (size_t i = 0; i < num_inputs; ++i)
+        {
+            auto blocks = toSortedBlocks(rows, i * num_rows / num_inputs, (i + 1) * num_rows / num_inputs, 100, description);
+            inputs.push_back(std::make_shared<BlocksListBlockInputStream>(std::move(blocks)));
+        }
+        ParallelMergeSortingBlockInputStream stream(
+            inputs,
+            nullptr,
+            description,
+            128,
+            max_bytes_before_external_sort,
+            tmp_path,
+            CompressionSettings(),
+            file_provider,
+            num_inputs,
+            "");
+
+        std::vector<Row> result;
+        stream.readPrefix();
+        while (Block block = stream.read())
+        {
+            ASSERT_LE(block.rows(), 128);
+            const auto & a = block.getByName("a").column;
+            const auto & b = block.getByName("b").column;
+            for (size_t i = 0; i < block.rows(); ++i)
+                result.push_back(Row{a->getInt(i), b->getInt(i)});
+        }
+        stream.readSuffix();
+
+        ASSERT_EQ(result.size(), expected.size());
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            ASSERT_EQ(result[i].a, expected[i].a) << "row: " << i;
+            ASSERT_EQ(result[i].b, expected[i].b) << "row: " << i;
+        }
+    }
+}
+CATCH
+
+TEST(ParallelMergeSortingBlockInputStreamTest, SortNullableCollatedStrings)
+try
+{
+    const size_t num_rows = 20000;
+    std::mt19937_64 rng(42);
+    // Strings equal under the case insensitive collation, which are ordered by b descending.
+    const std::vector<String> values{"", "a", "A", "b", "B", "ab", "aB", "Ab", "ba", "BA", "中", "中文"};
+    std::uniform_int_distribution<size_t> dist(0, values.size());
+    std::vector<std::optional<String>> s;
+    std::vector<Int64> b;
+    for (size_t i = 0; i < num_rows; ++i)
+    {
+        size_t index = dist(rng);
+        s.push_back(index == values.size() ? std::nullopt : std::make_optional(values[index]));
+        b.push_back(i);
+    }
+    Block block{createColumn<Nullable<String>>(s, "s"), createColumn<Int64>(b, "b")};
+
+    auto collator = TiDB::ITiDBCollator::getCollator(TiDB::ITiDBCollator::UTF8MB4_GENERAL_CI);
+    for (int nulls_direction : {1, -1})
+    {
+        SortDescription description{SortColumnDescription("s", 1, nulls_direction, collator), SortColumnDescription("b", -1, 1)};
+        for (size_t max_bytes_before_external_sort : {0, 64 * 1024})
+        {
+            SCOPED_TRACE(fmt::format("nulls_direction: {}, max_bytes_before_external_sort: {}", nulls_direction, max_bytes_before_external_sort));
+            auto stream = createSortingStream(toSortedInputs(block, 4, 100, description), description, max_bytes_before_external_sort);
+            checkSortedLike(*stream, block, description);
+        }
+    }
+}
+CATCH
+
+TEST(ParallelMergeSortingBlockInputStreamTest, SortWithConstantColumns)
+try
+{
+    const size_t num_rows = 20000;
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<Int64> dist(-500, 500);
+    std::vector<Int64> a, b;
+    for (size_t i = 0; i < num_rows; ++i)
+    {
+        a.push_back(dist(rng));
+        b.push_back(i);
+    }
+    // The constant columns are removed before sorting and restored at their positions for the output.
+    Block block{
+        createConstColumn<Int64>(num_rows, 7, "c"),
+        createColumn<Int64>(a, "a"),
+        createConstColumn<String>(num_rows, "const", "d"),
+        createColumn<Int64>(b, "b")};
+
+    SortDescription description{SortColumnDescription("c", 1, 1), SortColumnDescription("a", -1, 1), SortColumnDescription("d", 1, 1), SortColumnDescription("b", 1, 1)};
+    for (size_t max_bytes_before_external_sort : {0, 64 * 1024})
+    {
+        SCOPED_TRACE(fmt::format("max_bytes_before_external_sort: {}", max_bytes_before_external_sort));
+        auto stream = createSortingStream(toSortedInputs(block, 4, 100, description), description, max_bytes_before_external_sort);
+        checkSortedLike(*stream, block, description);
+    }
+
+    // Only sorted by the constant columns, the rows are output in a single range.
+    SortDescription const_description{SortColumnDescription("c", 1, 1), SortColumnDescription("d", 1, 1)};
+    auto stream = createSortingStream(toSortedInputs(block, 4, 100, const_description), const_description, 0);
+    size_t rows = 0;
+    stream->readPrefix();
+    while (Block res = stream->read())
+    {
+        ASSERT_TRUE(res.getByName("c").column->isColumnConst());
+        ASSERT_EQ(res.getByName("c").column->getInt(0), 7);
+        rows += res.rows();
+    }
+    stream->readSuffix();
+    ASSERT_EQ(rows, num_rows);
+}
+CATCH
+
+TEST(ParallelMergeSortingBlockInputStreamTest, CancelDuringRangeMerges)
+try
+{
+    const size_t num_rows = 20000;
+    std::vector<Int64> a;
+    for (size_t i = 0; i < num_rows; ++i)
+        a.push_back((i * 7919) % num_rows);
+    Block block{createColumn<Int64>(a, "a")};
+    SortDescription description{SortColumnDescription("a", 1, 1)};
+
+    for (size_t max_bytes_before_external_sort : {0, 64 * 1024})
+    {
+        SCOPED_TRACE(fmt::format("max_bytes_before_external_sort: {}", max_bytes_before_external_sort));
+        auto stream = createSortingStream(toSortedInputs(block, 4, 100, description), description, max_bytes_before_external_sort);
+        stream->readPrefix();
+        Block res = stream->read();
+        ASSERT_TRUE(res);
+        ASSERT_EQ(res.getByName("a").column->getInt(0), 0);
+
+        // The merging of the later ranges may be waiting for their full outputs, they must stop on cancel.
+        stream->cancel(false);
+        ASSERT_FALSE(stream->read());
+        stream->readSuffix();
+        stream.reset();
+    }
+}
+CATCH
+
+TEST(ParallelMergeSortingBlockInputStreamTest, ExceptionDuringRangeMerges)
+try
+{
+    const size_t num_rows = 20000;
+    std::vector<Int64> a;
+    for (size_t i = 0; i < num_rows; ++i)
+        a.push_back((i * 7919) % num_rows);
+    Block block{createColumn<Int64>(a, "a")};
+    SortDescription description{SortColumnDescription("a", 1, 1)};
+
+    for (size_t max_bytes_before_external_sort : {0, 64 * 1024})
+    {
+        SCOPED_TRACE(fmt::format("max_bytes_before_external_sort: {}", max_bytes_before_external_sort));
+        FailPointHelper::enableFailPoint(FailPoints::exception_during_parallel_merge_sort_range);
+        SCOPE_EXIT({ FailPointHelper::disableFailPoint(FailPoints::exception_during_parallel_merge_sort_range); });
+
+        // The exception of any range is thrown by the output, rather than ending the output early.
+        auto stream = createSortingStream(toSortedInputs(block, 4, 100, description), description, max_bytes_before_external_sort);
+        size_t rows = 0;
+        try
+        {
+            stream->readPrefix();
+            while (Block res = stream->read())
+                rows += res.rows();
+            FAIL() << "The exception is lost, output rows: " << rows;
+        }
+        catch (const Exception & e)
+        {
+            ASSERT_EQ(e.code(), ErrorCodes::FAIL_POINT_ERROR);
+        }
+        ASSERT_LT(rows, num_rows);
+        stream.reset();
+    }
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
@@ -0,0 +1,157 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <DataStreams/BlocksListBlockInputStream.h>
+#include <DataStreams/TopNBlockInputStream.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <algorithm>
+#include <random>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+struct Row
+{
+    Int64 a;
+    Int64 b;
+};
+
+/// Split the rows into blocks of (a, b).
+BlocksList toBlocks(const std::vector<Row> & rows, size_t block_rows)
+{
+    BlocksList blocks;
+    for (size_t begin = 0; begin < rows.size(); begin += block_rows)
+    {
+        std::vector<Int64> a, b;
+        for (size_t i = begin; i < std::min(rows.size(), begin + block_rows); ++i)
+        {
+            a.push_back(rows[i].a);
+            b.push_back(rows[i].b);
+        }
+        blocks.push_back(Block{createColumn<Int64>(a, "a"), createColumn<Int64>(b, "b")});
+    }
+    return blocks;
+}
+
+std::vector<Row> readAll(TopNBlockInputStream & stream)
+{
+    std::vector<Row> rows;
+    stream.readPrefix();
+    while (Block block = stream.read())
+    {
+        const auto & a = block.getByName("a").column;
+        const auto & b = block.getByName("b").column;
+        for (size_t i = 0; i < block.rows(); ++i)
+            rows.push_back(Row{a->getInt(i), b->getInt(i)});
+    }
+    stream.readSuffix();
+    return rows;
+}
+
+std::vector<Row> prepareRows(size_t num_rows, Int64 max_value)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<Int64> dist(-max_value, max_value);
+    std::vector<Row> rows(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        rows[i] = Row{dist(rng), static_cast<Int64>(i)};
+    return rows;
+}
+} // namespace
+
+TEST(TopNBlockInputStreamTest, OrderByOneColumn)
+try
+{
+    auto rows = prepareRows(2000, 1000000);
+    for (bool is_desc : {false, true})
+    {
+        for (size_t limit : {1, 10, 300, 5000})
+        {
+            SCOPED_TRACE(fmt::format("desc: {}, limit: {}", is_desc, limit));
+            auto threshold = std::make_shared<DM::TopNThreshold>(1, is_desc, false);
+            SortDescription description{SortColumnDescription("a", is_desc ? -1 : 1, 1)};
+            TopNBlockInputStream stream(std::make_shared<BlocksListBlockInputStream>(toBlocks(rows, 128)), description, limit, threshold, "");
+            auto result = readAll(stream);
+
+            auto expected = rows;
+            std::sort(expected.begin(), expected.end(), [&](const Row & lhs, const Row & rhs) {
+                return is_desc ? lhs.a > rhs.a : lhs.a < rhs.a;
+            });
+            expected.resize(std::min(limit, expected.size()));
+            ASSERT_EQ(result.size(), expected.size());
+            for (size_t i = 0; i < result.size(); ++i)
+                ASSERT_EQ(result[i].a, expected[i].a) << "row: " << i;
+
+            // The threshold is the last row of the result, only if there are `limit` rows.
+            Int64 value = 0;
+            ASSERT_EQ(threshold->get(value), limit <= rows.size());
+            if (limit <= rows.size())
+                ASSERT_EQ(value, expected.back().a);
+        }
+    }
+}
+CATCH
+
+TEST(TopNBlockInputStreamTest, OrderByMultipleColumns)
+try
+{
+    // Lots of ties in a, which are ordered by b descending.
+    auto rows = prepareRows(3000, 20);
+    const size_t limit = 100;
+    SortDescription description{SortColumnDescription("a", 1, 1), SortColumnDescription("b", -1, 1)};
+    TopNBlockInputStream stream(std::make_shared<BlocksListBlockInputStream>(toBlocks(rows, 100)), description, limit, nullptr, "");
+    auto result = readAll(stream);
+
+    auto expected = rows;
+    std::sort(expected.begin(), expected.end(), [](const Row & lhs, const Row & rhs) {
+        return lhs.a != rhs.a ? lhs.a < rhs.a : lhs.b > rhs.b;
+    });
+    expected.resize(limit);
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        ASSERT_EQ(result[i].a, expected[i].a) << "row: " << i;
+        ASSERT_EQ(result[i].b, expected[i].b) << "row: " << i;
+    }
+}
+CATCH
+
+TEST(TopNThresholdTest, KeepTightest)
+{
+    DM::TopNThreshold asc(1, false, false);
+    Int64 value = 0;
+    ASSERT_FALSE(asc.get(value));
+    ASSERT_FALSE(asc.canSkip(100, 200));
+    asc.publish(50);
+    asc.publish(80);
+    ASSERT_TRUE(asc.get(value));
+    ASSERT_EQ(value, 50);
+    ASSERT_TRUE(asc.canSkip(51, 200));
+    ASSERT_FALSE(asc.canSkip(50, 200));
+
+    DM::TopNThreshold desc(1, true, true);
+    desc.publish(10);
+    desc.publish(static_cast<Int64>(std::numeric_limits<UInt64>::max() - 1));
+    ASSERT_TRUE(desc.get(value));
+    ASSERT_EQ(static_cast<UInt64>(value), std::numeric_limits<UInt64>::max() - 1);
+    ASSERT_TRUE(desc.canSkip(0, 100));
+    ASSERT_FALSE(desc.canSkip(0, static_cast<Int64>(std::numeric_limits<UInt64>::max())));
+}
+
+} // namespace tests
+} // namespace DB
@@ -290,7 +290,10 @@ BlockInputStreamPtr executeQuery(Context & context, RegionID region_id, const DA
                 tipb_exchange_receiver.encoded_task_meta_size(),
                 10,
                 /*req_id=*/"",
-                /*executor_id=*/"");
+                /*executor_id=*/"",
+                context.getSettingsRef().max_exchange_receiver_queue_bytes,
+                context.getSettingsRef().exchange_receiver_decode_concurrency,
+                context.getSettingsRef().max_block_size);
         BlockInputStreamPtr ret = std::make_shared<ExchangeReceiverInputStream>(exchange_receiver, /*req_id=*/"", /*executor_id=*/"");
         return ret;
     }
@@ -81,6 +81,15 @@ CompressedReadBufferFromFileProvider<has_checksum>::CompressedReadBufferFromFile
     this->compressed_in = &file_in;
 }
 
+template <bool has_checksum>
+CompressedReadBufferFromFileProvider<has_checksum>::CompressedReadBufferFromFileProvider(std::unique_ptr<ReadBufferFromFileBase> file_in_)
+    : CompressedSeekableReaderBuffer()
+    , p_file_in(std::move(file_in_))
+    , file_in(*p_file_in)
+{
+    this->compressed_in = &file_in;
+}
+
 template <bool has_checksum>
 void CompressedReadBufferFromFileProvider<has_checksum>::seek(size_t offset_in_compressed_file, size_t offset_in_decompressed_block)
 {
@@ -83,6 +83,9 @@ public:
         ChecksumAlgo checksum_algorithm,
         size_t checksum_frame_size);
 
+    /// Read the compressed data from `file_in_`, which is created by the caller.
+    explicit CompressedReadBufferFromFileProvider(std::unique_ptr<ReadBufferFromFileBase> file_in_);
+
     void seek(size_t offset_in_compressed_file, size_t offset_in_decompressed_block) override;
 
     size_t readBig(char * to, size_t n) override;
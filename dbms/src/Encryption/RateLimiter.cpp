@@ -413,6 +413,12 @@ WriteLimiterPtr IORateLimiter::getWriteLimiter()
     return is_background_thread ? bg_write_limiter : fg_write_limiter;
 }
 
+UInt64 IORateLimiter::getBgWriteMaxBytesPerSec()
+{
+    std::lock_guard lock(mtx_);
+    return io_config.getBgWriteMaxBytesPerSec();
+}
+
 ReadLimiterPtr IORateLimiter::getReadLimiter()
 {
     std::lock_guard lock(mtx_);
@@ -207,6 +207,9 @@ public:
 
     void setBackgroundThreadIds(std::vector<pid_t> thread_ids);
 
+    // Returns the configured max bytes per second of background write, 0 means unlimited.
+    UInt64 getBgWriteMaxBytesPerSec();
+
     void setStop();
 
     struct IOInfo
@@ -48,6 +48,17 @@ ReadBufferFromFileProvider::ReadBufferFromFileProvider(
     fd = file->getFd();
 }
 
+ReadBufferFromFileProvider::ReadBufferFromFileProvider(
+    const RandomAccessFilePtr & file_,
+    size_t buf_size,
+    char * existing_memory,
+    size_t alignment)
+    : ReadBufferFromFileDescriptor(-1, buf_size, existing_memory, alignment)
+    , file(file_)
+{
+    fd = file->getFd();
+}
+
 void ReadBufferFromFileProvider::close()
 {
     file->close();
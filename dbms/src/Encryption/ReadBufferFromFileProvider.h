@@ -43,6 +43,13 @@ public:
         char * existing_memory = nullptr,
         size_t alignment = 0);
 
+    /// Read from an opened file, e.g. a file wrapped for direct reading.
+    explicit ReadBufferFromFileProvider(
+        const RandomAccessFilePtr & file_,
+        size_t buf_size = DBMS_DEFAULT_BUFFER_SIZE,
+        char * existing_memory = nullptr,
+        size_t alignment = 0);
+
     ReadBufferFromFileProvider(ReadBufferFromFileProvider &&) = default;
 
     ~ReadBufferFromFileProvider() override;
@@ -75,8 +75,18 @@ createReadBufferFromFileBaseByFileProvider(
     size_t checksum_frame_size,
     int flags_)
 {
-    ProfileEvents::increment(ProfileEvents::CreatedReadBufferOrdinary);
     auto file = file_provider->newRandomAccessFile(filename_, encryption_path_, read_limiter, flags_);
+    return createReadBufferFromFileBaseByFileProvider(file, estimated_size, checksum_algorithm, checksum_frame_size);
+}
+
+std::unique_ptr<ReadBufferFromFileBase>
+createReadBufferFromFileBaseByFileProvider(
+    const RandomAccessFilePtr & file,
+    size_t estimated_size,
+    ChecksumAlgo checksum_algorithm,
+    size_t checksum_frame_size)
+{
+    ProfileEvents::increment(ProfileEvents::CreatedReadBufferOrdinary);
     auto allocation_size = std::min(estimated_size, checksum_frame_size);
     switch (checksum_algorithm)
     {
@@ -59,4 +59,12 @@ createReadBufferFromFileBaseByFileProvider(
     ChecksumAlgo checksum_algorithm,
     size_t checksum_frame_size,
     int flags_ = -1);
+
+/// Same as above, but read from an opened file.
+std::unique_ptr<ReadBufferFromFileBase>
+createReadBufferFromFileBaseByFileProvider(
+    const RandomAccessFilePtr & file,
+    size_t estimated_size,
+    ChecksumAlgo checksum_algorithm,
+    size_t checksum_frame_size);
 } // namespace DB
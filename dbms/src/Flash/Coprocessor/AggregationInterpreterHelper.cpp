@@ -98,7 +98,9 @@ Aggregator::Params buildParams(
         settings.max_bytes_before_external_group_by,
         !is_final_agg,
         context.getTemporaryPath(),
-        has_collator ? collators : TiDB::dummy_collators);
+        has_collator ? collators : TiDB::dummy_collators,
+        settings.hash_table_prefetch_distance,
+        settings.hash_table_prefetch_min_bytes);
 }
 
 void fillArgColumnNumbers(AggregateDescriptions & aggregate_descriptions, const Block & before_agg_header)
@@ -11,7 +11,6 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
-
 #include <Columns/ColumnDecimal.h>
 #include <Columns/ColumnNullable.h>
 #include <Columns/ColumnString.h>
@@ -28,6 +27,7 @@
 #include <Flash/Coprocessor/DAGUtils.h>
 #include <Functions/FunctionHelpers.h>
 #include <IO/Endian.h>
+#include <common/unaligned.h>
 
 namespace DB
 {
@@ -46,25 +46,91 @@ const IColumn * getNestedCol(const IColumn * flash_col)
         return flash_col;
 }
 
-template <typename T>
-void decimalToVector(T value, std::vector<Int32> & vec, UInt32 scale)
+/// Return the null map since row `start_index`, or nullptr if the column is not nullable.
+const UInt8 * getNullMap(const IColumn * flash_col, size_t start_index)
+{
+    if (flash_col->isColumnNullable())
+        return static_cast<const ColumnNullable *>(flash_col)->getNullMapData().data() + start_index;
+    else
+        return nullptr;
+}
+
+/// Encode the values of rows in [start_index, end_index) into `dag_column` at a time, every value is converted
+/// to the fixed-size `ChunkType` by `convert`. The values of null rows are encoded as zero.
+template <typename ChunkType, typename T, typename Convert>
+void encodeFixedValues(
+    TiDBColumn & dag_column,
+    const IColumn * flash_col_untyped,
+    const PaddedPODArray<T> & values,
+    size_t start_index,
+    size_t end_index,
+    Convert && convert)
 {
-    if (value < 0)
+    size_t num = end_index - start_index;
+    const UInt8 * null_map = getNullMap(flash_col_untyped, start_index);
+    char * pos = dag_column.appendFixedValues(num, sizeof(ChunkType), null_map);
+    const T * data = values.data() + start_index;
+    if (null_map)
     {
-        value = -value;
+        for (size_t i = 0; i < num; ++i)
+            unalignedStore<ChunkType>(pos + i * sizeof(ChunkType), toLittleEndian(null_map[i] ? ChunkType(0) : convert(data[i])));
     }
-    while (value != 0)
+    else
     {
-        vec.push_back(static_cast<Int32>(value % 10));
-        value = value / 10;
+        for (size_t i = 0; i < num; ++i)
+            unalignedStore<ChunkType>(pos + i * sizeof(ChunkType), toLittleEndian(convert(data[i])));
     }
-    while (vec.size() < scale)
+}
+
+/// Encode the decimal into `pos` in the chunk format of TiDB, which is the same as encoding `TiDBDecimal`, but the words
+/// are split from the value directly instead of from its digits one by one.
+template <typename T>
+void encodeDecimal(const T & dec, UInt32 scale, typename T::NativeType scale_multiplier, char * pos)
+{
+    using NativeType = typename T::NativeType;
+    const NativeType word_max = 1000000000;
+
+    NativeType value = dec.value < 0 ? NativeType(-dec.value) : dec.value;
+    NativeType int_part = value / scale_multiplier;
+    NativeType frac_part = value % scale_multiplier;
+
+    Int32 word_buf[MAX_WORD_BUF_LEN] = {0};
+    Int32 int_words[MAX_WORD_BUF_LEN];
+    int word_int = 0;
+    for (; int_part != 0; int_part /= word_max)
+        int_words[word_int++] = static_cast<Int32>(int_part % word_max);
+    int digits_int = 0;
+    if (word_int > 0)
     {
-        vec.push_back(0);
+        digits_int = (word_int - 1) * DIGITS_PER_WORD;
+        for (Int32 top = int_words[word_int - 1]; top != 0; top /= 10)
+            ++digits_int;
     }
+    // The words of integer part are ordered from the most significant one.
+    for (int i = 0; i < word_int; ++i)
+        word_buf[i] = int_words[word_int - 1 - i];
+
+    // The tailing digits of fraction part are stored as the most significant digits of the last word.
+    int word_frac = scale / DIGITS_PER_WORD;
+    int tailing_digit = scale % DIGITS_PER_WORD;
+    if (tailing_digit > 0)
+    {
+        word_buf[word_int + word_frac] = static_cast<Int32>(frac_part % POWERS10[tailing_digit]) * POWERS10[DIGITS_PER_WORD - tailing_digit];
+        frac_part /= POWERS10[tailing_digit];
+    }
+    for (int i = word_frac - 1; i >= 0; --i, frac_part /= word_max)
+        word_buf[word_int + i] = static_cast<Int32>(frac_part % word_max);
+
+    // A zero decimal without fraction has no digits at all.
+    pos[0] = static_cast<UInt8>(digits_int);
+    pos[1] = static_cast<UInt8>(scale);
+    pos[2] = static_cast<UInt8>(scale);
+    pos[3] = static_cast<UInt8>(dec.value < 0);
+    for (int i = 0; i < MAX_WORD_BUF_LEN; ++i)
+        unalignedStore<Int32>(pos + 4 + i * sizeof(Int32), toLittleEndian(word_buf[i]));
 }
 
-template <typename T, bool is_nullable>
+template <typename T>
 bool flashDecimalColToArrowColInternal(
     TiDBColumn & dag_column,
     const IColumn * flash_col_untyped,
@@ -78,29 +144,25 @@ bool flashDecimalColToArrowColInternal(
         const ColumnDecimal<T> * flash_col = checkAndGetColumn<ColumnDecimal<T>>(nested_col);
         const DataTypeDecimal<T> * type = checkAndGetDataType<DataTypeDecimal<T>>(data_type);
         UInt32 scale = type->getScale();
-        for (size_t i = start_index; i < end_index; i++)
+        auto scale_multiplier = getScaleMultiplier<T>(scale);
+
+        constexpr size_t decimal_size = 4 + MAX_WORD_BUF_LEN * sizeof(Int32);
+        size_t num = end_index - start_index;
+        const UInt8 * null_map = getNullMap(flash_col_untyped, start_index);
+        char * pos = dag_column.appendFixedValues(num, decimal_size, null_map);
+        const auto & data = flash_col->getData();
+        for (size_t i = 0; i < num; ++i, pos += decimal_size)
         {
-            if constexpr (is_nullable)
-            {
-                if (flash_col_untyped->isNullAt(i))
-                {
-                    dag_column.appendNull();
-                    continue;
-                }
-            }
-            const T & dec = flash_col->getElement(i);
-            std::vector<Int32> digits;
-            digits.reserve(type->getPrec());
-            decimalToVector<typename T::NativeType>(dec.value, digits, scale);
-            TiDBDecimal tiDecimal(scale, digits, dec.value < 0);
-            dag_column.append(tiDecimal);
+            if (null_map && null_map[i])
+                memset(pos, 0, decimal_size);
+            else
+                encodeDecimal(data[start_index + i], scale, scale_multiplier, pos);
         }
         return true;
     }
     return false;
 }
 
-template <bool is_nullable>
 void flashDecimalColToArrowCol(
     TiDBColumn & dag_column,
     const IColumn * flash_col_untyped,
@@ -108,60 +170,43 @@ void flashDecimalColToArrowCol(
     size_t end_index,
     const IDataType * data_type)
 {
-    if (!(flashDecimalColToArrowColInternal<Decimal32, is_nullable>(dag_column, flash_col_untyped, start_index, end_index, data_type)
-          || flashDecimalColToArrowColInternal<Decimal64, is_nullable>(dag_column, flash_col_untyped, start_index, end_index, data_type)
-          || flashDecimalColToArrowColInternal<Decimal128, is_nullable>(dag_column, flash_col_untyped, start_index, end_index, data_type)
-          || flashDecimalColToArrowColInternal<Decimal256, is_nullable>(dag_column, flash_col_untyped, start_index, end_index, data_type)))
+    if (!(flashDecimalColToArrowColInternal<Decimal32>(dag_column, flash_col_untyped, start_index, end_index, data_type)
+          || flashDecimalColToArrowColInternal<Decimal64>(dag_column, flash_col_untyped, start_index, end_index, data_type)
+          || flashDecimalColToArrowColInternal<Decimal128>(dag_column, flash_col_untyped, start_index, end_index, data_type)
+          || flashDecimalColToArrowColInternal<Decimal256>(dag_column, flash_col_untyped, start_index, end_index, data_type)))
         throw TiFlashException(
             "Error while trying to convert flash col to DAG col, column name " + flash_col_untyped->getName(),
             Errors::Coprocessor::Internal);
 }
 
-template <typename T, bool is_nullable>
+template <typename T>
 bool flashIntegerColToArrowColInternal(TiDBColumn & dag_column, const IColumn * flash_col_untyped, size_t start_index, size_t end_index)
 {
     const IColumn * nested_col = getNestedCol(flash_col_untyped);
     if (const ColumnVector<T> * flash_col = checkAndGetColumn<ColumnVector<T>>(nested_col))
     {
-        constexpr bool is_unsigned = std::is_unsigned_v<T>;
-        for (size_t i = start_index; i < end_index; i++)
-        {
-            if constexpr (is_nullable)
-            {
-                if (flash_col_untyped->isNullAt(i))
-                {
-                    dag_column.appendNull();
-                    continue;
-                }
-            }
-            if constexpr (is_unsigned)
-                dag_column.append((UInt64)flash_col->getElement(i));
-            else
-                dag_column.append((Int64)flash_col->getElement(i));
-        }
+        using ChunkType = std::conditional_t<std::is_unsigned_v<T>, UInt64, Int64>;
+        encodeFixedValues<ChunkType>(dag_column, flash_col_untyped, flash_col->getData(), start_index, end_index, [](T value) {
+            return static_cast<ChunkType>(value);
+        });
         return true;
     }
     return false;
 }
 
-template <typename T, bool is_nullable>
+template <typename T>
 void flashDoubleColToArrowCol(TiDBColumn & dag_column, const IColumn * flash_col_untyped, size_t start_index, size_t end_index)
 {
     const IColumn * nested_col = getNestedCol(flash_col_untyped);
     if (const ColumnVector<T> * flash_col = checkAndGetColumn<ColumnVector<T>>(nested_col))
     {
-        for (size_t i = start_index; i < end_index; i++)
-        {
-            if constexpr (is_nullable)
-            {
-                if (flash_col_untyped->isNullAt(i))
-                {
-                    dag_column.appendNull();
-                    continue;
-                }
-            }
-            dag_column.append((T)flash_col->getElement(i));
-        }
+        using ChunkType = std::conditional_t<std::is_same_v<T, Float32>, UInt32, UInt64>;
+        encodeFixedValues<ChunkType>(dag_column, flash_col_untyped, flash_col->getData(), start_index, end_index, [](T value) {
+            // use memcpy to avoid breaking strict-aliasing rules
+            ChunkType u;
+            std::memcpy(&u, &value, sizeof(value));
+            return u;
+        });
         return;
     }
     throw TiFlashException(
@@ -169,24 +214,40 @@ void flashDoubleColToArrowCol(TiDBColumn & dag_column, const IColumn * flash_col
         Errors::Coprocessor::Internal);
 }
 
-template <bool is_nullable>
 void flashIntegerColToArrowCol(TiDBColumn & dag_column, const IColumn * flash_col_untyped, size_t start_index, size_t end_index)
 {
-    if (!(flashIntegerColToArrowColInternal<UInt8, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<UInt16, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<UInt32, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<UInt64, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<Int8, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<Int16, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<Int32, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)
-          || flashIntegerColToArrowColInternal<Int64, is_nullable>(dag_column, flash_col_untyped, start_index, end_index)))
+    if (!(flashIntegerColToArrowColInternal<UInt8>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<UInt16>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<UInt32>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<UInt64>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<Int8>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<Int16>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<Int32>(dag_column, flash_col_untyped, start_index, end_index)
+          || flashIntegerColToArrowColInternal<Int64>(dag_column, flash_col_untyped, start_index, end_index)))
         throw TiFlashException(
             "Error while trying to convert flash col to DAG col, column name " + flash_col_untyped->getName(),
             Errors::Coprocessor::Internal);
 }
 
+/// Convert the packed MyDateTime to the core time of TiDB, which is the same as `MyDateTime(packed).toCoreTime()`.
+inline UInt64 packedToCoreTime(UInt64 packed)
+{
+    UInt64 ymdhms = packed >> 24;
+    UInt64 ymd = ymdhms >> 17;
+    UInt64 ym = ymd >> 5;
+    UInt64 hms = ymdhms & ((1 << 17) - 1);
+
+    UInt64 v = 0;
+    v |= ((packed & ((1 << 24) - 1)) << MyTimeBase::MICROSECOND_BIT_FIELD_OFFSET) & MyTimeBase::MICROSECOND_BIT_FIELD_MASK;
+    v |= ((hms & ((1 << 6) - 1)) << MyTimeBase::SECOND_BIT_FIELD_OFFSET) & MyTimeBase::SECOND_BIT_FIELD_MASK;
+    v |= (((hms >> 6) & ((1 << 6) - 1)) << MyTimeBase::MINUTE_BIT_FIELD_OFFSET) & MyTimeBase::MINUTE_BIT_FIELD_MASK;
+    v |= ((hms >> 12) << MyTimeBase::HOUR_BIT_FIELD_OFFSET) & MyTimeBase::HOUR_BIT_FIELD_MASK;
+    v |= ((ymd & ((1 << 5) - 1)) << MyTimeBase::DAY_BIT_FIELD_OFFSET) & MyTimeBase::DAY_BIT_FIELD_MASK;
+    v |= ((ym % 13) << MyTimeBase::MONTH_BIT_FIELD_OFFSET) & MyTimeBase::MONTH_BIT_FIELD_MASK;
+    v |= ((ym / 13) << MyTimeBase::YEAR_BIT_FIELD_OFFSET) & MyTimeBase::YEAR_BIT_FIELD_MASK;
+    return v;
+}
 
-template <bool is_nullable>
 void flashDateOrDateTimeColToArrowCol(
     TiDBColumn & dag_column,
     const IColumn * flash_col_untyped,
@@ -196,44 +257,43 @@ void flashDateOrDateTimeColToArrowCol(
 {
     const IColumn * nested_col = getNestedCol(flash_col_untyped);
     using DateFieldType = DataTypeMyTimeBase::FieldType;
-    auto * flash_col = checkAndGetColumn<ColumnVector<DateFieldType>>(nested_col);
-    for (size_t i = start_index; i < end_index; i++)
+    const auto * flash_col = checkAndGetColumn<ColumnVector<DateFieldType>>(nested_col);
+    if (!flash_col)
+        throw TiFlashException(
+            "Error while trying to convert flash col to DAG col, column name " + flash_col_untyped->getName(),
+            Errors::Coprocessor::Internal);
+
+    // The fsp and time type of all the values are the same, see `TiDBTime::toChunkTime`.
+    UInt64 fsptt = 0;
+    if (field_type.tp() == TiDB::TypeDate)
     {
-        if constexpr (is_nullable)
-        {
-            if (flash_col_untyped->isNullAt(i))
-            {
-                dag_column.appendNull();
-                continue;
-            }
-        }
-        TiDBTime time = TiDBTime(flash_col->getElement(i), field_type);
-        dag_column.append(time);
+        fsptt = MyTimeBase::FSPTT_FOR_DATE;
     }
+    else
+    {
+        auto fsp = static_cast<Int8>(field_type.decimal());
+        if (fsp > 0)
+            fsptt |= UInt64(fsp) << 1u;
+        if (field_type.tp() == TiDB::TypeTimestamp)
+            fsptt |= 1u;
+    }
+    encodeFixedValues<UInt64>(dag_column, flash_col_untyped, flash_col->getData(), start_index, end_index, [fsptt](DateFieldType packed) {
+        return (packedToCoreTime(packed) & MyTimeBase::CORE_TIME_BIT_FIELD_MASK) | fsptt;
+    });
 }
 
-template <bool is_nullable>
 void flashStringColToArrowCol(TiDBColumn & dag_column, const IColumn * flash_col_untyped, size_t start_index, size_t end_index)
 {
     const IColumn * nested_col = getNestedCol(flash_col_untyped);
     // columnFixedString is not used so do not check it
-    auto * flash_col = checkAndGetColumn<ColumnString>(nested_col);
-    for (size_t i = start_index; i < end_index; i++)
-    {
-        // todo check if we can convert flash_col to DAG col directly since the internal representation is almost the same
-        if constexpr (is_nullable)
-        {
-            if (flash_col_untyped->isNullAt(i))
-            {
-                dag_column.appendNull();
-                continue;
-            }
-        }
-        dag_column.append(flash_col->getDataAt(i));
-    }
+    const auto * flash_col = checkAndGetColumn<ColumnString>(nested_col);
+    if (!flash_col)
+        throw TiFlashException(
+            "Error while trying to convert flash col to DAG col, column name " + flash_col_untyped->getName(),
+            Errors::Coprocessor::Internal);
+    dag_column.appendStrings(*flash_col, start_index, end_index, getNullMap(flash_col_untyped, start_index));
 }
 
-template <bool is_nullable>
 void flashBitColToArrowCol(
     TiDBColumn & dag_column,
     const IColumn * flash_col_untyped,
@@ -243,22 +303,19 @@ void flashBitColToArrowCol(
 {
     const IColumn * nested_col = getNestedCol(flash_col_untyped);
     auto * flash_col = checkAndGetColumn<ColumnVector<UInt64>>(nested_col);
+    const UInt8 * null_map = getNullMap(flash_col_untyped, 0);
     for (size_t i = start_index; i < end_index; i++)
     {
-        if constexpr (is_nullable)
+        if (null_map && null_map[i])
         {
-            if (flash_col_untyped->isNullAt(i))
-            {
-                dag_column.appendNull();
-                continue;
-            }
+            dag_column.appendNull();
+            continue;
         }
         TiDBBit bit(flash_col->getElement(i), field_type.flen() < 0 ? -1 : (field_type.flen() + 7u) >> 3u);
         dag_column.append(bit);
     }
 }
 
-template <bool is_nullable>
 void flashEnumColToArrowCol(
     TiDBColumn & dag_column,
     const IColumn * flash_col_untyped,
@@ -270,15 +327,13 @@ void flashEnumColToArrowCol(
     auto * flash_col = checkAndGetColumn<ColumnVector<DataTypeEnum16::FieldType>>(nested_col);
     const auto * enum_type = checkAndGetDataType<DataTypeEnum16>(data_type);
     size_t enum_value_size = enum_type->getValues().size();
+    const UInt8 * null_map = getNullMap(flash_col_untyped, 0);
     for (size_t i = start_index; i < end_index; i++)
     {
-        if constexpr (is_nullable)
+        if (null_map && null_map[i])
         {
-            if (flash_col_untyped->isNullAt(i))
-            {
-                dag_column.appendNull();
-                continue;
-            }
+            dag_column.appendNull();
+            continue;
         }
         auto enum_value = (UInt64)flash_col->getElement(i);
         if (enum_value == 0 || enum_value > enum_value_size)
@@ -317,30 +372,21 @@ void flashColToArrowCol(TiDBColumn & dag_column, const ColumnWithTypeAndName & f
                 Errors::Coprocessor::Internal);
         if (type->isUnsignedInteger() != tidb_column_info.hasUnsignedFlag())
             throw TiFlashException("Flash column and TiDB column has different unsigned flag", Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashIntegerColToArrowCol<false>(dag_column, col, start_index, end_index);
-        else
-            flashIntegerColToArrowCol<true>(dag_column, col, start_index, end_index);
+        flashIntegerColToArrowCol(dag_column, col, start_index, end_index);
         break;
     case TiDB::TypeFloat:
         if (!checkDataType<DataTypeFloat32>(type))
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is float32 and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashDoubleColToArrowCol<Float32, false>(dag_column, col, start_index, end_index);
-        else
-            flashDoubleColToArrowCol<Float32, true>(dag_column, col, start_index, end_index);
+        flashDoubleColToArrowCol<Float32>(dag_column, col, start_index, end_index);
         break;
     case TiDB::TypeDouble:
         if (!checkDataType<DataTypeFloat64>(type))
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is float64 and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashDoubleColToArrowCol<Float64, false>(dag_column, col, start_index, end_index);
-        else
-            flashDoubleColToArrowCol<Float64, true>(dag_column, col, start_index, end_index);
+        flashDoubleColToArrowCol<Float64>(dag_column, col, start_index, end_index);
         break;
     case TiDB::TypeDate:
     case TiDB::TypeDatetime:
@@ -349,20 +395,14 @@ void flashColToArrowCol(TiDBColumn & dag_column, const ColumnWithTypeAndName & f
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is datetime and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashDateOrDateTimeColToArrowCol<false>(dag_column, col, start_index, end_index, field_type);
-        else
-            flashDateOrDateTimeColToArrowCol<true>(dag_column, col, start_index, end_index, field_type);
+        flashDateOrDateTimeColToArrowCol(dag_column, col, start_index, end_index, field_type);
         break;
     case TiDB::TypeNewDecimal:
         if (!type->isDecimal())
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is datetime and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashDecimalColToArrowCol<false>(dag_column, col, start_index, end_index, type);
-        else
-            flashDecimalColToArrowCol<true>(dag_column, col, start_index, end_index, type);
+        flashDecimalColToArrowCol(dag_column, col, start_index, end_index, type);
         break;
     case TiDB::TypeVarchar:
     case TiDB::TypeVarString:
@@ -376,30 +416,21 @@ void flashColToArrowCol(TiDBColumn & dag_column, const ColumnWithTypeAndName & f
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is string and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashStringColToArrowCol<false>(dag_column, col, start_index, end_index);
-        else
-            flashStringColToArrowCol<true>(dag_column, col, start_index, end_index);
+        flashStringColToArrowCol(dag_column, col, start_index, end_index);
         break;
     case TiDB::TypeBit:
         if (!checkDataType<DataTypeUInt64>(type))
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is bit and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashBitColToArrowCol<false>(dag_column, col, start_index, end_index, field_type);
-        else
-            flashBitColToArrowCol<true>(dag_column, col, start_index, end_index, field_type);
+        flashBitColToArrowCol(dag_column, col, start_index, end_index, field_type);
         break;
     case TiDB::TypeEnum:
         if (!checkDataType<DataTypeEnum16>(type))
             throw TiFlashException(
                 "Type un-matched during arrow encode, target col type is bit and source column type is " + type->getName(),
                 Errors::Coprocessor::Internal);
-        if (tidb_column_info.hasNotNullFlag())
-            flashEnumColToArrowCol<false>(dag_column, col, start_index, end_index, type);
-        else
-            flashEnumColToArrowCol<true>(dag_column, col, start_index, end_index, type);
+        flashEnumColToArrowCol(dag_column, col, start_index, end_index, type);
         break;
     default:
         throw TiFlashException(
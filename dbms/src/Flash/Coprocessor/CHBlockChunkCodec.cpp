@@ -12,20 +12,40 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnString.h>
+#include <Common/HashTable/HashMap.h>
+#include <Common/StringUtils/StringUtils.h>
 #include <Common/TiFlashException.h>
+#include <Common/typeid_cast.h>
 #include <DataStreams/IBlockInputStream.h>
-#include <DataStreams/NativeBlockInputStream.h>
+#include <DataTypes/DataTypeFactory.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <Flash/Coprocessor/CHBlockChunkCodec.h>
 #include <Flash/Coprocessor/DAGUtils.h>
 #include <IO/ReadBufferFromString.h>
 
 namespace DB
 {
+namespace
+{
+constexpr auto dictionary_type_prefix = "LowCardinality(";
+constexpr size_t dictionary_type_prefix_size = std::char_traits<char>::length(dictionary_type_prefix);
+
+/// The codes are UInt16, so a dictionary holds at most 65536 strings.
+constexpr size_t max_dictionary_size = std::numeric_limits<UInt16>::max() + 1;
+
+using DictionaryCodes = PaddedPODArray<UInt16>;
+} // namespace
+
 class CHBlockChunkCodecStream : public ChunkCodecStream
 {
 public:
-    explicit CHBlockChunkCodecStream(const std::vector<tipb::FieldType> & field_types)
+    CHBlockChunkCodecStream(const std::vector<tipb::FieldType> & field_types, bool enable_dictionary_encoding_)
         : ChunkCodecStream(field_types)
+        , enable_dictionary_encoding(enable_dictionary_encoding_)
     {
         for (const auto & field_type : field_types)
         {
@@ -46,6 +66,7 @@ public:
     void encode(const Block & block, size_t start, size_t end) override;
     std::unique_ptr<WriteBufferFromOwnString> output;
     DataTypes expected_types;
+    bool enable_dictionary_encoding;
 };
 
 size_t getExtraInfoSize(const Block & block)
@@ -83,6 +104,120 @@ void writeData(const IDataType & type, const ColumnPtr & column, WriteBuffer & o
     type.serializeBinaryBulkWithMultipleStreams(*full_column, output_stream_getter, offset, limit, false, {});
 }
 
+/// Returns false if the dictionary would be too large to make the encoded data smaller.
+bool encodeByDictionary(const ColumnString & column, MutableColumnPtr & dictionary, DictionaryCodes & codes)
+{
+    size_t rows = column.size();
+    size_t max_size = std::min(max_dictionary_size, rows / 2);
+    const auto & chars = column.getChars();
+
+    HashMap<StringRef, UInt16, StringRefHash> code_map;
+    dictionary = ColumnString::create();
+    codes.resize(rows);
+    size_t dictionary_bytes = 0;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        StringRef value = column.getDataAt(i);
+        HashMap<StringRef, UInt16, StringRefHash>::LookupResult it;
+        bool inserted;
+        code_map.emplace(value, it, inserted);
+        if (inserted)
+        {
+            if (dictionary->size() >= max_size)
+                return false;
+            it->getMapped() = static_cast<UInt16>(dictionary->size());
+            /// the key refers to the chars of `column`, which outlives `code_map`.
+            dictionary->insertData(value.data, value.size);
+            dictionary_bytes += value.size + 1;
+        }
+        codes[i] = it->getMapped();
+    }
+    return dictionary_bytes + rows * sizeof(UInt16) < chars.size();
+}
+
+/// Try to write a String or Nullable(String) column as its dictionary and codes, return false if the column
+/// is not suitable for dictionary encoding and nothing is written.
+bool tryWriteDictionaryEncodedData(const ColumnWithTypeAndName & column, WriteBuffer & ostr)
+{
+    if (column.column->isColumnConst())
+        return false;
+
+    const ColumnString * string_column = nullptr;
+    const ColumnNullable * nullable_column = nullptr;
+    if (column.type->isNullable())
+    {
+        nullable_column = typeid_cast<const ColumnNullable *>(column.column.get());
+        if (nullable_column == nullptr)
+            return false;
+        string_column = typeid_cast<const ColumnString *>(&nullable_column->getNestedColumn());
+    }
+    else
+    {
+        string_column = typeid_cast<const ColumnString *>(column.column.get());
+    }
+    if (string_column == nullptr)
+        return false;
+
+    MutableColumnPtr dictionary;
+    DictionaryCodes codes;
+    if (!encodeByDictionary(*string_column, dictionary, codes))
+        return false;
+
+    writeStringBinary(dictionary_type_prefix + column.type->getName() + ")", ostr);
+    if (nullable_column)
+        DataTypeUInt8().serializeBinaryBulk(nullable_column->getNullMapColumn(), ostr, 0, 0);
+    writeVarUInt(dictionary->size(), ostr);
+    DataTypeString().serializeBinaryBulk(*dictionary, ostr, 0, 0);
+    ostr.write(reinterpret_cast<const char *>(codes.data()), codes.size() * sizeof(UInt16));
+    return true;
+}
+
+ColumnPtr readDictionaryEncodedData(const IDataType & type, ReadBuffer & istr, size_t rows)
+{
+    MutableColumnPtr null_map;
+    if (type.isNullable())
+    {
+        null_map = ColumnUInt8::create();
+        DataTypeUInt8().deserializeBinaryBulk(*null_map, istr, rows, 0);
+    }
+
+    size_t dictionary_size = 0;
+    readVarUInt(dictionary_size, istr);
+    if (dictionary_size > max_dictionary_size)
+        throw Exception(fmt::format("Dictionary size {} exceeds the limit {}", dictionary_size, max_dictionary_size));
+    auto dictionary = ColumnString::create();
+    DataTypeString().deserializeBinaryBulk(*dictionary, istr, dictionary_size, 0);
+
+    DictionaryCodes codes(rows);
+    istr.readStrict(reinterpret_cast<char *>(codes.data()), rows * sizeof(UInt16));
+
+    const auto & dict_chars = dictionary->getChars();
+    const auto & dict_offsets = dictionary->getOffsets();
+    auto column = ColumnString::create();
+    auto & chars = column->getChars();
+    auto & offsets = column->getOffsets();
+    offsets.resize(rows);
+    size_t total_bytes = 0;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (unlikely(codes[i] >= dictionary_size))
+            throw Exception(fmt::format("Dictionary code {} is out of the dictionary size {}", codes[i], dictionary_size));
+        total_bytes += dictionary->sizeAt(codes[i]);
+        offsets[i] = total_bytes;
+    }
+    chars.resize(total_bytes);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        size_t begin = codes[i] == 0 ? 0 : dict_offsets[codes[i] - 1];
+        size_t size = dict_offsets[codes[i]] - begin;
+        memcpy(&chars[offsets[i] - size], &dict_chars[begin], size);
+    }
+
+    if (null_map)
+        return ColumnNullable::create(std::move(column), std::move(null_map));
+    return column;
+}
+
 void CHBlockChunkCodecStream::encode(const Block & block, size_t start, size_t end)
 {
     /// only check block schema in CHBlock codec because for both
@@ -108,6 +243,8 @@ void CHBlockChunkCodecStream::encode(const Block & block, size_t start, size_t e
         const ColumnWithTypeAndName & column = block.safeGetByPosition(i);
 
         writeStringBinary(column.name, *output);
+        if (rows && enable_dictionary_encoding && tryWriteDictionaryEncodedData(column, *output))
+            continue;
         writeStringBinary(column.type->getName(), *output);
 
         if (rows)
@@ -117,8 +254,75 @@ void CHBlockChunkCodecStream::encode(const Block & block, size_t start, size_t e
 
 std::unique_ptr<ChunkCodecStream> CHBlockChunkCodec::newCodecStream(const std::vector<tipb::FieldType> & field_types)
 {
-    return std::make_unique<CHBlockChunkCodecStream>(field_types);
+    return std::make_unique<CHBlockChunkCodecStream>(field_types, enable_dictionary_encoding);
+}
+
+namespace
+{
+/// Same as `NativeBlockInputStream` with server_revision = 0, besides the dictionary encoded columns.
+/// If `header` is not empty, the names of columns are aligned with it and the types are checked with it.
+Block decodeBlock(ReadBuffer & istr, const Block & header, const std::vector<String> & output_names)
+{
+    size_t columns = 0;
+    size_t rows = 0;
+    readVarUInt(columns, istr);
+    readVarUInt(rows, istr);
+
+    size_t expected_columns = header ? header.columns() : output_names.size();
+    if ((header || !output_names.empty()) && columns != expected_columns)
+        throw Exception(fmt::format("Input column size {} is not equal to the expected column size {}", columns, expected_columns));
+
+    Block res;
+    for (size_t i = 0; i < columns; ++i)
+    {
+        ColumnWithTypeAndName column;
+        readBinary(column.name, istr);
+        if (header)
+            column.name = header.getByPosition(i).name;
+        else if (!output_names.empty())
+            column.name = output_names[i];
+
+        String type_name;
+        readBinary(type_name, istr);
+        bool is_dictionary_encoded = startsWith(type_name, dictionary_type_prefix) && endsWith(type_name, ")");
+        if (is_dictionary_encoded)
+            type_name = type_name.substr(dictionary_type_prefix_size, type_name.size() - dictionary_type_prefix_size - 1);
+
+        if (header)
+        {
+            const auto & header_type = header.getByPosition(i).type;
+            if (header_type->getName() != type_name)
+                throw Exception(fmt::format("Type of column {} mismatch, expected: {}, actual: {}", i, header_type->getName(), type_name));
+            column.type = header_type;
+        }
+        else
+        {
+            column.type = DataTypeFactory::instance().get(type_name);
+        }
+
+        if (is_dictionary_encoded)
+        {
+            column.column = readDictionaryEncodedData(*column.type, istr, rows);
+        }
+        else
+        {
+            MutableColumnPtr read_column = column.type->createColumn();
+            if (rows)
+            {
+                IDataType::InputStreamGetter input_stream_getter = [&](const IDataType::SubstreamPath &) {
+                    return &istr;
+                };
+                column.type->deserializeBinaryBulkWithMultipleStreams(*read_column, input_stream_getter, rows, 0, false, {});
+            }
+            if (read_column->size() != rows)
+                throw Exception(fmt::format("Cannot read all data of column {}, expected rows: {}, actual rows: {}", i, rows, read_column->size()));
+            column.column = std::move(read_column);
+        }
+        res.insert(std::move(column));
+    }
+    return res;
 }
+} // namespace
 
 Block CHBlockChunkCodec::decode(const String & str, const DAGSchema & schema)
 {
@@ -126,15 +330,13 @@ Block CHBlockChunkCodec::decode(const String & str, const DAGSchema & schema)
     std::vector<String> output_names;
     for (const auto & c : schema)
         output_names.push_back(c.first);
-    NativeBlockInputStream block_in(read_buffer, 0, std::move(output_names));
-    return block_in.read();
+    return decodeBlock(read_buffer, Block{}, output_names);
 }
 
 Block CHBlockChunkCodec::decode(const String & str, const Block & header)
 {
     ReadBufferFromString read_buffer(str);
-    NativeBlockInputStream block_in(read_buffer, header, 0, /*align_column_name_with_header=*/true);
-    return block_in.read();
+    return decodeBlock(read_buffer, header, {});
 }
 
 } // namespace DB
@@ -18,13 +18,23 @@
 
 namespace DB
 {
+/// Besides the native format, a String or Nullable(String) column with low cardinality can be encoded
+/// as a dictionary and the codes of its rows when `enable_dictionary_encoding` is on, the type name of
+/// such a column is wrapped by `LowCardinality()` in the chunk. It only compresses the exchanged chunks:
+/// every chunk carries its own dictionary, and decoding materializes the column back to the plain one.
 class CHBlockChunkCodec : public ChunkCodec
 {
 public:
     CHBlockChunkCodec() = default;
+    explicit CHBlockChunkCodec(bool enable_dictionary_encoding_)
+        : enable_dictionary_encoding(enable_dictionary_encoding_)
+    {}
     Block decode(const String &, const DAGSchema & schema) override;
     static Block decode(const String &, const Block & header);
     std::unique_ptr<ChunkCodecStream> newCodecStream(const std::vector<tipb::FieldType> & field_types) override;
+
+private:
+    bool enable_dictionary_encoding = false;
 };
 
 } // namespace DB
@@ -228,7 +228,10 @@ void DAGContext::initExchangeReceiverIfMPP(Context & context, size_t max_streams
                     executor.exchange_receiver().encoded_task_meta_size(),
                     max_streams,
                     log->identifier(),
-                    executor_id);
+                    executor_id,
+                    context.getSettingsRef().max_exchange_receiver_queue_bytes,
+                    context.getSettingsRef().exchange_receiver_decode_concurrency,
+                    context.getSettingsRef().max_block_size);
                 mpp_exchange_receiver_map[executor_id] = exchange_receiver;
                 new_thread_count_of_exchange_receiver += exchange_receiver->computeNewThreadCount();
             }
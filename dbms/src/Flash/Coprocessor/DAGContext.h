@@ -32,6 +32,8 @@
 #include <Interpreters/SubqueryForSet.h>
 #include <Storages/Transaction/TiDB.h>
 
+#include <unordered_set>
+
 namespace DB
 {
 class Context;
@@ -48,6 +50,8 @@ struct JoinExecuteInfo
 };
 
 using MPPTunnelSetPtr = std::shared_ptr<MPPTunnelSet>;
+struct StreamWriter;
+using StreamWriterPtr = std::shared_ptr<StreamWriter>;
 
 UInt64 inline getMaxErrorCount(const tipb::DAGRequest &)
 {
@@ -327,6 +331,10 @@ public:
     bool is_root_mpp_task = false;
     bool is_batch_cop = false;
     MPPTunnelSetPtr tunnel_set;
+    /// Only for batch cop, if it is set, the results are encoded and written to it by every stream in parallel.
+    StreamWriterPtr batch_cop_writer;
+    /// The streams whose execution summaries are sent with the responses encoded in parallel.
+    std::unordered_set<const IBlockInputStream *> batch_cop_encoded_streams;
     TablesRegionsInfo tables_regions_info;
     // part of regions_for_local_read + regions_for_remote_read, only used for batch-cop
     RegionInfoList retry_regions;
@@ -91,6 +91,14 @@ try
     DAGQuerySource dag(context);
     DAGContext & dag_context = *context.getDAGContext();
 
+    StreamWriterPtr streaming_writer;
+    if constexpr (batch)
+    {
+        streaming_writer = std::make_shared<StreamWriter>(writer);
+        if (context.getSettingsRef().enable_batch_cop_parallel_encode)
+            dag_context.batch_cop_writer = streaming_writer;
+    }
+
     BlockIO streams = executeQuery(dag, context, internal, QueryProcessingStage::Complete);
     if (!streams.in || streams.out)
         // Only query is allowed, so streams.in must not be null and streams.out must be null
@@ -126,7 +134,6 @@ try
             writer->Write(response);
         }
 
-        auto streaming_writer = std::make_shared<StreamWriter>(writer);
         TiDB::TiDBCollators collators;
 
         std::unique_ptr<DAGResponseWriter> response_writer = std::make_unique<StreamingDAGResponseWriter<StreamWriterPtr>>(
@@ -136,10 +143,31 @@ try
             tipb::ExchangeType::PassThrough,
             context.getSettingsRef().dag_records_per_chunk,
             context.getSettingsRef().batch_send_min_limit,
+            /*enable_local_tunnel_zero_copy=*/false,
+            /*enable_dictionary_encoding=*/false,
             true,
             dag_context);
-        dag_output_stream = std::make_shared<DAGBlockOutputStream>(streams.in->getHeader(), std::move(response_writer));
-        copyData(*streams.in, *dag_output_stream);
+        if (dag_context.batch_cop_writer)
+        {
+            /// The blocks are encoded and written by every stream of `streams.in` in parallel, and every response carries
+            /// the execution summaries of the stream sending it. The last response carries the execution summaries of
+            /// the streams not owned by any of them, e.g. the build side of joins.
+            streams.in->readPrefix();
+            while (streams.in->read())
+                continue;
+            streams.in->readSuffix();
+
+            const auto & encoded_streams = dag_context.batch_cop_encoded_streams;
+            response_writer->setExecSummaryStreamFilter([&encoded_streams](const IBlockInputStream & stream) {
+                return encoded_streams.find(&stream) == encoded_streams.end();
+            });
+            response_writer->finishWrite();
+        }
+        else
+        {
+            dag_output_stream = std::make_shared<DAGBlockOutputStream>(streams.in->getHeader(), std::move(response_writer));
+            copyData(*streams.in, *dag_output_stream);
+        }
     }
 
     auto throughput = dag_context.getTableScanThroughput();
@@ -24,17 +24,21 @@
 #include <DataStreams/HashJoinProbeBlockInputStream.h>
 #include <DataStreams/LimitBlockInputStream.h>
 #include <DataStreams/MergeSortingBlockInputStream.h>
+#include <DataStreams/MergingAggregatedBlockInputStream.h>
 #include <DataStreams/MockExchangeReceiverInputStream.h>
 #include <DataStreams/MockExchangeSenderInputStream.h>
 #include <DataStreams/MockTableScanBlockInputStream.h>
 #include <DataStreams/NullBlockInputStream.h>
 #include <DataStreams/ParallelAggregatingBlockInputStream.h>
+#include <DataStreams/ParallelMergeSortingBlockInputStream.h>
 #include <DataStreams/PartialSortingBlockInputStream.h>
 #include <DataStreams/SquashingBlockInputStream.h>
 #include <DataStreams/TiRemoteBlockInputStream.h>
+#include <DataStreams/TopNBlockInputStream.h>
 #include <DataStreams/WindowBlockInputStream.h>
 #include <DataTypes/DataTypesNumber.h>
 #include <Flash/Coprocessor/AggregationInterpreterHelper.h>
+#include <Flash/Coprocessor/DAGCodec.h>
 #include <Flash/Coprocessor/DAGExpressionAnalyzer.h>
 #include <Flash/Coprocessor/DAGQueryBlockInterpreter.h>
 #include <Flash/Coprocessor/DAGUtils.h>
@@ -46,10 +50,13 @@
 #include <Flash/Coprocessor/PushDownFilter.h>
 #include <Flash/Coprocessor/StreamingDAGResponseWriter.h>
 #include <Flash/Mpp/ExchangeReceiver.h>
+#include <IO/WriteBufferFromString.h>
+#include <IO/WriteHelpers.h>
 #include <Interpreters/Aggregator.h>
 #include <Interpreters/ExpressionAnalyzer.h>
 #include <Interpreters/Join.h>
 #include <Parsers/ASTSelectQuery.h>
+#include <Storages/DeltaMerge/DMSegmentThreadInputStream.h>
 
 namespace DB
 {
@@ -155,6 +162,66 @@ AnalysisResult analyzeExpressions(
     //todo need call prependProjectInput??
     return res;
 }
+
+/// Identify the operators executed on every segment by segment aggregation, and the environment of the expressions.
+String getSegmentAggregationCacheKey(const DAGQueryBlock & query_block, const Context & context, const Block & partial_header, bool is_final_agg)
+{
+    const auto & dag_context = *context.getDAGContext();
+    WriteBufferFromOwnString buf;
+    writeStringBinary(query_block.source->SerializeAsString(), buf);
+    writeStringBinary(query_block.selection ? query_block.selection->SerializeAsString() : "", buf);
+    writeStringBinary(query_block.aggregation->SerializeAsString(), buf);
+    writeStringBinary(query_block.qb_column_prefix, buf);
+    writeBinary(static_cast<UInt8>(is_final_agg), buf);
+    writeBinary(static_cast<UInt8>(AggregationInterpreterHelper::isGroupByCollationSensitive(context)), buf);
+    writeIntBinary(dag_context.getFlags(), buf);
+    writeIntBinary(dag_context.getSQLMode(), buf);
+    const auto & timezone_info = context.getTimezoneInfo();
+    writeStringBinary(timezone_info.timezone_name, buf);
+    writeIntBinary(timezone_info.timezone_offset, buf);
+    for (const auto & col : partial_header)
+    {
+        writeStringBinary(col.name, buf);
+        writeStringBinary(col.type->getName(), buf);
+    }
+    return buf.releaseStr();
+}
+
+/// Build the threshold published by the TopN executed right on the table scan, if it is ordered by an integer or date
+/// column not nullable first, whose values in storage are exactly the values sorted by the TopN.
+DM::TopNThresholdPtr buildTopNThreshold(const DAGQueryBlock & query_block, const TiDBTableScan & table_scan, const Context & context)
+{
+    if (!context.getSettingsRef().dt_enable_topn_threshold_pushdown || query_block.aggregation
+        || !query_block.limit_or_topn || query_block.limit_or_topn->tp() != tipb::ExecType::TypeTopN)
+        return nullptr;
+    const auto & topn = query_block.limit_or_topn->topn();
+    if (topn.limit() <= 0 || topn.order_by_size() == 0 || !isColumnExpr(topn.order_by(0).expr()))
+        return nullptr;
+    auto column_index = decodeDAGInt64(topn.order_by(0).expr().val());
+    if (column_index < 0 || column_index >= table_scan.getColumnSize())
+        return nullptr;
+
+    const auto & ci = table_scan.getColumns()[column_index];
+    bool is_desc = topn.order_by(0).desc();
+    if (ci.column_id() == TiDBPkColumnID)
+        return std::make_shared<DM::TopNThreshold>(ci.column_id(), is_desc, false);
+    if (ci.column_id() == ExtraTableIDColumnID || !(ci.flag() & TiDB::ColumnFlagNotNull))
+        return nullptr;
+    switch (ci.tp())
+    {
+    case TiDB::TypeTiny:
+    case TiDB::TypeShort:
+    case TiDB::TypeInt24:
+    case TiDB::TypeLong:
+    case TiDB::TypeLongLong:
+        return std::make_shared<DM::TopNThreshold>(ci.column_id(), is_desc, (ci.flag() & TiDB::ColumnFlagUnsigned) != 0);
+    case TiDB::TypeDate:
+    case TiDB::TypeDatetime:
+        return std::make_shared<DM::TopNThreshold>(ci.column_id(), is_desc, true);
+    default:
+        return nullptr;
+    }
+}
 } // namespace
 
 // for tests, we need to mock tableScan blockInputStream as the source stream.
@@ -183,10 +250,13 @@ void DAGQueryBlockInterpreter::handleTableScan(const TiDBTableScan & table_scan,
 {
     const auto push_down_filter = PushDownFilter::toPushDownFilter(query_block.selection_name, query_block.selection);
 
-    DAGStorageInterpreter storage_interpreter(context, table_scan, push_down_filter, max_streams);
+    topn_threshold = buildTopNThreshold(query_block, table_scan, context);
+
+    DAGStorageInterpreter storage_interpreter(context, table_scan, push_down_filter, topn_threshold, max_streams);
     storage_interpreter.execute(pipeline);
 
     analyzer = std::move(storage_interpreter.analyzer);
+    local_segment_streams = std::move(storage_interpreter.local_segment_streams);
 }
 
 void DAGQueryBlockInterpreter::handleJoin(const tipb::Join & join, DAGPipeline & pipeline, SubqueryForSet & right_query)
@@ -261,7 +331,9 @@ void DAGQueryBlockInterpreter::handleJoin(const tipb::Join & join, DAGPipeline &
         other_eq_filter_from_in_column_name,
         other_condition_expr,
         max_block_size_for_cross_join,
-        match_helper_name);
+        match_helper_name,
+        settings.hash_table_prefetch_distance,
+        settings.hash_table_prefetch_min_bytes);
 
     recordJoinExecuteInfo(tiflash_join.build_side_index, join_ptr);
 
@@ -421,6 +493,93 @@ void DAGQueryBlockInterpreter::executeAggregation(
     }
 }
 
+/// Aggregate the rows of every segment separately in the local segment streams, and then merge the partial results of
+/// all segments and remote streams. The partial results of segments are cached in SegmentResultCache and reused by
+/// the following queries with the same table scan, selection and aggregation if the segments are not changed.
+void DAGQueryBlockInterpreter::executeSegmentAggregation(
+    DAGPipeline & pipeline,
+    const ExpressionActionsPtr & expression_actions_ptr,
+    const Names & key_names,
+    const TiDB::TiDBCollators & collators,
+    AggregateDescriptions & aggregate_descriptions,
+    bool is_final_agg)
+{
+    assert(pipeline.streams_with_non_joined_data.empty());
+    const auto & segment_streams = local_segment_streams->streams;
+    assert(segment_streams.size() <= pipeline.streams.size());
+
+    pipeline.transform([&](auto & stream) {
+        stream = std::make_shared<ExpressionBlockInputStream>(stream, expression_actions_ptr, log->identifier());
+        stream->setExtraInfo("before aggregation");
+    });
+    Block before_agg_header = pipeline.firstStream()->getHeader();
+    AggregationInterpreterHelper::fillArgColumnNumbers(aggregate_descriptions, before_agg_header);
+    // Every segment or remote stream is aggregated by one thread.
+    auto partial_params = AggregationInterpreterHelper::buildParams(
+        context,
+        before_agg_header,
+        1,
+        key_names,
+        collators,
+        aggregate_descriptions,
+        is_final_agg);
+    Block partial_header = partial_params.getHeader(false);
+
+    // It is also used by the segment streams during reading, so capture everything by value.
+    auto to_partial_aggregation = [partial_params, file_provider = context.getFileProvider(), req_id = log->identifier()](const BlockInputStreamPtr & stream) -> BlockInputStreamPtr {
+        return std::make_shared<AggregatingBlockInputStream>(stream, partial_params, file_provider, false, req_id);
+    };
+    auto segment_transform = std::make_shared<DM::SegmentStreamTransform>();
+    segment_transform->cache_key = getSegmentAggregationCacheKey(query_block, context, partial_header, is_final_agg);
+    segment_transform->transform = [segment_streams = local_segment_streams, expression_actions_ptr, to_partial_aggregation, req_id = log->identifier()](const BlockInputStreamPtr & stream) {
+        auto res = segment_streams->transform(stream, req_id);
+        res = std::make_shared<ExpressionBlockInputStream>(res, expression_actions_ptr, req_id);
+        return to_partial_aggregation(res);
+    };
+
+    // The local streams are in front of the remote streams, see `DAGStorageInterpreter::executeImpl`.
+    for (size_t i = 0; i < pipeline.streams.size(); ++i)
+    {
+        auto & stream = pipeline.streams[i];
+        if (i < segment_streams.size())
+        {
+            segment_streams[i]->setSegmentTransform(segment_transform);
+            stream = segment_streams[i];
+            stream->setExtraInfo("segment aggregation");
+        }
+        else
+            stream = to_partial_aggregation(stream);
+    }
+    // The table scan and selection of local streams are executed inside the segment streams now.
+    auto & profile_streams_map = dagContext().getProfileStreamsMap();
+    for (const auto & executor_id : {query_block.source_name, query_block.selection_name})
+    {
+        auto iter = profile_streams_map.find(executor_id);
+        if (iter == profile_streams_map.end())
+            continue;
+        for (size_t i = 0; i < segment_streams.size() && i < iter->second.size(); ++i)
+            iter->second[i] = segment_streams[i];
+    }
+    // Aggregation without key outputs one row for empty set, while the merge does not.
+    if (key_names.empty() && is_final_agg)
+        pipeline.streams.push_back(to_partial_aggregation(std::make_shared<NullBlockInputStream>(before_agg_header)));
+
+    executeUnion(pipeline, max_streams, log, false, "for segment aggregation");
+
+    ColumnNumbers keys;
+    for (const auto & name : key_names)
+        keys.push_back(partial_header.getPositionByName(name));
+    // The keys with collator have been converted into sort keys in the partial results, so they are merged in binary.
+    Aggregator::Params merge_params(partial_header, keys, aggregate_descriptions, false);
+    pipeline.firstStream() = std::make_shared<MergingAggregatedBlockInputStream>(
+        pipeline.firstStream(),
+        merge_params,
+        true,
+        max_streams);
+    recordProfileStreams(pipeline, query_block.aggregation_name);
+    restorePipelineConcurrency(pipeline);
+}
+
 void DAGQueryBlockInterpreter::executeExpression(DAGPipeline & pipeline, const ExpressionActionsPtr & expressionActionsPtr, const String & extra_info)
 {
     if (!expressionActionsPtr->getActions().empty())
@@ -440,15 +599,20 @@ void DAGQueryBlockInterpreter::executeWindowOrder(DAGPipeline & pipeline, SortDe
 void DAGQueryBlockInterpreter::executeOrder(DAGPipeline & pipeline, const NamesAndTypes & order_columns)
 {
     Int64 limit = query_block.limit_or_topn->topn().limit();
-    orderStreams(pipeline, getSortDescription(order_columns, query_block.limit_or_topn->topn().order_by()), limit);
+    orderStreams(pipeline, getSortDescription(order_columns, query_block.limit_or_topn->topn().order_by()), limit, topn_threshold);
 }
 
-void DAGQueryBlockInterpreter::orderStreams(DAGPipeline & pipeline, SortDescription order_descr, Int64 limit)
+void DAGQueryBlockInterpreter::orderStreams(DAGPipeline & pipeline, SortDescription order_descr, Int64 limit, const DM::TopNThresholdPtr & threshold)
 {
     const Settings & settings = context.getSettingsRef();
 
     pipeline.transform([&](auto & stream) {
-        auto sorting_stream = std::make_shared<PartialSortingBlockInputStream>(stream, order_descr, log->identifier(), limit);
+        /// With limit, every stream only keeps the first `limit` rows of it, and publishes its threshold to the table scan.
+        std::shared_ptr<IProfilingBlockInputStream> sorting_stream;
+        if (limit > 0)
+            sorting_stream = std::make_shared<TopNBlockInputStream>(stream, order_descr, limit, threshold, log->identifier());
+        else
+            sorting_stream = std::make_shared<PartialSortingBlockInputStream>(stream, order_descr, log->identifier(), limit);
 
         /// Limits on sorting
         IProfilingBlockInputStream::LocalLimits limits;
@@ -459,6 +623,25 @@ void DAGQueryBlockInterpreter::orderStreams(DAGPipeline & pipeline, SortDescript
         stream = sorting_stream;
     });
 
+    /// Without limit, i.e. the sorting for window functions, all the rows are sorted, the streams are sorted by ranges in parallel instead of by a single thread.
+    if (limit == 0 && settings.enable_parallel_merge_sort && pipeline.streams.size() > 1)
+    {
+        BlockInputStreamPtr stream_with_non_joined_data = combinedNonJoinedDataStream(pipeline, max_streams, log);
+        pipeline.firstStream() = std::make_shared<ParallelMergeSortingBlockInputStream>(
+            pipeline.streams,
+            stream_with_non_joined_data,
+            order_descr,
+            settings.max_block_size,
+            settings.max_bytes_before_external_sort,
+            context.getTemporaryPath(),
+            CompressionSettings(settings.external_sort_compression_method, settings.external_sort_compression_level),
+            context.getFileProvider(),
+            max_streams,
+            log->identifier());
+        pipeline.streams.resize(1);
+        return;
+    }
+
     /// If there are several streams, we merge them into one
     executeUnion(pipeline, max_streams, log, false, "for partial order");
 
@@ -665,7 +848,12 @@ void DAGQueryBlockInterpreter::executeImpl(DAGPipeline & pipeline)
         pipeline.streams.size());
     dagContext().final_concurrency = std::min(std::max(dagContext().final_concurrency, pipeline.streams.size()), max_streams);
 
-    if (res.before_aggregation)
+    if (res.before_aggregation && local_segment_streams && !res.before_where && context.getSettingsRef().dt_enable_segment_result_cache)
+    {
+        // execute aggregation on every segment, so that the partial results of unchanged segments could be cached
+        executeSegmentAggregation(pipeline, res.before_aggregation, res.aggregation_keys, res.aggregation_collators, res.aggregate_descriptions, res.is_final_agg);
+    }
+    else if (res.before_aggregation)
     {
         // execute aggregation
         executeAggregation(pipeline, res.before_aggregation, res.aggregation_keys, res.aggregation_collators, res.aggregate_descriptions, res.is_final_agg);
@@ -752,6 +940,8 @@ void DAGQueryBlockInterpreter::handleExchangeSender(DAGPipeline & pipeline)
             exchange_sender.tp(),
             context.getSettingsRef().dag_records_per_chunk,
             context.getSettingsRef().batch_send_min_limit,
+            context.getSettingsRef().enable_local_tunnel_zero_copy,
+            context.getSettingsRef().enable_exchange_dictionary_encoding,
             stream_id++ == 0, /// only one stream needs to sending execution summaries for the last response
             dagContext());
         stream = std::make_shared<ExchangeSenderBlockInputStream>(stream, std::move(response_writer), log->identifier());
@@ -69,7 +69,7 @@ private:
     void executeWhere(DAGPipeline & pipeline, const ExpressionActionsPtr & expressionActionsPtr, String & filter_column, const String & extra_info = "");
     void executeExpression(DAGPipeline & pipeline, const ExpressionActionsPtr & expressionActionsPtr, const String & extra_info = "");
     void executeWindowOrder(DAGPipeline & pipeline, SortDescription sort_desc);
-    void orderStreams(DAGPipeline & pipeline, SortDescription order_descr, Int64 limit);
+    void orderStreams(DAGPipeline & pipeline, SortDescription order_descr, Int64 limit, const DM::TopNThresholdPtr & threshold = nullptr);
     void executeOrder(DAGPipeline & pipeline, const NamesAndTypes & order_columns);
     void executeLimit(DAGPipeline & pipeline);
     void executeWindow(
@@ -82,6 +82,13 @@ private:
         const TiDB::TiDBCollators & collators,
         AggregateDescriptions & aggregate_descriptions,
         bool is_final_agg);
+    void executeSegmentAggregation(
+        DAGPipeline & pipeline,
+        const ExpressionActionsPtr & expression_actions_ptr,
+        const Names & key_names,
+        const TiDB::TiDBCollators & collators,
+        AggregateDescriptions & aggregate_descriptions,
+        bool is_final_agg);
     void executeProject(DAGPipeline & pipeline, NamesWithAliases & project_cols, const String & extra_info = "");
     void handleExchangeSender(DAGPipeline & pipeline);
     void handleMockExchangeSender(DAGPipeline & pipeline);
@@ -104,6 +111,9 @@ private:
     size_t max_streams = 1;
 
     std::unique_ptr<DAGExpressionAnalyzer> analyzer;
+    LocalSegmentStreamsPtr local_segment_streams;
+    /// Published by the TopN of this query block to the table scan, see `DM::TopNThreshold`.
+    DM::TopNThresholdPtr topn_threshold;
 
     LoggerPtr log;
 };
@@ -17,6 +17,7 @@
 #include <Core/NamesAndTypes.h>
 #include <Flash/Coprocessor/DAGExpressionAnalyzer.h>
 #include <Flash/Coprocessor/DAGQuerySource.h>
+#include <Storages/DeltaMerge/Filter/TopNThreshold.h>
 
 #include <unordered_map>
 
@@ -43,5 +44,8 @@ struct DAGQueryInfo
     const NamesAndTypes & source_columns;
 
     const TimezoneInfo & timezone_info;
+
+    // The threshold published by the TopN right on the table scan, used to skip the data which can not enter its result.
+    DM::TopNThresholdPtr topn_threshold;
 };
 } // namespace DB
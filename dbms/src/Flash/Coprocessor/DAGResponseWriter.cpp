@@ -74,6 +74,8 @@ void DAGResponseWriter::addExecuteSummaries(tipb::SelectResponse & response, boo
     {
         for (const auto & stream_ptr : map_entry.second)
         {
+            if (exec_summary_stream_filter && !exec_summary_stream_filter(*stream_ptr))
+                continue;
             if (auto * exchange_receiver_stream_ptr = dynamic_cast<ExchangeReceiverInputStream *>(stream_ptr.get()))
             {
                 mergeRemoteExecuteSummaries(exchange_receiver_stream_ptr, merged_remote_execution_summaries);
@@ -96,6 +98,8 @@ void DAGResponseWriter::addExecuteSummaries(tipb::SelectResponse & response, boo
         /// part 1: local execution info
         for (auto & stream_ptr : p.second)
         {
+            if (exec_summary_stream_filter && !exec_summary_stream_filter(*stream_ptr))
+                continue;
             if (auto * p_stream = dynamic_cast<IProfilingBlockInputStream *>(stream_ptr.get()))
             {
                 current.time_processed_ns = std::max(current.time_processed_ns, p_stream->getProfileInfo().execution_time);
@@ -110,6 +114,9 @@ void DAGResponseWriter::addExecuteSummaries(tipb::SelectResponse & response, boo
             for (auto & remote : merged_remote_execution_summaries[p.first])
                 current.merge(remote, false);
         }
+        /// The executor has no stream accepted by the filter.
+        if (exec_summary_stream_filter && current.concurrency == 0)
+            continue;
         /// part 3: for join need to add the build time
         /// In TiFlash, a hash join's build side is finished before probe side starts,
         /// so the join probe side's running time does not include hash table's build time,
@@ -71,6 +71,9 @@ public:
         const String & executor_id,
         bool delta_mode);
     void addExecuteSummaries(tipb::SelectResponse & response, bool delta_mode);
+    /// Only count the local and remote input streams accepted by `filter` in the execution summaries.
+    using StreamFilter = std::function<bool(const IBlockInputStream &)>;
+    void setExecSummaryStreamFilter(StreamFilter filter) { exec_summary_stream_filter = std::move(filter); }
     virtual void write(const Block & block) = 0;
     virtual void finishWrite() = 0;
     virtual ~DAGResponseWriter() = default;
@@ -81,6 +84,7 @@ protected:
     DAGContext & dag_context;
     std::unordered_map<String, ExecutionSummary> previous_execution_stats;
     std::unordered_set<String> local_executors;
+    StreamFilter exec_summary_stream_filter;
 };
 
 } // namespace DB
@@ -30,6 +30,7 @@
 #include <Flash/Coprocessor/RemoteRequest.h>
 #include <Interpreters/Context.h>
 #include <Parsers/makeDummyQuery.h>
+#include <Storages/DeltaMerge/DMSegmentThreadInputStream.h>
 #include <Storages/IManageableStorage.h>
 #include <Storages/MutableSupport.h>
 #include <Storages/Transaction/KVStore.h>
@@ -212,16 +213,50 @@ bool addExtraCastsAfterTs(
         return false;
     return analyzer.appendExtraCastsAfterTS(chain, need_cast_column, table_scan);
 }
+
+LocalSegmentStreamsPtr collectLocalSegmentStreams(const BlockInputStreams & streams)
+{
+    if (streams.empty())
+        return nullptr;
+    auto res = std::make_shared<LocalSegmentStreams>();
+    for (const auto & stream : streams)
+    {
+        auto segment_stream = std::dynamic_pointer_cast<DM::DMSegmentThreadInputStream>(stream);
+        if (!segment_stream || !segment_stream->supportSegmentTransform())
+            return nullptr;
+        res->streams.push_back(std::move(segment_stream));
+    }
+    return res;
+}
 } // namespace
 
+BlockInputStreamPtr LocalSegmentStreams::transform(BlockInputStreamPtr stream, const String & req_id) const
+{
+    if (extra_cast)
+    {
+        stream = std::make_shared<ExpressionBlockInputStream>(stream, extra_cast, req_id);
+        stream->setExtraInfo("cast after local tableScan");
+    }
+    if (before_where)
+    {
+        stream = std::make_shared<FilterBlockInputStream>(stream, before_where, filter_column_name, req_id);
+        stream->setExtraInfo("push down filter");
+        stream = std::make_shared<ExpressionBlockInputStream>(stream, project_after_where, req_id);
+        stream->setExtraInfo("projection after push down filter");
+    }
+    return stream;
+}
+
 DAGStorageInterpreter::DAGStorageInterpreter(
     Context & context_,
     const TiDBTableScan & table_scan_,
     const PushDownFilter & push_down_filter_,
+    const DM::TopNThresholdPtr & topn_threshold_,
     size_t max_streams_)
     : context(context_)
     , table_scan(table_scan_)
     , push_down_filter(push_down_filter_)
+    , topn_threshold(topn_threshold_)
     , max_streams(max_streams_)
     , log(Logger::get("DAGStorageInterpreter", context.getDAGContext()->log ? context.getDAGContext()->log->identifier() : ""))
     , logical_table_id(table_scan.getLogicalTableID())
@@ -251,6 +286,7 @@ void DAGStorageInterpreter::executeImpl(DAGPipeline & pipeline)
 {
     if (!mvcc_query_info->regions_query_info.empty())
         buildLocalStreams(pipeline, settings.max_block_size);
+    local_segment_streams = collectLocalSegmentStreams(pipeline.streams);
 
     // Should build `remote_requests` and `null_stream` under protect of `table_structure_lock`.
     auto null_stream_if_empty = std::make_shared<NullBlockInputStream>(storage_for_logical_table->getSampleBlockForColumns(required_columns));
@@ -368,6 +404,13 @@ void DAGStorageInterpreter::executePushedDownFilter(
     chain.finalize();
     chain.clear();
 
+    if (local_segment_streams)
+    {
+        local_segment_streams->before_where = before_where;
+        local_segment_streams->filter_column_name = filter_column_name;
+        local_segment_streams->project_after_where = project_after_where;
+    }
+
     assert(pipeline.streams_with_non_joined_data.empty());
     assert(remote_read_streams_start_index <= pipeline.streams.size());
     // for remote read, filter had been pushed down, don't need to execute again.
@@ -397,6 +440,8 @@ void DAGStorageInterpreter::executeCastAfterTableScan(
         ExpressionActionsPtr extra_cast = chain.getLastActions();
         chain.finalize();
         chain.clear();
+        if (local_segment_streams)
+            local_segment_streams->extra_cast = extra_cast;
 
         // After `addExtraCastsAfterTs`, analyzer->getCurrentInputColumns() has been modified.
         // For remote read, `timezone cast and duration cast` had been pushed down, don't need to execute cast expressions.
@@ -597,6 +642,7 @@ std::unordered_map<TableID, SelectQueryInfo> DAGStorageInterpreter::generateSele
             analyzer->getPreparedSets(),
             analyzer->getCurrentInputColumns(),
             context.getTimezoneInfo());
+        query_info.dag_query->topn_threshold = topn_threshold;
         query_info.req_id = fmt::format("{} Table<{}>", log->identifier(), table_id);
         return query_info;
     };
@@ -20,6 +20,7 @@
 #include <Flash/Coprocessor/PushDownFilter.h>
 #include <Flash/Coprocessor/RemoteRequest.h>
 #include <Flash/Coprocessor/TiDBTableScan.h>
+#include <Storages/DeltaMerge/Filter/TopNThreshold.h>
 #include <Storages/RegionQueryInfo.h>
 #include <Storages/SelectQueryInfo.h>
 #include <Storages/TableLockHolder.h>
@@ -33,6 +34,27 @@
 namespace DB
 {
 class TMTContext;
+namespace DM
+{
+class DMSegmentThreadInputStream;
+} // namespace DM
+
+/// The local streams reading segments of DeltaTree and the operators executed on them after table scan.
+/// With them the following operators could be pushed down to each segment, see `DMSegmentThreadInputStream::setSegmentTransform`.
+struct LocalSegmentStreams
+{
+    std::vector<std::shared_ptr<DM::DMSegmentThreadInputStream>> streams;
+
+    ExpressionActionsPtr extra_cast;
+    ExpressionActionsPtr before_where;
+    String filter_column_name;
+    ExpressionActionsPtr project_after_where;
+
+    /// Apply the operators after table scan on the stream of a segment.
+    BlockInputStreamPtr transform(BlockInputStreamPtr stream, const String & req_id) const;
+};
+using LocalSegmentStreamsPtr = std::shared_ptr<LocalSegmentStreams>;
+
 using TablesRegionInfoMap = std::unordered_map<Int64, std::reference_wrapper<const RegionInfoMap>>;
 /// DAGStorageInterpreter encapsulates operations around storage during interprete stage.
 /// It's only intended to be used by DAGQueryBlockInterpreter.
@@ -44,6 +66,7 @@ public:
         Context & context_,
         const TiDBTableScan & table_scan,
         const PushDownFilter & push_down_filter_,
+        const DM::TopNThresholdPtr & topn_threshold_,
         size_t max_streams_);
 
     DISALLOW_MOVE(DAGStorageInterpreter);
@@ -53,6 +76,8 @@ public:
     /// Members will be transferred to DAGQueryBlockInterpreter after execute
 
     std::unique_ptr<DAGExpressionAnalyzer> analyzer;
+    /// Not null only if all the local streams are reading segments of one DeltaTree table directly.
+    LocalSegmentStreamsPtr local_segment_streams;
 
 private:
     struct StorageWithStructureLock
@@ -104,6 +129,7 @@ private:
     Context & context;
     const TiDBTableScan & table_scan;
     const PushDownFilter & push_down_filter;
+    DM::TopNThresholdPtr topn_threshold;
     size_t max_streams;
     LoggerPtr log;
 
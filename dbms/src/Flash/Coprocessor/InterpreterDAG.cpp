@@ -13,10 +13,13 @@
 // limitations under the License.
 
 #include <DataStreams/CreatingSetsBlockInputStream.h>
+#include <DataStreams/ExchangeSenderBlockInputStream.h>
 #include <Flash/Coprocessor/DAGContext.h>
 #include <Flash/Coprocessor/DAGQueryBlockInterpreter.h>
 #include <Flash/Coprocessor/InterpreterDAG.h>
 #include <Flash/Coprocessor/InterpreterUtils.h>
+#include <Flash/Coprocessor/StreamWriter.h>
+#include <Flash/Coprocessor/StreamingDAGResponseWriter.h>
 #include <Interpreters/Context.h>
 
 namespace DB
@@ -83,7 +86,46 @@ BlockIO InterpreterDAG::execute()
     DAGPipeline pipeline;
     pipeline.streams = streams;
     /// add union to run in parallel if needed
-    if (unlikely(dagContext().isTest()))
+    if (dagContext().isBatchCop() && dagContext().batch_cop_writer)
+    {
+        /// Every stream encodes its own blocks and writes the responses in the order they are done, so the returned
+        /// blocks are not needed. Every response carries the execution summaries of the streams under the stream
+        /// sending it, the streams shared by several of them are owned by the first one.
+        const Settings & settings = context.getSettingsRef();
+        auto & encoded_streams = dagContext().batch_cop_encoded_streams;
+        pipeline.transform([&](auto & stream) {
+            std::unordered_set<const IBlockInputStream *> owned_streams;
+            std::function<void(IBlockInputStream &)> collect_owned_streams = [&](IBlockInputStream & s) {
+                if (!encoded_streams.insert(&s).second)
+                    return;
+                owned_streams.insert(&s);
+                s.forEachChild([&](IBlockInputStream & child) {
+                    collect_owned_streams(child);
+                    return false;
+                });
+            };
+            collect_owned_streams(*stream);
+
+            auto response_writer = std::make_unique<StreamingDAGResponseWriter<StreamWriterPtr>>(
+                dagContext().batch_cop_writer,
+                std::vector<Int64>(),
+                TiDB::TiDBCollators(),
+                tipb::ExchangeType::PassThrough,
+                settings.dag_records_per_chunk,
+                settings.batch_send_min_limit,
+                /*enable_local_tunnel_zero_copy=*/false,
+                /*enable_dictionary_encoding=*/false,
+                /*should_send_exec_summary_at_last=*/true,
+                dagContext());
+            response_writer->setExecSummaryStreamFilter([owned_streams = std::move(owned_streams)](const IBlockInputStream & s) {
+                return owned_streams.find(&s) != owned_streams.end();
+            });
+            response_writer->enableExecSummaryPerResponse();
+            stream = std::make_shared<ExchangeSenderBlockInputStream>(stream, std::move(response_writer), dagContext().log->identifier());
+        });
+        executeUnion(pipeline, max_streams, dagContext().log, /*ignore_block=*/true, "for batch cop");
+    }
+    else if (unlikely(dagContext().isTest()))
         executeUnion(pipeline, max_streams, dagContext().log, /*ignore_block=*/false, "for test");
     else if (dagContext().isMPPTask())
         /// MPPTask do not need the returned blocks.
@@ -36,10 +36,10 @@ namespace DB
 {
 struct StreamWriter
 {
-    ::grpc::ServerWriter<::coprocessor::BatchResponse> * writer;
+    ::grpc::ServerWriterInterface<::coprocessor::BatchResponse> * writer;
     std::mutex write_mutex;
 
-    explicit StreamWriter(::grpc::ServerWriter<::coprocessor::BatchResponse> * writer_)
+    explicit StreamWriter(::grpc::ServerWriterInterface<::coprocessor::BatchResponse> * writer_)
         : writer(writer_)
     {}
     void write(mpp::MPPDataPacket &)
@@ -55,6 +55,7 @@ struct StreamWriter
         ::coprocessor::BatchResponse resp;
         if (!response.SerializeToString(resp.mutable_data()))
             throw Exception("Fail to serialize response, response size: " + std::to_string(response.ByteSizeLong()));
+        /// The blocking `Write` is done with `write_mutex` held, so the parallel writers are throttled by the grpc stream.
         std::lock_guard lk(write_mutex);
         if (!writer->Write(resp))
             throw Exception("Failed to write resp");
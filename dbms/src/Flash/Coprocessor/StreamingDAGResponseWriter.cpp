@@ -45,10 +45,13 @@ StreamingDAGResponseWriter<StreamWriterPtr>::StreamingDAGResponseWriter(
     tipb::ExchangeType exchange_type_,
     Int64 records_per_chunk_,
     Int64 batch_send_min_limit_,
+    bool enable_local_tunnel_zero_copy_,
+    bool enable_dictionary_encoding_,
     bool should_send_exec_summary_at_last_,
     DAGContext & dag_context_)
     : DAGResponseWriter(records_per_chunk_, dag_context_)
     , batch_send_min_limit(batch_send_min_limit_)
+    , local_tunnel_zero_copy(false)
     , should_send_exec_summary_at_last(should_send_exec_summary_at_last_)
     , exchange_type(exchange_type_)
     , writer(writer_)
@@ -57,6 +60,14 @@ StreamingDAGResponseWriter<StreamWriterPtr>::StreamingDAGResponseWriter(
 {
     rows_in_blocks = 0;
     partition_num = writer_->getPartitionNum();
+    /// blocks can only be passed through local tunnels between TiFlash nodes, i.e. encoded by CHBlock in MPP.
+    if constexpr (support_local_tunnel)
+    {
+        local_tunnel_zero_copy = enable_local_tunnel_zero_copy_
+            && dag_context.isMPPTask()
+            && dag_context.encode_type == tipb::EncodeType::TypeCHBlock
+            && writer_->getRemoteTunnelCnt() < partition_num;
+    }
     switch (dag_context.encode_type)
     {
     case tipb::EncodeType::TypeDefault:
@@ -66,11 +77,20 @@ StreamingDAGResponseWriter<StreamWriterPtr>::StreamingDAGResponseWriter(
         chunk_codec_stream = std::make_unique<ArrowChunkCodec>()->newCodecStream(dag_context.result_field_types);
         break;
     case tipb::EncodeType::TypeCHBlock:
-        chunk_codec_stream = std::make_unique<CHBlockChunkCodec>()->newCodecStream(dag_context.result_field_types);
+        chunk_codec_stream = std::make_unique<CHBlockChunkCodec>(enable_dictionary_encoding_)->newCodecStream(dag_context.result_field_types);
         break;
     }
 }
 
+template <class StreamWriterPtr>
+bool StreamingDAGResponseWriter<StreamWriterPtr>::isZeroCopyPartition(uint16_t part_id) const
+{
+    if constexpr (support_local_tunnel)
+        return local_tunnel_zero_copy && writer->isLocal(part_id);
+    else
+        return false;
+}
+
 template <class StreamWriterPtr>
 void StreamingDAGResponseWriter<StreamWriterPtr>::finishWrite()
 {
@@ -120,11 +140,26 @@ void StreamingDAGResponseWriter<StreamWriterPtr>::encodeThenWriteBlocks(
                 }
                 return;
             }
-            for (const auto & block : input_blocks)
+            /// if all tunnels are local, there is no need to encode the blocks.
+            bool need_encode = true;
+            if constexpr (support_local_tunnel)
+                need_encode = !local_tunnel_zero_copy || writer->getRemoteTunnelCnt() > 0;
+            if (need_encode)
             {
-                chunk_codec_stream->encode(block, 0, block.rows());
-                packet.add_chunks(chunk_codec_stream->getString());
-                chunk_codec_stream->clear();
+                for (const auto & block : input_blocks)
+                {
+                    chunk_codec_stream->encode(block, 0, block.rows());
+                    packet.add_chunks(chunk_codec_stream->getString());
+                    chunk_codec_stream->clear();
+                }
+            }
+            if constexpr (support_local_tunnel)
+            {
+                if (local_tunnel_zero_copy)
+                {
+                    writer->write(packet, input_blocks);
+                    return;
+                }
             }
             writer->write(packet);
         }
@@ -199,6 +234,8 @@ void StreamingDAGResponseWriter<StreamWriterPtr>::partitionAndEncodeThenWriteBlo
     tipb::SelectResponse & response) const
 {
     std::vector<mpp::MPPDataPacket> packet(partition_num);
+    /// blocks for the local tunnels in zero-copy mode, which are not encoded into `packet`.
+    std::vector<Blocks> local_blocks(partition_num);
 
     std::vector<size_t> responses_row_count(partition_num);
 
@@ -278,6 +315,12 @@ void StreamingDAGResponseWriter<StreamWriterPtr>::partitionAndEncodeThenWriteBlo
         {
             dest_blocks[part_id].setColumns(std::move(dest_tbl_cols[part_id]));
             responses_row_count[part_id] += dest_blocks[part_id].rows();
+            if (isZeroCopyPartition(part_id))
+            {
+                if (dest_blocks[part_id].rows() > 0)
+                    local_blocks[part_id].push_back(std::move(dest_blocks[part_id]));
+                continue;
+            }
             chunk_codec_stream->encode(dest_blocks[part_id], 0, dest_blocks[part_id].rows());
             packet[part_id].add_chunks(chunk_codec_stream->getString());
             chunk_codec_stream->clear();
@@ -286,15 +329,20 @@ void StreamingDAGResponseWriter<StreamWriterPtr>::partitionAndEncodeThenWriteBlo
 
     for (auto part_id = 0; part_id < partition_num; ++part_id)
     {
-        if constexpr (send_exec_summary_at_last)
+        if constexpr (!send_exec_summary_at_last)
         {
-            writer->write(packet[part_id], part_id);
+            if (responses_row_count[part_id] == 0)
+                continue;
         }
-        else
+        if constexpr (support_local_tunnel)
         {
-            if (responses_row_count[part_id] > 0)
-                writer->write(packet[part_id], part_id);
+            if (isZeroCopyPartition(part_id))
+            {
+                writer->write(packet[part_id], std::move(local_blocks[part_id]), part_id);
+                continue;
+            }
         }
+        writer->write(packet[part_id], part_id);
     }
 }
 
@@ -305,6 +353,8 @@ void StreamingDAGResponseWriter<StreamWriterPtr>::batchWrite()
     tipb::SelectResponse response;
     if constexpr (send_exec_summary_at_last)
         addExecuteSummaries(response, !dag_context.isMPPTask() || dag_context.isRootMPPTask());
+    else if (exec_summary_per_response && !blocks.empty())
+        addExecuteSummaries(response, /*delta_mode=*/true);
     if (exchange_type == tipb::ExchangeType::Hash)
     {
         partitionAndEncodeThenWriteBlocks<send_exec_summary_at_last>(blocks, response);
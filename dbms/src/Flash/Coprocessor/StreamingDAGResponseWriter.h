@@ -44,12 +44,22 @@ public:
         tipb::ExchangeType exchange_type_,
         Int64 records_per_chunk_,
         Int64 batch_send_min_limit_,
+        bool enable_local_tunnel_zero_copy_,
+        bool enable_dictionary_encoding,
         bool should_send_exec_summary_at_last,
         DAGContext & dag_context_);
     void write(const Block & block) override;
     void finishWrite() override;
+    /// Attach the execution summaries since the previous response to every response, used when several writers
+    /// send the responses of one request.
+    void enableExecSummaryPerResponse() { exec_summary_per_response = true; }
 
 private:
+    /// only the MPP tunnels can pass blocks to the local receivers without encoding.
+    static constexpr bool support_local_tunnel = std::is_same_v<StreamWriterPtr, MPPTunnelSetPtr>;
+
+    bool isZeroCopyPartition(uint16_t part_id) const;
+
     template <bool send_exec_summary_at_last>
     void batchWrite();
     template <bool send_exec_summary_at_last>
@@ -58,7 +68,10 @@ private:
     void partitionAndEncodeThenWriteBlocks(std::vector<Block> & input_blocks, tipb::SelectResponse & response) const;
 
     Int64 batch_send_min_limit;
+    /// pass blocks to local tunnels without encoding them, see `MPPTunnelMessage`.
+    bool local_tunnel_zero_copy;
     bool should_send_exec_summary_at_last; /// only one stream needs to sending execution summaries at last.
+    bool exec_summary_per_response = false;
     tipb::ExchangeType exchange_type;
     StreamWriterPtr writer;
     std::vector<Block> blocks;
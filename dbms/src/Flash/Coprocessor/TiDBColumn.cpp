@@ -11,7 +11,7 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
-
+#include <Columns/ColumnString.h>
 #include <Flash/Coprocessor/DAGCodec.h>
 #include <Flash/Coprocessor/TiDBColumn.h>
 #include <IO/Endian.h>
@@ -31,13 +31,19 @@ void encodeLittleEndian(const T & value, WriteBuffer & ss)
     ss.write(reinterpret_cast<const char *>(&v), sizeof(v));
 }
 
+template <typename T>
+void encodeLittleEndian(const T & value, PODArray<char> & data)
+{
+    auto v = toLittleEndian(value);
+    data.insert(reinterpret_cast<const char *>(&v), reinterpret_cast<const char *>(&v) + sizeof(v));
+}
+
 TiDBColumn::TiDBColumn(Int8 element_len_)
     : length(0)
     , null_cnt(0)
     , current_data_size(0)
     , fixed_size(element_len_)
 {
-    data = std::make_unique<WriteBufferFromOwnString>();
     if (fixed_size != VAR_SIZE)
         default_value = String(fixed_size, '\0');
     var_offsets.push_back(0);
@@ -50,7 +56,8 @@ void TiDBColumn::clear()
     null_bitmap.clear();
     var_offsets.clear();
     var_offsets.push_back(0);
-    data = std::make_unique<WriteBufferFromOwnString>();
+    // Keep the allocated memory for the next chunk.
+    data.clear();
     current_data_size = 0;
 }
 
@@ -72,6 +79,34 @@ void TiDBColumn::appendNullBitMap(bool value)
     }
 }
 
+void TiDBColumn::appendNullBitMap(const UInt8 * null_map, size_t num)
+{
+    size_t pos = length;
+    size_t end = length + num;
+    null_bitmap.resize((end + 7) >> 3, 0);
+    if (!null_map)
+    {
+        // Set the bits one by one until the byte boundary, then set the whole bytes.
+        for (; pos < end && (pos & 7); ++pos)
+            null_bitmap[pos >> 3] |= (1 << (pos & 7));
+        size_t full_bytes = (end - pos) >> 3;
+        if (full_bytes > 0)
+            memset(null_bitmap.data() + (pos >> 3), 0xFF, full_bytes);
+        for (pos += full_bytes << 3; pos < end; ++pos)
+            null_bitmap[pos >> 3] |= (1 << (pos & 7));
+        return;
+    }
+
+    size_t nulls = 0;
+    for (size_t i = 0; i < num; ++i, ++pos)
+    {
+        UInt8 is_null = null_map[i] != 0;
+        null_bitmap[pos >> 3] |= (static_cast<UInt8>(is_null ^ 1) << (pos & 7));
+        nulls += is_null;
+    }
+    null_cnt += nulls;
+}
+
 void TiDBColumn::finishAppendFixed()
 {
     current_data_size += fixed_size;
@@ -93,7 +128,7 @@ void TiDBColumn::appendNull()
     appendNullBitMap(false);
     if (isFixed())
     {
-        writeString(default_value, *data);
+        data.insert(default_value.data(), default_value.data() + default_value.size());
     }
     else
     {
@@ -105,53 +140,53 @@ void TiDBColumn::appendNull()
 
 void TiDBColumn::append(Int64 value)
 {
-    encodeLittleEndian<Int64>(value, *data);
+    encodeLittleEndian<Int64>(value, data);
     finishAppendFixed();
 }
 
 void TiDBColumn::append(const TiDBEnum & ti_enum)
 {
-    encodeLittleEndian<UInt64>(ti_enum.value, *data);
+    encodeLittleEndian<UInt64>(ti_enum.value, data);
     UInt64 size = 8;
-    data->write(ti_enum.name.data, ti_enum.name.size);
+    data.insert(ti_enum.name.data, ti_enum.name.data + ti_enum.name.size);
     size += ti_enum.name.size;
     finishAppendVar(size);
 }
 
 void TiDBColumn::append(const TiDBBit & bit)
 {
-    data->write(bit.val.data, bit.val.size);
+    data.insert(bit.val.data, bit.val.data + bit.val.size);
     finishAppendVar(bit.val.size);
 }
 
 void TiDBColumn::append(UInt64 value)
 {
-    encodeLittleEndian<UInt64>(value, *data);
+    encodeLittleEndian<UInt64>(value, data);
     finishAppendFixed();
 }
 
 void TiDBColumn::append(const TiDBTime & time)
 {
-    encodeLittleEndian<UInt64>(time.toChunkTime(), *data);
+    encodeLittleEndian<UInt64>(time.toChunkTime(), data);
     finishAppendFixed();
 }
 
 void TiDBColumn::append(const TiDBDecimal & decimal)
 {
-    encodeLittleEndian<UInt8>(decimal.digits_int, *data);
-    encodeLittleEndian<UInt8>(decimal.digits_frac, *data);
-    encodeLittleEndian<UInt8>(decimal.result_frac, *data);
-    encodeLittleEndian<UInt8>((UInt8)decimal.negative, *data);
+    encodeLittleEndian<UInt8>(decimal.digits_int, data);
+    encodeLittleEndian<UInt8>(decimal.digits_frac, data);
+    encodeLittleEndian<UInt8>(decimal.result_frac, data);
+    encodeLittleEndian<UInt8>((UInt8)decimal.negative, data);
     for (int i = 0; i < MAX_WORD_BUF_LEN; i++)
     {
-        encodeLittleEndian<Int32>(decimal.word_buf[i], *data);
+        encodeLittleEndian<Int32>(decimal.word_buf[i], data);
     }
     finishAppendFixed();
 }
 
 void TiDBColumn::append(const StringRef & value)
 {
-    data->write(value.data, value.size);
+    data.insert(value.data, value.data + value.size);
     finishAppendVar(value.size);
 }
 
@@ -160,7 +195,7 @@ void TiDBColumn::append(DB::Float32 value)
     // use memcpy to avoid breaking strict-aliasing rules
     UInt32 u;
     std::memcpy(&u, &value, sizeof(value));
-    encodeLittleEndian<UInt32>(u, *data);
+    encodeLittleEndian<UInt32>(u, data);
     finishAppendFixed();
 }
 
@@ -169,29 +204,81 @@ void TiDBColumn::append(DB::Float64 value)
     // use memcpy to avoid breaking strict-aliasing rules
     UInt64 u;
     std::memcpy(&u, &value, sizeof(value));
-    encodeLittleEndian<UInt64>(u, *data);
+    encodeLittleEndian<UInt64>(u, data);
     finishAppendFixed();
 }
 
+char * TiDBColumn::appendFixedValues(size_t num, size_t value_size, const UInt8 * null_map)
+{
+    if (unlikely(!isFixed() || value_size != static_cast<size_t>(fixed_size)))
+        throw Exception(fmt::format("Can not append values of size {} to column of fixed size {}", value_size, fixed_size),
+                        ErrorCodes::LOGICAL_ERROR);
+
+    appendNullBitMap(null_map, num);
+    size_t old_size = data.size();
+    data.resize(old_size + num * value_size);
+    current_data_size += num * value_size;
+    length += num;
+    return data.data() + old_size;
+}
+
+void TiDBColumn::appendStrings(const ColumnString & column, size_t start, size_t end, const UInt8 * null_map)
+{
+    if (unlikely(isFixed()))
+        throw Exception(fmt::format("Can not append strings to column of fixed size {}", fixed_size), ErrorCodes::LOGICAL_ERROR);
+
+    size_t num = end - start;
+    appendNullBitMap(null_map, num);
+
+    // Calculate the offsets first, so that the strings can be copied into the data without reallocation.
+    size_t old_offsets = var_offsets.size();
+    var_offsets.resize(old_offsets + num);
+    UInt64 data_size = current_data_size;
+    for (size_t i = 0; i < num; ++i)
+    {
+        if (!null_map || !null_map[i])
+            data_size += column.getDataAt(start + i).size;
+        var_offsets[old_offsets + i] = data_size;
+    }
+
+    size_t old_size = data.size();
+    data.resize(old_size + (data_size - current_data_size));
+    char * pos = data.data() + old_size;
+    for (size_t i = 0; i < num; ++i)
+    {
+        if (null_map && null_map[i])
+            continue;
+        auto value = column.getDataAt(start + i);
+        memcpy(pos, value.data, value.size);
+        pos += value.size;
+    }
+    current_data_size = data_size;
+    length += num;
+}
+
 void TiDBColumn::encodeColumn(WriteBuffer & ss)
 {
     encodeLittleEndian<UInt32>(length, ss);
     encodeLittleEndian<UInt32>(null_cnt, ss);
     if (null_cnt > 0)
     {
-        for (auto c : null_bitmap)
-        {
-            encodeLittleEndian<UInt8>(c, ss);
-        }
+        ss.write(reinterpret_cast<const char *>(null_bitmap.data()), null_bitmap.size());
     }
     if (!isFixed())
     {
-        for (auto c : var_offsets)
+        if constexpr (boost::endian::order::native == boost::endian::order::little)
+        {
+            ss.write(reinterpret_cast<const char *>(var_offsets.data()), var_offsets.size() * sizeof(Int64));
+        }
+        else
         {
-            encodeLittleEndian<Int64>(c, ss);
+            for (auto c : var_offsets)
+            {
+                encodeLittleEndian<Int64>(c, ss);
+            }
         }
     }
-    writeString(data->str(), ss);
+    ss.write(data.data(), data.size());
 }
 
 } // namespace DB
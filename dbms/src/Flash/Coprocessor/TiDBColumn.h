@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <Common/PODArray.h>
 #include <DataStreams/IBlockInputStream.h>
 #include <Flash/Coprocessor/DAGUtils.h>
 #include <Flash/Coprocessor/TiDBBit.h>
@@ -24,6 +25,8 @@
 
 namespace DB
 {
+class ColumnString;
+
 class TiDBColumn
 {
 public:
@@ -41,6 +44,14 @@ public:
     void append(const TiDBDecimal & decimal);
     void append(const TiDBBit & bit);
     void append(const TiDBEnum & ti_enum);
+
+    /// Append `num` fixed-size values at a time, which is much cheaper than appending them one by one.
+    /// The caller writes the values in chunk format into the returned buffer of `num * value_size` bytes.
+    /// `null_map` marks the null rows, whose values must be written as zero, or is nullptr if none of the rows is null.
+    char * appendFixedValues(size_t num, size_t value_size, const UInt8 * null_map);
+    /// Append the strings of rows in [start, end) of `column` at a time, `null_map` is the same as `appendFixedValues`.
+    void appendStrings(const ColumnString & column, size_t start, size_t end, const UInt8 * null_map);
+
     void encodeColumn(WriteBuffer & ss);
     void clear();
 
@@ -49,13 +60,13 @@ private:
     void finishAppendFixed();
     void finishAppendVar(UInt32 size);
     void appendNullBitMap(bool value);
+    void appendNullBitMap(const UInt8 * null_map, size_t num);
 
     UInt32 length;
     UInt32 null_cnt;
     std::vector<UInt8> null_bitmap;
     std::vector<Int64> var_offsets;
-    // WriteBufferFromOwnString is not moveable.
-    std::unique_ptr<WriteBufferFromOwnString> data;
+    PODArray<char> data;
     std::string default_value;
     UInt64 current_data_size;
     Int8 fixed_size;
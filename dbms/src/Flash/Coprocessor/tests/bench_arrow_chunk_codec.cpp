@@ -0,0 +1,148 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Columns/ColumnDecimal.h>
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnString.h>
+#include <Columns/ColumnsNumber.h>
+#include <Common/MyTime.h>
+#include <Common/typeid_cast.h>
+#include <Flash/Coprocessor/ArrowChunkCodec.h>
+#include <Flash/Coprocessor/TiDBChunk.h>
+#include <Storages/Transaction/TiDB.h>
+#include <Storages/Transaction/TypeMapping.h>
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+namespace DB
+{
+namespace bench
+{
+/// Encode the columns of a typical result set into the chunk format of TiDB:
+///   BIGINT NOT NULL, DECIMAL(15, 2) NOT NULL, DATETIME NOT NULL, VARCHAR NULL
+/// by the column-at-a-time encoder and by appending the values one by one, which is how they are encoded before.
+class ArrowChunkEncodeBench : public benchmark::Fixture
+{
+public:
+    void SetUp(const benchmark::State &) override
+    {
+        std::vector<TiDB::ColumnInfo> infos(4);
+        infos[0].tp = TiDB::TypeLongLong;
+        infos[1].tp = TiDB::TypeNewDecimal;
+        infos[1].flen = 15;
+        infos[1].decimal = 2;
+        infos[2].tp = TiDB::TypeDatetime;
+        infos[3].tp = TiDB::TypeVarchar;
+        for (size_t i = 0; i < 3; ++i)
+            infos[i].setNotNullFlag();
+        for (const auto & info : infos)
+            field_types.push_back(columnInfoToFieldType(info));
+
+        std::mt19937_64 rng(42);
+        auto ints = ColumnInt64::create();
+        auto decimals = ColumnDecimal<Decimal64>::create(0, 2);
+        auto times = ColumnUInt64::create();
+        auto strings = ColumnString::create();
+        auto null_map = ColumnUInt8::create();
+        for (size_t i = 0; i < rows; ++i)
+        {
+            ints->insert(static_cast<Int64>(rng()));
+            decimals->insert(Decimal64(static_cast<Int64>(rng() % 10000000000000)));
+            times->insert(MyDateTime(1990 + rng() % 30, 1 + rng() % 12, 1 + rng() % 28, rng() % 24, rng() % 60, rng() % 60, 0).toPackedUInt());
+            String str = "value_" + std::to_string(rng() % 100000);
+            strings->insertData(str.data(), str.size());
+            null_map->insert(static_cast<UInt8>(rng() % 10 == 0));
+        }
+        block = Block({
+            {std::move(ints), getDataTypeByColumnInfoForComputingLayer(infos[0]), "i"},
+            {std::move(decimals), getDataTypeByColumnInfoForComputingLayer(infos[1]), "d"},
+            {std::move(times), getDataTypeByColumnInfoForComputingLayer(infos[2]), "t"},
+            {ColumnNullable::create(std::move(strings), std::move(null_map)), getDataTypeByColumnInfoForComputingLayer(infos[3]), "s"},
+        });
+    }
+
+    /// Append the values one by one, just like the encoder before the values are encoded column at a time.
+    void encodeRowByRow(TiDBChunk & chunk, size_t start, size_t end) const
+    {
+        const auto & ints = typeid_cast<const ColumnInt64 &>(*block.getByPosition(0).column);
+        const auto & decimals = typeid_cast<const ColumnDecimal<Decimal64> &>(*block.getByPosition(1).column);
+        const auto & times = typeid_cast<const ColumnUInt64 &>(*block.getByPosition(2).column);
+        const auto & strings = typeid_cast<const ColumnNullable &>(*block.getByPosition(3).column);
+        for (size_t i = start; i < end; ++i)
+            chunk.getColumn(0).append(static_cast<Int64>(ints.getElement(i)));
+        for (size_t i = start; i < end; ++i)
+        {
+            auto value = decimals.getElement(i).value;
+            std::vector<Int32> digits;
+            digits.reserve(15);
+            for (auto v = value < 0 ? -value : value; v != 0; v /= 10)
+                digits.push_back(static_cast<Int32>(v % 10));
+            while (digits.size() < 2)
+                digits.push_back(0);
+            chunk.getColumn(1).append(TiDBDecimal(2, digits, value < 0));
+        }
+        for (size_t i = start; i < end; ++i)
+            chunk.getColumn(2).append(TiDBTime(times.getElement(i), field_types[2]));
+        for (size_t i = start; i < end; ++i)
+        {
+            if (strings.isNullAt(i))
+                chunk.getColumn(3).appendNull();
+            else
+                chunk.getColumn(3).append(strings.getNestedColumn().getDataAt(i));
+        }
+    }
+
+protected:
+    static constexpr size_t rows = 65536;
+    static constexpr size_t rows_per_encode = 8192;
+    std::vector<tipb::FieldType> field_types;
+    Block block;
+};
+
+BENCHMARK_DEFINE_F(ArrowChunkEncodeBench, ColumnAtATime)
+(benchmark::State & state)
+{
+    TiDBChunk chunk(field_types);
+    for (auto _ : state)
+    {
+        for (size_t start = 0; start < rows; start += rows_per_encode)
+            chunk.buildDAGChunkFromBlock(block, field_types, start, start + rows_per_encode);
+        WriteBufferFromOwnString buf;
+        chunk.encodeChunk(buf);
+        benchmark::DoNotOptimize(buf.str());
+        chunk.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK_REGISTER_F(ArrowChunkEncodeBench, ColumnAtATime);
+
+BENCHMARK_DEFINE_F(ArrowChunkEncodeBench, RowByRow)
+(benchmark::State & state)
+{
+    TiDBChunk chunk(field_types);
+    for (auto _ : state)
+    {
+        for (size_t start = 0; start < rows; start += rows_per_encode)
+            encodeRowByRow(chunk, start, start + rows_per_encode);
+        WriteBufferFromOwnString buf;
+        chunk.encodeChunk(buf);
+        benchmark::DoNotOptimize(buf.str());
+        chunk.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK_REGISTER_F(ArrowChunkEncodeBench, RowByRow);
+
+} // namespace bench
+} // namespace DB
@@ -0,0 +1,231 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Common/MyTime.h>
+#include <Core/Field.h>
+#include <Flash/Coprocessor/ArrowChunkCodec.h>
+#include <Flash/Coprocessor/TiDBChunk.h>
+#include <Storages/Transaction/TiDB.h>
+#include <Storages/Transaction/TypeMapping.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <functional>
+#include <random>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+struct ColumnSpec
+{
+    TiDB::ColumnInfo info;
+    std::function<Field(std::mt19937_64 &)> gen;
+};
+
+TiDB::ColumnInfo makeColumnInfo(TiDB::TP tp, bool not_null, bool is_unsigned = false, Int32 flen = 0, Int32 decimal = 0)
+{
+    TiDB::ColumnInfo info;
+    info.tp = tp;
+    if (not_null)
+        info.setNotNullFlag();
+    if (is_unsigned)
+        info.setUnsignedFlag();
+    info.flen = flen;
+    info.decimal = decimal;
+    return info;
+}
+
+Int64 randomInt(std::mt19937_64 & rng, Int64 max)
+{
+    return std::uniform_int_distribution<Int64>(-max, max)(rng);
+}
+
+template <typename T>
+Field randomDecimal(std::mt19937_64 & rng, UInt32 prec, UInt32 scale)
+{
+    // Decimals with all kinds of number of digits, including zero.
+    typename T::NativeType value = 0;
+    UInt32 digits = std::uniform_int_distribution<UInt32>(0, prec)(rng);
+    for (UInt32 i = 0; i < digits; ++i)
+        value = value * 10 + static_cast<Int32>(rng() % 10);
+    if (rng() % 2)
+        value = -value;
+    return DecimalField<T>(T(value), scale);
+}
+
+Field randomTime(std::mt19937_64 & rng, bool is_date)
+{
+    UInt16 year = 1000 + rng() % 9000;
+    UInt8 month = 1 + rng() % 12;
+    UInt8 day = 1 + rng() % 28;
+    if (is_date)
+        return Field(MyDateTime(year, month, day, 0, 0, 0, 0).toPackedUInt());
+    return Field(MyDateTime(year, month, day, rng() % 24, rng() % 60, rng() % 60, rng() % 1000000).toPackedUInt());
+}
+
+std::vector<ColumnSpec> getColumnSpecs()
+{
+    return {
+        {makeColumnInfo(TiDB::TypeLong, true), [](auto & rng) { return Field(randomInt(rng, std::numeric_limits<Int32>::max())); }},
+        {makeColumnInfo(TiDB::TypeTiny, false), [](auto & rng) { return Field(randomInt(rng, 127)); }},
+        {makeColumnInfo(TiDB::TypeLongLong, false, true), [](auto & rng) { return Field(static_cast<UInt64>(rng())); }},
+        {makeColumnInfo(TiDB::TypeFloat, false), [](auto & rng) { return Field(static_cast<Float64>(static_cast<Float32>(randomInt(rng, 1000000)) / 7)); }},
+        {makeColumnInfo(TiDB::TypeDouble, true), [](auto & rng) { return Field(static_cast<Float64>(randomInt(rng, 1000000000)) / 13); }},
+        {makeColumnInfo(TiDB::TypeNewDecimal, true, false, 5, 0), [](auto & rng) { return randomDecimal<Decimal32>(rng, 5, 0); }},
+        {makeColumnInfo(TiDB::TypeNewDecimal, false, false, 15, 4), [](auto & rng) { return randomDecimal<Decimal64>(rng, 15, 4); }},
+        {makeColumnInfo(TiDB::TypeNewDecimal, false, false, 38, 19), [](auto & rng) { return randomDecimal<Decimal128>(rng, 38, 19); }},
+        {makeColumnInfo(TiDB::TypeNewDecimal, true, false, 65, 30), [](auto & rng) { return randomDecimal<Decimal256>(rng, 65, 30); }},
+        {makeColumnInfo(TiDB::TypeDate, true), [](auto & rng) { return randomTime(rng, true); }},
+        {makeColumnInfo(TiDB::TypeDatetime, false, false, 0, 3), [](auto & rng) { return randomTime(rng, false); }},
+        {makeColumnInfo(TiDB::TypeTimestamp, true, false, 0, 6), [](auto & rng) { return randomTime(rng, false); }},
+        {makeColumnInfo(TiDB::TypeVarchar, false), [](auto & rng) { return Field(String(rng() % 20, 'a' + rng() % 26)); }},
+        {makeColumnInfo(TiDB::TypeString, true), [](auto & rng) { return Field(String(rng() % 3, 'x')); }},
+    };
+}
+
+template <typename T>
+bool appendDecimal(TiDBColumn & column, const Field & field)
+{
+    if (field.getType() != Field::TypeToEnum<DecimalField<T>>::value)
+        return false;
+    auto dec = field.get<DecimalField<T>>();
+    auto value = dec.getValue().value;
+    bool negative = value < 0;
+    if (negative)
+        value = -value;
+    std::vector<Int32> digits;
+    for (; value != 0; value /= 10)
+        digits.push_back(static_cast<Int32>(value % 10));
+    while (digits.size() < dec.getScale())
+        digits.push_back(0);
+    column.append(TiDBDecimal(dec.getScale(), digits, negative));
+    return true;
+}
+
+/// Encode the rows one by one by the appending interfaces of TiDBColumn, which is the reference of the encoder.
+void appendRowByRow(TiDBColumn & column, const Field & field, const tipb::FieldType & field_type, const TiDB::ColumnInfo & info)
+{
+    if (field.isNull())
+    {
+        column.appendNull();
+        return;
+    }
+    switch (info.tp)
+    {
+    case TiDB::TypeLong:
+    case TiDB::TypeTiny:
+    case TiDB::TypeLongLong:
+        if (info.hasUnsignedFlag())
+            column.append(field.get<UInt64>());
+        else
+            column.append(field.get<Int64>());
+        break;
+    case TiDB::TypeFloat:
+        column.append(static_cast<Float32>(field.get<Float64>()));
+        break;
+    case TiDB::TypeDouble:
+        column.append(field.get<Float64>());
+        break;
+    case TiDB::TypeNewDecimal:
+        if (!(appendDecimal<Decimal32>(column, field) || appendDecimal<Decimal64>(column, field)
+              || appendDecimal<Decimal128>(column, field) || appendDecimal<Decimal256>(column, field)))
+            throw Exception(fmt::format("Unexpected decimal field of type {}", field.getTypeName()));
+        break;
+    case TiDB::TypeDate:
+    case TiDB::TypeDatetime:
+    case TiDB::TypeTimestamp:
+        column.append(TiDBTime(field.get<UInt64>(), field_type));
+        break;
+    default:
+    {
+        const auto & str = field.get<String>();
+        column.append(StringRef(str));
+        break;
+    }
+    }
+}
+} // namespace
+
+TEST(ArrowChunkCodecTest, EncodeByColumns)
+try
+{
+    auto specs = getColumnSpecs();
+    std::vector<tipb::FieldType> field_types;
+    DAGSchema schema;
+    Block block;
+    std::mt19937_64 rng(42);
+    const size_t rows = 1000;
+    for (size_t i = 0; i < specs.size(); ++i)
+    {
+        const auto & info = specs[i].info;
+        field_types.push_back(columnInfoToFieldType(info));
+        String name = "c" + std::to_string(i);
+        schema.emplace_back(name, info);
+        auto type = getDataTypeByColumnInfoForComputingLayer(info);
+        auto column = type->createColumn();
+        for (size_t row = 0; row < rows; ++row)
+        {
+            // Nulls of nullable columns, the continuous ones and the sparse ones.
+            if (!info.hasNotNullFlag() && ((row / 100) % 3 == 0 || row % 7 == 0))
+                column->insert(Field());
+            else
+                column->insert(specs[i].gen(rng));
+        }
+        block.insert({std::move(column), type, name});
+    }
+
+    // Encode the block by several parts, which are not aligned with the bytes of null bitmap.
+    std::vector<std::pair<size_t, size_t>> ranges{{0, 3}, {3, 3}, {3, 500}, {500, 517}, {517, rows}};
+    auto codec_stream = ArrowChunkCodec().newCodecStream(field_types);
+    std::vector<TiDBColumn> expected_columns;
+    for (const auto & field_type : field_types)
+        expected_columns.emplace_back(getFieldLengthForArrowEncode(field_type.tp()));
+    for (const auto & [start, end] : ranges)
+    {
+        codec_stream->encode(block, start, end);
+        for (size_t i = 0; i < specs.size(); ++i)
+        {
+            const auto & column = block.getByPosition(i).column;
+            for (size_t row = start; row < end; ++row)
+                appendRowByRow(expected_columns[i], (*column)[row], field_types[i], specs[i].info);
+        }
+    }
+
+    WriteBufferFromOwnString expected;
+    for (auto & column : expected_columns)
+        column.encodeColumn(expected);
+    auto encoded = codec_stream->getString();
+    ASSERT_EQ(encoded, expected.str());
+
+    // Decode and check the values.
+    auto decoded = ArrowChunkCodec().decode(encoded, schema);
+    ASSERT_EQ(decoded.rows(), rows);
+    for (size_t i = 0; i < specs.size(); ++i)
+    {
+        const auto & expected_column = block.getByPosition(i).column;
+        const auto & actual_column = decoded.getByPosition(i).column;
+        for (size_t row = 0; row < rows; ++row)
+            ASSERT_EQ((*expected_column)[row], (*actual_column)[row]) << "column " << i << " row " << row;
+    }
+
+    // The memory of chunk is reused after clear.
+    codec_stream->clear();
+    codec_stream->encode(block, 0, rows);
+    ASSERT_EQ(codec_stream->getString(), encoded);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
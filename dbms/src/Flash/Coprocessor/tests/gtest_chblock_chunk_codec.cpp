@@ -0,0 +1,103 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnString.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <DataTypes/DataTypeString.h>
+#include <Flash/Coprocessor/CHBlockChunkCodec.h>
+#include <Storages/Transaction/TiDB.h>
+#include <gtest/gtest.h>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+std::vector<tipb::FieldType> getFieldTypes()
+{
+    TiDB::ColumnInfo not_null_info;
+    not_null_info.tp = TiDB::TypeString;
+    not_null_info.setNotNullFlag();
+    TiDB::ColumnInfo nullable_info;
+    nullable_info.tp = TiDB::TypeString;
+    return {columnInfoToFieldType(not_null_info), columnInfoToFieldType(nullable_info)};
+}
+
+Block getBlock(size_t rows, size_t cardinality)
+{
+    auto not_null_column = ColumnString::create();
+    auto nested_column = ColumnString::create();
+    auto null_map = ColumnUInt8::create();
+    for (size_t i = 0; i < rows; ++i)
+    {
+        String value = "value_" + std::to_string(i % cardinality);
+        not_null_column->insertData(value.data(), value.size());
+        nested_column->insertData(value.data(), value.size());
+        null_map->insert(static_cast<UInt64>(i % 7 == 0));
+    }
+    return Block{
+        {std::move(not_null_column), std::make_shared<DataTypeString>(), "s"},
+        {ColumnNullable::create(std::move(nested_column), std::move(null_map)), makeNullable(std::make_shared<DataTypeString>()), "n"}};
+}
+
+String encode(const Block & block, bool enable_dictionary_encoding)
+{
+    auto codec_stream = CHBlockChunkCodec(enable_dictionary_encoding).newCodecStream(getFieldTypes());
+    codec_stream->encode(block, 0, block.rows());
+    return codec_stream->getString();
+}
+
+void checkBlockEqual(const Block & expected, const Block & actual)
+{
+    ASSERT_EQ(expected.columns(), actual.columns());
+    ASSERT_EQ(expected.rows(), actual.rows());
+    for (size_t i = 0; i < expected.columns(); ++i)
+    {
+        const auto & expected_column = expected.getByPosition(i);
+        const auto & actual_column = actual.getByPosition(i);
+        ASSERT_EQ(expected_column.name, actual_column.name);
+        ASSERT_EQ(expected_column.type->getName(), actual_column.type->getName());
+        for (size_t j = 0; j < expected.rows(); ++j)
+            ASSERT_EQ((*expected_column.column)[j], (*actual_column.column)[j]) << "column " << i << " row " << j;
+    }
+}
+} // namespace
+
+TEST(CHBlockChunkCodecTest, DictionaryEncoding)
+{
+    Block block = getBlock(1000, 10);
+    String plain = encode(block, false);
+    String encoded = encode(block, true);
+    ASSERT_NE(encoded.find("LowCardinality(String)"), String::npos);
+    ASSERT_NE(encoded.find("LowCardinality(Nullable(String))"), String::npos);
+    ASSERT_LT(encoded.size(), plain.size());
+
+    checkBlockEqual(block, CHBlockChunkCodec::decode(plain, block.cloneEmpty()));
+    checkBlockEqual(block, CHBlockChunkCodec::decode(encoded, block.cloneEmpty()));
+}
+
+TEST(CHBlockChunkCodecTest, HighCardinalityNotEncoded)
+{
+    Block block = getBlock(1000, 1000);
+    String encoded = encode(block, true);
+    ASSERT_EQ(encoded.find("LowCardinality("), String::npos);
+    ASSERT_EQ(encoded, encode(block, false));
+
+    checkBlockEqual(block, CHBlockChunkCodec::decode(encoded, block.cloneEmpty()));
+}
+
+} // namespace tests
+} // namespace DB
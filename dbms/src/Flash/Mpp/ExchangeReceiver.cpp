@@ -13,11 +13,13 @@
 // limitations under the License.
 
 #include <Common/CPUAffinityManager.h>
+#include <Common/MemoryTracker.h>
 #include <Common/ThreadFactory.h>
 #include <Common/TiFlashMetrics.h>
 #include <Flash/Coprocessor/CoprocessorReader.h>
 #include <Flash/Mpp/ExchangeReceiver.h>
 #include <Flash/Mpp/MPPTunnel.h>
+#include <Storages/Transaction/TypeMapping.h>
 #include <fmt/core.h>
 
 namespace DB
@@ -41,6 +43,30 @@ String getReceiverStateStr(const ExchangeReceiverState & s)
     }
 }
 
+/// Blocks from a local tunnel keep the column names of the sender, rename them to the ones in
+/// `header` the same way as `CHBlockChunkCodec::decode` does.
+Block alignBlockWithHeader(const Block & block, const Block & header)
+{
+    size_t columns = header.columns();
+    if (unlikely(block.columns() != columns))
+        throw Exception(fmt::format("Column size mismatch of local block, expect {}, actual {}", columns, block.columns()));
+
+    ColumnsWithTypeAndName res;
+    res.reserve(columns);
+    for (size_t i = 0; i < columns; ++i)
+    {
+        const auto & src = block.getByPosition(i);
+        const auto & dst = header.getByPosition(i);
+        if (unlikely(src.type->getName() != dst.type->getName()))
+            throw Exception(fmt::format("Type mismatch of local block at column {}, expect {}, actual {}", i, dst.type->getName(), src.type->getName()));
+        ColumnPtr column = src.column;
+        if (ColumnPtr converted = column->convertToFullColumnIfConst())
+            column = converted;
+        res.emplace_back(std::move(column), dst.type, dst.name);
+    }
+    return Block(res);
+}
+
 enum class AsyncRequestStage
 {
     NEED_INIT,
@@ -69,6 +95,7 @@ public:
     AsyncRequestHandler(
         MPMCQueue<Self *> * queue,
         MPMCQueue<std::shared_ptr<ReceivedMessage>> * msg_channel_,
+        ExchangeMemoryTracker * mem_tracker_,
         const std::shared_ptr<RPCContext> & context,
         const Request & req,
         const String & req_id)
@@ -76,6 +103,7 @@ public:
         , request(&req)
         , notify_queue(queue)
         , msg_channel(msg_channel_)
+        , mem_tracker(mem_tracker_)
         , req_info(fmt::format("tunnel{}+{}", req.send_task_id, req.recv_task_id))
         , log(Logger::get("ExchangeReceiver", req_id, req_info))
     {
@@ -255,10 +283,18 @@ private:
             auto & packet = packets[i];
             auto recv_msg = std::make_shared<ReceivedMessage>();
             recv_msg->packet = std::move(packet);
+            recv_msg->bytes = recv_msg->packet->ByteSizeLong();
+            recv_msg->packet_bytes = recv_msg->bytes;
             recv_msg->source_index = request->source_index;
             recv_msg->req_info = req_info;
+            auto bytes = recv_msg->bytes;
+            mem_tracker->alloc(bytes);
             if (!msg_channel->push(std::move(recv_msg)))
+            {
+                mem_tracker->free(bytes);
                 return false;
+            }
+            GET_METRIC(tiflash_exchange_queueing_data_bytes, type_receive).Increment(bytes);
             // can't reuse packet since it is sent to readers.
             packet = std::make_shared<MPPDataPacket>();
         }
@@ -275,6 +311,7 @@ private:
     const Request * request; // won't be null
     MPMCQueue<Self *> * notify_queue; // won't be null
     MPMCQueue<std::shared_ptr<ReceivedMessage>> * msg_channel; // won't be null
+    ExchangeMemoryTracker * mem_tracker; // won't be null
 
     String req_info;
     bool meet_error = false;
@@ -299,13 +336,22 @@ ExchangeReceiverBase<RPCContext>::ExchangeReceiverBase(
     size_t source_num_,
     size_t max_streams_,
     const String & req_id,
-    const String & executor_id)
+    const String & executor_id,
+    UInt64 max_buffer_bytes_,
+    size_t decode_concurrency_,
+    size_t squash_rows_)
     : rpc_context(std::move(rpc_context_))
     , source_num(source_num_)
     , max_streams(max_streams_)
     , max_buffer_size(std::max<size_t>(batch_packet_count, std::max(source_num, max_streams_) * 2))
     , thread_manager(newThreadManager())
-    , msg_channel(max_buffer_size)
+    , msg_channel(
+          max_buffer_size,
+          static_cast<Int64>(max_buffer_bytes_),
+          [](const std::shared_ptr<ReceivedMessage> & msg) { return msg->bytes; })
+    , decode_concurrency(std::min(decode_concurrency_, source_num))
+    , squash_rows(squash_rows_)
+    , mem_tracker(current_memory_tracker)
     , live_connections(source_num)
     , state(ExchangeReceiverState::NORMAL)
     , exc_log(Logger::get("ExchangeReceiver", req_id, executor_id))
@@ -314,6 +360,19 @@ ExchangeReceiverBase<RPCContext>::ExchangeReceiverBase(
     try
     {
         rpc_context->fillSchema(schema);
+        if (decode_concurrency > 0)
+        {
+            ColumnsWithTypeAndName columns;
+            for (const auto & col : schema)
+                columns.emplace_back(getDataTypeByColumnInfoForComputingLayer(col.second), col.first);
+            decode_header = Block(columns);
+            for (size_t i = 0; i < decode_concurrency; ++i)
+                decode_queues.push_back(std::make_unique<MPMCQueue<std::shared_ptr<ReceivedMessage>>>(
+                    batch_packet_count,
+                    0,
+                    [](const std::shared_ptr<ReceivedMessage> & msg) { return msg->bytes; }));
+            live_decoders = decode_concurrency;
+        }
         setUpConnection();
     }
     catch (...)
@@ -338,6 +397,10 @@ ExchangeReceiverBase<RPCContext>::~ExchangeReceiverBase()
     {
         close();
         thread_manager->wait();
+        Int64 queueing_bytes = msg_channel.bytes();
+        for (const auto & queue : decode_queues)
+            queueing_bytes += queue->bytes();
+        GET_METRIC(tiflash_exchange_queueing_data_bytes, type_receive).Decrement(queueing_bytes);
     }
     catch (...)
     {
@@ -349,14 +412,15 @@ template <typename RPCContext>
 void ExchangeReceiverBase<RPCContext>::cancel()
 {
     setEndState(ExchangeReceiverState::CANCELED);
-    msg_channel.finish();
+    finishReceiveChannels(true);
 }
 
 template <typename RPCContext>
 void ExchangeReceiverBase<RPCContext>::close()
 {
     setEndState(ExchangeReceiverState::CLOSED);
-    msg_channel.finish();
+    finishReceiveChannels(true);
+    mem_tracker.release();
 }
 
 template <typename RPCContext>
@@ -382,6 +446,115 @@ void ExchangeReceiverBase<RPCContext>::setUpConnection()
         thread_manager->schedule(true, "RecvReactor", [this, async_requests = std::move(async_requests)] { reactor(async_requests); });
         ++thread_count;
     }
+
+    for (size_t index = 0; index < decode_concurrency; ++index)
+    {
+        thread_manager->schedule(true, "RecvDecoder", [this, index] { decodeLoop(index); });
+        ++thread_count;
+    }
+}
+
+template <typename RPCContext>
+MPMCQueue<std::shared_ptr<ReceivedMessage>> * ExchangeReceiverBase<RPCContext>::getReceiveChannel(size_t source_index)
+{
+    if (decode_queues.empty())
+        return &msg_channel;
+    return decode_queues[source_index % decode_queues.size()].get();
+}
+
+template <typename RPCContext>
+void ExchangeReceiverBase<RPCContext>::decodeLoop(size_t index)
+{
+    auto & decode_queue = *decode_queues[index];
+    SquashingTransform squashing(squash_rows, 0, exc_log->identifier());
+    bool meet_error = false;
+    String local_err_msg;
+    /// The message being decoded, its packet bytes are freed here unless it is passed to `msg_channel`.
+    std::shared_ptr<ReceivedMessage> recv_msg;
+    try
+    {
+        while (decode_queue.pop(recv_msg))
+        {
+            GET_METRIC(tiflash_exchange_queueing_data_bytes, type_receive).Decrement(recv_msg->bytes);
+            decodeReceivedMessage(*recv_msg, squashing);
+            auto bytes = recv_msg->bytes;
+            if (!msg_channel.push(std::move(recv_msg)))
+                break;
+            recv_msg = nullptr;
+            GET_METRIC(tiflash_exchange_queueing_data_bytes, type_receive).Increment(bytes);
+        }
+    }
+    catch (...)
+    {
+        meet_error = true;
+        local_err_msg = getCurrentExceptionMessage(false);
+    }
+    if (recv_msg)
+        mem_tracker.free(recv_msg->packet_bytes);
+    decoderDone(meet_error, local_err_msg);
+}
+
+template <typename RPCContext>
+void ExchangeReceiverBase<RPCContext>::decodeReceivedMessage(ReceivedMessage & recv_msg, SquashingTransform & squashing)
+{
+    auto & packet = *recv_msg.packet;
+    if (packet.has_error() || packet.chunks_size() == 0)
+        return;
+
+    for (const auto & chunk : packet.chunks())
+    {
+        Block block = CHBlockChunkCodec::decode(chunk, decode_header);
+        if (unlikely(block.rows() == 0))
+            continue;
+        auto result = squashing.add(std::move(block));
+        if (result.ready)
+            recv_msg.blocks.push_back(std::move(result.block));
+    }
+    /// flush the accumulated block, blocks are never merged across packets.
+    auto result = squashing.add({});
+    if (result.block)
+        recv_msg.blocks.push_back(std::move(result.block));
+
+    packet.clear_chunks();
+    recv_msg.bytes = packet.ByteSizeLong();
+    mem_tracker.free(recv_msg.packet_bytes - recv_msg.bytes);
+    recv_msg.packet_bytes = recv_msg.bytes;
+    for (const auto & block : recv_msg.blocks)
+        recv_msg.bytes += block.bytes();
+}
+
+template <typename RPCContext>
+void ExchangeReceiverBase<RPCContext>::decoderDone(bool meet_error, const String & local_err_msg)
+{
+    if (meet_error)
+    {
+        LOG_FMT_WARNING(exc_log, "decoder meet error: {}", local_err_msg);
+        std::unique_lock lock(mu);
+        if (state == ExchangeReceiverState::NORMAL)
+            state = ExchangeReceiverState::ERROR;
+        if (err_msg.empty())
+            err_msg = local_err_msg;
+    }
+    if (meet_error)
+        finishReceiveChannels(true);
+    else if (--live_decoders == 0)
+        msg_channel.finish();
+}
+
+template <typename RPCContext>
+void ExchangeReceiverBase<RPCContext>::finishReceiveChannels(bool meet_error)
+{
+    /// Without the decode stage, or on error, `msg_channel` is finished at once. Otherwise
+    /// the decoders finish it after all the received messages are decoded.
+    for (auto & queue : decode_queues)
+    {
+        if (meet_error)
+            queue->cancel();
+        else
+            queue->finish();
+    }
+    if (meet_error || decode_queues.empty())
+        msg_channel.finish();
 }
 
 template <typename RPCContext>
@@ -403,7 +576,7 @@ void ExchangeReceiverBase<RPCContext>::reactor(const std::vector<Request> & asyn
     std::vector<std::unique_ptr<AsyncHandler>> handlers;
     handlers.reserve(alive_async_connections);
     for (const auto & req : async_requests)
-        handlers.emplace_back(std::make_unique<AsyncHandler>(&ready_requests, &msg_channel, rpc_context, req, exc_log->identifier()));
+        handlers.emplace_back(std::make_unique<AsyncHandler>(&ready_requests, getReceiveChannel(req.source_index), &mem_tracker, rpc_context, req, exc_log->identifier()));
 
     while (alive_async_connections > 0)
     {
@@ -476,15 +649,27 @@ void ExchangeReceiverBase<RPCContext>::readLoop(const Request & req)
                 recv_msg->packet = std::make_shared<MPPDataPacket>();
                 recv_msg->req_info = req_info;
                 recv_msg->source_index = req.source_index;
-                bool success = reader->read(recv_msg->packet);
+                bool success = reader->read(recv_msg->packet, recv_msg->blocks);
                 if (!success)
                     break;
                 has_data = true;
                 if (recv_msg->packet->has_error())
                     throw Exception("Exchange receiver meet error : " + recv_msg->packet->error().msg());
 
-                if (!msg_channel.push(std::move(recv_msg)))
+                recv_msg->packet_bytes = recv_msg->packet->ByteSizeLong();
+                recv_msg->bytes = recv_msg->packet_bytes;
+                for (const auto & block : recv_msg->blocks)
+                    recv_msg->bytes += block.bytes();
+                auto bytes = recv_msg->bytes;
+                auto packet_bytes = recv_msg->packet_bytes;
+                mem_tracker.alloc(packet_bytes);
+                if (getReceiveChannel(req.source_index)->push(std::move(recv_msg)))
+                {
+                    GET_METRIC(tiflash_exchange_queueing_data_bytes, type_receive).Increment(bytes);
+                }
+                else
                 {
+                    mem_tracker.free(packet_bytes);
                     meet_error = true;
                     auto local_state = getState();
                     local_err_msg = "receiver's state is " + getReceiverStateStr(local_state) + ", exit from readLoop";
@@ -570,6 +755,27 @@ DecodeDetail ExchangeReceiverBase<RPCContext>::decodeChunks(
     return detail;
 }
 
+template <typename RPCContext>
+DecodeDetail ExchangeReceiverBase<RPCContext>::moveLocalBlocks(
+    const std::shared_ptr<ReceivedMessage> & recv_msg,
+    std::queue<Block> & block_queue,
+    const Block & header)
+{
+    assert(recv_msg != nullptr);
+    DecodeDetail detail;
+
+    for (auto & block : recv_msg->blocks)
+    {
+        if (unlikely(block.rows() == 0))
+            continue;
+        detail.rows += block.rows();
+        detail.packet_bytes += block.bytes();
+        block_queue.push(alignBlockWithHeader(block, header));
+    }
+    recv_msg->blocks.clear();
+    return detail;
+}
+
 template <typename RPCContext>
 ExchangeReceiverResult ExchangeReceiverBase<RPCContext>::nextResult(std::queue<Block> & block_queue, const Block & header)
 {
@@ -597,6 +803,9 @@ ExchangeReceiverResult ExchangeReceiverBase<RPCContext>::nextResult(std::queue<B
         }
     }
     assert(recv_msg != nullptr && recv_msg->packet != nullptr);
+    GET_METRIC(tiflash_exchange_queueing_data_bytes, type_receive).Decrement(recv_msg->bytes);
+    mem_tracker.free(recv_msg->packet_bytes);
+
     ExchangeReceiverResult result;
     if (recv_msg->packet->has_error())
     {
@@ -631,6 +840,11 @@ ExchangeReceiverResult ExchangeReceiverBase<RPCContext>::nextResult(std::queue<B
             assert(result.decode_detail.rows == 0);
             result.decode_detail = decodeChunks(recv_msg, block_queue, header);
         }
+        if (!result.meet_error && !recv_msg->blocks.empty())
+        {
+            assert(result.decode_detail.rows == 0);
+            result.decode_detail = moveLocalBlocks(recv_msg, block_queue, header);
+        }
     }
     return result;
 }
@@ -688,7 +902,7 @@ void ExchangeReceiverBase<RPCContext>::connectionDone(
         throw Exception("live_connections should not be less than 0!");
 
     if (meet_error || copy_live_conn == 0)
-        msg_channel.finish();
+        finishReceiveChannels(meet_error);
 }
 
 /// Explicit template instantiations - to avoid code bloat in headers.
@@ -16,12 +16,14 @@
 
 #include <Common/MPMCQueue.h>
 #include <Common/ThreadManager.h>
+#include <DataStreams/SquashingTransform.h>
 #include <Flash/Coprocessor/CHBlockChunkCodec.h>
 #include <Flash/Coprocessor/ChunkCodec.h>
 #include <Flash/Coprocessor/DAGContext.h>
 #include <Flash/Coprocessor/DAGUtils.h>
 #include <Flash/Coprocessor/DecodeDetail.h>
 #include <Flash/Mpp/GRPCReceiverContext.h>
+#include <Flash/Mpp/Utils.h>
 #include <Interpreters/Context.h>
 #include <kvproto/mpp.pb.h>
 #include <tipb/executor.pb.h>
@@ -36,6 +38,13 @@ namespace DB
 struct ReceivedMessage
 {
     std::shared_ptr<mpp::MPPDataPacket> packet;
+    /// blocks received from a local tunnel without encoding, or decoded by the decode stage.
+    Blocks blocks;
+    /// bytes of `packet` and `blocks`, `msg_channel` is bounded by it.
+    Int64 bytes = 0;
+    /// bytes of `packet`, the blocks are already tracked by `Allocator` so only these bytes are accounted
+    /// to the memory tracker of the query while the message is queued.
+    Int64 packet_bytes = 0;
     size_t source_index = 0;
     String req_info;
 };
@@ -92,7 +101,10 @@ public:
         size_t source_num_,
         size_t max_streams_,
         const String & req_id,
-        const String & executor_id);
+        const String & executor_id,
+        UInt64 max_buffer_bytes_ = 0,
+        size_t decode_concurrency_ = 0,
+        size_t squash_rows_ = 0);
 
     ~ExchangeReceiverBase();
 
@@ -131,6 +143,14 @@ private:
     void readLoop(const Request & req);
     void reactor(const std::vector<Request> & async_requests);
 
+    /// If the decode stage is enabled, received messages are pushed to one of `decode_queues`
+    /// selected by the source index, so messages from the same source are decoded in order.
+    MPMCQueue<std::shared_ptr<ReceivedMessage>> * getReceiveChannel(size_t source_index);
+    void decodeLoop(size_t index);
+    void decodeReceivedMessage(ReceivedMessage & recv_msg, SquashingTransform & squashing);
+    void decoderDone(bool meet_error, const String & local_err_msg);
+    void finishReceiveChannels(bool meet_error);
+
     bool setEndState(ExchangeReceiverState new_state);
     ExchangeReceiverState getState();
 
@@ -139,6 +159,10 @@ private:
         std::queue<Block> & block_queue,
         const Block & header);
 
+    DecodeDetail moveLocalBlocks(
+        const std::shared_ptr<ReceivedMessage> & recv_msg,
+        std::queue<Block> & block_queue,
+        const Block & header);
 
     void connectionDone(
         bool meet_error,
@@ -158,6 +182,17 @@ private:
 
     MPMCQueue<std::shared_ptr<ReceivedMessage>> msg_channel;
 
+    /// The optional decode stage: `decode_concurrency` workers decode the chunks of received packets
+    /// into blocks of `decode_header` and merge small blocks up to `squash_rows` rows.
+    const size_t decode_concurrency;
+    const size_t squash_rows;
+    Block decode_header;
+    std::vector<std::unique_ptr<MPMCQueue<std::shared_ptr<ReceivedMessage>>>> decode_queues;
+    std::atomic<size_t> live_decoders{0};
+    /// the memory tracker of the query captured at construction, the packets in `msg_channel` and `decode_queues`
+    /// are allocated and freed against it, no matter which thread pushes or pops them.
+    ExchangeMemoryTracker mem_tracker;
+
     std::mutex mu;
     /// should lock `mu` when visit these members
     Int32 live_connections;
@@ -133,10 +133,21 @@ struct LocalExchangePacketReader : public ExchangePacketReader
 
     bool read(MPPDataPacketPtr & packet) override
     {
-        MPPDataPacketPtr tmp_packet = tunnel->readForLocal();
-        bool success = tmp_packet != nullptr;
+        Blocks blocks;
+        bool success = read(packet, blocks);
+        RUNTIME_CHECK(blocks.empty(), Exception, "Receive blocks from local tunnel but the reader can not handle them");
+        return success;
+    }
+
+    bool read(MPPDataPacketPtr & packet, Blocks & blocks) override
+    {
+        MPPTunnelMessage msg;
+        bool success = tunnel->readForLocal(msg);
         if (success)
-            packet = tmp_packet;
+        {
+            packet = std::move(msg.packet);
+            blocks = std::move(msg.blocks);
+        }
         return success;
     }
 
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <Common/UnaryCallback.h>
+#include <Core/Block.h>
 #include <Flash/Coprocessor/ChunkCodec.h>
 #include <Flash/Mpp/MPPTaskManager.h>
 #include <common/types.h>
@@ -36,6 +37,11 @@ class ExchangePacketReader
 public:
     virtual ~ExchangePacketReader() = default;
     virtual bool read(MPPDataPacketPtr & packet) = 0;
+    /// Only local readers may return blocks that are passed without encoding, see `MPPTunnelMessage`.
+    virtual bool read(MPPDataPacketPtr & packet, Blocks & /*blocks*/)
+    {
+        return read(packet);
+    }
     virtual ::grpc::Status finish() = 0;
 };
 using ExchangePacketReaderPtr = std::shared_ptr<ExchangePacketReader>;
@@ -27,6 +27,7 @@
 #include <Flash/Mpp/MPPTunnelSet.h>
 #include <Flash/Mpp/MinTSOScheduler.h>
 #include <Flash/Mpp/Utils.h>
+#include <Flash/Statistics/traverseExecutors.h>
 #include <Interpreters/ProcessList.h>
 #include <Interpreters/executeQuery.h>
 #include <Storages/Transaction/KVStore.h>
@@ -71,7 +72,7 @@ MPPTask::~MPPTask()
     {
         /// the threads of this task are not fully freed now, since the BlockIO and DAGContext are not destructed
         /// TODO: finish all threads before here, except the current one.
-        manager->releaseThreadsFromScheduler(needed_threads);
+        manager->releaseResourcesFromScheduler(id.start_ts, needed_threads, reserved_memory, memory_tracker ? memory_tracker->getPeak() : 0);
         schedule_state = ScheduleState::COMPLETED;
     }
     LOG_FMT_DEBUG(log, "finish MPPTask: {}", id.toString());
@@ -218,7 +219,15 @@ void MPPTask::prepare(const mpp::DispatchTaskRequest & task_request)
             throw TiFlashException("Failed to decode task meta info in ExchangeSender", Errors::Coprocessor::BadRequest);
         bool is_local = context->getSettingsRef().enable_local_tunnel && meta.address() == task_meta.address();
         bool is_async = !is_local && context->getSettingsRef().enable_async_server;
-        MPPTunnelPtr tunnel = std::make_shared<MPPTunnel>(task_meta, task_request.meta(), timeout, context->getSettingsRef().max_threads, is_local, is_async, log->identifier());
+        MPPTunnelPtr tunnel = std::make_shared<MPPTunnel>(
+            task_meta,
+            task_request.meta(),
+            timeout,
+            context->getSettingsRef().max_threads,
+            is_local,
+            is_async,
+            log->identifier(),
+            context->getSettingsRef().max_mpp_tunnel_queue_bytes);
         LOG_FMT_DEBUG(log, "begin to register the tunnel {}", tunnel->id());
         registerTunnel(MPPTaskId{task_meta.start_ts(), task_meta.task_id()}, tunnel);
         if (!dag_context->isRootMPPTask())
@@ -281,11 +290,14 @@ void MPPTask::runImpl()
         preprocess();
         needed_threads = estimateCountOfNewThreads();
         LOG_FMT_DEBUG(log, "Estimate new thread count of query :{} including tunnel_threads: {} , receiver_threads: {}", needed_threads, dag_context->tunnel_set->getRemoteTunnelCnt(), dag_context->getNewThreadCountOfExchangeReceiver());
+        memory_hint = estimateMemoryHint();
+        scheduling_priority = context->getSettingsRef().mpp_task_scheduling_priority;
 
         scheduleOrWait();
 
         LOG_FMT_INFO(log, "task starts running");
         memory_tracker = current_memory_tracker;
+        tunnel_set->setMemoryTracker(memory_tracker);
         if (status.load() != RUNNING)
         {
             /// when task is in running state, canceling the task will call sendCancelToQuery to do the cancellation, however
@@ -451,6 +463,28 @@ int MPPTask::estimateCountOfNewThreads()
         + dag_context->tunnel_set->getRemoteTunnelCnt();
 }
 
+/// Joins, aggregations and sorts hold data in memory, so each of them is supposed to use
+/// `task_scheduler_memory_hint_per_thread` for every thread of the task.
+UInt64 MPPTask::estimateMemoryHint() const
+{
+    size_t memory_intensive_executors = 0;
+    traverseExecutors(&dag_req, [&](const tipb::Executor & executor) {
+        switch (executor.tp())
+        {
+        case tipb::ExecType::TypeJoin:
+        case tipb::ExecType::TypeAggregation:
+        case tipb::ExecType::TypeStreamAgg:
+        case tipb::ExecType::TypeTopN:
+            ++memory_intensive_executors;
+            break;
+        default:
+            break;
+        }
+        return true;
+    });
+    return context->getSettingsRef().task_scheduler_memory_hint_per_thread * needed_threads * std::max<size_t>(1, memory_intensive_executors);
+}
+
 int MPPTask::getNeededThreads()
 {
     if (needed_threads == 0)
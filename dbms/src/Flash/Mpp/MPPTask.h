@@ -66,6 +66,14 @@ public:
 
     int getNeededThreads();
 
+    /// the hint of memory usage from the operators of this task, used by the scheduler to reserve memory.
+    UInt64 getMemoryHint() const { return memory_hint; }
+
+    Int64 getSchedulingPriority() const { return scheduling_priority; }
+
+    /// only called by the scheduler under the lock protection of MPPTaskManager.
+    void setReservedMemory(UInt64 reserved_memory_) { reserved_memory = reserved_memory_; }
+
     enum class ScheduleState
     {
         WAITING,
@@ -84,7 +92,11 @@ public:
 
     ~MPPTask();
 
+#ifndef DBMS_PUBLIC_GTEST
 private:
+#else
+public:
+#endif
     MPPTask(const mpp::TaskMeta & meta_, const ContextPtr & context_);
 
     void runImpl();
@@ -107,6 +119,8 @@ private:
 
     int estimateCountOfNewThreads();
 
+    UInt64 estimateMemoryHint() const;
+
     tipb::DAGRequest dag_req;
 
     ContextPtr context;
@@ -134,6 +148,9 @@ private:
     friend class MPPTaskManager;
 
     int needed_threads;
+    UInt64 memory_hint = 0;
+    UInt64 reserved_memory = 0;
+    Int64 scheduling_priority = 0;
 
     std::mutex schedule_mu;
     std::condition_variable schedule_cv;
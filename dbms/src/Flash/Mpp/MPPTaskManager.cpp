@@ -211,10 +211,16 @@ bool MPPTaskManager::tryToScheduleTask(const MPPTaskPtr & task)
     return scheduler->tryToSchedule(task, *this);
 }
 
-void MPPTaskManager::releaseThreadsFromScheduler(const int needed_threads)
+void MPPTaskManager::releaseResourcesFromScheduler(UInt64 query_id, const int needed_threads, UInt64 reserved_memory, Int64 peak_memory)
 {
     std::lock_guard lock(mu);
-    scheduler->releaseThreadsThenSchedule(needed_threads, *this);
+    scheduler->releaseResourcesThenSchedule(query_id, needed_threads, reserved_memory, peak_memory, *this);
+}
+
+std::vector<MinTSOScheduler::QueryStatus> MPPTaskManager::getSchedulerQueryStatuses()
+{
+    std::lock_guard lock(mu);
+    return scheduler->getQueryStatuses(*this);
 }
 
 } // namespace DB
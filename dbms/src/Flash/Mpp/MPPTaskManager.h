@@ -75,7 +75,9 @@ public:
 
     bool tryToScheduleTask(const MPPTaskPtr & task);
 
-    void releaseThreadsFromScheduler(const int needed_threads);
+    void releaseResourcesFromScheduler(UInt64 query_id, const int needed_threads, UInt64 reserved_memory, Int64 peak_memory);
+
+    std::vector<MinTSOScheduler::QueryStatus> getSchedulerQueryStatuses();
 
     MPPTaskPtr findTaskWithTimeout(const mpp::TaskMeta & meta, std::chrono::seconds timeout, std::string & errMsg);
 
@@ -35,7 +35,8 @@ MPPTunnelBase<Writer>::MPPTunnelBase(
     int input_steams_num_,
     bool is_local_,
     bool is_async_,
-    const String & req_id)
+    const String & req_id,
+    UInt64 max_queue_bytes_)
     : connected(false)
     , finished(false)
     , is_local(is_local_)
@@ -43,7 +44,10 @@ MPPTunnelBase<Writer>::MPPTunnelBase(
     , timeout(timeout_)
     , tunnel_id(fmt::format("tunnel{}+{}", sender_meta_.task_id(), receiver_meta_.task_id()))
     , input_streams_num(input_steams_num_)
-    , send_queue(std::max(5, input_steams_num_ * 5)) // MPMCQueue can benefit from a slightly larger queue size
+    , send_queue(
+          std::max(5, input_steams_num_ * 5), // MPMCQueue can benefit from a slightly larger queue size
+          static_cast<Int64>(max_queue_bytes_),
+          [](const MPPTunnelMessage & msg) { return msg.bytes; })
     , thread_manager(newThreadManager())
     , log(Logger::get("MPPTunnel", req_id, tunnel_id))
 {
@@ -58,7 +62,8 @@ MPPTunnelBase<Writer>::MPPTunnelBase(
     int input_steams_num_,
     bool is_local_,
     bool is_async_,
-    const String & req_id)
+    const String & req_id,
+    UInt64 max_queue_bytes_)
     : connected(false)
     , finished(false)
     , is_local(is_local_)
@@ -66,7 +71,10 @@ MPPTunnelBase<Writer>::MPPTunnelBase(
     , timeout(timeout_)
     , tunnel_id(tunnel_id_)
     , input_streams_num(input_steams_num_)
-    , send_queue(std::max(5, input_steams_num_ * 5)) // MPMCQueue can benefit from a slightly larger queue size
+    , send_queue(
+          std::max(5, input_steams_num_ * 5), // MPMCQueue can benefit from a slightly larger queue size
+          static_cast<Int64>(max_queue_bytes_),
+          [](const MPPTunnelMessage & msg) { return msg.bytes; })
     , thread_manager(newThreadManager())
     , log(Logger::get("MPPTunnel", req_id, tunnel_id))
 {
@@ -78,6 +86,7 @@ MPPTunnelBase<Writer>::~MPPTunnelBase()
 {
     SCOPE_EXIT({
         GET_METRIC(tiflash_object_count, type_count_of_mpptunnel).Decrement();
+        GET_METRIC(tiflash_exchange_queueing_data_bytes, type_send).Decrement(send_queue.bytes());
     });
     try
     {
@@ -128,7 +137,13 @@ void MPPTunnelBase<Writer>::close(const String & reason)
                 try
                 {
                     FAIL_POINT_TRIGGER_EXCEPTION(FailPoints::exception_during_mpp_close_tunnel);
-                    send_queue.push(std::make_shared<mpp::MPPDataPacket>(getPacketWithError(reason)));
+                    auto packet = std::make_shared<mpp::MPPDataPacket>(getPacketWithError(reason));
+                    auto bytes = static_cast<Int64>(packet->ByteSizeLong());
+                    mem_tracker.alloc(bytes);
+                    if (send_queue.push(MPPTunnelMessage{std::move(packet), {}, bytes, bytes}))
+                        GET_METRIC(tiflash_exchange_queueing_data_bytes, type_send).Increment(bytes);
+                    else
+                        mem_tracker.free(bytes);
                     if (!is_local && is_async)
                         writer->tryFlushOne();
                 }
@@ -146,6 +161,7 @@ void MPPTunnelBase<Writer>::close(const String & reason)
             return;
         }
     }
+    mem_tracker.release();
     waitForConsumerFinish(/*allow_throw=*/false);
 }
 
@@ -154,15 +170,40 @@ template <typename Writer>
 void MPPTunnelBase<Writer>::write(const mpp::MPPDataPacket & data, bool close_after_write)
 {
     LOG_FMT_TRACE(log, "ready to write");
+    auto bytes = static_cast<Int64>(data.ByteSizeLong());
+    pushMessage(MPPTunnelMessage{std::make_shared<mpp::MPPDataPacket>(data), {}, bytes, bytes}, close_after_write);
+}
+
+template <typename Writer>
+void MPPTunnelBase<Writer>::writeLocal(const mpp::MPPDataPacket & data, Blocks blocks)
+{
+    RUNTIME_ASSERT(is_local, log, "should not reach writeLocal for remote tunnels");
+    RUNTIME_ASSERT(data.chunks().empty(), log, "the packet written along with blocks should not contain chunks");
+    LOG_FMT_TRACE(log, "ready to write {} blocks", blocks.size());
+    auto packet_bytes = static_cast<Int64>(data.ByteSizeLong());
+    auto bytes = packet_bytes;
+    for (const auto & block : blocks)
+        bytes += block.bytes();
+    pushMessage(MPPTunnelMessage{std::make_shared<mpp::MPPDataPacket>(data), std::move(blocks), bytes, packet_bytes}, /*close_after_write=*/false);
+}
+
+template <typename Writer>
+void MPPTunnelBase<Writer>::pushMessage(MPPTunnelMessage && msg, bool close_after_write)
+{
     {
         std::unique_lock lk(mu);
         waitUntilConnectedOrFinished(lk);
         if (finished)
             throw Exception("write to tunnel which is already closed," + consumer_state.getError());
 
-        if (send_queue.push(std::make_shared<mpp::MPPDataPacket>(data)))
+        auto bytes = msg.bytes;
+        auto packet_bytes = msg.packet_bytes;
+        /// account the packet before pushing it, otherwise it may be popped and freed before being allocated.
+        mem_tracker.alloc(packet_bytes);
+        if (send_queue.push(std::move(msg)))
         {
-            connection_profile_info.bytes += data.ByteSizeLong();
+            GET_METRIC(tiflash_exchange_queueing_data_bytes, type_send).Increment(bytes);
+            connection_profile_info.bytes += packet_bytes;
             connection_profile_info.packets += 1;
             if (!is_local && is_async)
                 writer->tryFlushOne();
@@ -173,6 +214,7 @@ void MPPTunnelBase<Writer>::write(const mpp::MPPDataPacket & data, bool close_af
             }
             return;
         }
+        mem_tracker.free(packet_bytes);
     }
     // push failed, wait consumer for the final state
     waitForConsumerFinish(/*allow_throw=*/true);
@@ -191,10 +233,11 @@ void MPPTunnelBase<Writer>::sendJob(bool need_lock)
     try
     {
         /// TODO(fzh) reuse it later
-        MPPDataPacketPtr res;
+        MPPTunnelMessage res;
         while (send_queue.pop(res))
         {
-            if (!writer->write(*res))
+            onMessagePopped(res);
+            if (!writer->write(*res.packet))
             {
                 err_msg = "grpc writes failed.";
                 break;
@@ -243,18 +286,28 @@ void MPPTunnelBase<Writer>::writeDone()
         waitUntilConnectedOrFinished(lk);
         finishSendQueue();
     }
+    mem_tracker.release();
     waitForConsumerFinish(/*allow_throw=*/true);
 }
 
 template <typename Writer>
-std::shared_ptr<mpp::MPPDataPacket> MPPTunnelBase<Writer>::readForLocal()
+bool MPPTunnelBase<Writer>::readForLocal(MPPTunnelMessage & msg)
 {
     RUNTIME_ASSERT(is_local, log, "should not reach readForLocal for remote tunnels");
-    MPPDataPacketPtr res;
-    if (send_queue.pop(res))
-        return res;
+    if (send_queue.pop(msg))
+    {
+        onMessagePopped(msg);
+        return true;
+    }
     consumerFinish("");
-    return nullptr;
+    return false;
+}
+
+template <typename Writer>
+void MPPTunnelBase<Writer>::onMessagePopped(const MPPTunnelMessage & msg)
+{
+    GET_METRIC(tiflash_exchange_queueing_data_bytes, type_send).Decrement(msg.bytes);
+    mem_tracker.free(msg.packet_bytes);
 }
 
 template <typename Writer>
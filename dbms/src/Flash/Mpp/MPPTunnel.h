@@ -17,8 +17,10 @@
 #include <Common/Logger.h>
 #include <Common/MPMCQueue.h>
 #include <Common/ThreadManager.h>
+#include <Core/Block.h>
 #include <Flash/FlashService.h>
 #include <Flash/Mpp/PacketWriter.h>
+#include <Flash/Mpp/Utils.h>
 #include <Flash/Statistics/ConnectionProfileInfo.h>
 #include <common/logger_useful.h>
 #include <common/types.h>
@@ -50,6 +52,23 @@ class TestMPPTunnelBase;
 
 class EstablishCallData;
 
+using MPPDataPacketPtr = std::shared_ptr<mpp::MPPDataPacket>;
+
+/// The element of MPPTunnel's `send_queue`.
+/// `packet` is always set. For local tunnels in zero-copy mode, the sender's blocks are put into `blocks`
+/// as they are instead of being encoded into `packet.chunks`, and `packet` only carries the error or the
+/// serialized execution summaries.
+struct MPPTunnelMessage
+{
+    MPPDataPacketPtr packet;
+    Blocks blocks;
+    /// bytes of `packet` and `blocks`, `send_queue` is bounded by it.
+    Int64 bytes = 0;
+    /// bytes of `packet`, the blocks are already tracked by `Allocator` so only these bytes are accounted
+    /// to the memory tracker while the message is queued.
+    Int64 packet_bytes = 0;
+};
+
 /**
  * MPPTunnelBase represents the sender of an exchange connection.
  *
@@ -77,6 +96,9 @@ class EstablishCallData;
  * - Consumer's state is saved in `consumer_state` and be available after consumer finished.
  *
  * NOTE: to avoid deadlock, `waitForConsumerFinish` should be called outside of the protection of `mu`.
+ *
+ * `send_queue` is bounded by both the count and the bytes of the messages in it. The packet bytes in the queue
+ * are accounted to the memory tracker of the query, which is set by `setMemoryTracker` when the task starts running.
  */
 template <typename Writer>
 class MPPTunnelBase : private boost::noncopyable
@@ -89,7 +111,8 @@ public:
         int input_steams_num_,
         bool is_local_,
         bool is_async_,
-        const String & req_id);
+        const String & req_id,
+        UInt64 max_queue_bytes_ = 0);
 
     ~MPPTunnelBase();
 
@@ -98,10 +121,14 @@ public:
     // write a single packet to the tunnel, it will block if tunnel is not ready.
     void write(const mpp::MPPDataPacket & data, bool close_after_write = false);
 
+    // write blocks to a local tunnel without encoding them, `data` should not contain any chunks.
+    void writeLocal(const mpp::MPPDataPacket & data, Blocks blocks);
+
     // finish the writing.
     void writeDone();
 
-    std::shared_ptr<mpp::MPPDataPacket> readForLocal();
+    // read the next message for the local consumer, return false if the tunnel is finished.
+    bool readForLocal(MPPTunnelMessage & msg);
 
     /// close() finishes the tunnel, if the tunnel is connected already, it will
     /// write the error message to the tunnel, otherwise it just close the tunnel
@@ -117,6 +144,9 @@ public:
 
     bool isLocal() const { return is_local; }
 
+    // the tunnels are created before the query, so the memory tracker of the query is set when the task starts running.
+    void setMemoryTracker(MemoryTracker * memory_tracker) { mem_tracker.setMemoryTracker(memory_tracker); }
+
     const LoggerPtr & getLogger() const { return log; }
 
     // do finish work for consumer, if need_lock is false, it means it has been protected by a mutex lock.
@@ -138,10 +168,17 @@ private:
         int input_steams_num_,
         bool is_local_,
         bool is_async_,
-        const String & req_id);
+        const String & req_id,
+        UInt64 max_queue_bytes_ = 0);
 
     void finishSendQueue();
 
+    /// `msg.packet_bytes` is reported in `connection_profile_info`, the blocks passed to local tunnels
+    /// without encoding are not counted.
+    void pushMessage(MPPTunnelMessage && msg, bool close_after_write);
+
+    void onMessagePopped(const MPPTunnelMessage & msg);
+
     void waitUntilConnectedOrFinished(std::unique_lock<std::mutex> & lk);
 
     void waitForConsumerFinish(bool allow_throw);
@@ -166,8 +203,10 @@ private:
 
     int input_streams_num;
 
-    using MPPDataPacketPtr = std::shared_ptr<mpp::MPPDataPacket>;
-    MPMCQueue<MPPDataPacketPtr> send_queue;
+    MPMCQueue<MPPTunnelMessage> send_queue;
+
+    // the packets in `send_queue` are allocated and freed against it, no matter which thread pushes or pops them.
+    ExchangeMemoryTracker mem_tracker;
 
     std::shared_ptr<ThreadManager> thread_manager;
 
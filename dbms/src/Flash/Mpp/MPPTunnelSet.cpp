@@ -41,6 +41,23 @@ void checkPacketSize(size_t size)
         throw Exception(fmt::format("Packet is too large to send, size : {}", size));
 }
 
+/// The operators after the receivers may modify the received columns in place, so every local receiver of a
+/// broadcast gets its own copy instead of sharing the columns with the sender and the other receivers.
+Blocks copyBlocks(const Blocks & blocks)
+{
+    Blocks res;
+    res.reserve(blocks.size());
+    for (const auto & block : blocks)
+    {
+        MutableColumns columns;
+        columns.reserve(block.columns());
+        for (const auto & column : block)
+            columns.push_back(column.column->cloneResized(column.column->size()));
+        res.push_back(block.cloneWithColumns(std::move(columns)));
+    }
+    return res;
+}
+
 } // namespace
 
 template <typename Tunnel>
@@ -114,6 +131,39 @@ void MPPTunnelSetBase<Tunnel>::write(mpp::MPPDataPacket & packet, int16_t partit
     tunnels[partition_id]->write(packet);
 }
 
+template <typename Tunnel>
+void MPPTunnelSetBase<Tunnel>::write(mpp::MPPDataPacket & packet, const Blocks & blocks)
+{
+    checkPacketSize(packet.ByteSizeLong());
+    /// the packet for local tunnels, which only carries the execution summaries.
+    mpp::MPPDataPacket local_packet;
+    if (!packet.data().empty())
+        local_packet.set_data(packet.data());
+    for (size_t i = 0; i < tunnels.size(); ++i)
+    {
+        if (i == 1 && !packet.data().empty())
+        {
+            /// only the first tunnel has execution summaries
+            packet.mutable_data()->clear();
+            local_packet.mutable_data()->clear();
+        }
+        if (tunnels[i]->isLocal())
+            tunnels[i]->writeLocal(local_packet, copyBlocks(blocks));
+        else
+            tunnels[i]->write(packet);
+    }
+}
+
+template <typename Tunnel>
+void MPPTunnelSetBase<Tunnel>::write(mpp::MPPDataPacket & packet, Blocks && blocks, int16_t partition_id)
+{
+    checkPacketSize(packet.ByteSizeLong());
+    if (partition_id != 0 && !packet.data().empty())
+        packet.mutable_data()->clear();
+
+    tunnels[partition_id]->writeLocal(packet, std::move(blocks));
+}
+
 template <typename Tunnel>
 void MPPTunnelSetBase<Tunnel>::writeError(const String & msg)
 {
@@ -162,6 +212,13 @@ void MPPTunnelSetBase<Tunnel>::finishWrite()
     }
 }
 
+template <typename Tunnel>
+void MPPTunnelSetBase<Tunnel>::setMemoryTracker(MemoryTracker * memory_tracker)
+{
+    for (auto & tunnel : tunnels)
+        tunnel->setMemoryTracker(memory_tracker);
+}
+
 template <typename Tunnel>
 typename MPPTunnelSetBase<Tunnel>::TunnelPtr MPPTunnelSetBase<Tunnel>::getTunnelById(const MPPTaskId & id)
 {
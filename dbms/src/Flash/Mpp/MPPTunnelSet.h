@@ -54,9 +54,17 @@ public:
     // this is a partition writing.
     void write(tipb::SelectResponse & response, int16_t partition_id);
     void write(mpp::MPPDataPacket & packet, int16_t partition_id);
+
+    /// zero-copy writing: local tunnels receive blocks without encoding while the remote ones receive
+    /// `packet`, which should contain the encoded chunks only if there're remote tunnels.
+    // this is a broadcast writing, every local tunnel receives its own copy of `blocks`.
+    void write(mpp::MPPDataPacket & packet, const Blocks & blocks);
+    // this is a partition writing, the tunnel of `partition_id` should be local.
+    void write(mpp::MPPDataPacket & packet, Blocks && blocks, int16_t partition_id);
     void writeError(const String & msg);
     void close(const String & reason);
     void finishWrite();
+    void setMemoryTracker(MemoryTracker * memory_tracker);
     void registerTunnel(const MPPTaskId & id, const TunnelPtr & tunnel);
 
     TunnelPtr getTunnelById(const MPPTaskId & id);
@@ -68,6 +76,8 @@ public:
         return remote_tunnel_cnt;
     }
 
+    bool isLocal(int16_t partition_id) const { return tunnels[partition_id]->isLocal(); }
+
     const std::vector<TunnelPtr> & getTunnels() const { return tunnels; }
 
 private:
@@ -21,11 +21,14 @@ namespace DB
 constexpr UInt64 MAX_UINT64 = std::numeric_limits<UInt64>::max();
 constexpr UInt64 OS_THREAD_SOFT_LIMIT = 100000;
 
-MinTSOScheduler::MinTSOScheduler(UInt64 soft_limit, UInt64 hard_limit)
+MinTSOScheduler::MinTSOScheduler(UInt64 soft_limit, UInt64 hard_limit, UInt64 memory_limit_)
     : min_tso(MAX_UINT64)
     , thread_soft_limit(soft_limit)
     , thread_hard_limit(hard_limit)
     , estimated_thread_usage(0)
+    , memory_limit(memory_limit_)
+    , reserved_memory_usage(0)
+    , observed_memory_per_thread(0)
     , log(&Poco::Logger::get("MinTSOScheduler"))
 {
     auto cores = getNumberOfPhysicalCPUCores();
@@ -46,6 +49,7 @@ MinTSOScheduler::MinTSOScheduler(UInt64 soft_limit, UInt64 hard_limit)
         {
             LOG_FMT_INFO(log, "thread_hard_limit is {}, thread_soft_limit is {}, and active_set_soft_limit is {} in MinTSOScheduler.", thread_hard_limit, thread_soft_limit, active_set_soft_limit);
         }
+        LOG_FMT_INFO(log, "memory_limit is {} in MinTSOScheduler{}.", memory_limit, memory_limit == 0 ? ", memory-aware scheduling is disabled" : "");
         GET_METRIC(tiflash_task_scheduler, type_min_tso).Set(min_tso);
         GET_METRIC(tiflash_task_scheduler, type_thread_soft_limit).Set(thread_soft_limit);
         GET_METRIC(tiflash_task_scheduler, type_thread_hard_limit).Set(thread_hard_limit);
@@ -55,6 +59,8 @@ MinTSOScheduler::MinTSOScheduler(UInt64 soft_limit, UInt64 hard_limit)
         GET_METRIC(tiflash_task_scheduler, type_waiting_tasks_count).Set(0);
         GET_METRIC(tiflash_task_scheduler, type_active_tasks_count).Set(0);
         GET_METRIC(tiflash_task_scheduler, type_hard_limit_exceeded_count).Set(0);
+        GET_METRIC(tiflash_task_scheduler, type_memory_limit).Set(memory_limit);
+        GET_METRIC(tiflash_task_scheduler, type_reserved_memory).Set(reserved_memory_usage);
     }
 }
 
@@ -88,6 +94,7 @@ void MinTSOScheduler::deleteQuery(const UInt64 tso, MPPTaskManager & task_manage
     LOG_FMT_DEBUG(log, "{} query {} (is min = {}) is deleted from active set {} left {} or waiting set {} left {}.", is_cancelled ? "Cancelled" : "Finished", tso, tso == min_tso, active_set.find(tso) != active_set.end(), active_set.size(), waiting_set.find(tso) != waiting_set.end(), waiting_set.size());
     active_set.erase(tso);
     waiting_set.erase(tso);
+    eraseQueryResourceIfIdle(tso);
     GET_METRIC(tiflash_task_scheduler, type_waiting_queries_count).Set(waiting_set.size());
     GET_METRIC(tiflash_task_scheduler, type_active_queries_count).Set(active_set.size());
 
@@ -115,7 +122,7 @@ void MinTSOScheduler::deleteQuery(const UInt64 tso, MPPTaskManager & task_manage
 }
 
 /// NOTE: should not throw exceptions due to being called when destruction.
-void MinTSOScheduler::releaseThreadsThenSchedule(const int needed_threads, MPPTaskManager & task_manager)
+void MinTSOScheduler::releaseResourcesThenSchedule(const UInt64 tso, const int needed_threads, const UInt64 reserved_memory, const Int64 peak_memory, MPPTaskManager & task_manager)
 {
     if (isDisabled())
     {
@@ -127,8 +134,29 @@ void MinTSOScheduler::releaseThreadsThenSchedule(const int needed_threads, MPPTa
         LOG_FMT_FATAL(log, "estimated_thread_usage should not be smaller than 0, actually is {}.", static_cast<Int64>(estimated_thread_usage) - needed_threads);
         std::terminate();
     }
+    if (reserved_memory_usage < reserved_memory)
+    {
+        LOG_FMT_FATAL(log, "reserved_memory_usage should not be smaller than 0, actually is {}.", static_cast<Int64>(reserved_memory_usage - reserved_memory));
+        std::terminate();
+    }
     estimated_thread_usage -= needed_threads;
+    reserved_memory_usage -= reserved_memory;
+    if (auto it = query_resources.find(tso); it != query_resources.end())
+    {
+        auto & resource = it->second;
+        --resource.active_tasks;
+        resource.reserved_threads -= needed_threads;
+        resource.reserved_memory -= reserved_memory;
+        eraseQueryResourceIfIdle(tso);
+    }
+    if (peak_memory > 0 && needed_threads > 0)
+    {
+        /// a simple moving average, so that a few outliers would not change the reservations too much.
+        UInt64 memory_per_thread = peak_memory / needed_threads;
+        observed_memory_per_thread = observed_memory_per_thread == 0 ? memory_per_thread : (observed_memory_per_thread * 7 + memory_per_thread) / 8;
+    }
     GET_METRIC(tiflash_task_scheduler, type_estimated_thread_usage).Set(estimated_thread_usage);
+    GET_METRIC(tiflash_task_scheduler, type_reserved_memory).Set(reserved_memory_usage);
     GET_METRIC(tiflash_task_scheduler, type_active_tasks_count).Decrement();
     /// as tasks release some threads, so some tasks would get scheduled.
     scheduleWaitingQueries(task_manager);
@@ -139,7 +167,7 @@ void MinTSOScheduler::scheduleWaitingQueries(MPPTaskManager & task_manager)
     /// schedule new tasks
     while (!waiting_set.empty())
     {
-        auto current_query_id = *waiting_set.begin();
+        auto current_query_id = nextWaitingQuery();
         auto query_task_set = task_manager.getQueryTaskSetWithoutLock(current_query_id);
         if (nullptr == query_task_set) /// silently solve this rare case
         {
@@ -147,6 +175,7 @@ void MinTSOScheduler::scheduleWaitingQueries(MPPTaskManager & task_manager)
             updateMinTSO(current_query_id, true, "as it is not in the task manager.");
             active_set.erase(current_query_id);
             waiting_set.erase(current_query_id);
+            eraseQueryResourceIfIdle(current_query_id);
             GET_METRIC(tiflash_task_scheduler, type_waiting_queries_count).Set(waiting_set.size());
             GET_METRIC(tiflash_task_scheduler, type_active_queries_count).Set(active_set.size());
             continue;
@@ -177,18 +206,29 @@ void MinTSOScheduler::scheduleWaitingQueries(MPPTaskManager & task_manager)
 bool MinTSOScheduler::scheduleImp(const UInt64 tso, const MPPQueryTaskSetPtr & query_task_set, const MPPTaskPtr & task, const bool isWaiting, bool & has_error)
 {
     auto needed_threads = task->getNeededThreads();
+    auto needed_memory = estimateMemoryReservation(task, needed_threads);
+    /// the min_tso query is not limited by memory, otherwise the queries may deadlock among nodes.
     auto check_for_new_min_tso = tso <= min_tso && estimated_thread_usage + needed_threads <= thread_hard_limit;
-    auto check_for_not_min_tso = (active_set.size() < active_set_soft_limit || tso <= *active_set.rbegin()) && (estimated_thread_usage + needed_threads <= thread_soft_limit);
+    auto check_for_not_min_tso = (active_set.size() < active_set_soft_limit || tso <= *active_set.rbegin()) && (estimated_thread_usage + needed_threads <= thread_soft_limit)
+        && (memory_limit == 0 || reserved_memory_usage + needed_memory <= memory_limit);
+    auto & resource = query_resources[tso];
+    resource.priority = task->getSchedulingPriority();
     if (check_for_new_min_tso || check_for_not_min_tso)
     {
         updateMinTSO(tso, false, isWaiting ? "from the waiting set" : "when directly schedule it");
         active_set.insert(tso);
         estimated_thread_usage += needed_threads;
+        reserved_memory_usage += needed_memory;
+        ++resource.active_tasks;
+        resource.reserved_threads += needed_threads;
+        resource.reserved_memory += needed_memory;
+        task->setReservedMemory(needed_memory);
         task->scheduleThisTask(MPPTask::ScheduleState::SCHEDULED);
         GET_METRIC(tiflash_task_scheduler, type_active_queries_count).Set(active_set.size());
         GET_METRIC(tiflash_task_scheduler, type_estimated_thread_usage).Set(estimated_thread_usage);
+        GET_METRIC(tiflash_task_scheduler, type_reserved_memory).Set(reserved_memory_usage);
         GET_METRIC(tiflash_task_scheduler, type_active_tasks_count).Increment();
-        LOG_FMT_INFO(log, "{} is scheduled (active set size = {}) due to available threads {}, after applied for {} threads, used {} of the thread {} limit {}.", task->getId().toString(), active_set.size(), isWaiting ? " from the waiting set" : " directly", needed_threads, estimated_thread_usage, min_tso == tso ? "hard" : "soft", min_tso == tso ? thread_hard_limit : thread_soft_limit);
+        LOG_FMT_INFO(log, "{} is scheduled (active set size = {}) due to available threads {}, after applied for {} threads and {} bytes memory, used {} of the thread {} limit {} and {} of the memory limit {}.", task->getId().toString(), active_set.size(), isWaiting ? " from the waiting set" : " directly", needed_threads, needed_memory, estimated_thread_usage, min_tso == tso ? "hard" : "soft", min_tso == tso ? thread_hard_limit : thread_soft_limit, reserved_memory_usage, memory_limit);
         return true;
     }
     else
@@ -218,11 +258,79 @@ bool MinTSOScheduler::scheduleImp(const UInt64 tso, const MPPQueryTaskSetPtr & q
             GET_METRIC(tiflash_task_scheduler, type_waiting_queries_count).Set(waiting_set.size());
             GET_METRIC(tiflash_task_scheduler, type_waiting_tasks_count).Increment();
         }
-        LOG_FMT_INFO(log, "threads are unavailable for the query {} or active set is full (size =  {}), need {}, but used {} of the thread soft limit {},{} waiting set size = {}", tso, active_set.size(), needed_threads, estimated_thread_usage, thread_soft_limit, isWaiting ? "" : " put into", waiting_set.size());
+        LOG_FMT_INFO(log, "threads or memory are unavailable for the query {} or active set is full (size =  {}), need {} threads and {} bytes memory, but used {} of the thread soft limit {} and {} of the memory limit {},{} waiting set size = {}", tso, active_set.size(), needed_threads, needed_memory, estimated_thread_usage, thread_soft_limit, reserved_memory_usage, memory_limit, isWaiting ? "" : " put into", waiting_set.size());
         return false;
     }
 }
 
+/// the min_tso query is always the first one, and then the ones with higher priority and smaller tso.
+UInt64 MinTSOScheduler::nextWaitingQuery() const
+{
+    auto next = *waiting_set.begin();
+    if (next == min_tso)
+        return next;
+    auto get_priority = [&](UInt64 tso) {
+        auto it = query_resources.find(tso);
+        return it == query_resources.end() ? 0 : it->second.priority;
+    };
+    auto next_priority = get_priority(next);
+    for (auto tso : waiting_set)
+    {
+        auto priority = get_priority(tso);
+        if (priority > next_priority)
+        {
+            next = tso;
+            next_priority = priority;
+        }
+    }
+    return next;
+}
+
+UInt64 MinTSOScheduler::estimateMemoryReservation(const MPPTaskPtr & task, const int needed_threads) const
+{
+    if (memory_limit == 0)
+        return 0;
+    return std::max(task->getMemoryHint(), observed_memory_per_thread * needed_threads);
+}
+
+void MinTSOScheduler::eraseQueryResourceIfIdle(const UInt64 tso)
+{
+    auto it = query_resources.find(tso);
+    if (it != query_resources.end() && it->second.active_tasks == 0 && active_set.find(tso) == active_set.end() && waiting_set.find(tso) == waiting_set.end())
+        query_resources.erase(it);
+}
+
+std::vector<MinTSOScheduler::QueryStatus> MinTSOScheduler::getQueryStatuses(MPPTaskManager & task_manager) const
+{
+    std::vector<QueryStatus> statuses;
+    if (isDisabled())
+        return statuses;
+    auto fill_status = [&](UInt64 tso, bool is_waiting) {
+        QueryStatus status;
+        status.tso = tso;
+        status.is_min_tso = tso == min_tso;
+        status.is_waiting = is_waiting;
+        if (auto it = query_resources.find(tso); it != query_resources.end())
+        {
+            status.priority = it->second.priority;
+            status.active_tasks = it->second.active_tasks;
+            status.reserved_threads = it->second.reserved_threads;
+            status.reserved_memory = it->second.reserved_memory;
+        }
+        if (auto query_task_set = task_manager.getQueryTaskSetWithoutLock(tso))
+            status.waiting_tasks = query_task_set->waiting_tasks.size();
+        statuses.push_back(status);
+    };
+    for (auto tso : waiting_set)
+        fill_status(tso, true);
+    for (auto tso : active_set)
+    {
+        if (waiting_set.find(tso) == waiting_set.end())
+            fill_status(tso, false);
+    }
+    return statuses;
+}
+
 /// if return true, then need to schedule the waiting tasks of the min_tso.
 bool MinTSOScheduler::updateMinTSO(const UInt64 tso, const bool retired, const String msg)
 {
@@ -30,12 +30,28 @@ using MPPQueryTaskSetPtr = std::shared_ptr<MPPQueryTaskSet>;
 
 /// scheduling tasks in the set according to the tso order under the soft limit of threads, but allow the min_tso query to preempt threads under the hard limit of threads.
 /// The min_tso query avoids the deadlock resulted from threads competition among nodes.
+/// Besides threads, non-min_tso queries are admitted only if their memory reservations fit in the memory limit. The reservation
+/// of a task is the larger one of its hint from the operators and the memory per thread observed from the finished tasks.
+/// Waiting queries are scheduled in the order of priority and then tso, while the min_tso query is always the first one.
 /// schedule tasks under the lock protection of the task manager.
 /// NOTE: if the updated min-tso query has waiting tasks, necessarily scheduling them, otherwise the query would hang.
 class MinTSOScheduler : private boost::noncopyable
 {
 public:
-    MinTSOScheduler(UInt64 soft_limit, UInt64 hard_limit);
+    /// the status of a query in the scheduler, only used for introspection.
+    struct QueryStatus
+    {
+        UInt64 tso = 0;
+        bool is_min_tso = false;
+        bool is_waiting = false;
+        Int64 priority = 0;
+        UInt64 active_tasks = 0;
+        UInt64 waiting_tasks = 0;
+        UInt64 reserved_threads = 0;
+        UInt64 reserved_memory = 0;
+    };
+
+    MinTSOScheduler(UInt64 soft_limit, UInt64 hard_limit, UInt64 memory_limit_ = 0);
     ~MinTSOScheduler() = default;
     /// try to schedule this task if it is the min_tso query or there are enough threads, otherwise put it into the waiting set.
     /// NOTE: call tryToSchedule under the lock protection of MPPTaskManager
@@ -45,23 +61,49 @@ public:
     /// NOTE: call deleteQuery under the lock protection of MPPTaskManager
     void deleteQuery(const UInt64 tso, MPPTaskManager & task_manager, const bool is_cancelled);
 
-    /// all scheduled tasks should finally call this function to release threads and schedule new tasks
-    void releaseThreadsThenSchedule(const int needed_threads, MPPTaskManager & task_manager);
+    /// all scheduled tasks should finally call this function to release threads and memory and schedule new tasks.
+    /// `peak_memory` is the observed memory peak of the task, which is used to estimate the reservations of new tasks.
+    void releaseResourcesThenSchedule(const UInt64 tso, const int needed_threads, const UInt64 reserved_memory, const Int64 peak_memory, MPPTaskManager & task_manager);
+
+    /// NOTE: call getQueryStatuses under the lock protection of MPPTaskManager
+    std::vector<QueryStatus> getQueryStatuses(MPPTaskManager & task_manager) const;
 
+#ifndef DBMS_PUBLIC_GTEST
 private:
+#else
+public:
+#endif
+    struct QueryResource
+    {
+        Int64 priority = 0;
+        UInt64 active_tasks = 0;
+        UInt64 reserved_threads = 0;
+        UInt64 reserved_memory = 0;
+    };
+
     bool scheduleImp(const UInt64 tso, const MPPQueryTaskSetPtr & query_task_set, const MPPTaskPtr & task, const bool isWaiting, bool & has_error);
     bool updateMinTSO(const UInt64 tso, const bool retired, const String msg);
     void scheduleWaitingQueries(MPPTaskManager & task_manager);
-    bool isDisabled()
+    UInt64 nextWaitingQuery() const;
+    UInt64 estimateMemoryReservation(const MPPTaskPtr & task, const int needed_threads) const;
+    void eraseQueryResourceIfIdle(const UInt64 tso);
+    bool isDisabled() const
     {
         return thread_hard_limit == 0 && thread_soft_limit == 0;
     }
     std::set<UInt64> waiting_set;
     std::set<UInt64> active_set;
+    /// the priorities and resources of the queries in the active and waiting set, or still holding resources.
+    std::unordered_map<UInt64, QueryResource> query_resources;
     UInt64 min_tso;
     UInt64 thread_soft_limit;
     UInt64 thread_hard_limit;
     UInt64 estimated_thread_usage;
+    /// 0 means scheduling without considering memory.
+    UInt64 memory_limit;
+    UInt64 reserved_memory_usage;
+    /// the moving average of the memory peak per thread of the finished tasks.
+    UInt64 observed_memory_per_thread;
     /// to prevent from too many queries just issue a part of tasks to occupy threads, in proportion to the hardware cores.
     size_t active_set_soft_limit;
     Poco::Logger * log;
@@ -12,8 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <Common/MemoryTracker.h>
 #include <Flash/Mpp/Utils.h>
 
+#include <algorithm>
 #include <memory>
 
 namespace DB
@@ -27,4 +29,45 @@ mpp::MPPDataPacket getPacketWithError(String reason)
     return data;
 }
 
+void ExchangeMemoryTracker::setMemoryTracker(MemoryTracker * mem_tracker_)
+{
+    std::lock_guard lock(mu);
+    mem_tracker = mem_tracker_;
+}
+
+void ExchangeMemoryTracker::alloc(Int64 bytes)
+{
+    std::lock_guard lock(mu);
+    if (mem_tracker == nullptr || released || bytes <= 0)
+        return;
+    mem_tracker->alloc(bytes, /*check_memory_limit=*/false);
+    tracked_bytes += bytes;
+}
+
+void ExchangeMemoryTracker::free(Int64 bytes)
+{
+    std::lock_guard lock(mu);
+    /// the bytes allocated before `setMemoryTracker` are not tracked.
+    bytes = std::min(bytes, tracked_bytes);
+    if (mem_tracker == nullptr || released || bytes <= 0)
+        return;
+    mem_tracker->free(bytes);
+    tracked_bytes -= bytes;
+}
+
+void ExchangeMemoryTracker::release()
+{
+    std::lock_guard lock(mu);
+    if (mem_tracker != nullptr && tracked_bytes > 0)
+        mem_tracker->free(tracked_bytes);
+    tracked_bytes = 0;
+    released = true;
+}
+
+Int64 ExchangeMemoryTracker::get() const
+{
+    std::lock_guard lock(mu);
+    return tracked_bytes;
+}
+
 } // namespace DB
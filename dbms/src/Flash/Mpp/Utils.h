@@ -15,13 +15,47 @@
 #pragma once
 
 #include <common/types.h>
+
+#include <boost/noncopyable.hpp>
+#include <mutex>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <kvproto/mpp.pb.h>
 #pragma GCC diagnostic pop
 
+class MemoryTracker;
+
 namespace DB
 {
 mpp::MPPDataPacket getPacketWithError(String reason);
 
+/// Accounts the bytes queued in an exchange to an explicit memory tracker, so that the bytes are always
+/// allocated and freed against the same tracker no matter which thread pushes or pops the data.
+/// Only the memory that is not tracked by `Allocator`, i.e. the protobuf packets, should be accounted here.
+class ExchangeMemoryTracker : private boost::noncopyable
+{
+public:
+    explicit ExchangeMemoryTracker(MemoryTracker * mem_tracker_ = nullptr)
+        : mem_tracker(mem_tracker_)
+    {}
+
+    /// Should be called before any bytes are allocated.
+    void setMemoryTracker(MemoryTracker * mem_tracker_);
+
+    /// Never throws for exceeding the memory limit, the following allocations of the query will do.
+    void alloc(Int64 bytes);
+    void free(Int64 bytes);
+
+    /// Free all the tracked bytes, the later `alloc` and `free` are ignored.
+    void release();
+
+    Int64 get() const;
+
+private:
+    mutable std::mutex mu;
+    MemoryTracker * mem_tracker;
+    Int64 tracked_bytes = 0;
+    bool released = false;
+};
+
 } // namespace DB
@@ -0,0 +1,290 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnsNumber.h>
+#include <Common/typeid_cast.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Flash/Mpp/Utils.h>
+#include <Storages/Transaction/TiDB.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <Flash/Mpp/ExchangeReceiver.cpp> // to include the implementation of ExchangeReceiver
+#include <queue>
+#include <vector>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+/// Every source sends the prepared packets in order through a sync reader.
+struct MockReceiverContext
+{
+    using Status = ::grpc::Status;
+    using AsyncReader = AsyncExchangePacketReader;
+
+    struct Request
+    {
+        String debugString() const { return "{Request}"; }
+
+        Int64 source_index = 0;
+        Int64 send_task_id = 0;
+        Int64 recv_task_id = -1;
+    };
+
+    struct Reader
+    {
+        explicit Reader(const std::vector<MPPDataPacketPtr> & packets_)
+            : packets(packets_)
+        {}
+
+        bool read(MPPDataPacketPtr & packet, Blocks &)
+        {
+            if (index >= packets.size())
+                return false;
+            *packet = *packets[index++]; // avoid changing the shared packets
+            return true;
+        }
+
+        Status finish() const { return Status::OK; }
+
+        const std::vector<MPPDataPacketPtr> & packets;
+        size_t index = 0;
+    };
+
+    MockReceiverContext(std::vector<std::vector<MPPDataPacketPtr>> sources_, const tipb::FieldType & field_type_)
+        : sources(std::move(sources_))
+        , field_type(field_type_)
+    {}
+
+    void fillSchema(DAGSchema & schema) const
+    {
+        schema.clear();
+        schema.emplace_back("exchange_receiver_0", TiDB::fieldTypeToColumnInfo(field_type));
+    }
+
+    Request makeRequest(size_t index) const { return {static_cast<Int64>(index), static_cast<Int64>(index), -1}; }
+
+    bool supportAsync(const Request &) const { return false; }
+
+    std::shared_ptr<Reader> makeReader(const Request & request) const { return std::make_shared<Reader>(sources[request.source_index]); }
+
+    void makeAsyncReader(const Request &, std::shared_ptr<AsyncReader> &, UnaryCallback<bool> *) const
+    {
+        throw Exception("MockReceiverContext does not support async reader");
+    }
+
+    static Status getStatusOK() { return Status::OK; }
+
+    std::vector<std::vector<MPPDataPacketPtr>> sources;
+    tipb::FieldType field_type;
+};
+
+using MockExchangeReceiver = ExchangeReceiverBase<MockReceiverContext>;
+} // namespace
+
+class ExchangeReceiverTest : public ::testing::Test
+{
+protected:
+    static constexpr size_t source_num = 3;
+    static constexpr size_t packet_num = 4;
+    static constexpr size_t chunk_num = 5;
+    static constexpr size_t chunk_rows = 3;
+
+    void SetUp() override
+    {
+        field_type.set_tp(TiDB::TypeLongLong);
+        field_type.set_flag(TiDB::ColumnFlagNotNull);
+        header = Block{{DataTypeInt64().createColumn(), std::make_shared<DataTypeInt64>(), "exchange_receiver_0"}};
+    }
+
+    /// The values of a source are `source_index * 1000 + i` in the order of sending.
+    std::vector<std::vector<MPPDataPacketPtr>> makeSources()
+    {
+        std::vector<std::vector<MPPDataPacketPtr>> sources(source_num);
+        CHBlockChunkCodec codec;
+        std::vector<tipb::FieldType> field_types{field_type};
+        for (size_t s = 0; s < source_num; ++s)
+        {
+            Int64 value = s * 1000;
+            for (size_t p = 0; p < packet_num; ++p)
+            {
+                auto packet = std::make_shared<MPPDataPacket>();
+                for (size_t c = 0; c < chunk_num; ++c)
+                {
+                    auto column = ColumnInt64::create();
+                    for (size_t i = 0; i < chunk_rows; ++i)
+                        column->insert(value++);
+                    Block block{{std::move(column), std::make_shared<DataTypeInt64>(), "exchange_receiver_0"}};
+                    auto stream = codec.newCodecStream(field_types);
+                    stream->encode(block, 0, block.rows());
+                    packet->add_chunks(stream->getString());
+                }
+                sources[s].push_back(packet);
+            }
+        }
+        return sources;
+    }
+
+    std::shared_ptr<MockExchangeReceiver> makeReceiver(std::vector<std::vector<MPPDataPacketPtr>> sources, size_t decode_concurrency, size_t squash_rows)
+    {
+        return std::make_shared<MockExchangeReceiver>(
+            std::make_shared<MockReceiverContext>(std::move(sources), field_type),
+            source_num,
+            /*max_streams=*/1,
+            "exchange_receiver_test",
+            "ExchangeReceiver_0",
+            /*max_buffer_bytes=*/0,
+            decode_concurrency,
+            squash_rows);
+    }
+
+    /// Read all the results, the rows of the blocks of every packet are collected by source.
+    /// Return the error message if any.
+    String readAll(MockExchangeReceiver & receiver)
+    {
+        received_values.assign(source_num, {});
+        received_block_rows.assign(source_num, {});
+        for (;;)
+        {
+            std::queue<Block> block_queue;
+            auto result = receiver.nextResult(block_queue, header);
+            if (result.meet_error)
+                return result.error_msg;
+            if (result.eof)
+                return "";
+            std::vector<size_t> block_rows;
+            while (!block_queue.empty())
+            {
+                const auto & block = block_queue.front();
+                const auto & column = typeid_cast<const ColumnInt64 &>(*block.getByPosition(0).column);
+                for (size_t i = 0; i < column.size(); ++i)
+                    received_values[result.call_index].push_back(column.getElement(i));
+                block_rows.push_back(block.rows());
+                block_queue.pop();
+            }
+            received_block_rows[result.call_index].push_back(block_rows);
+        }
+    }
+
+    void checkReceivedValues()
+    {
+        for (size_t s = 0; s < source_num; ++s)
+        {
+            ASSERT_EQ(received_values[s].size(), packet_num * chunk_num * chunk_rows);
+            /// the blocks of a source are received in order.
+            for (size_t i = 0; i < received_values[s].size(); ++i)
+                ASSERT_EQ(received_values[s][i], static_cast<Int64>(s * 1000 + i));
+        }
+    }
+
+    tipb::FieldType field_type;
+    Block header;
+    std::vector<std::vector<Int64>> received_values;
+    std::vector<std::vector<std::vector<size_t>>> received_block_rows;
+};
+
+TEST_F(ExchangeReceiverTest, DecodeStageOff)
+try
+{
+    auto receiver = makeReceiver(makeSources(), /*decode_concurrency=*/0, /*squash_rows=*/10);
+    ASSERT_EQ(readAll(*receiver), "");
+    checkReceivedValues();
+    /// every chunk is decoded to a block by the consumer without squashing.
+    for (size_t s = 0; s < source_num; ++s)
+    {
+        ASSERT_EQ(received_block_rows[s].size(), packet_num);
+        for (const auto & block_rows : received_block_rows[s])
+            ASSERT_EQ(block_rows, std::vector<size_t>(chunk_num, chunk_rows));
+    }
+}
+CATCH
+
+TEST_F(ExchangeReceiverTest, DecodeStageOn)
+try
+{
+    for (size_t decode_concurrency : {1, 2, 3})
+    {
+        auto receiver = makeReceiver(makeSources(), decode_concurrency, /*squash_rows=*/10);
+        ASSERT_EQ(readAll(*receiver), "");
+        checkReceivedValues();
+        /// the chunks of a packet are squashed up to 10 rows, the remaining rows are flushed at the end of
+        /// the packet because blocks are never merged across packets.
+        for (size_t s = 0; s < source_num; ++s)
+        {
+            ASSERT_EQ(received_block_rows[s].size(), packet_num);
+            for (const auto & block_rows : received_block_rows[s])
+                ASSERT_EQ(block_rows, (std::vector<size_t>{12, 3}));
+        }
+    }
+}
+CATCH
+
+TEST_F(ExchangeReceiverTest, DecodeStageWithoutSquashing)
+try
+{
+    auto receiver = makeReceiver(makeSources(), /*decode_concurrency=*/2, /*squash_rows=*/0);
+    ASSERT_EQ(readAll(*receiver), "");
+    checkReceivedValues();
+    for (size_t s = 0; s < source_num; ++s)
+    {
+        for (const auto & block_rows : received_block_rows[s])
+            ASSERT_EQ(block_rows, std::vector<size_t>(chunk_num, chunk_rows));
+    }
+}
+CATCH
+
+TEST_F(ExchangeReceiverTest, ErrorPacket)
+try
+{
+    for (size_t decode_concurrency : {0, 2})
+    {
+        auto sources = makeSources();
+        sources[1][2] = std::make_shared<MPPDataPacket>(getPacketWithError("mock sender error"));
+        auto receiver = makeReceiver(std::move(sources), decode_concurrency, /*squash_rows=*/10);
+        auto err_msg = readAll(*receiver);
+        ASSERT_NE(err_msg.find("mock sender error"), String::npos) << err_msg;
+        /// the packets before the error are still received in order.
+        for (size_t i = 0; i < received_values[1].size(); ++i)
+            ASSERT_EQ(received_values[1][i], static_cast<Int64>(1000 + i));
+        ASSERT_LE(received_values[1].size(), 2 * chunk_num * chunk_rows);
+    }
+}
+CATCH
+
+TEST_F(ExchangeReceiverTest, DecodeError)
+try
+{
+    auto sources = makeSources();
+    auto broken_packet = std::make_shared<MPPDataPacket>();
+    broken_packet->add_chunks("broken chunk");
+    sources[2][1] = broken_packet;
+
+    /// without the decode stage, the error is thrown by the consumer.
+    {
+        auto receiver = makeReceiver(sources, /*decode_concurrency=*/0, /*squash_rows=*/10);
+        ASSERT_ANY_THROW(readAll(*receiver));
+    }
+    /// with the decode stage, the error is thrown by the decoder and reported to the consumer.
+    {
+        auto receiver = makeReceiver(sources, /*decode_concurrency=*/2, /*squash_rows=*/10);
+        ASSERT_NE(readAll(*receiver), "");
+        ASSERT_LE(received_values[2].size(), chunk_num * chunk_rows);
+    }
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
@@ -0,0 +1,195 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Columns/ColumnsNumber.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Flash/Coprocessor/DAGContext.h>
+#include <Flash/Coprocessor/StreamingDAGResponseWriter.h>
+#include <Flash/Mpp/MPPTunnelSet.h>
+#include <Storages/Transaction/TiDB.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <map>
+#include <thread>
+
+namespace DB
+{
+namespace tests
+{
+/// Write blocks by StreamingDAGResponseWriter through a MPPTunnelSet of local tunnels in zero-copy mode,
+/// and read them by the local receivers like ExchangeReceiver.
+class LocalExchangeTest : public ::testing::Test
+{
+protected:
+    static constexpr size_t receiver_num = 3;
+
+    void SetUp() override
+    {
+        dag_context = std::make_unique<DAGContext>(1024);
+        dag_context->is_mpp_task = true;
+        dag_context->encode_type = tipb::EncodeType::TypeCHBlock;
+        for (size_t i = 0; i < 2; ++i)
+        {
+            tipb::FieldType field_type;
+            field_type.set_tp(TiDB::TypeLongLong);
+            dag_context->result_field_types.push_back(field_type);
+        }
+
+        tunnel_set = std::make_shared<MPPTunnelSet>("local_exchange_test");
+        mpp::TaskMeta sender_meta;
+        sender_meta.set_task_id(0);
+        for (size_t i = 0; i < receiver_num; ++i)
+        {
+            mpp::TaskMeta receiver_meta;
+            receiver_meta.set_task_id(i + 1);
+            auto tunnel = std::make_shared<MPPTunnel>(receiver_meta, sender_meta, std::chrono::seconds(10), 1, true, false, "local_exchange_test");
+            tunnel->connect(nullptr);
+            tunnel_set->registerTunnel(MPPTaskId(1, i + 1), tunnel);
+        }
+        received.resize(receiver_num);
+    }
+
+    void startReceivers()
+    {
+        for (size_t i = 0; i < receiver_num; ++i)
+        {
+            readers.emplace_back([this, i] {
+                const auto & tunnel = tunnel_set->getTunnels()[i];
+                MPPTunnelMessage msg;
+                while (tunnel->readForLocal(msg))
+                {
+                    /// the packets carry neither chunks nor execution summaries here.
+                    EXPECT_TRUE(msg.packet->chunks().empty());
+                    for (auto & block : msg.blocks)
+                        received[i].push_back(std::move(block));
+                }
+            });
+        }
+    }
+
+    void finish()
+    {
+        tunnel_set->finishWrite();
+        for (auto & reader : readers)
+            reader.join();
+    }
+
+    std::unique_ptr<StreamingDAGResponseWriter<MPPTunnelSetPtr>> createWriter(tipb::ExchangeType exchange_type)
+    {
+        return std::make_unique<StreamingDAGResponseWriter<MPPTunnelSetPtr>>(
+            tunnel_set,
+            std::vector<Int64>{0},
+            TiDB::TiDBCollators{nullptr},
+            exchange_type,
+            /*records_per_chunk=*/-1,
+            /*batch_send_min_limit=*/0,
+            /*enable_local_tunnel_zero_copy=*/true,
+            /*enable_dictionary_encoding=*/false,
+            /*should_send_exec_summary_at_last=*/false,
+            *dag_context);
+    }
+
+    static Block createBlock(Int64 begin, Int64 end)
+    {
+        auto key = ColumnInt64::create();
+        auto value = ColumnInt64::create();
+        for (Int64 i = begin; i < end; ++i)
+        {
+            key->insert(Field(i % 37));
+            value->insert(Field(i));
+        }
+        auto type = std::make_shared<DataTypeInt64>();
+        return Block{{std::move(key), type, "key"}, {std::move(value), type, "value"}};
+    }
+
+    /// Return the (key, value) rows of `blocks` sorted by value.
+    static std::vector<std::pair<Int64, Int64>> collectRows(const Blocks & blocks)
+    {
+        std::vector<std::pair<Int64, Int64>> rows;
+        for (const auto & block : blocks)
+        {
+            const auto & keys = typeid_cast<const ColumnInt64 &>(*block.getByPosition(0).column).getData();
+            const auto & values = typeid_cast<const ColumnInt64 &>(*block.getByPosition(1).column).getData();
+            for (size_t i = 0; i < block.rows(); ++i)
+                rows.emplace_back(keys[i], values[i]);
+        }
+        std::sort(rows.begin(), rows.end(), [](const auto & a, const auto & b) { return a.second < b.second; });
+        return rows;
+    }
+
+    std::unique_ptr<DAGContext> dag_context;
+    MPPTunnelSetPtr tunnel_set;
+    std::vector<std::thread> readers;
+    std::vector<Blocks> received;
+};
+
+TEST_F(LocalExchangeTest, Broadcast)
+try
+{
+    startReceivers();
+    Blocks sent{createBlock(0, 100), createBlock(100, 1000)};
+    auto writer = createWriter(tipb::ExchangeType::Broadcast);
+    for (const auto & block : sent)
+        writer->write(block);
+    writer->finishWrite();
+    finish();
+
+    auto expected = collectRows(sent);
+    for (size_t i = 0; i < receiver_num; ++i)
+    {
+        ASSERT_EQ(collectRows(received[i]), expected);
+        /// every receiver gets its own columns, which are not shared with the sender or the other receivers.
+        for (const auto & block : received[i])
+        {
+            for (const auto & sent_block : sent)
+                ASSERT_NE(block.getByPosition(0).column.get(), sent_block.getByPosition(0).column.get());
+            for (size_t j = 0; j < i; ++j)
+            {
+                for (const auto & other : received[j])
+                    ASSERT_NE(block.getByPosition(1).column.get(), other.getByPosition(1).column.get());
+            }
+        }
+    }
+}
+CATCH
+
+TEST_F(LocalExchangeTest, HashPartition)
+try
+{
+    startReceivers();
+    Blocks sent{createBlock(0, 100), createBlock(100, 1000), createBlock(1000, 1001)};
+    auto writer = createWriter(tipb::ExchangeType::Hash);
+    for (const auto & block : sent)
+        writer->write(block);
+    writer->finishWrite();
+    finish();
+
+    Blocks all_received;
+    std::map<Int64, size_t> receiver_of_key;
+    for (size_t i = 0; i < receiver_num; ++i)
+    {
+        for (const auto & [key, value] : collectRows(received[i]))
+        {
+            /// the rows with the same key go to the same receiver.
+            auto [it, inserted] = receiver_of_key.emplace(key, i);
+            ASSERT_TRUE(inserted || it->second == i) << "key " << key;
+        }
+        all_received.insert(all_received.end(), received[i].begin(), received[i].end());
+    }
+    ASSERT_EQ(collectRows(all_received), collectRows(sent));
+    ASSERT_EQ(receiver_of_key.size(), 37);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
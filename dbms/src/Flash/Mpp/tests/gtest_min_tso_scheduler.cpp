@@ -0,0 +1,223 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Core/Defines.h>
+#include <Flash/Mpp/MPPTaskManager.h>
+#include <Flash/Mpp/MinTSOScheduler.h>
+#include <Storages/SelectQueryInfo.h>
+#include <Storages/System/StorageSystemMPPSchedulerQueries.h>
+#include <Storages/Transaction/TMTContext.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <algorithm>
+#include <map>
+
+namespace DB
+{
+namespace tests
+{
+class MinTSOSchedulerTest : public ::testing::Test
+{
+protected:
+    static constexpr UInt64 memory_limit = 1000;
+
+    void SetUp() override
+    {
+        context = std::make_shared<Context>(TiFlashTestEnv::getContext());
+        auto scheduler_ptr = std::make_unique<MinTSOScheduler>(100, 200, memory_limit);
+        scheduler = scheduler_ptr.get();
+        /// not to be limited by the number of active queries, which depends on the cores of the machine.
+        scheduler->active_set_soft_limit = 100;
+        task_manager = std::make_shared<MPPTaskManager>(std::move(scheduler_ptr));
+    }
+
+    void TearDown() override
+    {
+        /// unregister the tasks before destroying them, so that the scheduler is consistent.
+        for (auto & task : tasks)
+            task_manager->unregisterTask(task.get());
+        tasks.clear();
+    }
+
+    MPPTaskPtr addTask(UInt64 start_ts, Int64 task_id, int needed_threads, UInt64 memory_hint, Int64 priority = 0)
+    {
+        mpp::TaskMeta meta;
+        meta.set_start_ts(start_ts);
+        meta.set_task_id(task_id);
+        auto task = MPPTask::newTask(meta, context);
+        task->needed_threads = needed_threads;
+        task->memory_hint = memory_hint;
+        task->scheduling_priority = priority;
+        EXPECT_TRUE(task_manager->registerTask(task));
+        tasks.push_back(task);
+        return task;
+    }
+
+    /// the scheduled task releases its resources when it is destroyed.
+    void finishTask(const MPPTaskPtr & task)
+    {
+        task_manager->unregisterTask(task.get());
+        tasks.erase(std::find(tasks.begin(), tasks.end(), task));
+    }
+
+    std::map<UInt64, MinTSOScheduler::QueryStatus> getQueryStatuses()
+    {
+        std::map<UInt64, MinTSOScheduler::QueryStatus> statuses;
+        for (const auto & status : task_manager->getSchedulerQueryStatuses())
+            statuses[status.tso] = status;
+        return statuses;
+    }
+
+    ContextPtr context;
+    MinTSOScheduler * scheduler = nullptr;
+    MPPTaskManagerPtr task_manager;
+    std::vector<MPPTaskPtr> tasks;
+};
+
+TEST_F(MinTSOSchedulerTest, MemoryAdmission)
+try
+{
+    /// the min_tso query is not limited by memory.
+    auto task_1_1 = addTask(1, 1, 1, 600);
+    auto task_1_2 = addTask(1, 2, 1, 0);
+    ASSERT_TRUE(task_manager->tryToScheduleTask(task_1_1));
+    ASSERT_TRUE(task_manager->tryToScheduleTask(task_1_2));
+
+    /// 600 + 600 exceeds the memory limit.
+    auto task_2 = addTask(2, 1, 1, 600);
+    ASSERT_FALSE(task_manager->tryToScheduleTask(task_2));
+    ASSERT_FALSE(task_2->isScheduled());
+
+    /// 600 + 300 fits in the memory limit.
+    auto task_3 = addTask(3, 1, 1, 300);
+    ASSERT_TRUE(task_manager->tryToScheduleTask(task_3));
+
+    auto statuses = getQueryStatuses();
+    ASSERT_EQ(statuses.size(), 3);
+    ASSERT_TRUE(statuses[1].is_min_tso);
+    ASSERT_EQ(statuses[1].active_tasks, 2);
+    ASSERT_EQ(statuses[1].reserved_threads, 2);
+    ASSERT_EQ(statuses[1].reserved_memory, 600);
+    ASSERT_TRUE(statuses[2].is_waiting);
+    ASSERT_EQ(statuses[2].waiting_tasks, 1);
+    ASSERT_EQ(statuses[2].reserved_memory, 0);
+    ASSERT_FALSE(statuses[3].is_waiting);
+    ASSERT_EQ(statuses[3].reserved_memory, 300);
+
+    /// query 1 is still the min_tso one, task_2 is admitted because the memory of task_1_1 is released.
+    finishTask(task_1_1);
+    task_1_1.reset();
+    ASSERT_TRUE(task_2->isScheduled());
+    statuses = getQueryStatuses();
+    ASSERT_TRUE(statuses[1].is_min_tso);
+    ASSERT_EQ(statuses[1].reserved_memory, 0);
+    ASSERT_FALSE(statuses[2].is_waiting);
+    ASSERT_EQ(statuses[2].reserved_memory, 600);
+}
+CATCH
+
+TEST_F(MinTSOSchedulerTest, PriorityOfWaitingQueries)
+try
+{
+    /// the min_tso query reserves all the memory.
+    auto task_1_1 = addTask(1, 1, 1, memory_limit);
+    auto task_1_2 = addTask(1, 2, 1, 0);
+    ASSERT_TRUE(task_manager->tryToScheduleTask(task_1_1));
+    ASSERT_TRUE(task_manager->tryToScheduleTask(task_1_2));
+
+    auto task_2 = addTask(2, 1, 1, 600, /*priority=*/0);
+    auto task_3 = addTask(3, 1, 1, 600, /*priority=*/5);
+    auto task_4 = addTask(4, 1, 1, 600, /*priority=*/1);
+    ASSERT_FALSE(task_manager->tryToScheduleTask(task_2));
+    ASSERT_FALSE(task_manager->tryToScheduleTask(task_3));
+    ASSERT_FALSE(task_manager->tryToScheduleTask(task_4));
+    ASSERT_EQ(getQueryStatuses()[3].priority, 5);
+
+    /// only one of the waiting queries fits in the memory, the one with the highest priority is the first.
+    finishTask(task_1_1);
+    task_1_1.reset();
+    ASSERT_FALSE(task_2->isScheduled());
+    ASSERT_TRUE(task_3->isScheduled());
+    ASSERT_FALSE(task_4->isScheduled());
+
+    /// then the one with higher priority rather than smaller tso.
+    finishTask(task_3);
+    task_3.reset();
+    ASSERT_FALSE(task_2->isScheduled());
+    ASSERT_TRUE(task_4->isScheduled());
+
+    /// the min_tso query is always the first one regardless of the priority.
+    auto task_5 = addTask(5, 1, 1, 600, /*priority=*/10);
+    ASSERT_FALSE(task_manager->tryToScheduleTask(task_5));
+    finishTask(task_1_2);
+    task_1_2.reset();
+    ASSERT_TRUE(task_2->isScheduled());
+    ASSERT_FALSE(task_5->isScheduled());
+}
+CATCH
+
+TEST_F(MinTSOSchedulerTest, SystemTable)
+try
+{
+    /// the system table reads the scheduler of the global context, whose thread soft limit is 5000 by default.
+    task_manager = context->getTMTContext().getMPPTaskManager();
+
+    auto task_1 = addTask(1, 1, 2, 300, /*priority=*/3);
+    auto task_2 = addTask(2, 1, 5000, 800);
+    ASSERT_TRUE(task_manager->tryToScheduleTask(task_1));
+    ASSERT_FALSE(task_manager->tryToScheduleTask(task_2));
+    auto statuses = getQueryStatuses();
+
+    auto storage = StorageSystemMPPSchedulerQueries::create("mpp_scheduler_queries");
+    Names column_names = storage->getColumns().getNamesOfPhysical();
+    auto stage = QueryProcessingStage::FetchColumns;
+    auto streams = storage->read(column_names, SelectQueryInfo(), *context, stage, DEFAULT_BLOCK_SIZE, 1);
+    ASSERT_EQ(streams.size(), 1);
+    Block block = streams[0]->read();
+    ASSERT_EQ(block.rows(), 2);
+
+    auto get_uint = [&](const String & name, size_t row) {
+        return block.getByName(name).column->getUInt(row);
+    };
+    auto get_string = [&](const String & name, size_t row) {
+        return (*block.getByName(name).column)[row].get<String>();
+    };
+    std::map<UInt64, size_t> rows;
+    for (size_t i = 0; i < block.rows(); ++i)
+        rows[get_uint("query_tso", i)] = i;
+    ASSERT_EQ(rows.size(), 2);
+
+    size_t row = rows[1];
+    ASSERT_EQ(get_string("state", row), "active");
+    ASSERT_EQ(get_uint("is_min_tso", row), 1);
+    ASSERT_EQ(block.getByName("priority").column->getInt(row), 3);
+    ASSERT_EQ(get_uint("active_tasks", row), 1);
+    ASSERT_EQ(get_uint("waiting_tasks", row), 0);
+    ASSERT_EQ(get_uint("reserved_threads", row), 2);
+    /// the reservation depends on task_scheduler_memory_limit of the global context.
+    ASSERT_EQ(get_uint("reserved_memory", row), statuses[1].reserved_memory);
+
+    row = rows[2];
+    ASSERT_EQ(get_string("state", row), "waiting");
+    ASSERT_EQ(get_uint("is_min_tso", row), 0);
+    ASSERT_EQ(block.getByName("priority").column->getInt(row), 0);
+    ASSERT_EQ(get_uint("active_tasks", row), 0);
+    ASSERT_EQ(get_uint("waiting_tasks", row), 1);
+    ASSERT_EQ(get_uint("reserved_threads", row), 0);
+    ASSERT_EQ(get_uint("reserved_memory", row), 0);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
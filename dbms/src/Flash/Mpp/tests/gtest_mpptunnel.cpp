@@ -13,12 +13,15 @@
 // limitations under the License.
 
 #include <Common/Exception.h>
+#include <Common/MemoryTracker.h>
+#include <DataTypes/DataTypesNumber.h>
 #include <Flash/Mpp/GRPCReceiverContext.h>
 #include <Flash/Mpp/MPPTunnel.h>
 #include <TestUtils/TiFlashTestBasic.h>
 
 #include <memory>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -88,6 +91,7 @@ struct MockLocalReader
 {
     MPPTunnelTestPtr tunnel;
     std::vector<String> write_packet_vec;
+    Blocks received_blocks;
 
     explicit MockLocalReader(const MPPTunnelTestPtr & tunnel_)
         : tunnel(tunnel_)
@@ -108,11 +112,13 @@ struct MockLocalReader
     {
         while (true)
         {
-            MPPDataPacketPtr tmp_packet = tunnel->readForLocal();
-            bool success = tmp_packet != nullptr;
+            MPPTunnelMessage msg;
+            bool success = tunnel->readForLocal(msg);
             if (success)
             {
-                write_packet_vec.push_back(tmp_packet->data());
+                write_packet_vec.push_back(msg.packet->data());
+                for (auto & block : msg.blocks)
+                    received_blocks.push_back(std::move(block));
             }
             else
             {
@@ -142,7 +148,8 @@ struct MockTerminateLocalReader
 
     void read() const
     {
-        MPPDataPacketPtr tmp_packet = tunnel->readForLocal();
+        MPPTunnelMessage msg;
+        tunnel->readForLocal(msg);
         tunnel->consumerFinish("Receiver closed");
     }
 };
@@ -495,6 +502,73 @@ try
 }
 CATCH
 
+TEST_F(TestMPPTunnelBase, LocalWriteBlocks)
+try
+{
+    auto mpp_tunnel_ptr = constructLocalSyncTunnel();
+    auto local_reader_ptr = connectLocalSyncTunnel(mpp_tunnel_ptr);
+    GTEST_ASSERT_EQ(mpp_tunnel_ptr->getConnectFlag(), true);
+
+    auto type = std::make_shared<DataTypeInt64>();
+    auto column = type->createColumn();
+    for (Int64 i = 0; i < 10; ++i)
+        column->insert(Field(i));
+    Block block{ColumnWithTypeAndName(std::move(column), type, "col")};
+    const auto * column_ptr = block.getByPosition(0).column.get();
+
+    mpp_tunnel_ptr->writeLocal(mpp::MPPDataPacket(), Blocks{block});
+    mpp::MPPDataPacket last_packet;
+    last_packet.set_data("Last");
+    mpp_tunnel_ptr->writeLocal(last_packet, Blocks{});
+    mpp_tunnel_ptr->writeDone();
+    mpp_tunnel_ptr->getThreadManager()->wait(); // Join local read thread
+    GTEST_ASSERT_EQ(mpp_tunnel_ptr->getFinishFlag(), true);
+    GTEST_ASSERT_EQ(local_reader_ptr->write_packet_vec.size(), 2);
+    GTEST_ASSERT_EQ(local_reader_ptr->write_packet_vec[1], "Last");
+    GTEST_ASSERT_EQ(local_reader_ptr->received_blocks.size(), 1);
+    /// the column is passed without being copied.
+    GTEST_ASSERT_EQ(local_reader_ptr->received_blocks[0].getByPosition(0).column.get(), column_ptr);
+    GTEST_ASSERT_EQ(mpp_tunnel_ptr->getConnectionProfileInfo().packets, 2);
+}
+CATCH
+
+TEST_F(TestMPPTunnelBase, LocalMemoryTracker)
+try
+{
+    MemoryTracker memory_tracker;
+    auto mpp_tunnel_ptr = constructLocalSyncTunnel();
+    mpp_tunnel_ptr->setMemoryTracker(&memory_tracker);
+    mpp_tunnel_ptr->connect(nullptr);
+
+    auto type = std::make_shared<DataTypeInt64>();
+    auto column = type->createColumn();
+    for (Int64 i = 0; i < 1000; ++i)
+        column->insert(Field(i));
+    Block block{ColumnWithTypeAndName(std::move(column), type, "col")};
+
+    mpp::MPPDataPacket packet;
+    packet.set_data("First");
+    auto packet_bytes = static_cast<Int64>(packet.ByteSizeLong());
+    mpp_tunnel_ptr->writeLocal(packet, Blocks{block});
+    /// the blocks are tracked by `Allocator` already, only the packet is accounted.
+    GTEST_ASSERT_EQ(memory_tracker.get(), packet_bytes);
+
+    /// the message is freed against the same memory tracker even if it is popped by another thread.
+    std::thread([&] {
+        MPPTunnelMessage msg;
+        ASSERT_TRUE(mpp_tunnel_ptr->readForLocal(msg));
+        ASSERT_EQ(msg.blocks.size(), 1);
+    }).join();
+    GTEST_ASSERT_EQ(memory_tracker.get(), 0);
+
+    mpp_tunnel_ptr->writeLocal(packet, Blocks{});
+    GTEST_ASSERT_EQ(memory_tracker.get(), packet_bytes);
+    mpp_tunnel_ptr->consumerFinish("");
+    mpp_tunnel_ptr->close("");
+    GTEST_ASSERT_EQ(memory_tracker.get(), 0);
+}
+CATCH
+
 TEST_F(TestMPPTunnelBase, LocalConsumerFinish)
 try
 {
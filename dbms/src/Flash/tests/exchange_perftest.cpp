@@ -555,6 +555,8 @@ struct SenderHelper
                     tipb::Hash,
                     -1,
                     -1,
+                    false,
+                    false,
                     true,
                     *dag_context));
             send_streams.push_back(std::make_shared<ExchangeSenderBlockInputStream>(stream, std::move(response_writer), /*req_id=*/""));
@@ -0,0 +1,140 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Flash/Coprocessor/CHBlockChunkCodec.h>
+#include <Flash/Coprocessor/DAGQuerySource.h>
+#include <Flash/Coprocessor/StreamWriter.h>
+#include <Interpreters/executeQuery.h>
+#include <TestUtils/ExecutorTestUtils.h>
+#include <TestUtils/mockExecutor.h>
+
+#include <mutex>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+class MockBatchResponseWriter : public ::grpc::ServerWriterInterface<::coprocessor::BatchResponse>
+{
+public:
+    void SendInitialMetadata() override {}
+
+    bool Write(const ::coprocessor::BatchResponse & msg, ::grpc::WriteOptions) override
+    {
+        std::lock_guard lock(mu);
+        responses.push_back(msg);
+        return true;
+    }
+
+    std::mutex mu;
+    std::vector<::coprocessor::BatchResponse> responses;
+};
+} // namespace
+
+class BatchCopParallelEncodeTest : public DB::tests::ExecutorTest
+{
+public:
+    static constexpr size_t rows = 10000;
+    static constexpr size_t concurrency = 4;
+
+    void initializeContext() override
+    {
+        ExecutorTest::initializeContext();
+        std::vector<std::optional<Int64>> values;
+        for (size_t i = 0; i < rows; ++i)
+            values.emplace_back(i);
+        context.addMockTable({"test_db", "test_table"}, {{"s1", TiDB::TP::TypeLongLong}}, {toNullableVec<Int64>("s1", values)});
+        context.context.setSetting("max_threads", Field(static_cast<UInt64>(concurrency)));
+        // Every stream sends several responses.
+        context.context.setSetting("batch_send_min_limit", Field(static_cast<UInt64>(100)));
+    }
+};
+
+TEST_F(BatchCopParallelEncodeTest, RowsAndExecutionSummaries)
+try
+{
+    auto request = context
+                       .scan("test_db", "test_table")
+                       .filter(eq(col("s1"), col("s1")))
+                       .build(context);
+
+    MockBatchResponseWriter mock_writer;
+    DAGContext dag_context(*request, "batch_cop_parallel_encode_test", concurrency);
+    dag_context.setColumnsForTest(context.executorIdColumnsMap());
+    dag_context.is_mpp_task = false;
+    dag_context.is_batch_cop = true;
+    dag_context.collect_execution_summaries = true;
+    dag_context.return_executor_id = true;
+    dag_context.encode_type = tipb::EncodeType::TypeCHBlock;
+    dag_context.batch_cop_writer = std::make_shared<StreamWriter>(&mock_writer);
+    context.context.setDAGContext(&dag_context);
+
+    DAGQuerySource dag(context.context);
+    auto stream = executeQuery(dag, context.context, false, QueryProcessingStage::Complete).in;
+    stream->readPrefix();
+    while (stream->read())
+        continue;
+    stream->readSuffix();
+
+    std::vector<Int64> values;
+    UInt64 summary_rows = 0;
+    UInt64 summary_concurrency = 0;
+    size_t responses_with_chunks = 0;
+    for (const auto & batch_response : mock_writer.responses)
+    {
+        tipb::SelectResponse response;
+        ASSERT_TRUE(response.ParseFromString(batch_response.data()));
+        size_t response_rows = 0;
+        for (const auto & chunk : response.chunks())
+        {
+            auto block = CHBlockChunkCodec::decode(chunk.rows_data(), Block{});
+            const auto & column = block.getByPosition(0).column;
+            for (size_t i = 0; i < column->size(); ++i)
+                values.push_back((*column)[i].get<Int64>());
+            response_rows += block.rows();
+        }
+        UInt64 selection_rows = 0;
+        for (const auto & summary : response.execution_summaries())
+        {
+            if (summary.executor_id() == "selection_1")
+            {
+                selection_rows += summary.num_produced_rows();
+                summary_concurrency += summary.concurrency();
+            }
+        }
+        // Every response carries the execution summary of the stream encoding it, which covers the rows of the response.
+        if (response_rows > 0)
+        {
+            ++responses_with_chunks;
+            ASSERT_GE(selection_rows, response_rows);
+        }
+        summary_rows += selection_rows;
+    }
+
+    // The rows are complete and not duplicated.
+    ASSERT_EQ(values.size(), rows);
+    std::sort(values.begin(), values.end());
+    for (size_t i = 0; i < rows; ++i)
+        ASSERT_EQ(values[i], static_cast<Int64>(i));
+    ASSERT_GT(responses_with_chunks, concurrency);
+
+    // The summaries of all the responses sum up to the total.
+    ASSERT_EQ(summary_rows, rows);
+    ASSERT_EQ(summary_concurrency, concurrency);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
@@ -52,7 +52,7 @@ Union: <for test>
   Expression: <final projection>
    MergeSorting, limit = 10
     Union: <for partial order>
-     PartialSorting x 10: limit = 10
+     TopN x 10: limit = 10
       Expression: <before order and select>
        Filter: <execute having>
         SharedQuery: <restore concurrency>
@@ -130,7 +130,7 @@ Union: <for test>
      Expression: <final projection>
       MergeSorting, limit = 10
        Union: <for partial order>
-        PartialSorting x 10: limit = 10
+        TopN x 10: limit = 10
          Expression: <projection>
           Expression: <before projection>
            Expression: <final projection>
@@ -161,7 +161,7 @@ Union: <for test>
            Expression: <final projection>
             MergeSorting, limit = 10
              Union: <for partial order>
-              PartialSorting x 10: limit = 10
+              TopN x 10: limit = 10
                Expression: <projection>
                 Expression: <before projection>
                  Expression: <final projection>
@@ -204,7 +204,7 @@ Union: <for test>
                     Expression: <final projection>
                      MergeSorting, limit = 10
                       Union: <for partial order>
-                       PartialSorting x 10: limit = 10
+                       TopN x 10: limit = 10
                         Expression: <projection>
                          Expression: <before projection>
                           Expression: <final projection>
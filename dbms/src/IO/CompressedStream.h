@@ -32,6 +32,7 @@ enum class CompressionMethod
     LZ4HC = 2, /// The format is the same as for LZ4. The difference is only in compression.
     ZSTD = 3, /// Experimental algorithm: https://github.com/Cyan4973/zstd
     NONE = 4, /// No compression
+    LIGHTWEIGHT = 5, /// Lightweight codecs for fixed-width numbers, falls back to LZ4 for other data. See LightweightCompression.h
 };
 
 /** The compressed block format is as follows:
@@ -52,6 +53,8 @@ enum class CompressionMethod
   *
   * 0x90 - ZSTD
   *
+  * 0x91 - LIGHTWEIGHT
+  *
   * All sizes are little endian.
   */
 
@@ -60,6 +63,7 @@ enum class CompressionMethodByte : uint8_t
     NONE = 0x02,
     LZ4 = 0x82,
     ZSTD = 0x90,
+    LIGHTWEIGHT = 0x91,
     // COL_END is not a compreesion method, but a flag of column end used in compact file.
     COL_END = 0x66,
 };
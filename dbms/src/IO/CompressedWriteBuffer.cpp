@@ -14,6 +14,7 @@
 
 #include <Core/Types.h>
 #include <IO/CompressedWriteBuffer.h>
+#include <IO/LightweightCompression.h>
 #include <city.h>
 #include <common/unaligned.h>
 #include <lz4.h>
@@ -33,6 +34,35 @@ extern const int UNKNOWN_COMPRESSION_METHOD;
 } // namespace ErrorCodes
 
 
+template <bool add_checksum>
+size_t CompressedWriteBuffer<add_checksum>::compressLZ4(PODArray<char> & dest, CompressionMethod method, int level)
+{
+    static constexpr size_t header_size = 1 + sizeof(UInt32) + sizeof(UInt32);
+
+    size_t uncompressed_size = offset();
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+    dest.resize(header_size + LZ4_COMPRESSBOUND(uncompressed_size));
+#pragma GCC diagnostic pop
+
+    dest[0] = static_cast<UInt8>(CompressionMethodByte::LZ4);
+
+    size_t compressed_size;
+    if (method == CompressionMethod::LZ4)
+        compressed_size = header_size + LZ4_compress_fast(working_buffer.begin(), &dest[header_size], uncompressed_size, LZ4_COMPRESSBOUND(uncompressed_size), level);
+    else
+        compressed_size = header_size + LZ4_compress_HC(working_buffer.begin(), &dest[header_size], uncompressed_size, LZ4_COMPRESSBOUND(uncompressed_size), level);
+
+    UInt32 compressed_size_32 = compressed_size;
+    UInt32 uncompressed_size_32 = uncompressed_size;
+
+    unalignedStore<UInt32>(&dest[1], compressed_size_32);
+    unalignedStore<UInt32>(&dest[5], uncompressed_size_32);
+
+    return compressed_size;
+}
+
 template <bool add_checksum>
 void CompressedWriteBuffer<add_checksum>::nextImpl()
 {
@@ -51,26 +81,34 @@ void CompressedWriteBuffer<add_checksum>::nextImpl()
     case CompressionMethod::LZ4:
     case CompressionMethod::LZ4HC:
     {
-        static constexpr size_t header_size = 1 + sizeof(UInt32) + sizeof(UInt32);
-
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wold-style-cast"
-        compressed_buffer.resize(header_size + LZ4_COMPRESSBOUND(uncompressed_size));
-#pragma GCC diagnostic pop
-
-        compressed_buffer[0] = static_cast<UInt8>(CompressionMethodByte::LZ4);
-
-        if (compression_settings.method == CompressionMethod::LZ4)
-            compressed_size = header_size + LZ4_compress_fast(working_buffer.begin(), &compressed_buffer[header_size], uncompressed_size, LZ4_COMPRESSBOUND(uncompressed_size), compression_settings.level);
-        else
-            compressed_size = header_size + LZ4_compress_HC(working_buffer.begin(), &compressed_buffer[header_size], uncompressed_size, LZ4_COMPRESSBOUND(uncompressed_size), compression_settings.level);
-
-        UInt32 compressed_size_32 = compressed_size;
-        UInt32 uncompressed_size_32 = uncompressed_size;
-
-        unalignedStore<UInt32>(&compressed_buffer[1], compressed_size_32);
-        unalignedStore<UInt32>(&compressed_buffer[5], uncompressed_size_32);
-
+        compressed_size = compressLZ4(compressed_buffer, compression_settings.method, compression_settings.level);
+        compressed_buffer_ptr = &compressed_buffer[0];
+        break;
+    }
+    case CompressionMethod::LIGHTWEIGHT:
+    {
+        /// Lightweight codecs only work for fixed-width numbers, and they are not always better than LZ4
+        /// (e.g. for values repeating in a pattern). So compress by both and choose the smaller one for every block.
+        compressed_size = compressLZ4(compressed_buffer, CompressionMethod::LZ4, CompressionSettings::getDefaultLevel(CompressionMethod::LZ4));
+        if (compression_settings.data_type != LightweightDataType::Unknown)
+        {
+            static constexpr size_t header_size = 1 + sizeof(UInt32) + sizeof(UInt32);
+
+            lightweight_buffer.resize(header_size + LightweightCompression::compressBound(uncompressed_size));
+            size_t lightweight_size = header_size
+                + LightweightCompression::compress(compression_settings.data_type, working_buffer.begin(), uncompressed_size, &lightweight_buffer[header_size]);
+            if (lightweight_size < compressed_size)
+            {
+                lightweight_buffer[0] = static_cast<UInt8>(CompressionMethodByte::LIGHTWEIGHT);
+                UInt32 compressed_size_32 = lightweight_size;
+                UInt32 uncompressed_size_32 = uncompressed_size;
+                unalignedStore<UInt32>(&lightweight_buffer[1], compressed_size_32);
+                unalignedStore<UInt32>(&lightweight_buffer[5], uncompressed_size_32);
+
+                compressed_buffer.swap(lightweight_buffer);
+                compressed_size = lightweight_size;
+            }
+        }
         compressed_buffer_ptr = &compressed_buffer[0];
         break;
     }
@@ -32,6 +32,11 @@ private:
     CompressionSettings compression_settings;
 
     PODArray<char> compressed_buffer;
+    /// Only used by CompressionMethod::LIGHTWEIGHT to keep the lightweight encoded block.
+    PODArray<char> lightweight_buffer;
+
+    /// Compress the working buffer into `dest` by LZ4 or LZ4HC, returns the compressed size with header.
+    size_t compressLZ4(PODArray<char> & dest, CompressionMethod method, int level);
 
     void nextImpl() override;
 
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <IO/CompressedStream.h>
+#include <IO/LightweightCompression.h>
 
 
 namespace DB
@@ -25,6 +26,8 @@ struct CompressionSettings
 {
     CompressionMethod method;
     int level;
+    /// Only used by CompressionMethod::LIGHTWEIGHT, the element type of the data to be compressed.
+    LightweightDataType data_type = LightweightDataType::Unknown;
 
     CompressionSettings()
         : CompressionSettings(CompressionMethod::LZ4)
@@ -0,0 +1,660 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/Exception.h>
+#include <Common/PODArray.h>
+#include <IO/LightweightCompression.h>
+#include <common/likely.h>
+#include <common/unaligned.h>
+
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+extern const int CANNOT_COMPRESS;
+extern const int CANNOT_DECOMPRESS;
+} // namespace ErrorCodes
+
+namespace LightweightCompression
+{
+namespace
+{
+enum class Codec : UInt8
+{
+    RAW = 0,
+    FOR = 1,
+    DELTA = 2,
+    RLE = 3,
+    GORILLA = 4,
+};
+
+/// data type + codec
+constexpr size_t header_size = 2;
+
+[[noreturn]] void throwCorrupted(const char * reason)
+{
+    throw Exception(fmt::format("Cannot decompress lightweight compressed data: {}", reason), ErrorCodes::CANNOT_DECOMPRESS);
+}
+
+size_t getElementSize(LightweightDataType data_type)
+{
+    switch (data_type)
+    {
+    case LightweightDataType::UInt8:
+    case LightweightDataType::Int8:
+        return 1;
+    case LightweightDataType::UInt16:
+    case LightweightDataType::Int16:
+        return 2;
+    case LightweightDataType::UInt32:
+    case LightweightDataType::Int32:
+    case LightweightDataType::Float32:
+        return 4;
+    case LightweightDataType::UInt64:
+    case LightweightDataType::Int64:
+    case LightweightDataType::Float64:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/// Call `f` with a value of the element type of `data_type`.
+template <typename F>
+void dispatch(LightweightDataType data_type, F && f)
+{
+    switch (data_type)
+    {
+    case LightweightDataType::UInt8:
+        return f(UInt8{});
+    case LightweightDataType::UInt16:
+        return f(UInt16{});
+    case LightweightDataType::UInt32:
+        return f(UInt32{});
+    case LightweightDataType::UInt64:
+        return f(UInt64{});
+    case LightweightDataType::Int8:
+        return f(Int8{});
+    case LightweightDataType::Int16:
+        return f(Int16{});
+    case LightweightDataType::Int32:
+        return f(Int32{});
+    case LightweightDataType::Int64:
+        return f(Int64{});
+    case LightweightDataType::Float32:
+        return f(Float32{});
+    case LightweightDataType::Float64:
+        return f(Float64{});
+    default:
+        throw Exception(fmt::format("Unknown lightweight data type {}", static_cast<Int32>(data_type)), ErrorCodes::CANNOT_COMPRESS);
+    }
+}
+
+inline UInt8 bitWidth(UInt64 x)
+{
+    return x == 0 ? 0 : 64 - __builtin_clzll(x);
+}
+
+inline size_t packedBytes(size_t count, UInt8 width)
+{
+    return (count * width + 7) / 8;
+}
+
+inline UInt64 zigzagEncode(UInt64 x)
+{
+    return (x << 1) ^ static_cast<UInt64>(static_cast<Int64>(x) >> 63);
+}
+
+inline UInt64 zigzagDecode(UInt64 x)
+{
+    return (x >> 1) ^ (~(x & 1) + 1);
+}
+
+class BitWriter
+{
+public:
+    explicit BitWriter(char * dest_)
+        : dest(dest_)
+    {}
+
+    /// Write the lowest `bits` bits of `value`, `bits` should not be greater than 64.
+    void write(UInt64 value, UInt8 bits)
+    {
+        if (bits == 0)
+            return;
+        if (bits < 64)
+            value &= (1ULL << bits) - 1;
+        buffer |= value << filled;
+        if (filled + bits >= 64)
+        {
+            unalignedStore<UInt64>(dest + pos, buffer);
+            pos += sizeof(UInt64);
+            buffer = filled == 0 ? 0 : value >> (64 - filled);
+            filled = filled + bits - 64;
+        }
+        else
+        {
+            filled += bits;
+        }
+    }
+
+    /// Flush the pending bits and return the number of written bytes.
+    size_t finish()
+    {
+        size_t bytes = (filled + 7) / 8;
+        for (size_t i = 0; i < bytes; ++i)
+            dest[pos + i] = static_cast<char>(buffer >> (i * 8));
+        pos += bytes;
+        buffer = 0;
+        filled = 0;
+        return pos;
+    }
+
+private:
+    char * dest;
+    size_t pos = 0;
+    UInt64 buffer = 0;
+    UInt8 filled = 0;
+};
+
+class BitReader
+{
+public:
+    BitReader(const char * src_, size_t size_)
+        : src(src_)
+        , size(size_)
+    {}
+
+    UInt64 read(UInt8 bits)
+    {
+        if (bits == 0)
+            return 0;
+        if (unlikely(bit_pos + bits > size * 8))
+            throwCorrupted("unexpected end of bit stream");
+
+        size_t byte_pos = bit_pos / 8;
+        UInt8 shift = bit_pos % 8;
+        UInt64 res = loadWord(byte_pos) >> shift;
+        if (shift + bits > 64)
+            res |= static_cast<UInt64>(static_cast<UInt8>(src[byte_pos + sizeof(UInt64)])) << (64 - shift);
+        if (bits < 64)
+            res &= (1ULL << bits) - 1;
+        bit_pos += bits;
+        return res;
+    }
+
+private:
+    UInt64 loadWord(size_t byte_pos) const
+    {
+        if (likely(byte_pos + sizeof(UInt64) <= size))
+            return unalignedLoad<UInt64>(src + byte_pos);
+        UInt64 word = 0;
+        for (size_t i = 0; byte_pos + i < size; ++i)
+            word |= static_cast<UInt64>(static_cast<UInt8>(src[byte_pos + i])) << (i * 8);
+        return word;
+    }
+
+    const char * src;
+    size_t size;
+    size_t bit_pos = 0;
+};
+
+/// Integers are encoded as UInt64 with the sign bit flipped, so that the order of signed values is kept
+/// and FOR can work on the unsigned distance to the minimum value.
+template <typename T>
+constexpr UInt64 sign_flip = std::is_signed_v<T> ? (1ULL << 63) : 0;
+
+template <typename T>
+inline UInt64 loadValue(const char * source, size_t i)
+{
+    return static_cast<UInt64>(unalignedLoad<T>(source + i * sizeof(T))) ^ sign_flip<T>;
+}
+
+template <typename T>
+inline void storeValue(char * dest, size_t i, UInt64 value)
+{
+    unalignedStore<T>(dest + i * sizeof(T), static_cast<T>(value ^ sign_flip<T>));
+}
+
+char * writePacked(char * pos, const PaddedPODArray<UInt64> & values, UInt64 min_value, UInt8 width)
+{
+    unalignedStore<UInt64>(pos, min_value);
+    pos += sizeof(UInt64);
+    *pos++ = static_cast<char>(width);
+    BitWriter writer(pos);
+    for (auto value : values)
+        writer.write(value - min_value, width);
+    return pos + writer.finish();
+}
+
+template <typename T>
+size_t compressInteger(const char * source, size_t count, char * dest)
+{
+    PaddedPODArray<UInt64> values(count);
+    for (size_t i = 0; i < count; ++i)
+        values[i] = loadValue<T>(source, i);
+
+    /// Collect the statistics to estimate the encoded size of every codec.
+    UInt64 min_value = std::numeric_limits<UInt64>::max(), max_value = 0;
+    UInt64 delta1_min = std::numeric_limits<UInt64>::max(), delta1_max = 0;
+    UInt64 delta2_min = std::numeric_limits<UInt64>::max(), delta2_max = 0;
+    size_t runs = count == 0 ? 0 : 1;
+    UInt64 prev_delta = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        min_value = std::min(min_value, values[i]);
+        max_value = std::max(max_value, values[i]);
+        if (i == 0)
+            continue;
+        runs += values[i] != values[i - 1];
+        UInt64 delta = values[i] - values[i - 1];
+        UInt64 zigzag = zigzagEncode(delta);
+        delta1_min = std::min(delta1_min, zigzag);
+        delta1_max = std::max(delta1_max, zigzag);
+        if (i >= 2)
+        {
+            zigzag = zigzagEncode(delta - prev_delta);
+            delta2_min = std::min(delta2_min, zigzag);
+            delta2_max = std::max(delta2_max, zigzag);
+        }
+        prev_delta = delta;
+    }
+
+    Codec codec = Codec::RAW;
+    size_t best_size = count * sizeof(T);
+    auto try_codec = [&](Codec c, size_t size) {
+        if (size < best_size)
+        {
+            codec = c;
+            best_size = size;
+        }
+    };
+    if (count > 0)
+        try_codec(Codec::FOR, sizeof(UInt64) + 1 + packedBytes(count, bitWidth(max_value - min_value)));
+    try_codec(Codec::RLE, sizeof(UInt32) + runs * (sizeof(T) + sizeof(UInt32)));
+    UInt8 delta_order = 0;
+    if (count > 1)
+    {
+        size_t size = 1 + sizeof(UInt64) + sizeof(UInt64) + 1 + packedBytes(count - 1, bitWidth(delta1_max - delta1_min));
+        if (size < best_size)
+            delta_order = 1;
+        try_codec(Codec::DELTA, size);
+    }
+    if (count > 2)
+    {
+        size_t size = 1 + 2 * sizeof(UInt64) + sizeof(UInt64) + 1 + packedBytes(count - 2, bitWidth(delta2_max - delta2_min));
+        if (size < best_size)
+            delta_order = 2;
+        try_codec(Codec::DELTA, size);
+    }
+
+    char * pos = dest;
+    *pos++ = static_cast<char>(codec);
+    switch (codec)
+    {
+    case Codec::RAW:
+        memcpy(pos, source, count * sizeof(T));
+        pos += count * sizeof(T);
+        break;
+    case Codec::FOR:
+        pos = writePacked(pos, values, min_value, bitWidth(max_value - min_value));
+        break;
+    case Codec::DELTA:
+    {
+        *pos++ = static_cast<char>(delta_order);
+        for (size_t i = 0; i < delta_order; ++i)
+        {
+            unalignedStore<UInt64>(pos, values[i]);
+            pos += sizeof(UInt64);
+        }
+        PaddedPODArray<UInt64> deltas(count - delta_order);
+        for (size_t i = delta_order; i < count; ++i)
+        {
+            UInt64 delta = values[i] - values[i - 1];
+            if (delta_order == 2)
+                delta -= values[i - 1] - values[i - 2];
+            deltas[i - delta_order] = zigzagEncode(delta);
+        }
+        if (delta_order == 1)
+            pos = writePacked(pos, deltas, delta1_min, bitWidth(delta1_max - delta1_min));
+        else
+            pos = writePacked(pos, deltas, delta2_min, bitWidth(delta2_max - delta2_min));
+        break;
+    }
+    case Codec::RLE:
+    {
+        unalignedStore<UInt32>(pos, static_cast<UInt32>(runs));
+        pos += sizeof(UInt32);
+        size_t run_begin = 0;
+        for (size_t i = 1; i <= count; ++i)
+        {
+            if (i < count && values[i] == values[run_begin])
+                continue;
+            unalignedStore<T>(pos, unalignedLoad<T>(source + run_begin * sizeof(T)));
+            pos += sizeof(T);
+            unalignedStore<UInt32>(pos, static_cast<UInt32>(i - run_begin));
+            pos += sizeof(UInt32);
+            run_begin = i;
+        }
+        break;
+    }
+    default:
+        throw Exception("Unexpected lightweight codec", ErrorCodes::CANNOT_COMPRESS);
+    }
+    return pos - dest;
+}
+
+const char * readPackedHeader(const char * pos, const char * end, UInt64 & min_value, UInt8 & width)
+{
+    if (unlikely(end - pos < static_cast<ssize_t>(sizeof(UInt64) + 1)))
+        throwCorrupted("unexpected end of data");
+    min_value = unalignedLoad<UInt64>(pos);
+    pos += sizeof(UInt64);
+    width = static_cast<UInt8>(*pos++);
+    if (unlikely(width > 64))
+        throwCorrupted("invalid bit width");
+    return pos;
+}
+
+template <typename T>
+void decompressInteger(Codec codec, const char * pos, const char * end, char * dest, size_t count)
+{
+    switch (codec)
+    {
+    case Codec::RAW:
+        if (unlikely(static_cast<size_t>(end - pos) != count * sizeof(T)))
+            throwCorrupted("size mismatch");
+        memcpy(dest, pos, count * sizeof(T));
+        break;
+    case Codec::FOR:
+    {
+        UInt64 min_value;
+        UInt8 width;
+        pos = readPackedHeader(pos, end, min_value, width);
+        if (width == 0)
+        {
+            for (size_t i = 0; i < count; ++i)
+                storeValue<T>(dest, i, min_value);
+            break;
+        }
+        BitReader reader(pos, end - pos);
+        for (size_t i = 0; i < count; ++i)
+            storeValue<T>(dest, i, reader.read(width) + min_value);
+        break;
+    }
+    case Codec::DELTA:
+    {
+        if (unlikely(pos >= end))
+            throwCorrupted("unexpected end of data");
+        UInt8 order = static_cast<UInt8>(*pos++);
+        if (unlikely((order != 1 && order != 2) || count < order || end - pos < static_cast<ssize_t>(order * sizeof(UInt64))))
+            throwCorrupted("invalid delta header");
+        UInt64 prev_value = 0;
+        UInt64 prev_delta = 0;
+        for (size_t i = 0; i < order; ++i)
+        {
+            UInt64 value = unalignedLoad<UInt64>(pos);
+            pos += sizeof(UInt64);
+            prev_delta = value - prev_value;
+            prev_value = value;
+            storeValue<T>(dest, i, value);
+        }
+        UInt64 min_value;
+        UInt8 width;
+        pos = readPackedHeader(pos, end, min_value, width);
+        BitReader reader(pos, end - pos);
+        for (size_t i = order; i < count; ++i)
+        {
+            UInt64 delta = zigzagDecode(reader.read(width) + min_value);
+            if (order == 2)
+                delta += prev_delta;
+            prev_value += delta;
+            prev_delta = delta;
+            storeValue<T>(dest, i, prev_value);
+        }
+        break;
+    }
+    case Codec::RLE:
+    {
+        if (unlikely(end - pos < static_cast<ssize_t>(sizeof(UInt32))))
+            throwCorrupted("unexpected end of data");
+        UInt32 runs = unalignedLoad<UInt32>(pos);
+        pos += sizeof(UInt32);
+        if (unlikely(static_cast<size_t>(end - pos) != runs * (sizeof(T) + sizeof(UInt32))))
+            throwCorrupted("size mismatch");
+        size_t offset = 0;
+        for (UInt32 run = 0; run < runs; ++run)
+        {
+            T value = unalignedLoad<T>(pos);
+            pos += sizeof(T);
+            UInt32 length = unalignedLoad<UInt32>(pos);
+            pos += sizeof(UInt32);
+            if (unlikely(offset + length > count))
+                throwCorrupted("too many values");
+            for (size_t i = 0; i < length; ++i)
+                unalignedStore<T>(dest + (offset + i) * sizeof(T), value);
+            offset += length;
+        }
+        if (unlikely(offset != count))
+            throwCorrupted("too few values");
+        break;
+    }
+    default:
+        throwCorrupted("unknown codec");
+    }
+}
+
+template <typename T>
+using FloatBits = std::conditional_t<sizeof(T) == sizeof(UInt32), UInt32, UInt64>;
+
+/// The XOR encoding of Gorilla, see "Gorilla: A Fast, Scalable, In-Memory Time Series Database".
+/// A value is encoded as:
+/// - '0' if it is the same as the previous value;
+/// - '10' + meaningful bits, if the meaningful bits of XOR fit in the window of the previous one;
+/// - '11' + leading zeros (6 bits) + length of meaningful bits - 1 (6 bits) + meaningful bits.
+template <typename T>
+size_t encodeGorilla(const char * source, size_t count, char * dest)
+{
+    using U = FloatBits<T>;
+    constexpr UInt8 value_bits = sizeof(U) * 8;
+
+    BitWriter writer(dest);
+    U prev = 0;
+    bool has_window = false;
+    UInt8 prev_leading = 0, prev_trailing = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        U value = unalignedLoad<U>(source + i * sizeof(U));
+        if (i == 0)
+        {
+            writer.write(value, value_bits);
+            prev = value;
+            continue;
+        }
+        U x = value ^ prev;
+        prev = value;
+        if (x == 0)
+        {
+            writer.write(0, 1);
+            continue;
+        }
+        UInt8 leading = __builtin_clzll(static_cast<UInt64>(x)) - (64 - value_bits);
+        UInt8 trailing = __builtin_ctzll(static_cast<UInt64>(x));
+        if (has_window && leading >= prev_leading && trailing >= prev_trailing)
+        {
+            writer.write(0b01, 2);
+            writer.write(x >> prev_trailing, value_bits - prev_leading - prev_trailing);
+        }
+        else
+        {
+            UInt8 meaningful = value_bits - leading - trailing;
+            writer.write(0b11, 2);
+            writer.write(leading, 6);
+            writer.write(meaningful - 1, 6);
+            writer.write(x >> trailing, meaningful);
+            has_window = true;
+            prev_leading = leading;
+            prev_trailing = trailing;
+        }
+    }
+    return writer.finish();
+}
+
+template <typename T>
+void decodeGorilla(const char * pos, const char * end, char * dest, size_t count)
+{
+    using U = FloatBits<T>;
+    constexpr UInt8 value_bits = sizeof(U) * 8;
+
+    BitReader reader(pos, end - pos);
+    U prev = 0;
+    UInt8 prev_leading = 0, prev_trailing = 0;
+    bool has_window = false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i == 0)
+        {
+            prev = static_cast<U>(reader.read(value_bits));
+        }
+        else if (reader.read(1) != 0)
+        {
+            if (reader.read(1) == 0)
+            {
+                if (unlikely(!has_window))
+                    throwCorrupted("missing XOR window");
+                prev ^= static_cast<U>(reader.read(value_bits - prev_leading - prev_trailing) << prev_trailing);
+            }
+            else
+            {
+                UInt8 leading = reader.read(6);
+                UInt8 meaningful = reader.read(6) + 1;
+                if (unlikely(leading + meaningful > value_bits))
+                    throwCorrupted("invalid XOR window");
+                has_window = true;
+                prev_leading = leading;
+                prev_trailing = value_bits - leading - meaningful;
+                prev ^= static_cast<U>(reader.read(meaningful) << prev_trailing);
+            }
+        }
+        unalignedStore<U>(dest + i * sizeof(U), prev);
+    }
+}
+
+template <typename T>
+size_t compressFloat(const char * source, size_t count, char * dest)
+{
+    /// At most 2 + 6 + 6 + 64 bits for each value.
+    PODArray<char> encoded(count * 10 + sizeof(UInt64));
+    size_t encoded_size = encodeGorilla<T>(source, count, encoded.data());
+
+    char * pos = dest;
+    if (encoded_size < count * sizeof(T))
+    {
+        *pos++ = static_cast<char>(Codec::GORILLA);
+        memcpy(pos, encoded.data(), encoded_size);
+        pos += encoded_size;
+    }
+    else
+    {
+        *pos++ = static_cast<char>(Codec::RAW);
+        memcpy(pos, source, count * sizeof(T));
+        pos += count * sizeof(T);
+    }
+    return pos - dest;
+}
+
+template <typename T>
+void decompressFloat(Codec codec, const char * pos, const char * end, char * dest, size_t count)
+{
+    switch (codec)
+    {
+    case Codec::RAW:
+        if (unlikely(static_cast<size_t>(end - pos) != count * sizeof(T)))
+            throwCorrupted("size mismatch");
+        memcpy(dest, pos, count * sizeof(T));
+        break;
+    case Codec::GORILLA:
+        decodeGorilla<T>(pos, end, dest, count);
+        break;
+    default:
+        throwCorrupted("unknown codec");
+    }
+}
+
+} // namespace
+
+size_t compressBound(size_t source_size)
+{
+    /// The smallest encoding is chosen, so it is never larger than RAW.
+    return header_size + source_size;
+}
+
+size_t compress(LightweightDataType data_type, const char * source, size_t source_size, char * dest)
+{
+    size_t element_size = getElementSize(data_type);
+    if (element_size == 0)
+        throw Exception(fmt::format("Unknown lightweight data type {}", static_cast<Int32>(data_type)), ErrorCodes::CANNOT_COMPRESS);
+
+    size_t count = source_size / element_size;
+    size_t tail = source_size % element_size;
+
+    char * pos = dest;
+    *pos++ = static_cast<char>(data_type);
+    dispatch(data_type, [&](auto v) {
+        using T = decltype(v);
+        if constexpr (std::is_floating_point_v<T>)
+            pos += compressFloat<T>(source, count, pos);
+        else
+            pos += compressInteger<T>(source, count, pos);
+    });
+    memcpy(pos, source + count * element_size, tail);
+    pos += tail;
+    return pos - dest;
+}
+
+void decompress(const char * source, size_t source_size, char * dest, size_t dest_size)
+{
+    if (unlikely(source_size < header_size))
+        throwCorrupted("unexpected end of data");
+
+    auto data_type = static_cast<LightweightDataType>(source[0]);
+    size_t element_size = getElementSize(data_type);
+    if (unlikely(element_size == 0))
+        throwCorrupted("unknown data type");
+
+    size_t count = dest_size / element_size;
+    size_t tail = dest_size % element_size;
+    if (unlikely(source_size < header_size + tail))
+        throwCorrupted("unexpected end of data");
+
+    const char * end = source + source_size - tail;
+    memcpy(dest + count * element_size, end, tail);
+
+    auto codec = static_cast<Codec>(source[1]);
+    const char * pos = source + header_size;
+    dispatch(data_type, [&](auto v) {
+        using T = decltype(v);
+        if constexpr (std::is_floating_point_v<T>)
+            decompressFloat<T>(codec, pos, end, dest, count);
+        else
+            decompressInteger<T>(codec, pos, end, dest, count);
+    });
+}
+
+} // namespace LightweightCompression
+} // namespace DB
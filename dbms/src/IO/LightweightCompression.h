@@ -0,0 +1,64 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Core/Types.h>
+
+namespace DB
+{
+/// The element types of the data that can be encoded by lightweight compression.
+enum class LightweightDataType : UInt8
+{
+    Unknown = 0,
+    UInt8,
+    UInt16,
+    UInt32,
+    UInt64,
+    Int8,
+    Int16,
+    Int32,
+    Int64,
+    Float32,
+    Float64,
+};
+
+/** Lightweight compression of fixed-width numbers. The codec is chosen by the size of the encoded result for every block:
+  *
+  * - FOR: frame of reference, bit-packs the distance from the minimum value. Good for values within a narrow range.
+  * - DELTA: FOR on the (zigzag encoded) deltas or deltas of deltas. Good for monotonic values, e.g. handles and versions.
+  * - RLE: run-length encoding. Good for values with long runs, e.g. delete marks and null maps.
+  * - GORILLA: XOR with the previous value, only for floats. Good for slowly changing measurements.
+  * - RAW: store the data as is.
+  *
+  * Decoding is much cheaper than LZ4/ZSTD, which makes it suitable for the hot columns of DMFile.
+  *
+  * The encoded format is: [data type (1 byte)][codec (1 byte)][codec specific data][trailing bytes].
+  * The trailing bytes are the last (source_size % sizeof(element)) bytes which don't make up a whole element,
+  * they are possible because a compressed block may end in the middle of an element.
+  */
+namespace LightweightCompression
+{
+/// The max size of the encoded data.
+size_t compressBound(size_t source_size);
+
+/// Encode `source_size` bytes from `source` to `dest`, returns the size of encoded data.
+/// `dest` must have at least `compressBound(source_size)` bytes.
+size_t compress(LightweightDataType data_type, const char * source, size_t source_size, char * dest);
+
+/// Decode the data encoded by `compress`. `dest_size` must be equal to the original `source_size`.
+void decompress(const char * source, size_t source_size, char * dest, size_t dest_size);
+} // namespace LightweightCompression
+
+} // namespace DB
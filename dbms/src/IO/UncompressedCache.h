@@ -15,7 +15,7 @@
 #pragma once
 
 #include <Common/HashTable/Hash.h>
-#include <Common/LRUCache.h>
+#include <Common/ManagedLRUCache.h>
 #include <Common/ProfileEvents.h>
 #include <Common/SipHash.h>
 #include <IO/BufferWithOwnMemory.h>
@@ -46,14 +46,14 @@ struct UncompressedSizeWeightFunction
 
 /** Cache of decompressed blocks for implementation of CachedCompressedReadBuffer. thread-safe.
   */
-class UncompressedCache : public LRUCache<UInt128, UncompressedCacheCell, TrivialHash, UncompressedSizeWeightFunction>
+class UncompressedCache : public ManagedLRUCache<UInt128, UncompressedCacheCell, TrivialHash, UncompressedSizeWeightFunction>
 {
 private:
-    using Base = LRUCache<UInt128, UncompressedCacheCell, TrivialHash, UncompressedSizeWeightFunction>;
+    using Base = ManagedLRUCache<UInt128, UncompressedCacheCell, TrivialHash, UncompressedSizeWeightFunction>;
 
 public:
     UncompressedCache(size_t max_size_in_bytes)
-        : Base(max_size_in_bytes)
+        : Base(max_size_in_bytes, Delay::zero(), /*segmented*/ true)
     {}
 
     /// Calculate key from path to file and offset.
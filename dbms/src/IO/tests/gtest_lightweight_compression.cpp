@@ -0,0 +1,134 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <IO/CompressedReadBuffer.h>
+#include <IO/CompressedWriteBuffer.h>
+#include <IO/LightweightCompression.h>
+#include <IO/ReadBufferFromString.h>
+#include <IO/WriteBufferFromString.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+template <typename T>
+String toBytes(const std::vector<T> & values)
+{
+    return String(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+size_t roundTrip(LightweightDataType data_type, const String & source)
+{
+    String encoded(LightweightCompression::compressBound(source.size()), '\0');
+    size_t encoded_size = LightweightCompression::compress(data_type, source.data(), source.size(), encoded.data());
+    EXPECT_LE(encoded_size, encoded.size());
+
+    String decoded(source.size(), '\0');
+    LightweightCompression::decompress(encoded.data(), encoded_size, decoded.data(), decoded.size());
+    EXPECT_EQ(decoded, source);
+    return encoded_size;
+}
+} // namespace
+
+TEST(LightweightCompressionTest, Integers)
+{
+    std::mt19937_64 rng(42);
+
+    std::vector<Int64> handles(8192);
+    for (size_t i = 0; i < handles.size(); ++i)
+        handles[i] = 1000000 + i * 3;
+    /// Delta of delta is zero, only a few bytes are needed.
+    ASSERT_LT(roundTrip(LightweightDataType::Int64, toBytes(handles)), 64UL);
+
+    std::vector<Int32> narrow(8192);
+    for (auto & v : narrow)
+        v = -100 + static_cast<Int32>(rng() % 200);
+    /// 8 bits for every value.
+    ASSERT_LT(roundTrip(LightweightDataType::Int32, toBytes(narrow)), narrow.size() + 64);
+
+    std::vector<UInt8> runs(8192);
+    for (size_t i = 0; i < runs.size(); ++i)
+        runs[i] = i < 4000 ? 0 : 1;
+    ASSERT_LT(roundTrip(LightweightDataType::UInt8, toBytes(runs)), 64UL);
+
+    std::vector<UInt64> random(1000);
+    for (auto & v : random)
+        v = rng();
+    /// Random values are kept as is.
+    ASSERT_EQ(roundTrip(LightweightDataType::UInt64, toBytes(random)), random.size() * sizeof(UInt64) + 2);
+
+    std::vector<Int16> extremes{std::numeric_limits<Int16>::min(), std::numeric_limits<Int16>::max(), 0, -1, 1};
+    roundTrip(LightweightDataType::Int16, toBytes(extremes));
+    std::vector<UInt64> wrap{0, std::numeric_limits<UInt64>::max(), 0, std::numeric_limits<UInt64>::max(), 1};
+    roundTrip(LightweightDataType::UInt64, toBytes(wrap));
+
+    roundTrip(LightweightDataType::UInt32, "");
+}
+
+TEST(LightweightCompressionTest, Floats)
+{
+    std::vector<Float64> measurements(4096);
+    for (size_t i = 0; i < measurements.size(); ++i)
+        measurements[i] = 20.0 + std::floor(i / 16.0) * 0.5;
+    ASSERT_LT(roundTrip(LightweightDataType::Float64, toBytes(measurements)), measurements.size() * sizeof(Float64) / 4);
+
+    std::vector<Float32> specials{0.0f, -0.0f, std::numeric_limits<Float32>::infinity(), std::numeric_limits<Float32>::quiet_NaN(), 1.5f, 1.25f};
+    roundTrip(LightweightDataType::Float32, toBytes(specials));
+}
+
+TEST(LightweightCompressionTest, TrailingBytes)
+{
+    std::vector<UInt32> values(100, 7);
+    String source = toBytes(values);
+    /// A compressed block may end in the middle of an element.
+    for (size_t cut = 1; cut < sizeof(UInt32); ++cut)
+        roundTrip(LightweightDataType::UInt32, source.substr(0, source.size() - cut));
+    roundTrip(LightweightDataType::Float64, String("abc"));
+}
+
+TEST(LightweightCompressionTest, CompressedBuffer)
+{
+    std::vector<Int64> values(100000);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = i * i;
+    String source = toBytes(values);
+
+    for (auto data_type : {LightweightDataType::Int64, LightweightDataType::Unknown})
+    {
+        WriteBufferFromOwnString compressed;
+        {
+            CompressionSettings settings(CompressionMethod::LIGHTWEIGHT);
+            settings.data_type = data_type;
+            CompressedWriteBuffer<> out(compressed, settings, 10000);
+            out.write(source.data(), source.size());
+        }
+
+        ReadBufferFromString compressed_in(compressed.str());
+        CompressedReadBuffer<> in(compressed_in);
+        String decoded(source.size(), '\0');
+        in.readStrict(decoded.data(), decoded.size());
+        ASSERT_EQ(decoded, source);
+        ASSERT_TRUE(in.eof());
+    }
+}
+
+} // namespace tests
+} // namespace DB
@@ -415,13 +415,13 @@ void NO_INLINE Aggregator::executeImplBatch(
 
     std::unique_ptr<AggregateDataPtr[]> places(new AggregateDataPtr[rows]);
 
-    for (size_t i = 0; i < rows; ++i)
-    {
+    /// `hash_value` is either empty or the hash value of the key of row `i`.
+    auto get_place = [&](size_t i, auto... hash_value) {
         AggregateDataPtr aggregate_data = nullptr;
 
         if constexpr (!no_more_keys)
         {
-            auto emplace_result = state.emplaceKey(method.data, i, *aggregates_pool, sort_key_containers);
+            auto emplace_result = state.emplaceKey(method.data, i, *aggregates_pool, sort_key_containers, hash_value...);
 
             /// If a new key is inserted, initialize the states of the aggregate functions, and possibly something related to the key.
             if (emplace_result.isInserted())
@@ -440,14 +440,42 @@ void NO_INLINE Aggregator::executeImplBatch(
         else
         {
             /// Add only if the key already exists.
-            auto find_result = state.findKey(method.data, i, *aggregates_pool, sort_key_containers);
+            auto find_result = state.findKey(method.data, i, *aggregates_pool, sort_key_containers, hash_value...);
             if (find_result.isFound())
                 aggregate_data = find_result.getMapped();
             else
                 aggregate_data = overflow_row;
         }
 
-        places[i] = aggregate_data;
+        return aggregate_data;
+    };
+
+    bool looked_up = false;
+    if constexpr (ColumnsHashing::columns_hashing_impl::canLookupInTwoPasses<typename Method::State, typename Method::Data>())
+    {
+        size_t prefetch_distance = ColumnsHashing::columns_hashing_impl::getPrefetchDistance(method.data.getBufferSizeInBytes(), rows, params.prefetch_distance, params.prefetch_min_bytes);
+        if (prefetch_distance > 0)
+        {
+            /// Almost every lookup misses the cache for a large hash table, so compute the hashes of all rows
+            /// first and prefetch the cells of the rows `prefetch_distance` ahead while looking up the keys.
+            PaddedPODArray<size_t> hashes(rows);
+            for (size_t i = 0; i < rows; ++i)
+                hashes[i] = state.getHash(method.data, i, *aggregates_pool, sort_key_containers);
+
+            for (size_t i = 0; i < rows; ++i)
+            {
+                if (i + prefetch_distance < rows)
+                    method.data.prefetch(hashes[i + prefetch_distance]);
+                places[i] = get_place(i, hashes[i]);
+            }
+            looked_up = true;
+        }
+    }
+
+    if (!looked_up)
+    {
+        for (size_t i = 0; i < rows; ++i)
+            places[i] = get_place(i);
     }
 
     /// Add values to the aggregate functions.
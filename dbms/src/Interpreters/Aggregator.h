@@ -737,6 +737,11 @@ public:
 
         TiDB::TiDBCollators collators;
 
+        /// How many rows ahead to prefetch the cells of a large hash table when aggregating a block, 0 - disabled.
+        const size_t prefetch_distance;
+        /// The hash tables smaller than this are looked up row by row without prefetching.
+        const size_t prefetch_min_bytes;
+
         Params(
             const Block & src_header_,
             const ColumnNumbers & keys_,
@@ -749,7 +754,9 @@ public:
             size_t max_bytes_before_external_group_by_,
             bool empty_result_for_aggregation_by_empty_set_,
             const std::string & tmp_path_,
-            const TiDB::TiDBCollators & collators_ = TiDB::dummy_collators)
+            const TiDB::TiDBCollators & collators_ = TiDB::dummy_collators,
+            size_t prefetch_distance_ = 0,
+            size_t prefetch_min_bytes_ = ColumnsHashing::columns_hashing_impl::prefetch_min_hash_table_bytes)
             : src_header(src_header_)
             , keys(keys_)
             , aggregates(aggregates_)
@@ -764,6 +771,8 @@ public:
             , empty_result_for_aggregation_by_empty_set(empty_result_for_aggregation_by_empty_set_)
             , tmp_path(tmp_path_)
             , collators(collators_)
+            , prefetch_distance(prefetch_distance_)
+            , prefetch_min_bytes(prefetch_min_bytes_)
         {
         }
 
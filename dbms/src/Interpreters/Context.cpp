@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <Common/CacheManager.h>
 #include <Common/Config/ConfigProcessor.h>
 #include <Common/DNSCache.h>
 #include <Common/FailPoint.h>
@@ -50,8 +51,10 @@
 #include <Poco/Net/IPAddress.h>
 #include <Poco/UUID.h>
 #include <Storages/BackgroundProcessingPool.h>
+#include <Storages/DeltaMerge/BackgroundTaskScheduler.h>
 #include <Storages/DeltaMerge/DeltaIndexManager.h>
 #include <Storages/DeltaMerge/Index/MinMaxIndex.h>
+#include <Storages/DeltaMerge/SegmentResultCache.h>
 #include <Storages/DeltaMerge/StoragePool.h>
 #include <Storages/IStorage.h>
 #include <Storages/MarkCache.h>
@@ -146,7 +149,9 @@ struct ContextShared
     mutable DBGInvoker dbg_invoker; /// Execute inner functions, debug only.
     mutable MarkCachePtr mark_cache; /// Cache of marks in compressed files.
     mutable DM::MinMaxIndexCachePtr minmax_index_cache; /// Cache of minmax index in compressed files.
+    mutable DM::SegmentResultCachePtr segment_result_cache; /// Cache of the partial results of segments.
     mutable DM::DeltaIndexManagerPtr delta_index_manager; /// Manage the Delta Indies of Segments.
+    CacheManagerPtr cache_manager; /// Share the memory budget among the caches.
     ProcessList process_list; /// Executing queries at the moment.
     ViewDependencies view_dependencies; /// Current dependencies
     ConfigurationPtr users_config; /// Config with the users, profiles and quotas sections.
@@ -162,6 +167,7 @@ struct ContextShared
     PathCapacityMetricsPtr path_capacity_ptr; /// Path capacity metrics
     FileProviderPtr file_provider; /// File provider.
     IORateLimiter io_rate_limiter;
+    DM::BackgroundTaskSchedulerPtr dm_background_task_scheduler; /// Schedule the background tasks of all DeltaMerge stores.
     PageStorageRunMode storage_run_mode = PageStorageRunMode::ONLY_V3;
     DM::GlobalStoragePoolPtr global_storage_pool;
     /// Named sessions. The user could specify session identifier to reuse settings and temporary tables in subsequent requests.
@@ -1406,6 +1412,22 @@ void Context::dropMinMaxIndexCache() const
         shared->minmax_index_cache->reset();
 }
 
+void Context::setSegmentResultCache(size_t cache_size_in_bytes)
+{
+    auto lock = getLock();
+
+    if (shared->segment_result_cache)
+        throw Exception("Segment result cache has been already created.", ErrorCodes::LOGICAL_ERROR);
+
+    shared->segment_result_cache = std::make_shared<DM::SegmentResultCache>(cache_size_in_bytes);
+}
+
+DM::SegmentResultCachePtr Context::getSegmentResultCache() const
+{
+    auto lock = getLock();
+    return shared->segment_result_cache;
+}
+
 bool Context::isDeltaIndexLimited() const
 {
     // Don't need to use a lock here, as delta_index_manager should be set at starting up.
@@ -1430,6 +1452,22 @@ DM::DeltaIndexManagerPtr Context::getDeltaIndexManager() const
     return shared->delta_index_manager;
 }
 
+void Context::setCacheManager(size_t memory_budget)
+{
+    auto lock = getLock();
+
+    if (shared->cache_manager)
+        throw Exception("CacheManager has been already created.", ErrorCodes::LOGICAL_ERROR);
+
+    shared->cache_manager = std::make_shared<CacheManager>(memory_budget);
+}
+
+CacheManagerPtr Context::getCacheManager() const
+{
+    auto lock = getLock();
+    return shared->cache_manager;
+}
+
 void Context::dropCaches() const
 {
     auto lock = getLock();
@@ -1458,6 +1496,14 @@ BackgroundProcessingPool & Context::getBlockableBackgroundPool()
     return *shared->blockable_background_pool;
 }
 
+DM::BackgroundTaskSchedulerPtr Context::getDMBackgroundTaskScheduler() const
+{
+    auto lock = getLock();
+    if (!shared->dm_background_task_scheduler)
+        shared->dm_background_task_scheduler = std::make_shared<DM::BackgroundTaskScheduler>(DM::BackgroundTaskScheduler::Limits(settings), &shared->io_rate_limiter);
+    return shared->dm_background_task_scheduler;
+}
+
 void Context::createTMTContext(const TiFlashRaftConfig & raft_config, pingcap::ClusterConfig && cluster_config)
 {
     auto lock = getLock();
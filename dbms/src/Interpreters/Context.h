@@ -54,6 +54,7 @@ class BackgroundProcessingPool;
 class MergeList;
 class MarkCache;
 class UncompressedCache;
+class CacheManager;
 class DBGInvoker;
 class TMTContext;
 using TMTContextPtr = std::shared_ptr<TMTContext>;
@@ -102,7 +103,9 @@ enum class PageStorageRunMode : UInt8;
 namespace DM
 {
 class MinMaxIndexCache;
+class SegmentResultCache;
 class DeltaIndexManager;
+class BackgroundTaskScheduler;
 class GlobalStoragePool;
 using GlobalStoragePoolPtr = std::shared_ptr<GlobalStoragePool>;
 } // namespace DM
@@ -364,10 +367,17 @@ public:
     std::shared_ptr<DM::MinMaxIndexCache> getMinMaxIndexCache() const;
     void dropMinMaxIndexCache() const;
 
+    void setSegmentResultCache(size_t cache_size_in_bytes);
+    std::shared_ptr<DM::SegmentResultCache> getSegmentResultCache() const;
+
     bool isDeltaIndexLimited() const;
     void setDeltaIndexManager(size_t cache_size_in_bytes);
     std::shared_ptr<DM::DeltaIndexManager> getDeltaIndexManager() const;
 
+    /// Create a manager to share one memory budget among the caches above. This can be done only once.
+    void setCacheManager(size_t memory_budget);
+    std::shared_ptr<CacheManager> getCacheManager() const;
+
     /** Clear the caches of the uncompressed blocks and marks.
       * This is usually done when renaming tables, changing the type of columns, deleting a table.
       *  - since caches are linked to file names, and become incorrect.
@@ -381,6 +391,7 @@ public:
 
     BackgroundProcessingPool & getBackgroundPool();
     BackgroundProcessingPool & getBlockableBackgroundPool();
+    std::shared_ptr<DM::BackgroundTaskScheduler> getDMBackgroundTaskScheduler() const;
 
     void createTMTContext(const TiFlashRaftConfig & raft_config, pingcap::ClusterConfig && cluster_config);
 
@@ -22,6 +22,7 @@
 #include <Functions/FunctionFactory.h>
 #include <Functions/IFunction.h>
 #include <Interpreters/ExpressionActions.h>
+#include <Interpreters/ExpressionFusion.h>
 #include <Interpreters/Join.h>
 
 #include <optional>
@@ -857,6 +858,9 @@ void ExpressionActions::finalize(const Names & output_columns)
         std::cerr << action.toString() << "\n";
     std::cerr << "\n";*/
 
+    if (settings.enable_expression_fusion)
+        fuseExpressionActions(actions, final_columns, sample_block);
+
     /// Deletes unnecessary temporary columns.
 
     /// If the column after performing the function `refcount = 0`, it can be deleted.
@@ -0,0 +1,922 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Columns/ColumnConst.h>
+#include <Columns/ColumnNullable.h>
+#include <Columns/ColumnsNumber.h>
+#include <Common/LRUCache.h>
+#include <Common/PODArray.h>
+#include <Common/ProfileEvents.h>
+#include <Common/typeid_cast.h>
+#include <DataTypes/DataTypeNullable.h>
+#include <Functions/IFunction.h>
+#include <Interpreters/ExpressionFusion.h>
+
+#include <optional>
+#include <unordered_map>
+
+namespace ProfileEvents
+{
+extern const Event CompiledExpressionCacheHits;
+extern const Event CompiledExpressionCacheMisses;
+} // namespace ProfileEvents
+
+namespace DB
+{
+namespace ErrorCodes
+{
+extern const int LOGICAL_ERROR;
+} // namespace ErrorCodes
+
+namespace
+{
+/// The number of rows evaluated at a time, small enough to keep the intermediate results of a chunk in the cache.
+constexpr size_t FUSED_CHUNK_ROWS = 512;
+
+/// The number of compiled expressions kept in the cache.
+constexpr size_t COMPILED_EXPRESSION_CACHE_SIZE = 4096;
+
+enum class FusedOp
+{
+    Input,
+    Cast,
+    ToBool,
+    Plus,
+    Minus,
+    Multiply,
+    Equals,
+    NotEquals,
+    Less,
+    LessOrEquals,
+    Greater,
+    GreaterOrEquals,
+    Not,
+    And,
+    Or,
+    IsNull,
+    If,
+};
+
+bool isComparison(FusedOp op)
+{
+    return op >= FusedOp::Equals && op <= FusedOp::GreaterOrEquals;
+}
+
+/// Whether the result is NULL if any operand is NULL, like the default implementation for nulls of functions.
+bool propagatesNulls(FusedOp op)
+{
+    return op != FusedOp::And && op != FusedOp::Or && op != FusedOp::IsNull && op != FusedOp::If;
+}
+
+std::optional<FusedOp> getFusedOp(const String & function_name)
+{
+    static const std::unordered_map<String, FusedOp> ops = {
+        {"plus", FusedOp::Plus},
+        {"minus", FusedOp::Minus},
+        {"multiply", FusedOp::Multiply},
+        {"equals", FusedOp::Equals},
+        {"notEquals", FusedOp::NotEquals},
+        {"less", FusedOp::Less},
+        {"lessOrEquals", FusedOp::LessOrEquals},
+        {"greater", FusedOp::Greater},
+        {"greaterOrEquals", FusedOp::GreaterOrEquals},
+        {"not", FusedOp::Not},
+        {"and", FusedOp::And},
+        {"or", FusedOp::Or},
+        {"isNull", FusedOp::IsNull},
+        {"multiIf", FusedOp::If},
+    };
+    if (auto it = ops.find(function_name); it != ops.end())
+        return it->second;
+    return std::nullopt;
+}
+
+template <typename F>
+auto dispatchNumber(TypeIndex type, F && f)
+{
+    switch (type)
+    {
+    case TypeIndex::UInt8:
+        return f(UInt8{});
+    case TypeIndex::UInt16:
+        return f(UInt16{});
+    case TypeIndex::UInt32:
+        return f(UInt32{});
+    case TypeIndex::UInt64:
+        return f(UInt64{});
+    case TypeIndex::Int8:
+        return f(Int8{});
+    case TypeIndex::Int16:
+        return f(Int16{});
+    case TypeIndex::Int32:
+        return f(Int32{});
+    case TypeIndex::Int64:
+        return f(Int64{});
+    case TypeIndex::Float32:
+        return f(Float32{});
+    case TypeIndex::Float64:
+        return f(Float64{});
+    default:
+        throw Exception("Unexpected type in fused expression", ErrorCodes::LOGICAL_ERROR);
+    }
+}
+
+bool isFusibleType(TypeIndex type)
+{
+    switch (type)
+    {
+    case TypeIndex::UInt8:
+    case TypeIndex::UInt16:
+    case TypeIndex::UInt32:
+    case TypeIndex::UInt64:
+    case TypeIndex::Int8:
+    case TypeIndex::Int16:
+    case TypeIndex::Int32:
+    case TypeIndex::Int64:
+    case TypeIndex::Float32:
+    case TypeIndex::Float64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+size_t sizeOfType(TypeIndex type)
+{
+    return dispatchNumber(type, [](auto v) { return sizeof(v); });
+}
+
+bool isFloat(TypeIndex type)
+{
+    return type == TypeIndex::Float32 || type == TypeIndex::Float64;
+}
+
+bool isSignedInteger(TypeIndex type)
+{
+    return type >= TypeIndex::Int8 && type <= TypeIndex::Int64;
+}
+
+/// The type both sides of a comparison are converted to. Only the types that can be converted
+/// without changing the result of comparison are supported, e.g. Int32 and Int64, but not Int64 and UInt64.
+std::optional<TypeIndex> getComparisonType(TypeIndex lhs, TypeIndex rhs)
+{
+    if (lhs == rhs)
+        return lhs;
+    if (isFloat(lhs) != isFloat(rhs) || isSignedInteger(lhs) != isSignedInteger(rhs))
+        return std::nullopt;
+    return sizeOfType(lhs) >= sizeOfType(rhs) ? lhs : rhs;
+}
+
+/// The integers are computed as unsigned ones, which wrap around on overflow just like the unfused functions do.
+template <typename T, bool is_float = std::is_floating_point_v<T>>
+struct ComputeTypeImpl
+{
+    using Type = T;
+};
+
+template <typename T>
+struct ComputeTypeImpl<T, false>
+{
+    using Type = std::conditional_t<(sizeof(T) < sizeof(unsigned)), unsigned, std::make_unsigned_t<T>>;
+};
+
+template <typename T>
+using ComputeType = typename ComputeTypeImpl<T>::Type;
+
+/// The operands and the result of a node for one chunk. The null maps of operands which are not nullable are all zeros,
+/// and the null map of result is nullptr if it is not nullable.
+struct KernelArgs
+{
+    const void * values[3] = {};
+    const UInt8 * nulls[3] = {};
+    void * res_values = nullptr;
+    UInt8 * res_nulls = nullptr;
+};
+
+/// The loop specialized for the operation and types of a node, which is selected when the expression is compiled.
+using Kernel = void (*)(const KernelArgs & args, size_t n);
+
+template <typename From, typename To>
+void castKernel(const KernelArgs & args, size_t n)
+{
+    const auto * __restrict a = static_cast<const From *>(args.values[0]);
+    auto * __restrict c = static_cast<To *>(args.res_values);
+    for (size_t i = 0; i < n; ++i)
+        c[i] = static_cast<To>(a[i]);
+}
+
+template <typename T>
+void toBoolKernel(const KernelArgs & args, size_t n)
+{
+    const auto * __restrict a = static_cast<const T *>(args.values[0]);
+    auto * __restrict c = static_cast<UInt8 *>(args.res_values);
+    for (size_t i = 0; i < n; ++i)
+        c[i] = a[i] != 0;
+}
+
+template <typename T>
+void notKernel(const KernelArgs & args, size_t n)
+{
+    const auto * __restrict a = static_cast<const T *>(args.values[0]);
+    auto * __restrict c = static_cast<UInt8 *>(args.res_values);
+    for (size_t i = 0; i < n; ++i)
+        c[i] = !a[i];
+}
+
+template <FusedOp op, typename T>
+void arithmeticKernel(const KernelArgs & args, size_t n)
+{
+    using U = ComputeType<T>;
+    const auto * __restrict a = static_cast<const T *>(args.values[0]);
+    const auto * __restrict b = static_cast<const T *>(args.values[1]);
+    auto * __restrict c = static_cast<T *>(args.res_values);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if constexpr (op == FusedOp::Plus)
+            c[i] = static_cast<T>(static_cast<U>(a[i]) + static_cast<U>(b[i]));
+        else if constexpr (op == FusedOp::Minus)
+            c[i] = static_cast<T>(static_cast<U>(a[i]) - static_cast<U>(b[i]));
+        else
+            c[i] = static_cast<T>(static_cast<U>(a[i]) * static_cast<U>(b[i]));
+    }
+}
+
+template <FusedOp op, typename T>
+void compareKernel(const KernelArgs & args, size_t n)
+{
+    const auto * __restrict a = static_cast<const T *>(args.values[0]);
+    const auto * __restrict b = static_cast<const T *>(args.values[1]);
+    auto * __restrict c = static_cast<UInt8 *>(args.res_values);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if constexpr (op == FusedOp::Equals)
+            c[i] = a[i] == b[i];
+        else if constexpr (op == FusedOp::NotEquals)
+            c[i] = a[i] != b[i];
+        else if constexpr (op == FusedOp::Less)
+            c[i] = a[i] < b[i];
+        else if constexpr (op == FusedOp::LessOrEquals)
+            c[i] = a[i] <= b[i];
+        else if constexpr (op == FusedOp::Greater)
+            c[i] = a[i] > b[i];
+        else
+            c[i] = a[i] >= b[i];
+    }
+}
+
+/// The three-valued logic of and/or: false AND NULL is false, true OR NULL is true, otherwise NULL makes the result NULL.
+template <FusedOp op>
+void logicalKernel(const KernelArgs & args, size_t n)
+{
+    const auto * __restrict a = static_cast<const UInt8 *>(args.values[0]);
+    const auto * __restrict b = static_cast<const UInt8 *>(args.values[1]);
+    const UInt8 * __restrict a_nulls = args.nulls[0];
+    const UInt8 * __restrict b_nulls = args.nulls[1];
+    auto * __restrict c = static_cast<UInt8 *>(args.res_values);
+    UInt8 * __restrict c_nulls = args.res_nulls;
+    for (size_t i = 0; i < n; ++i)
+    {
+        /// The result is decided by an operand which is not NULL, false for and, true for or.
+        bool decided;
+        if constexpr (op == FusedOp::And)
+            decided = (!a_nulls[i] && !a[i]) || (!b_nulls[i] && !b[i]);
+        else
+            decided = (!a_nulls[i] && a[i]) || (!b_nulls[i] && b[i]);
+        bool is_null = !decided && (a_nulls[i] || b_nulls[i]);
+        if constexpr (op == FusedOp::And)
+            c[i] = !decided && !is_null;
+        else
+            c[i] = decided;
+        if (c_nulls)
+            c_nulls[i] = is_null;
+    }
+}
+
+void isNullKernel(const KernelArgs & args, size_t n)
+{
+    memcpy(args.res_values, args.nulls[0], n);
+}
+
+/// A NULL condition is taken as false, like multiIf does.
+template <typename T>
+void ifKernel(const KernelArgs & args, size_t n)
+{
+    const auto * __restrict cond = static_cast<const UInt8 *>(args.values[0]);
+    const UInt8 * __restrict cond_nulls = args.nulls[0];
+    const auto * __restrict a = static_cast<const T *>(args.values[1]);
+    const auto * __restrict b = static_cast<const T *>(args.values[2]);
+    auto * __restrict c = static_cast<T *>(args.res_values);
+    for (size_t i = 0; i < n; ++i)
+        c[i] = (cond[i] && !cond_nulls[i]) ? a[i] : b[i];
+    if (UInt8 * __restrict c_nulls = args.res_nulls)
+    {
+        for (size_t i = 0; i < n; ++i)
+            c_nulls[i] = (cond[i] && !cond_nulls[i]) ? args.nulls[1][i] : args.nulls[2][i];
+    }
+}
+
+void mergeNulls(const KernelArgs & args, size_t num_args, size_t n)
+{
+    UInt8 * __restrict c = args.res_nulls;
+    memcpy(c, args.nulls[0], n);
+    for (size_t k = 1; k < num_args; ++k)
+    {
+        const UInt8 * __restrict a = args.nulls[k];
+        for (size_t i = 0; i < n; ++i)
+            c[i] |= a[i];
+    }
+}
+
+struct FusedNode
+{
+    FusedOp op;
+    /// The type of the values produced by this node.
+    TypeIndex type;
+    bool nullable = false;
+    /// For Input, the position of the argument of fused function.
+    size_t input = 0;
+    /// The positions of operands in the program.
+    std::vector<size_t> args;
+    Kernel kernel = nullptr;
+};
+
+/// The nodes in the order of evaluation, the last one is the result.
+struct CompiledExpression
+{
+    std::vector<FusedNode> nodes;
+};
+using CompiledExpressionPtr = std::shared_ptr<const CompiledExpression>;
+
+/// The compiled expressions are shared by the actions with the same structure, e.g. the same filters of different
+/// queries, so that an expression is compiled only once.
+using CompiledExpressionCache = LRUCache<String, CompiledExpression>;
+
+CompiledExpressionCache & getCompiledExpressionCache()
+{
+    static CompiledExpressionCache cache(COMPILED_EXPRESSION_CACHE_SIZE);
+    return cache;
+}
+
+Kernel selectKernel(const std::vector<FusedNode> & nodes, const FusedNode & node)
+{
+    const TypeIndex operand_type = nodes[node.args[0]].type;
+    switch (node.op)
+    {
+    case FusedOp::Cast:
+        return dispatchNumber(operand_type, [&](auto from) {
+            return dispatchNumber(node.type, [&](auto to) -> Kernel { return &castKernel<decltype(from), decltype(to)>; });
+        });
+    case FusedOp::ToBool:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &toBoolKernel<decltype(v)>; });
+    case FusedOp::Not:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &notKernel<decltype(v)>; });
+    case FusedOp::Plus:
+        return dispatchNumber(node.type, [](auto v) -> Kernel { return &arithmeticKernel<FusedOp::Plus, decltype(v)>; });
+    case FusedOp::Minus:
+        return dispatchNumber(node.type, [](auto v) -> Kernel { return &arithmeticKernel<FusedOp::Minus, decltype(v)>; });
+    case FusedOp::Multiply:
+        return dispatchNumber(node.type, [](auto v) -> Kernel { return &arithmeticKernel<FusedOp::Multiply, decltype(v)>; });
+    case FusedOp::Equals:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &compareKernel<FusedOp::Equals, decltype(v)>; });
+    case FusedOp::NotEquals:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &compareKernel<FusedOp::NotEquals, decltype(v)>; });
+    case FusedOp::Less:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &compareKernel<FusedOp::Less, decltype(v)>; });
+    case FusedOp::LessOrEquals:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &compareKernel<FusedOp::LessOrEquals, decltype(v)>; });
+    case FusedOp::Greater:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &compareKernel<FusedOp::Greater, decltype(v)>; });
+    case FusedOp::GreaterOrEquals:
+        return dispatchNumber(operand_type, [](auto v) -> Kernel { return &compareKernel<FusedOp::GreaterOrEquals, decltype(v)>; });
+    case FusedOp::And:
+        return &logicalKernel<FusedOp::And>;
+    case FusedOp::Or:
+        return &logicalKernel<FusedOp::Or>;
+    case FusedOp::IsNull:
+        return &isNullKernel;
+    case FusedOp::If:
+        return dispatchNumber(node.type, [](auto v) -> Kernel { return &ifKernel<decltype(v)>; });
+    default:
+        throw Exception("Unexpected operation in fused expression", ErrorCodes::LOGICAL_ERROR);
+    }
+}
+
+class ExecutableFunctionFused final : public IExecutableFunction
+{
+public:
+    explicit ExecutableFunctionFused(const CompiledExpressionPtr & expression_)
+        : expression(expression_)
+    {}
+
+    String getName() const override { return "fused"; }
+
+protected:
+    /// The null maps are handled by the nodes, because and/or/isNull/multiIf don't follow the default implementation.
+    bool useDefaultImplementationForNulls() const override { return false; }
+    bool useDefaultImplementationForConstants() const override { return true; }
+
+    void executeImpl(Block & block, const ColumnNumbers & arguments, size_t result) const override
+    {
+        const size_t rows = block.rows();
+        const auto & nodes = expression->nodes;
+
+        /// The buffers of the intermediate results and the constant arguments, for one chunk.
+        std::vector<PaddedPODArray<char>> value_buffers(nodes.size());
+        std::vector<PaddedPODArray<UInt8>> null_buffers(nodes.size());
+        std::vector<const char *> input_values(nodes.size(), nullptr);
+        std::vector<const UInt8 *> input_nulls(nodes.size(), nullptr);
+        PaddedPODArray<UInt8> zero_nulls(FUSED_CHUNK_ROWS, 0);
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            const auto & node = nodes[i];
+            const size_t value_size = sizeOfType(node.type);
+            if (node.op != FusedOp::Input)
+            {
+                value_buffers[i].resize(FUSED_CHUNK_ROWS * value_size);
+                if (node.nullable)
+                    null_buffers[i].resize(FUSED_CHUNK_ROWS);
+                continue;
+            }
+
+            const auto & column = block.getByPosition(arguments[node.input]).column;
+            const IColumn * values = column.get();
+            const IColumn * nulls = nullptr;
+            if (const auto * const_column = typeid_cast<const ColumnConst *>(values))
+                values = &const_column->getDataColumn();
+            if (const auto * nullable_column = typeid_cast<const ColumnNullable *>(values))
+            {
+                values = &nullable_column->getNestedColumn();
+                nulls = &nullable_column->getNullMapColumn();
+            }
+            if (unlikely(!values->isFixedAndContiguous() || values->sizeOfValueIfFixed() != value_size || (nulls && !node.nullable)))
+                throw Exception("Unexpected argument of fused expression: " + column->getName(), ErrorCodes::LOGICAL_ERROR);
+
+            if (column->isColumnConst())
+            {
+                auto value = values->getRawData();
+                value_buffers[i].resize(FUSED_CHUNK_ROWS * value_size);
+                for (size_t row = 0; row < FUSED_CHUNK_ROWS; ++row)
+                    memcpy(&value_buffers[i][row * value_size], value.data, value_size);
+                if (node.nullable)
+                    null_buffers[i].assign(FUSED_CHUNK_ROWS, nulls ? *nulls->getRawData().data : UInt8(0));
+            }
+            else
+            {
+                input_values[i] = values->getRawData().data;
+                if (nulls)
+                    input_nulls[i] = reinterpret_cast<const UInt8 *>(nulls->getRawData().data);
+                else if (node.nullable)
+                    null_buffers[i].assign(FUSED_CHUNK_ROWS, UInt8(0));
+            }
+        }
+
+        const auto & result_node = nodes.back();
+        MutableColumnPtr result_values;
+        char * result_data = nullptr;
+        dispatchNumber(result_node.type, [&](auto v) {
+            auto column = ColumnVector<decltype(v)>::create(rows);
+            result_data = reinterpret_cast<char *>(column->getData().data());
+            result_values = std::move(column);
+        });
+        MutableColumnPtr result_nulls;
+        UInt8 * result_null_data = nullptr;
+        if (result_node.nullable)
+        {
+            auto column = ColumnUInt8::create(rows);
+            result_null_data = column->getData().data();
+            result_nulls = std::move(column);
+        }
+
+        std::vector<const void *> values(nodes.size());
+        std::vector<const UInt8 *> nulls(nodes.size());
+        for (size_t begin = 0; begin < rows; begin += FUSED_CHUNK_ROWS)
+        {
+            const size_t n = std::min(FUSED_CHUNK_ROWS, rows - begin);
+            for (size_t i = 0; i < nodes.size(); ++i)
+            {
+                const auto & node = nodes[i];
+                if (node.op == FusedOp::Input)
+                {
+                    values[i] = input_values[i] ? input_values[i] + begin * sizeOfType(node.type) : value_buffers[i].data();
+                    nulls[i] = input_nulls[i] ? input_nulls[i] + begin : (node.nullable ? null_buffers[i].data() : zero_nulls.data());
+                    continue;
+                }
+
+                KernelArgs args;
+                for (size_t k = 0; k < node.args.size(); ++k)
+                {
+                    args.values[k] = values[node.args[k]];
+                    args.nulls[k] = nulls[node.args[k]];
+                }
+                /// The result node is written into the result column directly.
+                const bool is_result = i + 1 == nodes.size();
+                args.res_values = is_result ? result_data + begin * sizeOfType(node.type) : value_buffers[i].data();
+                if (node.nullable)
+                    args.res_nulls = is_result ? result_null_data + begin : null_buffers[i].data();
+
+                node.kernel(args, n);
+                if (node.nullable && propagatesNulls(node.op))
+                    mergeNulls(args, node.args.size(), n);
+
+                values[i] = args.res_values;
+                nulls[i] = node.nullable ? args.res_nulls : zero_nulls.data();
+            }
+        }
+
+        if (result_node.nullable)
+            block.getByPosition(result).column = ColumnNullable::create(std::move(result_values), std::move(result_nulls));
+        else
+            block.getByPosition(result).column = std::move(result_values);
+    }
+
+private:
+    CompiledExpressionPtr expression;
+};
+
+class FunctionFused final : public IFunctionBase
+{
+public:
+    FunctionFused(const CompiledExpressionPtr & expression_, const DataTypes & argument_types_, const DataTypePtr & return_type_)
+        : expression(expression_)
+        , argument_types(argument_types_)
+        , return_type(return_type_)
+    {}
+
+    String getName() const override { return "fused"; }
+
+    const DataTypes & getArgumentTypes() const override { return argument_types; }
+    const DataTypePtr & getReturnType() const override { return return_type; }
+
+    ExecutableFunctionPtr prepare(const Block & /*sample_block*/) const override
+    {
+        return std::make_shared<ExecutableFunctionFused>(expression);
+    }
+
+private:
+    CompiledExpressionPtr expression;
+    DataTypes argument_types;
+    DataTypePtr return_type;
+};
+
+struct FusedTree;
+using FusedTreePtr = std::shared_ptr<FusedTree>;
+
+/// The expression tree of fused actions, the leaves are the columns of the block.
+struct FusedTree
+{
+    FusedOp op;
+    TypeIndex type;
+    bool nullable = false;
+    /// For Input.
+    String input_name;
+    DataTypePtr input_type;
+    std::vector<FusedTreePtr> children;
+};
+
+FusedTreePtr makeTree(FusedOp op, TypeIndex type, bool nullable, std::vector<FusedTreePtr> children)
+{
+    auto tree = std::make_shared<FusedTree>();
+    tree->op = op;
+    tree->type = type;
+    tree->nullable = nullable;
+    tree->children = std::move(children);
+    return tree;
+}
+
+/// Return the operation of `action` if it can be fused, the results must be the same as the unfused function.
+std::optional<FusedOp> getFusedOp(const ExpressionAction & action)
+{
+    if (action.type != ExpressionAction::APPLY_FUNCTION || !action.function)
+        return std::nullopt;
+    auto op = getFusedOp(action.function->getName());
+    if (!op)
+        return std::nullopt;
+
+    const auto & argument_types = action.function->getArgumentTypes();
+    const size_t num_args = argument_types.size();
+    if (num_args != action.argument_names.size())
+        return std::nullopt;
+    bool has_nullable = false;
+    bool has_float = false;
+    std::vector<TypeIndex> types(num_args);
+    for (size_t i = 0; i < num_args; ++i)
+    {
+        types[i] = removeNullable(argument_types[i])->getTypeId();
+        if (!isFusibleType(types[i]))
+            return std::nullopt;
+        has_nullable |= argument_types[i]->isNullable();
+        has_float |= isFloat(types[i]);
+    }
+    const auto result_type = removeNullable(action.result_type)->getTypeId();
+    const bool result_nullable = action.result_type->isNullable();
+    if (!isFusibleType(result_type))
+        return std::nullopt;
+
+    switch (*op)
+    {
+    case FusedOp::IsNull:
+        if (num_args != 1 || result_type != TypeIndex::UInt8 || result_nullable)
+            return std::nullopt;
+        break;
+    case FusedOp::Not:
+        if (num_args != 1 || result_type != TypeIndex::UInt8 || result_nullable != has_nullable)
+            return std::nullopt;
+        break;
+    case FusedOp::And:
+    case FusedOp::Or:
+        if (num_args < 2 || result_type != TypeIndex::UInt8 || result_nullable != has_nullable)
+            return std::nullopt;
+        break;
+    case FusedOp::If:
+    {
+        /// multiIf(cond1, then1, cond2, then2, ..., else), the branches are cast to the result type.
+        if (num_args < 3 || num_args % 2 == 0)
+            return std::nullopt;
+        bool branch_nullable = false;
+        bool branch_float = false;
+        for (size_t i = 0; i < num_args; ++i)
+        {
+            if (i % 2 == 1 || i + 1 == num_args)
+            {
+                branch_nullable |= argument_types[i]->isNullable();
+                branch_float |= isFloat(types[i]);
+            }
+            else if (types[i] != TypeIndex::UInt8)
+                return std::nullopt;
+        }
+        if (result_nullable != branch_nullable || (branch_float && !isFloat(result_type)))
+            return std::nullopt;
+        break;
+    }
+    default:
+        /// Arithmetic and comparison functions, the null maps are merged like the default implementation for nulls.
+        if (num_args != 2 || result_nullable != has_nullable)
+            return std::nullopt;
+        if (isComparison(*op))
+        {
+            if (result_type != TypeIndex::UInt8 || !getComparisonType(types[0], types[1]))
+                return std::nullopt;
+        }
+        else if (isFloat(result_type) != has_float)
+            return std::nullopt;
+    }
+    return op;
+}
+
+/// Build the tree of `action` from the trees of its arguments, n-ary functions are turned into binary ones.
+FusedTreePtr buildTree(FusedOp op, const ExpressionAction & action, std::vector<FusedTreePtr> && children)
+{
+    const auto type = removeNullable(action.result_type)->getTypeId();
+    const bool nullable = action.result_type->isNullable();
+    switch (op)
+    {
+    case FusedOp::And:
+    case FusedOp::Or:
+    {
+        auto tree = children[0];
+        for (size_t i = 1; i < children.size(); ++i)
+            tree = makeTree(op, type, tree->nullable || children[i]->nullable, {tree, children[i]});
+        return tree;
+    }
+    case FusedOp::If:
+    {
+        /// multiIf(c1, t1, c2, t2, e) is if(c1, t1, if(c2, t2, e)).
+        auto tree = children.back();
+        for (size_t i = children.size() - 1; i >= 2; i -= 2)
+            tree = makeTree(op, type, nullable, {children[i - 2], children[i - 1], tree});
+        return tree;
+    }
+    default:
+        return makeTree(op, type, nullable, std::move(children));
+    }
+}
+
+/// The structure of an expression, with the inputs numbered in the order of first appearance.
+/// The expressions with the same key are compiled into the same program.
+void serializeTree(const FusedTreePtr & tree, String & key, Names & input_names, DataTypes & input_types, std::unordered_map<String, size_t> & input_positions)
+{
+    key += std::to_string(static_cast<int>(tree->op));
+    key += ':';
+    key += std::to_string(static_cast<int>(tree->type));
+    key += tree->nullable ? "?" : "";
+    if (tree->op == FusedOp::Input)
+    {
+        auto [it, inserted] = input_positions.emplace(tree->input_name, input_names.size());
+        if (inserted)
+        {
+            input_names.push_back(tree->input_name);
+            input_types.push_back(tree->input_type);
+        }
+        key += '$';
+        key += std::to_string(it->second);
+        return;
+    }
+    key += '(';
+    for (const auto & child : tree->children)
+    {
+        serializeTree(child, key, input_names, input_types, input_positions);
+        key += ',';
+    }
+    key += ')';
+}
+
+class ExpressionCompiler
+{
+public:
+    explicit ExpressionCompiler(const std::unordered_map<String, size_t> & input_positions_)
+        : input_positions(input_positions_)
+    {}
+
+    CompiledExpression compile(const FusedTreePtr & tree)
+    {
+        compileNode(tree);
+        for (auto & node : expression.nodes)
+        {
+            if (node.op != FusedOp::Input)
+                node.kernel = selectKernel(expression.nodes, node);
+        }
+        return std::move(expression);
+    }
+
+private:
+    size_t addNode(FusedOp op, TypeIndex type, bool nullable, std::vector<size_t> args)
+    {
+        FusedNode node;
+        node.op = op;
+        node.type = type;
+        node.nullable = nullable;
+        node.args = std::move(args);
+        expression.nodes.push_back(std::move(node));
+        return expression.nodes.size() - 1;
+    }
+
+    size_t castTo(size_t pos, TypeIndex type)
+    {
+        const auto & node = expression.nodes[pos];
+        if (node.type == type)
+            return pos;
+        return addNode(FusedOp::Cast, type, node.nullable, {pos});
+    }
+
+    size_t toBool(size_t pos)
+    {
+        const auto & node = expression.nodes[pos];
+        if (node.type == TypeIndex::UInt8)
+            return pos;
+        return addNode(FusedOp::ToBool, TypeIndex::UInt8, node.nullable, {pos});
+    }
+
+    size_t compileNode(const FusedTreePtr & tree)
+    {
+        if (tree->op == FusedOp::Input)
+        {
+            const size_t input = input_positions.at(tree->input_name);
+            if (auto it = input_nodes.find(input); it != input_nodes.end())
+                return it->second;
+            size_t pos = addNode(FusedOp::Input, tree->type, tree->nullable, {});
+            expression.nodes[pos].input = input;
+            input_nodes.emplace(input, pos);
+            return pos;
+        }
+
+        std::vector<size_t> args;
+        for (const auto & child : tree->children)
+            args.push_back(compileNode(child));
+
+        switch (tree->op)
+        {
+        case FusedOp::And:
+        case FusedOp::Or:
+            for (auto & arg : args)
+                arg = toBool(arg);
+            break;
+        case FusedOp::If:
+            args[1] = castTo(args[1], tree->type);
+            args[2] = castTo(args[2], tree->type);
+            break;
+        case FusedOp::Not:
+        case FusedOp::IsNull:
+            break;
+        default:
+        {
+            /// Both operands are converted to the result type, like `static_cast<Result>(a) + b` in the arithmetic functions.
+            const auto & lhs = expression.nodes[args[0]];
+            const auto & rhs = expression.nodes[args[1]];
+            TypeIndex operand_type = isComparison(tree->op) ? *getComparisonType(lhs.type, rhs.type) : tree->type;
+            args[0] = castTo(args[0], operand_type);
+            args[1] = castTo(args[1], operand_type);
+        }
+        }
+        return addNode(tree->op, tree->type, tree->nullable, std::move(args));
+    }
+
+    const std::unordered_map<String, size_t> & input_positions;
+    std::unordered_map<size_t, size_t> input_nodes;
+    CompiledExpression expression;
+};
+
+void replaceWithFused(ExpressionAction & action, const FusedTreePtr & tree)
+{
+    String key;
+    Names input_names;
+    DataTypes input_types;
+    std::unordered_map<String, size_t> input_positions;
+    serializeTree(tree, key, input_names, input_types, input_positions);
+
+    auto [expression, compiled] = getCompiledExpressionCache().getOrSet(key, [&] {
+        return std::make_shared<CompiledExpression>(ExpressionCompiler(input_positions).compile(tree));
+    });
+    ProfileEvents::increment(compiled ? ProfileEvents::CompiledExpressionCacheMisses : ProfileEvents::CompiledExpressionCacheHits);
+
+    action.function_builder = nullptr;
+    action.function = std::make_shared<FunctionFused>(expression, input_types, action.result_type);
+    action.argument_names = std::move(input_names);
+    action.collator = nullptr;
+}
+} // namespace
+
+void fuseExpressionActions(ExpressionActions::Actions & actions, const NameSet & final_columns, Block & sample_block)
+{
+    std::unordered_map<String, size_t> uses;
+    for (const auto & name : final_columns)
+        ++uses[name];
+    for (const auto & action : actions)
+    {
+        for (const auto & name : action.getNeededColumns())
+            ++uses[name];
+    }
+
+    struct Pending
+    {
+        size_t index;
+        FusedTreePtr tree;
+        bool has_fused;
+    };
+    /// The fusible actions whose results are only used once, they are fused into the consumers if possible.
+    std::unordered_map<String, Pending> pending;
+    std::vector<bool> fused_away(actions.size(), false);
+
+    for (size_t i = 0; i < actions.size(); ++i)
+    {
+        auto & action = actions[i];
+        auto op = getFusedOp(action);
+        if (!op)
+            continue;
+
+        bool has_fused = false;
+        const auto & argument_types = action.function->getArgumentTypes();
+        std::vector<FusedTreePtr> children;
+        for (size_t j = 0; j < action.argument_names.size(); ++j)
+        {
+            if (auto it = pending.find(action.argument_names[j]); it != pending.end())
+            {
+                children.push_back(it->second.tree);
+                fused_away[it->second.index] = true;
+                pending.erase(it);
+                has_fused = true;
+            }
+            else
+            {
+                auto child = makeTree(FusedOp::Input, removeNullable(argument_types[j])->getTypeId(), argument_types[j]->isNullable(), {});
+                child->input_name = action.argument_names[j];
+                child->input_type = argument_types[j];
+                children.push_back(std::move(child));
+            }
+        }
+        auto tree = buildTree(*op, action, std::move(children));
+
+        if (uses[action.result_name] == 1 && !final_columns.count(action.result_name))
+            pending.emplace(action.result_name, Pending{i, tree, has_fused});
+        else if (has_fused || *op == FusedOp::If)
+            replaceWithFused(action, tree);
+    }
+    /// The consumers of these actions are not fusible.
+    for (const auto & [name, p] : pending)
+    {
+        if (p.has_fused || p.tree->op == FusedOp::If)
+            replaceWithFused(actions[p.index], p.tree);
+    }
+
+    ExpressionActions::Actions new_actions;
+    new_actions.reserve(actions.size());
+    for (size_t i = 0; i < actions.size(); ++i)
+    {
+        if (!fused_away[i])
+            new_actions.push_back(std::move(actions[i]));
+        else if (sample_block.has(actions[i].result_name))
+            sample_block.erase(actions[i].result_name);
+    }
+    actions.swap(new_actions);
+}
+
+} // namespace DB
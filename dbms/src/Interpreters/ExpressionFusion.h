@@ -0,0 +1,36 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <Interpreters/ExpressionActions.h>
+
+namespace DB
+{
+/** Fuse the chains of arithmetic (plus, minus, multiply), comparison, logical (and, or, not) and conditional
+  * (multiIf, isNull) functions over native numbers, like `price * (1 - discount) * (1 + tax) > 100 and tax < 0.05`,
+  * into one function.
+  *
+  * The fused expression is compiled into a program of loops specialized for the operations and types of every node,
+  * so no type dispatching is needed on execution. The programs are cached by the structure of expressions.
+  * It evaluates the whole chain over small chunks of rows, so the intermediate results stay in the CPU cache instead
+  * of being materialized as full-sized columns and read back by the next function. The results, including the null
+  * maps, are the same as evaluating the functions one by one.
+  *
+  * An action is fused into its consumer only if its result is used by nothing else, so the intermediate
+  * columns are not needed anymore. The other actions are still executed by their functions.
+  * It must be called before the REMOVE_COLUMN actions are inserted.
+  */
+void fuseExpressionActions(ExpressionActions::Actions & actions, const NameSet & final_columns, Block & sample_block);
+
+} // namespace DB
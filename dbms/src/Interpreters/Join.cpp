@@ -118,7 +118,9 @@ Join::Join(
     const String & other_eq_filter_from_in_column_,
     ExpressionActionsPtr other_condition_ptr_,
     size_t max_block_size_,
-    const String & match_helper_name)
+    const String & match_helper_name,
+    size_t prefetch_distance_,
+    size_t prefetch_min_bytes_)
     : match_helper_name(match_helper_name)
     , kind(kind_)
     , strictness(strictness_)
@@ -135,6 +137,8 @@ Join::Join(
     , other_condition_ptr(other_condition_ptr_)
     , original_strictness(strictness)
     , max_block_size_for_cross_join(max_block_size_)
+    , prefetch_distance(prefetch_distance_)
+    , prefetch_min_bytes(prefetch_min_bytes_)
     , build_table_state(BuildTableState::SUCCEED)
     , log(Logger::get("Join", req_id))
     , limits(limits)
@@ -1058,7 +1062,9 @@ void NO_INLINE joinBlockImplTypeCase(
     IColumn::Offset & current_offset,
     std::unique_ptr<IColumn::Offsets> & offsets_to_replicate,
     const std::vector<size_t> & right_indexes,
-    const TiDB::TiDBCollators & collators)
+    const TiDB::TiDBCollators & collators,
+    size_t probe_prefetch_distance,
+    size_t probe_prefetch_min_bytes)
 {
     size_t num_columns_to_add = right_indexes.size();
 
@@ -1067,8 +1073,43 @@ void NO_INLINE joinBlockImplTypeCase(
     sort_key_containers.resize(key_columns.size());
     Arena pool;
 
+    auto get_segment_index = [&](size_t hash_value) {
+        return map.getSegmentSize() > 0 ? hash_value % map.getSegmentSize() : 0;
+    };
+
+    size_t prefetch_distance = 0;
+    if constexpr (ColumnsHashing::columns_hashing_impl::canLookupInTwoPasses<KeyGetter, typename Map::SegmentType::HashTable>())
+        prefetch_distance = ColumnsHashing::columns_hashing_impl::getPrefetchDistance(map.getBufferSizeInBytes(), rows, probe_prefetch_distance, probe_prefetch_min_bytes);
+
+    /// For a large hash table, compute the hash values of all rows first, so that the cells of the rows
+    /// `prefetch_distance` ahead can be prefetched while probing. The hash value of null and zero keys is 0.
+    PaddedPODArray<size_t> hashes;
+    if (prefetch_distance > 0)
+    {
+        hashes.resize_fill(rows, 0);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            if (has_null_map && (*null_map)[i])
+                continue;
+            auto key_holder = key_getter.getKeyHolder(i, &pool, sort_key_containers);
+            auto key = keyHolderGetKey(key_holder);
+            if (!ZeroTraits::check(key))
+                hashes[i] = map.hash(key);
+            keyHolderDiscardKey(key_holder);
+        }
+    }
+
     for (size_t i = 0; i < rows; ++i)
     {
+        if constexpr (ColumnsHashing::columns_hashing_impl::canLookupInTwoPasses<KeyGetter, typename Map::SegmentType::HashTable>())
+        {
+            if (prefetch_distance > 0 && i + prefetch_distance < rows)
+            {
+                size_t hash_value = hashes[i + prefetch_distance];
+                map.getSegmentTable(get_segment_index(hash_value)).prefetch(hash_value);
+            }
+        }
+
         if (has_null_map && (*null_map)[i])
         {
             Adder<KIND, STRICTNESS, Map>::addNotFound(
@@ -1085,14 +1126,19 @@ void NO_INLINE joinBlockImplTypeCase(
             auto key = keyHolderGetKey(key_holder);
             size_t segment_index = 0;
             size_t hash_value = 0;
-            if (map.getSegmentSize() > 0 && !ZeroTraits::check(key))
+            if (prefetch_distance > 0)
+            {
+                hash_value = hashes[i];
+                segment_index = get_segment_index(hash_value);
+            }
+            else if (map.getSegmentSize() > 0 && !ZeroTraits::check(key))
             {
                 hash_value = map.hash(key);
                 segment_index = hash_value % map.getSegmentSize();
             }
             auto & internal_map = map.getSegmentTable(segment_index);
             /// do not require segment lock because in join, the hash table can not be changed in probe stage.
-            auto it = map.getSegmentSize() > 0 ? internal_map.find(key, hash_value) : internal_map.find(key);
+            auto it = map.getSegmentSize() > 0 || prefetch_distance > 0 ? internal_map.find(key, hash_value) : internal_map.find(key);
 
             if (it != internal_map.end())
             {
@@ -1132,7 +1178,9 @@ void joinBlockImplType(
     IColumn::Offset & current_offset,
     std::unique_ptr<IColumn::Offsets> & offsets_to_replicate,
     const std::vector<size_t> & right_indexes,
-    const TiDB::TiDBCollators & collators)
+    const TiDB::TiDBCollators & collators,
+    size_t probe_prefetch_distance,
+    size_t probe_prefetch_min_bytes)
 {
     if (null_map)
         joinBlockImplTypeCase<KIND, STRICTNESS, KeyGetter, Map, true>(
@@ -1146,7 +1194,9 @@ void joinBlockImplType(
             current_offset,
             offsets_to_replicate,
             right_indexes,
-            collators);
+            collators,
+            probe_prefetch_distance,
+            probe_prefetch_min_bytes);
     else
         joinBlockImplTypeCase<KIND, STRICTNESS, KeyGetter, Map, false>(
             map,
@@ -1159,7 +1209,9 @@ void joinBlockImplType(
             current_offset,
             offsets_to_replicate,
             right_indexes,
-            collators);
+            collators,
+            probe_prefetch_distance,
+            probe_prefetch_min_bytes);
 }
 } // namespace
 
@@ -1505,7 +1557,9 @@ void Join::joinBlockImpl(Block & block, const Maps & maps) const
             current_offset,                                                                                                                    \
             offsets_to_replicate,                                                                                                              \
             right_indexes,                                                                                                                     \
-            collators);                                                                                                                        \
+            collators,                                                                                                                         \
+            prefetch_distance,                                                                                                                 \
+            prefetch_min_bytes);                                                                                                               \
         break;
         APPLY_FOR_JOIN_VARIANTS(M)
 #undef M
@@ -18,6 +18,7 @@
 #include <Columns/ColumnNullable.h>
 #include <Columns/ColumnString.h>
 #include <Common/Arena.h>
+#include <Common/ColumnsHashingImpl.h>
 #include <Common/HashTable/HashMap.h>
 #include <Common/Logger.h>
 #include <DataStreams/IBlockInputStream.h>
@@ -106,7 +107,9 @@ public:
          const String & other_eq_filter_from_in_column = "",
          ExpressionActionsPtr other_condition_ptr = nullptr,
          size_t max_block_size = 0,
-         const String & match_helper_name = "");
+         const String & match_helper_name = "",
+         size_t prefetch_distance = 0,
+         size_t prefetch_min_bytes = ColumnsHashing::columns_hashing_impl::prefetch_min_hash_table_bytes);
 
     /** Call `setBuildConcurrencyAndInitPool`, `initMapImpl` and `setSampleBlock`.
       * You must call this method before subsequent calls to insertFromBlock.
@@ -294,6 +297,10 @@ private:
     ExpressionActionsPtr other_condition_ptr;
     ASTTableJoin::Strictness original_strictness;
     size_t max_block_size_for_cross_join;
+    /// How many rows ahead to prefetch the cells of a large hash table when probing, 0 - disabled.
+    size_t prefetch_distance;
+    /// The hash tables smaller than this are probed row by row without prefetching.
+    size_t prefetch_min_bytes;
     /** Blocks of "right" table.
       */
     BlocksList blocks;
@@ -44,6 +44,15 @@ extern const int NUMBER_OF_COLUMNS_DOESNT_MATCH;
 extern const int COP_BAD_DAG_REQUEST;
 } // namespace ErrorCodes
 
+namespace
+{
+/// The hash table of a smaller set fits in the cache, checking a bloom filter before looking up it doesn't help.
+constexpr size_t bloom_filter_min_rows = 65536;
+/// The bloom filter is checked for some rows at least before deciding whether it is worth it.
+constexpr size_t bloom_filter_min_probes = 65536;
+/// The rows are hashed and checked with the bloom filter batch by batch.
+constexpr size_t bloom_filter_batch_size = 256;
+} // namespace
 
 template <typename Method>
 void NO_INLINE Set::insertFromBlockImpl(
@@ -165,6 +174,13 @@ bool Set::insertFromBlock(const Block & block, bool fill_set_elements)
 #undef M
     }
 
+    {
+        /// The bloom filter is rebuilt with the new keys.
+        std::lock_guard bloom_filter_lock(bloom_filter_mutex);
+        bloom_filter_built = false;
+        bloom_filter.reset();
+    }
+
     if (fill_set_elements)
     {
         for (size_t i = 0; i < rows; ++i)
@@ -363,7 +379,8 @@ ColumnPtr Set::execute(const Block & block, bool negative) const
     ConstNullMapPtr null_map{};
     extractNestedColumnsAndNullMap(key_columns, null_map_holder, null_map);
 
-    executeOrdinary(key_columns, vec_res, negative, null_map);
+    auto filter = getBloomFilter();
+    executeOrdinary(key_columns, vec_res, negative, null_map, filter.get());
 
     return res;
 }
@@ -376,9 +393,17 @@ void NO_INLINE Set::executeImpl(
     ColumnUInt8::Container & vec_res,
     bool negative,
     size_t rows,
-    ConstNullMapPtr null_map) const
+    ConstNullMapPtr null_map,
+    const BlockedBloomFilter * bloom_filter) const
 {
-    if (null_map)
+    if (bloom_filter)
+    {
+        if (null_map)
+            executeImplCaseWithBloomFilter<Method, true>(method, key_columns, vec_res, negative, rows, null_map, *bloom_filter);
+        else
+            executeImplCaseWithBloomFilter<Method, false>(method, key_columns, vec_res, negative, rows, null_map, *bloom_filter);
+    }
+    else if (null_map)
         executeImplCase<Method, true>(method, key_columns, vec_res, negative, rows, null_map);
     else
         executeImplCase<Method, false>(method, key_columns, vec_res, negative, rows, null_map);
@@ -415,11 +440,62 @@ void NO_INLINE Set::executeImplCase(
 }
 
 
+/// The rows are probed batch by batch: the hash values of a batch are computed and checked with the bloom filter first,
+/// then only the rows passing the bloom filter look up the hash table, with the hash values computed already.
+template <typename Method, bool has_null_map>
+void NO_INLINE Set::executeImplCaseWithBloomFilter(
+    Method & method,
+    const ColumnRawPtrs & key_columns,
+    ColumnUInt8::Container & vec_res,
+    bool negative,
+    size_t rows,
+    ConstNullMapPtr null_map,
+    const BlockedBloomFilter & bloom_filter) const
+{
+    Arena pool;
+    typename Method::State state(key_columns, key_sizes, collators);
+    std::vector<String> sort_key_containers;
+    sort_key_containers.resize(key_columns.size(), "");
+
+    size_t hashes[bloom_filter_batch_size];
+    UInt8 may_contain[bloom_filter_batch_size];
+    size_t misses = 0;
+
+    for (size_t begin = 0; begin < rows; begin += bloom_filter_batch_size)
+    {
+        size_t end = std::min(rows, begin + bloom_filter_batch_size);
+        for (size_t i = begin; i < end; ++i)
+            hashes[i - begin] = state.getHash(method.data, i, pool, sort_key_containers);
+        bloom_filter.mayContain(hashes, end - begin, may_contain);
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (has_null_map && (*null_map)[i])
+                vec_res[i] = negative;
+            else if (!may_contain[i - begin])
+            {
+                vec_res[i] = negative;
+                ++misses;
+            }
+            else
+            {
+                auto key_holder = state.getKeyHolder(i, &pool, sort_key_containers);
+                vec_res[i] = negative ^ (method.data.find(keyHolderGetKey(key_holder), hashes[i - begin]) != nullptr);
+            }
+        }
+    }
+
+    bloom_filter_probes.fetch_add(rows, std::memory_order_relaxed);
+    bloom_filter_misses.fetch_add(misses, std::memory_order_relaxed);
+}
+
+
 void Set::executeOrdinary(
     const ColumnRawPtrs & key_columns,
     ColumnUInt8::Container & vec_res,
     bool negative,
-    ConstNullMapPtr null_map) const
+    ConstNullMapPtr null_map,
+    const BlockedBloomFilter * bloom_filter) const
 {
     size_t rows = key_columns[0]->size();
 
@@ -427,9 +503,9 @@ void Set::executeOrdinary(
     {
     case SetVariants::Type::EMPTY:
         break;
-#define M(NAME)                                                                  \
-    case SetVariants::Type::NAME:                                                \
-        executeImpl(*data.NAME, key_columns, vec_res, negative, rows, null_map); \
+#define M(NAME)                                                                                \
+    case SetVariants::Type::NAME:                                                              \
+        executeImpl(*data.NAME, key_columns, vec_res, negative, rows, null_map, bloom_filter); \
         break;
         APPLY_FOR_SET_VARIANTS(M)
 #undef M
@@ -437,4 +513,50 @@ void Set::executeOrdinary(
 }
 
 
+std::shared_ptr<const BlockedBloomFilter> Set::getBloomFilter() const
+{
+    /// Most rows are in the set, checking the bloom filter only costs more.
+    size_t probes = bloom_filter_probes.load(std::memory_order_relaxed);
+    if (probes >= bloom_filter_min_probes && bloom_filter_misses.load(std::memory_order_relaxed) * 8 < probes)
+        return nullptr;
+
+    std::lock_guard lock(bloom_filter_mutex);
+    if (!bloom_filter_built)
+    {
+        bloom_filter_built = true;
+        if (getTotalRowCount() >= bloom_filter_min_rows)
+        {
+            switch (data.type)
+            {
+            case SetVariants::Type::EMPTY:
+                break;
+#define M(NAME)                                           \
+    case SetVariants::Type::NAME:                         \
+        bloom_filter = buildBloomFilterImpl(*data.NAME); \
+        break;
+                APPLY_FOR_SET_VARIANTS(M)
+#undef M
+            }
+            if (bloom_filter)
+                LOG_FMT_DEBUG(log, "Built bloom filter of {} bytes for {} rows", bloom_filter->getBytes(), getTotalRowCount());
+        }
+    }
+    return bloom_filter;
+}
+
+
+template <typename Method>
+std::shared_ptr<const BlockedBloomFilter> Set::buildBloomFilterImpl(const Method & method) const
+{
+    /// The hash tables of 8 and 16 bits keys are small enough.
+    if constexpr (sizeof(typename Method::Key) <= sizeof(UInt16))
+        return nullptr;
+
+    auto filter = std::make_shared<BlockedBloomFilter>(method.data.size());
+    for (const auto & cell : method.data)
+        filter->add(method.data.hash(cell.getKey()));
+    return filter;
+}
+
+
 } // namespace DB
@@ -19,6 +19,7 @@
 #include <tipb/expression.pb.h>
 #pragma GCC diagnostic pop
 
+#include <Common/BlockedBloomFilter.h>
 #include <Core/Block.h>
 #include <DataStreams/SizeLimits.h>
 #include <DataTypes/IDataType.h>
@@ -28,6 +29,7 @@
 #include <Storages/Transaction/Collator.h>
 #include <common/logger_useful.h>
 
+#include <mutex>
 #include <shared_mutex>
 
 
@@ -134,7 +136,8 @@ private:
         const ColumnRawPtrs & key_columns,
         ColumnUInt8::Container & vec_res,
         bool negative,
-        const PaddedPODArray<UInt8> * null_map) const;
+        const PaddedPODArray<UInt8> * null_map,
+        const BlockedBloomFilter * bloom_filter) const;
 
     /// Vector of elements of `Set`.
     /// It is necessary for the index to work on the primary key in the IN statement.
@@ -149,6 +152,21 @@ private:
 
     TiDB::TiDBCollators collators;
 
+    /** The bloom filter of the hash values of a large set, which is checked before looking up the hash table,
+      *  so that the rows not in the set don't need to access the hash table that is much larger than the cache.
+      * It is built at the first `execute` after the insertions, and is not used any more if it filters out only a few rows.
+      */
+    mutable std::mutex bloom_filter_mutex;
+    mutable bool bloom_filter_built = false;
+    mutable std::shared_ptr<const BlockedBloomFilter> bloom_filter;
+    mutable std::atomic<size_t> bloom_filter_probes{0};
+    mutable std::atomic<size_t> bloom_filter_misses{0};
+
+    std::shared_ptr<const BlockedBloomFilter> getBloomFilter() const;
+
+    template <typename Method>
+    std::shared_ptr<const BlockedBloomFilter> buildBloomFilterImpl(const Method & method) const;
+
     template <typename Method>
     void insertFromBlockImpl(
         Method & method,
@@ -172,7 +190,8 @@ private:
         ColumnUInt8::Container & vec_res,
         bool negative,
         size_t rows,
-        ConstNullMapPtr null_map) const;
+        ConstNullMapPtr null_map,
+        const BlockedBloomFilter * bloom_filter) const;
 
     template <typename Method, bool has_null_map>
     void executeImplCase(
@@ -182,6 +201,16 @@ private:
         bool negative,
         size_t rows,
         ConstNullMapPtr null_map) const;
+
+    template <typename Method, bool has_null_map>
+    void executeImplCaseWithBloomFilter(
+        Method & method,
+        const ColumnRawPtrs & key_columns,
+        ColumnUInt8::Container & vec_res,
+        bool negative,
+        size_t rows,
+        ConstNullMapPtr null_map,
+        const BlockedBloomFilter & bloom_filter) const;
 };
 
 using SetPtr = std::shared_ptr<Set>;
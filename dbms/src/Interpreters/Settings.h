@@ -66,6 +66,7 @@ struct Settings
     M(SettingMaxThreads, max_threads, 0, "The maximum number of threads to execute the request. By default, it is determined automatically.")                                                                                           \
     M(SettingUInt64, cop_pool_size, 0, "The number of threads to handle cop requests. By default, it is determined automatically.")                                                                                                     \
     M(SettingUInt64, batch_cop_pool_size, 0, "The number of threads to handle batch cop requests. By default, it is determined automatically.")                                                                                         \
+    M(SettingBool, enable_batch_cop_parallel_encode, false, "Encode and write the results of a batch cop request by every stream in parallel, every response carries its own execution summaries.")                                     \
     M(SettingUInt64, max_read_buffer_size, DBMS_DEFAULT_BUFFER_SIZE, "The maximum size of the buffer to read from the filesystem.")                                                                                                     \
     M(SettingUInt64, max_distributed_connections, DEFAULT_MAX_DISTRIBUTED_CONNECTIONS, "The maximum number of connections for distributed processing of one query (should be greater than max_threads).")                               \
     M(SettingUInt64, max_query_size, DEFAULT_MAX_QUERY_SIZE, "Which part of the query can be read into RAM for parsing (the remaining data for INSERT, if any, is read later)")                                                         \
@@ -93,6 +94,7 @@ struct Settings
                                                                                                                                                                                                                                         \
     M(SettingBool, compile, false, "Whether query compilation is enabled.")                                                                                                                                                             \
     M(SettingUInt64, min_count_to_compile, 3, "The number of structurally identical queries before they are compiled.")                                                                                                                 \
+    M(SettingBool, enable_expression_fusion, false, "Compile the chains of arithmetic, comparison, logical and conditional functions over numbers, and evaluate them in one pass over small chunks of rows.")                           \
     M(SettingUInt64, group_by_two_level_threshold, 100000, "From what number of keys, a two-level aggregation starts. 0 - the threshold is not set.")                                                                                   \
     M(SettingUInt64, group_by_two_level_threshold_bytes, 100000000, "From what size of the aggregation state in bytes, a two-level aggregation begins to be used. 0 - the threshold is not set. "                                       \
                                                                     "Two-level aggregation is used when at least one of the thresholds is triggered.")                                                                                  \
@@ -225,6 +227,9 @@ struct Settings
     M(SettingUInt64, max_bytes_to_sort, 0, "")                                                                                                                                                                                          \
     M(SettingOverflowMode<false>, sort_overflow_mode, OverflowMode::THROW, "What to do when the limit is exceeded.")                                                                                                                    \
     M(SettingUInt64, max_bytes_before_external_sort, 0, "")                                                                                                                                                                             \
+    M(SettingBool, enable_parallel_merge_sort, false, "Sort several streams for window functions in parallel by ranges of sampled splitters, spilling with max_bytes_before_external_sort.")                                            \
+    M(SettingCompressionMethod, external_sort_compression_method, CompressionMethod::LZ4, "The method of data compression of the temporary files of parallel merge sort.")                                                              \
+    M(SettingInt64, external_sort_compression_level, 1, "The compression level of the temporary files of parallel merge sort.")                                                                                                         \
                                                                                                                                                                                                                                         \
     M(SettingUInt64, max_result_rows, 0, "Limit on result size in rows. Also checked for intermediate data sent from remote servers.")                                                                                                  \
     M(SettingUInt64, max_result_bytes, 0, "Limit on result size in bytes (uncompressed). Also checked for intermediate data sent from remote servers.")                                                                                 \
@@ -277,8 +282,13 @@ struct Settings
     M(SettingFloat, dt_bg_gc_ratio_threhold_to_trigger_gc, 1.2, "Trigger segment's gc when the ratio of invalid version exceed this threhold. Values smaller than or equal to 1.0 means gc all "                                        \
                                                                 "segments")                                                                                                                                                             \
     M(SettingFloat, dt_bg_gc_delta_delete_ratio_to_trigger_gc, 0.3, "Trigger segment's gc when the ratio of delta delete range to stable exceeds this ratio.")                                                                          \
+    M(SettingUInt64, dt_bg_merge_delta_max_concurrency, 0, "Max number of running background merge delta tasks of all tables. 0 means no limit.")                                                                                       \
+    M(SettingUInt64, dt_bg_split_max_concurrency, 0, "Max number of running background split tasks of all tables. 0 means no limit.")                                                                                                   \
+    M(SettingUInt64, dt_bg_merge_max_concurrency, 0, "Max number of running background segment merge tasks of all tables. 0 means no limit.")                                                                                           \
+    M(SettingUInt64, dt_bg_task_io_budget_seconds, 10, "The running heavy background tasks should finish writing in this many seconds under the background write rate limit. 0 means no limit.")                                        \
     M(SettingUInt64, dt_insert_max_rows, 0, "Max rows of insert blocks when write into DeltaTree Engine. By default 0 means no limit.")                                                                                                 \
     M(SettingBool, dt_enable_rough_set_filter, true, "Whether to parse where expression as Rough Set Index filter or not.")                                                                                                             \
+    M(SettingBool, dt_enable_topn_threshold_pushdown, true, "Skip the stable packs which can not enter the result of the TopN on an integer column right above the table scan.")                                                        \
     M(SettingBool, dt_raw_filter_range, true, "Do range filter or not when read data in raw mode in DeltaTree Engine.")                                                                                                                 \
     M(SettingBool, dt_read_delta_only, false, "Only read delta data in DeltaTree Engine.")                                                                                                                                              \
     M(SettingBool, dt_read_stable_only, false, "Only read stable data in DeltaTree Engine.")                                                                                                                                            \
@@ -286,6 +296,11 @@ struct Settings
     M(SettingBool, dt_flush_after_write, false, "Flush cache or not after write in DeltaTree Engine.")                                                                                                                                  \
     M(SettingBool, dt_enable_relevant_place, false, "Enable relevant place or not in DeltaTree Engine.")                                                                                                                                \
     M(SettingBool, dt_enable_skippable_place, true, "Enable skippable place or not in DeltaTree Engine.")                                                                                                                               \
+    M(SettingBool, dt_enable_sorted_mem_table_read, false, "Merge the rows in memory of delta by their sorted index instead of placing them into the delta index when reading in DeltaTree Engine.")                                    \
+    M(SettingFloat, dt_partial_merge_delta_max_ratio, 0.5, "Only rewrite the stable packs overlapping delta in merge delta if they are less than this ratio of stable rows. "                                                           \
+                                                           "0 means always rewriting the whole stable. Only works with storage format_version >= 5.")                                                                                   \
+    M(SettingUInt64, dt_partial_merge_delta_max_stable_files, 8, "Always rewrite the whole stable in merge delta if it contains this many DMFiles.")                                                                                    \
+    M(SettingUInt64, dt_direct_read_prefetch_max_bytes, 134217728, "Max memory of prefetching for a query when reading DMFiles with direct I/O, see min_bytes_to_use_direct_io. 0 means no prefetching.")                               \
     M(SettingBool, dt_enable_stable_column_cache, true, "Enable column cache for StorageDeltaMerge.")                                                                                                                                   \
     M(SettingBool, dt_enable_single_file_mode_dmfile, false, "Enable write DMFile in single file mode.")                                                                                                                                \
     M(SettingUInt64, dt_open_file_max_idle_seconds, 15, "Max idle time of opening files, 0 means infinite.")                                                                                                                            \
@@ -319,8 +334,10 @@ struct Settings
     M(SettingDouble, dt_storage_blob_block_alignment_bytes, 0, "Blob IO alignment size")                                                                                                                                                \
                                                                                                                                                                                                                                         \
     M(SettingChecksumAlgorithm, dt_checksum_algorithm, ChecksumAlgo::XXH3, "Checksum algorithm for delta tree stable storage")                                                                                                          \
-    M(SettingCompressionMethod, dt_compression_method, CompressionMethod::LZ4, "The method of data compression when writing.")                                                                                                          \
+    M(SettingCompressionMethod, dt_compression_method, CompressionMethod::LZ4, "The method of data compression when writing. 'lightweight' chooses FOR/delta/RLE/Gorilla or LZ4 per block for numeric columns.")                        \
     M(SettingInt64, dt_compression_level, 1, "The compression level.")                                                                                                                                                                  \
+    M(SettingUInt64, dt_dmfile_write_threads, 4, "The max threads to compress and write the column streams of a DTFile in parallel. 1 means writing on the calling thread.")                                                            \
+    M(SettingBool, dt_enable_segment_result_cache, false, "Aggregate every segment separately and cache the partial results of unchanged segments for the repeated aggregations.")                                                      \
     M(SettingUInt64, max_rows_in_set, 0, "Maximum size of the set (in number of elements) resulting from the execution of the IN section.")                                                                                             \
     M(SettingUInt64, max_bytes_in_set, 0, "Maximum size of the set (in bytes in memory) resulting from the execution of the IN section.")                                                                                               \
     M(SettingOverflowMode<false>, set_overflow_mode, OverflowMode::THROW, "What to do when the limit is exceeded.")                                                                                                                     \
@@ -338,6 +355,8 @@ struct Settings
     M(SettingOverflowMode<false>, distinct_overflow_mode, OverflowMode::THROW, "What to do when the limit is exceeded.")                                                                                                                \
                                                                                                                                                                                                                                         \
     M(SettingBool, join_concurrent_build, true, "Build hash table concurrently for join.")                                                                                                                                              \
+    M(SettingUInt64, hash_table_prefetch_distance, 16, "How many rows ahead to prefetch the cells of the hash tables larger than the CPU cache in aggregation and join probe. 0 - prefetching is disabled.")                            \
+    M(SettingUInt64, hash_table_prefetch_min_bytes, 2097152, "The hash tables smaller than this are looked up without prefetching, since they mostly stay in the CPU cache.")                                                           \
     M(SettingUInt64, max_memory_usage, 0, "Maximum memory usage for processing of single query. Zero means unlimited.")                                                                                                                 \
     M(SettingUInt64, max_memory_usage_for_user, 0, "Maximum memory usage for processing all concurrently running queries for the user. Zero means unlimited.")                                                                          \
     M(SettingUInt64, max_memory_usage_for_all_queries, 0, "Maximum memory usage for processing all concurrently running queries on the server. Zero means unlimited.")                                                                  \
@@ -350,11 +369,19 @@ struct Settings
                                                              "unlimited.")                                                                                                                                                              \
     M(SettingUInt64, task_scheduler_thread_soft_limit, 5000, "The soft limit of threads for min_tso task scheduler.")                                                                                                                   \
     M(SettingUInt64, task_scheduler_thread_hard_limit, 10000, "The hard limit of threads for min_tso task scheduler.")                                                                                                                  \
+    M(SettingUInt64, task_scheduler_memory_limit, 0, "The limit of memory reserved by the queries admitted by min_tso task scheduler, except the min_tso query. 0 means no limit.")                                                     \
+    M(SettingUInt64, task_scheduler_memory_hint_per_thread, 16 * Constant::MB, "The estimated memory usage per thread of each join, aggregation or sort in a MPP task, used to reserve memory in min_tso task scheduler.")              \
+    M(SettingInt64, mpp_task_scheduling_priority, 0, "The priority of a MPP query waiting in min_tso task scheduler, queries with higher priority are scheduled first.")                                                                \
     M(SettingUInt64, max_grpc_pollers, 200, "The maximum number of grpc thread pool's non-temporary threads, better tune it up to avoid frequent creation/destruction of threads.")                                                     \
     M(SettingBool, enable_elastic_threadpool, true, "Enable elastic thread pool for thread create usages.")                                                                                                                             \
     M(SettingUInt64, elastic_threadpool_init_cap, 400, "The size of elastic thread pool.")                                                                                                                                              \
     M(SettingUInt64, elastic_threadpool_shrink_period_ms, 300000, "The shrink period(ms) of elastic thread pool.")                                                                                                                      \
     M(SettingBool, enable_local_tunnel, true, "Enable local data transfer between local MPP tasks.")                                                                                                                                    \
+    M(SettingBool, enable_local_tunnel_zero_copy, true, "Pass blocks through local MPP tunnels without encoding and decoding them, only takes effect when enable_local_tunnel is on.")                                                  \
+    M(SettingUInt64, max_mpp_tunnel_queue_bytes, 128 * Constant::MB, "Max bytes of data queueing in the send queue of a MPP tunnel. 0 means no limit.")                                                                                 \
+    M(SettingUInt64, max_exchange_receiver_queue_bytes, 256 * Constant::MB, "Max bytes of data queueing in an exchange receiver. 0 means no limit.")                                                                                    \
+    M(SettingUInt64, exchange_receiver_decode_concurrency, 0, "The number of threads an exchange receiver uses to decode received packets and merge small blocks. 0 means packets are decoded by the threads consuming them.")          \
+    M(SettingBool, enable_exchange_dictionary_encoding, false, "Encode low cardinality string columns as dictionaries in the data exchanged among TiFlash nodes. All the nodes must support it.")                                       \
     M(SettingBool, enable_async_grpc_client, true, "Enable async grpc in MPP.")                                                                                                                                                                \
     M(SettingUInt64, grpc_completion_queue_pool_size, 0, "The size of gRPC completion queue pool. 0 means using hardware_concurrency.")\
     M(SettingBool, enable_async_server, true, "Enable async rpc server.")                                                                                                                                                               \
@@ -15,6 +15,7 @@
 #include <Columns/ColumnNullable.h>
 #include <Columns/ColumnString.h>
 #include <Common/typeid_cast.h>
+#include <Core/NormalizedSortKeys.h>
 #include <Interpreters/sortBlock.h>
 
 
@@ -114,13 +115,69 @@ struct PartialSortingLessWithCollation
 };
 
 
+/// Sort the rows by their normalized keys, the first 8 bytes of every key are cached as a big-endian integer,
+/// so that most of the comparisons need neither memcmp nor an access to the keys.
+static void getPermutationByNormalizedKeys(const NormalizedSortKeys & keys, size_t limit, IColumn::Permutation & perm)
+{
+    struct Entry
+    {
+        UInt64 prefix;
+        size_t row;
+    };
+
+    size_t size = keys.size();
+    std::vector<Entry> entries(size);
+    for (size_t row = 0; row < size; ++row)
+    {
+        StringRef key = keys.at(row);
+        UInt8 prefix[sizeof(UInt64)] = {};
+        memcpy(prefix, key.data, std::min(key.size, sizeof(UInt64)));
+        UInt64 value = 0;
+        for (auto byte : prefix)
+            value = (value << 8) | byte;
+        entries[row] = Entry{value, row};
+    }
+
+    auto less = [&keys](const Entry & lhs, const Entry & rhs) {
+        if (lhs.prefix != rhs.prefix)
+            return lhs.prefix < rhs.prefix;
+        return compareNormalizedSortKeys(keys.at(lhs.row), keys.at(rhs.row)) < 0;
+    };
+    if (limit)
+        std::partial_sort(entries.begin(), entries.begin() + limit, entries.end(), less);
+    else
+        std::sort(entries.begin(), entries.end(), less);
+
+    size_t perm_size = limit ? limit : size;
+    perm.resize(perm_size);
+    for (size_t i = 0; i < perm_size; ++i)
+        perm[i] = entries[i].row;
+}
+
 void sortBlock(Block & block, const SortDescription & description, size_t limit)
 {
     if (!block)
         return;
 
+    /// Comparing the rows column by column is expensive for several columns or collations,
+    /// so sort them by the normalized keys if possible.
+    bool use_normalized_keys = !description.empty()
+        && (description.size() > 1 || needCollation(getColumnsWithSortDescription(block, description)[0].first, description[0]))
+        && NormalizedSortKeys::canNormalize(block, description);
+    if (use_normalized_keys)
+    {
+        if (limit >= block.rows())
+            limit = 0;
+
+        IColumn::Permutation perm;
+        getPermutationByNormalizedKeys(NormalizedSortKeys(block, description), limit, perm);
+
+        size_t columns = block.columns();
+        for (size_t i = 0; i < columns; ++i)
+            block.safeGetByPosition(i).column = block.safeGetByPosition(i).column->permute(perm, limit);
+    }
     /// If only one column to sort by
-    if (description.size() == 1)
+    else if (description.size() == 1)
     {
         bool reverse = description[0].direction == -1;
 
@@ -0,0 +1,162 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Columns/ColumnsNumber.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Functions/FunctionFactory.h>
+#include <Functions/registerFunctions.h>
+#include <Interpreters/ExpressionActions.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+namespace DB
+{
+namespace bench
+{
+/// The expressions of TPC-H Q1 over DOUBLE columns:
+///   sum(l_extendedprice * (1 - l_discount)), sum(l_extendedprice * (1 - l_discount) * (1 + l_tax))
+/// with the filter `l_extendedprice * (1 - l_discount) > 1000` on the top.
+/// And the filter of TPC-H Q6:
+///   l_discount >= 0.05 and l_discount <= 0.07 and l_quantity < 24
+class ExpressionFusionBench : public benchmark::Fixture
+{
+public:
+    void SetUp(const benchmark::State &) override
+    {
+        try
+        {
+            DB::registerFunctions();
+        }
+        catch (DB::Exception &)
+        {
+            // Maybe another test has already registered, ignore exception here.
+        }
+
+        std::mt19937_64 rng(42);
+        std::uniform_real_distribution<Float64> dist(0, 1);
+        auto price = ColumnFloat64::create(rows);
+        auto discount = ColumnFloat64::create(rows);
+        auto tax = ColumnFloat64::create(rows);
+        auto quantity = ColumnFloat64::create(rows);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            price->getData()[i] = dist(rng) * 100000;
+            discount->getData()[i] = dist(rng) / 10;
+            tax->getData()[i] = dist(rng) / 10;
+            quantity->getData()[i] = dist(rng) * 50;
+        }
+        auto type = std::make_shared<DataTypeFloat64>();
+        block = Block({
+            {std::move(price), type, "l_extendedprice"},
+            {std::move(discount), type, "l_discount"},
+            {std::move(tax), type, "l_tax"},
+            {std::move(quantity), type, "l_quantity"},
+        });
+    }
+
+    ExpressionActionsPtr buildActions(bool enable_fusion, bool with_filter) const
+    {
+        Settings settings;
+        settings.enable_expression_fusion = enable_fusion;
+        const auto & context = tests::TiFlashTestEnv::getGlobalContext();
+        auto & factory = FunctionFactory::instance();
+        auto actions = std::make_shared<ExpressionActions>(block.getNamesAndTypesList(), settings);
+        auto type = std::make_shared<DataTypeFloat64>();
+        actions->add(ExpressionAction::addColumn({type->createColumnConst(1, Field(1.0)), type, "1"}));
+        actions->add(ExpressionAction::addColumn({type->createColumnConst(1, Field(1000.0)), type, "1000"}));
+        actions->add(ExpressionAction::applyFunction(factory.get("minus", context), {"1", "l_discount"}, "minus(1, l_discount)"));
+        actions->add(ExpressionAction::applyFunction(factory.get("multiply", context), {"l_extendedprice", "minus(1, l_discount)"}, "disc_price"));
+        actions->add(ExpressionAction::applyFunction(factory.get("plus", context), {"1", "l_tax"}, "plus(1, l_tax)"));
+        actions->add(ExpressionAction::applyFunction(factory.get("multiply", context), {"disc_price", "plus(1, l_tax)"}, "charge"));
+        if (with_filter)
+        {
+            actions->add(ExpressionAction::applyFunction(factory.get("greater", context), {"disc_price", "1000"}, "filter"));
+            actions->finalize({"filter", "charge"});
+        }
+        else
+        {
+            actions->finalize({"charge"});
+        }
+        return actions;
+    }
+
+    ExpressionActionsPtr buildFilterActions(bool enable_fusion) const
+    {
+        Settings settings;
+        settings.enable_expression_fusion = enable_fusion;
+        const auto & context = tests::TiFlashTestEnv::getGlobalContext();
+        auto & factory = FunctionFactory::instance();
+        auto actions = std::make_shared<ExpressionActions>(block.getNamesAndTypesList(), settings);
+        auto type = std::make_shared<DataTypeFloat64>();
+        actions->add(ExpressionAction::addColumn({type->createColumnConst(1, Field(0.05)), type, "0.05"}));
+        actions->add(ExpressionAction::addColumn({type->createColumnConst(1, Field(0.07)), type, "0.07"}));
+        actions->add(ExpressionAction::addColumn({type->createColumnConst(1, Field(24.0)), type, "24"}));
+        actions->add(ExpressionAction::applyFunction(factory.get("greaterOrEquals", context), {"l_discount", "0.05"}, "greaterOrEquals(l_discount, 0.05)"));
+        actions->add(ExpressionAction::applyFunction(factory.get("lessOrEquals", context), {"l_discount", "0.07"}, "lessOrEquals(l_discount, 0.07)"));
+        actions->add(ExpressionAction::applyFunction(factory.get("less", context), {"l_quantity", "24"}, "less(l_quantity, 24)"));
+        actions->add(ExpressionAction::applyFunction(
+            factory.get("and", context),
+            {"greaterOrEquals(l_discount, 0.05)", "lessOrEquals(l_discount, 0.07)", "less(l_quantity, 24)"},
+            "filter"));
+        actions->finalize({"filter"});
+        return actions;
+    }
+
+    void run(benchmark::State & state, const ExpressionActionsPtr & actions) const
+    {
+        for (auto _ : state)
+        {
+            Block res = block;
+            actions->execute(res);
+            benchmark::DoNotOptimize(res);
+        }
+        state.SetItemsProcessed(state.iterations() * rows);
+    }
+
+protected:
+    static constexpr size_t rows = DEFAULT_BLOCK_SIZE;
+    Block block;
+};
+
+BENCHMARK_DEFINE_F(ExpressionFusionBench, Charge)
+(benchmark::State & state)
+try
+{
+    run(state, buildActions(state.range(0), false));
+}
+CATCH
+BENCHMARK_REGISTER_F(ExpressionFusionBench, Charge)->Arg(0)->Arg(1);
+
+BENCHMARK_DEFINE_F(ExpressionFusionBench, ChargeWithFilter)
+(benchmark::State & state)
+try
+{
+    run(state, buildActions(state.range(0), true));
+}
+CATCH
+BENCHMARK_REGISTER_F(ExpressionFusionBench, ChargeWithFilter)->Arg(0)->Arg(1);
+
+BENCHMARK_DEFINE_F(ExpressionFusionBench, DiscountFilter)
+(benchmark::State & state)
+try
+{
+    run(state, buildFilterActions(state.range(0)));
+}
+CATCH
+BENCHMARK_REGISTER_F(ExpressionFusionBench, DiscountFilter)->Arg(0)->Arg(1);
+
+} // namespace bench
+} // namespace DB
@@ -0,0 +1,135 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Columns/ColumnsNumber.h>
+#include <Common/Arena.h>
+#include <Common/HashTable/Hash.h>
+#include <Interpreters/Aggregator.h>
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+namespace DB
+{
+namespace bench
+{
+namespace
+{
+constexpr size_t block_rows = 65536;
+constexpr size_t blocks_per_iteration = 16;
+
+using OneLevelMethod = AggregationMethodOneNumber<UInt64, AggregatedDataWithUInt64Key>;
+using TwoLevelMethod = AggregationMethodOneNumber<UInt64, AggregatedDataWithUInt64KeyTwoLevel>;
+
+/// The keys of GROUP BY, uniformly distributed in `distinct_keys` keys which are all in the hash table already,
+/// so that the time is spent on the lookups of a hash table of the given size.
+template <typename Method>
+struct LookupData
+{
+    explicit LookupData(size_t distinct_keys)
+    {
+        AggregateDataPtr place = pool.alloc(0);
+        for (size_t i = 0; i < distinct_keys; ++i)
+        {
+            typename Method::Data::LookupResult it;
+            bool inserted;
+            method.data.emplace(intHash64(i), it, inserted);
+            it->getMapped() = place;
+        }
+
+        std::mt19937_64 rng(42);
+        for (size_t b = 0; b < blocks_per_iteration; ++b)
+        {
+            auto column = ColumnUInt64::create(block_rows);
+            for (auto & key : column->getData())
+                key = intHash64(rng() % distinct_keys);
+            blocks.push_back(std::move(column));
+        }
+    }
+
+    Method method;
+    Arena pool;
+    std::vector<ColumnPtr> blocks;
+};
+
+/// Look up the keys of every block like `Aggregator::executeImplBatch`, with `emplace` or with `find` like the join probe.
+/// If `prefetch_distance` is not 0, the hashes of a block are computed first and the cells are prefetched while looking up.
+template <typename Method, bool use_emplace>
+void lookupBlocks(LookupData<Method> & data, size_t prefetch_distance)
+{
+    std::vector<String> sort_key_containers(1);
+    PaddedPODArray<size_t> hashes(block_rows);
+    std::unique_ptr<AggregateDataPtr[]> places(new AggregateDataPtr[block_rows]);
+
+    auto get_place = [&](typename Method::State & state, size_t i, auto... hash_value) -> AggregateDataPtr {
+        if constexpr (use_emplace)
+            return state.emplaceKey(data.method.data, i, data.pool, sort_key_containers, hash_value...).getMapped();
+        else
+        {
+            auto find_result = state.findKey(data.method.data, i, data.pool, sort_key_containers, hash_value...);
+            return find_result.isFound() ? find_result.getMapped() : nullptr;
+        }
+    };
+
+    for (const auto & block : data.blocks)
+    {
+        typename Method::State state(block.get());
+        if (prefetch_distance == 0)
+        {
+            for (size_t i = 0; i < block_rows; ++i)
+                places[i] = get_place(state, i);
+        }
+        else
+        {
+            for (size_t i = 0; i < block_rows; ++i)
+                hashes[i] = state.getHash(data.method.data, i, data.pool, sort_key_containers);
+            for (size_t i = 0; i < block_rows; ++i)
+            {
+                if (i + prefetch_distance < block_rows)
+                    data.method.data.prefetch(hashes[i + prefetch_distance]);
+                places[i] = get_place(state, i, hashes[i]);
+            }
+        }
+        benchmark::DoNotOptimize(places.get());
+    }
+}
+} // namespace
+
+template <typename Method, bool use_emplace>
+static void HashTableLookup(benchmark::State & state)
+{
+    const size_t distinct_keys = state.range(0);
+    const size_t prefetch_distance = state.range(1);
+    LookupData<Method> data(distinct_keys);
+    for (auto _ : state)
+        lookupBlocks<Method, use_emplace>(data, prefetch_distance);
+    state.SetItemsProcessed(state.iterations() * blocks_per_iteration * block_rows);
+}
+
+/// {distinct keys, prefetch distance}, the prefetch distance 0 means looking up the keys row by row.
+static void lookupArgs(benchmark::internal::Benchmark * bench)
+{
+    for (int64_t distinct_keys : {1000000, 10000000, 100000000})
+    {
+        bench->Args({distinct_keys, 0});
+        bench->Args({distinct_keys, 16});
+    }
+    bench->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_TEMPLATE(HashTableLookup, OneLevelMethod, true)->Apply(lookupArgs);
+BENCHMARK_TEMPLATE(HashTableLookup, TwoLevelMethod, true)->Apply(lookupArgs);
+BENCHMARK_TEMPLATE(HashTableLookup, OneLevelMethod, false)->Apply(lookupArgs);
+
+} // namespace bench
+} // namespace DB
@@ -0,0 +1,132 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnString.h>
+#include <Columns/ColumnsNumber.h>
+#include <DataStreams/MergeSortingBlockInputStream.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Interpreters/sortBlock.h>
+#include <Storages/Transaction/Collator.h>
+#include <benchmark/benchmark.h>
+
+#include <numeric>
+#include <random>
+
+namespace DB
+{
+namespace bench
+{
+/// ORDER BY a string with collation, an integer and a double, with many duplicated strings.
+class SortBlockBench : public benchmark::Fixture
+{
+public:
+    void SetUp(const benchmark::State &) override
+    {
+        block = createBlock(rows, 42);
+        const auto * collator = TiDB::ITiDBCollator::getCollator(TiDB::ITiDBCollator::UTF8MB4_GENERAL_CI);
+        description = {SortColumnDescription("s", 1, 1, collator), SortColumnDescription("i", -1, 1), SortColumnDescription("f", 1, 1)};
+    }
+
+    static Block createBlock(size_t num_rows, UInt64 seed)
+    {
+        std::mt19937_64 rng(seed);
+        auto s = ColumnString::create();
+        auto i = ColumnInt64::create(num_rows);
+        auto f = ColumnFloat64::create(num_rows);
+        for (size_t row = 0; row < num_rows; ++row)
+        {
+            auto str = "customer#" + std::to_string(rng() % 1000);
+            s->insertData(str.data(), str.size());
+            i->getData()[row] = rng() % 100;
+            f->getData()[row] = static_cast<Float64>(rng() % 10000) / 100;
+        }
+        return Block({
+            {std::move(s), std::make_shared<DataTypeString>(), "s"},
+            {std::move(i), std::make_shared<DataTypeInt64>(), "i"},
+            {std::move(f), std::make_shared<DataTypeFloat64>(), "f"},
+        });
+    }
+
+    static constexpr size_t rows = 65536;
+    Block block;
+    SortDescription description;
+};
+
+BENCHMARK_DEFINE_F(SortBlockBench, NormalizedKeys)
+(benchmark::State & state)
+{
+    for (auto _ : state)
+    {
+        Block sorted = block;
+        sortBlock(sorted, description);
+        benchmark::DoNotOptimize(sorted);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+/// The comparison of the rows column by column, which is used if the sort columns could not be normalized.
+BENCHMARK_DEFINE_F(SortBlockBench, CompareAt)
+(benchmark::State & state)
+{
+    ColumnRawPtrs columns;
+    for (const auto & desc : description)
+        columns.push_back(block.getByName(desc.column_name).column.get());
+    for (auto _ : state)
+    {
+        IColumn::Permutation perm(rows);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::sort(perm.begin(), perm.end(), [&](size_t lhs, size_t rhs) {
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                const auto & desc = description[i];
+                int res = desc.collator
+                    ? columns[i]->compareAt(lhs, rhs, *columns[i], desc.nulls_direction, *desc.collator)
+                    : columns[i]->compareAt(lhs, rhs, *columns[i], desc.nulls_direction);
+                if (res != 0)
+                    return res * desc.direction < 0;
+            }
+            return false;
+        });
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+/// Merge 16 sorted blocks, just like MergeSortingBlockInputStream does after partial sorting.
+BENCHMARK_DEFINE_F(SortBlockBench, MergeSortedBlocks)
+(benchmark::State & state)
+{
+    Blocks sorted_blocks;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        sorted_blocks.push_back(createBlock(rows / 16, i));
+        sortBlock(sorted_blocks.back(), description);
+    }
+    for (auto _ : state)
+    {
+        Blocks blocks = sorted_blocks;
+        MergeSortingBlocksBlockInputStream stream(blocks, description, "", 8192);
+        while (Block merged = stream.read())
+            benchmark::DoNotOptimize(merged);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+BENCHMARK_REGISTER_F(SortBlockBench, NormalizedKeys);
+BENCHMARK_REGISTER_F(SortBlockBench, CompareAt);
+BENCHMARK_REGISTER_F(SortBlockBench, MergeSortedBlocks);
+
+} // namespace bench
+} // namespace DB
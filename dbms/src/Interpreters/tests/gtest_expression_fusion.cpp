@@ -0,0 +1,213 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <Functions/FunctionFactory.h>
+#include <Functions/IFunction.h>
+#include <Interpreters/ExpressionActions.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <random>
+
+namespace DB
+{
+namespace tests
+{
+class ExpressionFusionTest : public FunctionTest
+{
+protected:
+    struct Call
+    {
+        String function;
+        Names arguments;
+        String result;
+    };
+
+    /// Build the actions of `calls` over the non-constant columns of `block`, the constant columns are added as literals.
+    ExpressionActionsPtr buildActions(const Block & block, const std::vector<Call> & calls, const Names & outputs, bool enable_fusion)
+    {
+        Settings settings;
+        settings.enable_expression_fusion = enable_fusion;
+        NamesAndTypesList input_columns;
+        for (const auto & column : block)
+        {
+            if (!column.column->isColumnConst())
+                input_columns.emplace_back(column.name, column.type);
+        }
+        auto actions = std::make_shared<ExpressionActions>(input_columns, settings);
+        for (const auto & column : block)
+        {
+            if (column.column->isColumnConst())
+                actions->add(ExpressionAction::addColumn({column.column->cloneResized(1), column.type, column.name}));
+        }
+        for (const auto & call : calls)
+            actions->add(ExpressionAction::applyFunction(FunctionFactory::instance().get(call.function, context), call.arguments, call.result));
+        actions->finalize(outputs);
+        return actions;
+    }
+
+    static size_t countFusedActions(const ExpressionActions & actions)
+    {
+        size_t count = 0;
+        for (const auto & action : actions.getActions())
+        {
+            if (action.type == ExpressionAction::APPLY_FUNCTION && action.function->getName() == "fused")
+                ++count;
+        }
+        return count;
+    }
+
+    /// Check the results of fused actions are the same as the unfused ones, return the fused actions.
+    ExpressionActionsPtr checkFusion(const Block & block, const std::vector<Call> & calls, const Names & outputs)
+    {
+        auto unfused = buildActions(block, calls, outputs, false);
+        auto fused = buildActions(block, calls, outputs, true);
+        EXPECT_EQ(countFusedActions(*unfused), 0);
+
+        Block unfused_block = block;
+        unfused->execute(unfused_block);
+        Block fused_block = block;
+        fused->execute(fused_block);
+        for (const auto & name : outputs)
+            EXPECT_TRUE(columnEqual(unfused_block.getByName(name), fused_block.getByName(name))) << name;
+        return fused;
+    }
+};
+
+TEST_F(ExpressionFusionTest, PricingSummary)
+try
+{
+    // More rows than one chunk, with NULLs.
+    const size_t rows = 2000;
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<Float64> dist(0, 1);
+    InferredDataVector<Float64> price;
+    InferredDataVector<Nullable<Float64>> discount;
+    InferredDataVector<Float64> tax;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        price.push_back(dist(rng) * 1000);
+        if (i % 7 == 0)
+            discount.push_back(std::nullopt);
+        else
+            discount.push_back(dist(rng) / 10);
+        tax.push_back(dist(rng) / 10);
+    }
+    Block block({
+        createColumn<Float64>(price, "price"),
+        createColumn<Nullable<Float64>>(discount, "discount"),
+        createColumn<Float64>(tax, "tax"),
+        createConstColumn<Float64>(rows, 1, "one"),
+        createConstColumn<Float64>(rows, 500, "bound"),
+    });
+
+    // price * (1 - discount) * (1 + tax) and (price * (1 - discount) > 500)
+    std::vector<Call> calls{
+        {"minus", {"one", "discount"}, "minus(one, discount)"},
+        {"multiply", {"price", "minus(one, discount)"}, "disc_price"},
+        {"plus", {"one", "tax"}, "plus(one, tax)"},
+        {"multiply", {"disc_price", "plus(one, tax)"}, "charge"},
+        {"greater", {"disc_price", "bound"}, "filter"},
+    };
+    // `disc_price` is used twice, so it is not fused into its consumers.
+    auto actions = checkFusion(block, calls, {"charge", "filter"});
+    ASSERT_EQ(countFusedActions(*actions), 2);
+
+    // Only the result of the whole expression is output.
+    actions = checkFusion(block, calls, {"charge"});
+    ASSERT_EQ(countFusedActions(*actions), 1);
+    for (const auto & action : actions->getActions())
+        ASSERT_NE(action.result_name, "disc_price");
+}
+CATCH
+
+TEST_F(ExpressionFusionTest, IntegerOverflowAndMixedTypes)
+try
+{
+    Block block({
+        createColumn<Int8>({127, -128, 0, -1, 5}, "a"),
+        createColumn<UInt32>({4294967295U, 0, 1, 4294967295U, 7}, "b"),
+        createColumn<Int64>({9223372036854775807LL, -9223372036854775807LL - 1, -1, 0, 5}, "c"),
+        createColumn<Nullable<Int32>>({1, {}, 0, -5, 35}, "d"),
+        createColumn<Float32>({1.5, -2.25, 0, 3, 0.5}, "e"),
+    });
+    std::vector<Call> calls{
+        {"plus", {"a", "b"}, "plus(a, b)"},
+        {"minus", {"plus(a, b)", "c"}, "minus(plus(a, b), c)"},
+        {"multiply", {"minus(plus(a, b), c)", "c"}, "x"},
+        {"multiply", {"a", "d"}, "multiply(a, d)"},
+        {"lessOrEquals", {"multiply(a, d)", "c"}, "y"},
+        {"multiply", {"a", "e"}, "multiply(a, e)"},
+        {"minus", {"multiply(a, e)", "b"}, "z"},
+        // Int32 and UInt32 are not fused, because they can not be compared as the same type.
+        {"equals", {"d", "b"}, "equals(d, b)"},
+        {"notEquals", {"equals(d, b)", "a"}, "w"},
+    };
+    auto actions = checkFusion(block, calls, {"x", "y", "z", "w"});
+    ASSERT_EQ(countFusedActions(*actions), 3);
+}
+CATCH
+
+TEST_F(ExpressionFusionTest, LogicalAndConditional)
+try
+{
+    const size_t rows = 2000;
+    std::mt19937_64 rng(42);
+    InferredDataVector<Nullable<Int32>> a;
+    InferredDataVector<Nullable<Int64>> d;
+    InferredDataVector<Int64> e;
+    InferredDataVector<Float64> b;
+    InferredDataVector<UInt8> c;
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (rng() % 4 == 0)
+            a.push_back(std::nullopt);
+        else
+            a.push_back(static_cast<Int32>(rng() % 7) - 3);
+        if (rng() % 4 == 0)
+            d.push_back(std::nullopt);
+        else
+            d.push_back(static_cast<Int64>(rng() % 7) - 3);
+        e.push_back(static_cast<Int64>(rng() % 3) - 1);
+        b.push_back((rng() % 5) / 4.0);
+        c.push_back(rng() % 3);
+    }
+    Block block({
+        createColumn<Nullable<Int32>>(a, "a"),
+        createColumn<Nullable<Int64>>(d, "d"),
+        createColumn<Int64>(e, "e"),
+        createColumn<Float64>(b, "b"),
+        createColumn<UInt8>(c, "c"),
+        createConstColumn<Float64>(rows, 0.5, "half"),
+    });
+
+    // multiIf(a > d and c and not b, a, isNull(a), d, e) or b <= 0.5
+    std::vector<Call> calls{
+        {"greater", {"a", "d"}, "greater(a, d)"},
+        {"not", {"b"}, "not(b)"},
+        {"and", {"greater(a, d)", "c", "not(b)"}, "and(greater(a, d), c, not(b))"},
+        {"isNull", {"a"}, "isNull(a)"},
+        {"multiIf", {"and(greater(a, d), c, not(b))", "a", "isNull(a)", "d", "e"}, "m"},
+        {"lessOrEquals", {"b", "half"}, "lessOrEquals(b, half)"},
+        {"or", {"m", "lessOrEquals(b, half)"}, "filter"},
+    };
+    auto actions = checkFusion(block, calls, {"filter"});
+    ASSERT_EQ(countFusedActions(*actions), 1);
+
+    actions = checkFusion(block, calls, {"filter", "m"});
+    ASSERT_EQ(countFusedActions(*actions), 2);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
@@ -0,0 +1,318 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <AggregateFunctions/AggregateFunctionFactory.h>
+#include <AggregateFunctions/registerAggregateFunctions.h>
+#include <Common/FieldVisitors.h>
+#include <DataStreams/BlocksListBlockInputStream.h>
+#include <Encryption/MockKeyManager.h>
+#include <Interpreters/Aggregator.h>
+#include <Interpreters/Join.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+#include <map>
+#include <random>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+/// The tables of the tests are far smaller than the default threshold, which is lowered to 0 to look up the keys
+/// of every block in two passes with prefetching.
+constexpr size_t prefetch_distance = 16;
+constexpr size_t block_rows = 1000;
+
+enum class KeyType
+{
+    Int64,
+    NullableInt64,
+    String,
+    NullableString,
+};
+
+String toString(KeyType type)
+{
+    switch (type)
+    {
+    case KeyType::Int64:
+        return "Int64";
+    case KeyType::NullableInt64:
+        return "Nullable(Int64)";
+    case KeyType::String:
+        return "String";
+    case KeyType::NullableString:
+        return "Nullable(String)";
+    }
+    return "";
+}
+
+/// The keys of `rows` rows in [0, distinct). One of every `zero_every` rows is 0, which is the zero key of the hash
+/// tables for both numbers and strings, and one of every `null_every` rows is NULL if the type is nullable.
+ColumnWithTypeAndName generateKeys(KeyType type, size_t rows, size_t distinct, size_t zero_every, size_t null_every, UInt64 seed)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<Int64> dist(1, distinct - 1);
+    bool nullable = type == KeyType::NullableInt64 || type == KeyType::NullableString;
+    std::vector<std::optional<Int64>> keys(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (nullable && i % null_every == null_every - 1)
+            keys[i] = std::nullopt;
+        else
+            keys[i] = i % zero_every == 0 ? 0 : dist(rng);
+    }
+
+    auto to_string = [](Int64 key) {
+        return key == 0 ? String() : fmt::format("key_{}", key);
+    };
+    switch (type)
+    {
+    case KeyType::Int64:
+    {
+        std::vector<Int64> values;
+        for (const auto & key : keys)
+            values.push_back(*key);
+        return createColumn<Int64>(values, "k");
+    }
+    case KeyType::NullableInt64:
+        return createColumn<Nullable<Int64>>(keys, "k");
+    case KeyType::String:
+    {
+        std::vector<String> values;
+        for (const auto & key : keys)
+            values.push_back(to_string(*key));
+        return createColumn<String>(values, "k");
+    }
+    case KeyType::NullableString:
+    {
+        std::vector<std::optional<String>> values;
+        for (const auto & key : keys)
+            values.push_back(key ? std::make_optional(to_string(*key)) : std::nullopt);
+        return createColumn<Nullable<String>>(values, "k");
+    }
+    }
+    return {};
+}
+
+ColumnWithTypeAndName generateRowIds(size_t rows, const String & name)
+{
+    std::vector<Int64> values(rows);
+    for (size_t i = 0; i < rows; ++i)
+        values[i] = i;
+    return createColumn<Int64>(values, name);
+}
+
+BlocksList splitBlock(const Block & block)
+{
+    BlocksList blocks;
+    for (size_t begin = 0; begin < block.rows(); begin += block_rows)
+    {
+        Block part = block.cloneEmpty();
+        for (size_t i = 0; i < block.columns(); ++i)
+            part.getByPosition(i).column = block.getByPosition(i).column->cut(begin, std::min(block_rows, block.rows() - begin));
+        blocks.push_back(std::move(part));
+    }
+    return blocks;
+}
+
+String fieldToString(const IColumn & column, size_t row)
+{
+    return applyVisitor(FieldVisitorToString(), column[row]);
+}
+} // namespace
+
+class HashTablePrefetchTest : public ::testing::Test
+{
+public:
+    static void SetUpTestCase()
+    {
+        try
+        {
+            registerAggregateFunctions();
+        }
+        catch (DB::Exception &)
+        {
+            // Maybe another test has already registered, ignore exception here.
+        }
+    }
+
+protected:
+    /// Count the rows of every key of `block`, return the count of every key.
+    static std::map<String, UInt64> aggregate(
+        const Block & block,
+        size_t max_rows_to_group_by,
+        size_t group_by_two_level_threshold,
+        size_t distance,
+        size_t min_bytes)
+    {
+        AggregateDescriptions aggregates(1);
+        aggregates[0].function = AggregateFunctionFactory::instance().get("count", DataTypes{});
+        aggregates[0].column_name = "cnt";
+        Aggregator::Params params(
+            block.cloneEmpty(),
+            {0},
+            aggregates,
+            false,
+            max_rows_to_group_by,
+            OverflowMode::ANY,
+            group_by_two_level_threshold,
+            0,
+            0,
+            false,
+            "",
+            TiDB::dummy_collators,
+            distance,
+            min_bytes);
+        Aggregator aggregator(params, "");
+
+        AggregatedDataVariants data_variants;
+        auto file_provider = std::make_shared<FileProvider>(std::make_shared<MockKeyManager>(false), false);
+        aggregator.execute(std::make_shared<BlocksListBlockInputStream>(splitBlock(block)), data_variants, file_provider);
+        EXPECT_EQ(data_variants.isTwoLevel(), group_by_two_level_threshold > 0);
+
+        std::map<String, UInt64> res;
+        for (const auto & result_block : aggregator.convertToBlocks(data_variants, true, 1))
+        {
+            const auto & keys = *result_block.getByName("k").column;
+            const auto & counts = *result_block.getByName("cnt").column;
+            for (size_t i = 0; i < result_block.rows(); ++i)
+                res[fieldToString(keys, i)] = counts.getUInt(i);
+        }
+        return res;
+    }
+
+    /// Join `left` with `right` by the key, return the sorted pairs of the row ids of the joined rows.
+    static std::vector<std::pair<Int64, Int64>> join(
+        const Block & left,
+        const Block & right,
+        ASTTableJoin::Kind kind,
+        ASTTableJoin::Strictness strictness,
+        size_t build_concurrency,
+        size_t distance,
+        size_t min_bytes)
+    {
+        Join hash_join({"k"}, {"k"}, false, SizeLimits(), kind, strictness, "", TiDB::dummy_collators, "", "", "", "", nullptr, 0, "", distance, min_bytes);
+        hash_join.init(right.cloneEmpty(), build_concurrency);
+        size_t stream_index = 0;
+        for (const auto & block : splitBlock(right))
+            hash_join.insertFromBlock(block, stream_index++ % build_concurrency);
+
+        std::vector<std::pair<Int64, Int64>> res;
+        for (auto & block : splitBlock(left))
+        {
+            hash_join.joinBlock(block);
+            const auto & left_ids = *block.getByName("l").column;
+            const auto & right_ids = *block.getByName("r").column;
+            for (size_t i = 0; i < block.rows(); ++i)
+                res.emplace_back(left_ids.getInt(i), right_ids.getInt(i));
+        }
+        std::sort(res.begin(), res.end());
+        return res;
+    }
+};
+
+TEST_F(HashTablePrefetchTest, Aggregation)
+try
+{
+    const size_t rows = 20000;
+    for (auto type : {KeyType::Int64, KeyType::NullableInt64, KeyType::String, KeyType::NullableString})
+    {
+        Block block{generateKeys(type, rows, 5000, 10, 13, 42)};
+
+        std::map<String, UInt64> expected;
+        for (size_t i = 0; i < rows; ++i)
+            ++expected[fieldToString(*block.getByPosition(0).column, i)];
+
+        // One-level and two-level hash tables, and finding the keys only after `max_rows_to_group_by` keys.
+        for (auto [max_rows_to_group_by, group_by_two_level_threshold] : std::vector<std::pair<size_t, size_t>>{{0, 0}, {0, 1000}, {1000, 0}})
+        {
+            SCOPED_TRACE(fmt::format("type: {}, max_rows_to_group_by: {}, group_by_two_level_threshold: {}", toString(type), max_rows_to_group_by, group_by_two_level_threshold));
+            auto without_prefetch = aggregate(block, max_rows_to_group_by, group_by_two_level_threshold, 0, 0);
+            auto with_prefetch = aggregate(block, max_rows_to_group_by, group_by_two_level_threshold, prefetch_distance, 0);
+            ASSERT_EQ(with_prefetch, without_prefetch);
+            if (max_rows_to_group_by == 0)
+                ASSERT_EQ(with_prefetch, expected);
+            else
+                ASSERT_LT(with_prefetch.size(), expected.size());
+        }
+    }
+}
+CATCH
+
+TEST_F(HashTablePrefetchTest, JoinProbe)
+try
+{
+    const size_t left_rows = 20000;
+    const size_t right_rows = 10000;
+    for (auto type : {KeyType::Int64, KeyType::NullableInt64, KeyType::String, KeyType::NullableString})
+    {
+        // Only a few zero keys at the right side, or the zero keys would join into too many rows.
+        Block left{generateKeys(type, left_rows, 5000, 10, 13, 42), generateRowIds(left_rows, "l")};
+        Block right{generateKeys(type, right_rows, 5000, 1000, 17, 43), generateRowIds(right_rows, "r")};
+
+        std::multimap<String, Int64> right_rows_by_key;
+        for (size_t i = 0; i < right_rows; ++i)
+        {
+            if (!right.getByName("k").column->isNullAt(i))
+                right_rows_by_key.emplace(fieldToString(*right.getByName("k").column, i), i);
+        }
+        std::vector<std::pair<Int64, Int64>> expected;
+        for (size_t i = 0; i < left_rows; ++i)
+        {
+            if (left.getByName("k").column->isNullAt(i))
+                continue;
+            auto [begin, end] = right_rows_by_key.equal_range(fieldToString(*left.getByName("k").column, i));
+            for (auto it = begin; it != end; ++it)
+                expected.emplace_back(i, it->second);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        // The segments of the hash table are picked by the precomputed hashes when it is built concurrently.
+        for (size_t build_concurrency : {1, 4})
+        {
+            SCOPED_TRACE(fmt::format("type: {}, build_concurrency: {}", toString(type), build_concurrency));
+            auto inner_all = join(left, right, ASTTableJoin::Kind::Inner, ASTTableJoin::Strictness::All, build_concurrency, prefetch_distance, 0);
+            ASSERT_EQ(inner_all, expected);
+            ASSERT_EQ(inner_all, join(left, right, ASTTableJoin::Kind::Inner, ASTTableJoin::Strictness::All, build_concurrency, 0, 0));
+
+            // The rows not found, including the ones with NULL keys, are kept by the left join.
+            auto left_any = join(left, right, ASTTableJoin::Kind::Left, ASTTableJoin::Strictness::Any, build_concurrency, prefetch_distance, 0);
+            ASSERT_EQ(left_any.size(), left_rows);
+            ASSERT_EQ(left_any, join(left, right, ASTTableJoin::Kind::Left, ASTTableJoin::Strictness::Any, build_concurrency, 0, 0));
+        }
+    }
+}
+CATCH
+
+TEST_F(HashTablePrefetchTest, SmallHashTable)
+try
+{
+    // With the default threshold, the small tables are looked up row by row whatever the distance is.
+    const size_t rows = 20000;
+    Block block{generateKeys(KeyType::Int64, rows, 5000, 10, 13, 42), generateRowIds(rows, "l")};
+    ASSERT_EQ(
+        aggregate(block, 0, 0, prefetch_distance, ColumnsHashing::columns_hashing_impl::prefetch_min_hash_table_bytes),
+        aggregate(block, 0, 0, prefetch_distance, 0));
+    ASSERT_EQ(ColumnsHashing::columns_hashing_impl::getPrefetchDistance(1024, rows, prefetch_distance, ColumnsHashing::columns_hashing_impl::prefetch_min_hash_table_bytes), 0);
+    ASSERT_EQ(ColumnsHashing::columns_hashing_impl::getPrefetchDistance(1024, rows, prefetch_distance, 0), prefetch_distance);
+    ASSERT_EQ(ColumnsHashing::columns_hashing_impl::getPrefetchDistance(1024, prefetch_distance, prefetch_distance, 0), 0);
+    ASSERT_EQ(ColumnsHashing::columns_hashing_impl::getPrefetchDistance(1024, rows, 0, 0), 0);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
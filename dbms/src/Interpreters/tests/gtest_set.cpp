@@ -0,0 +1,88 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Interpreters/Set.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+namespace DB
+{
+namespace tests
+{
+namespace
+{
+/// The values in the set are the even numbers in [0, 2 * num_rows).
+SetPtr createEvenSet(size_t num_rows)
+{
+    std::vector<Int64> values(num_rows);
+    for (size_t i = 0; i < num_rows; ++i)
+        values[i] = 2 * i;
+    Block block{createColumn<Int64>(values, "x")};
+
+    auto set = std::make_shared<Set>(SizeLimits());
+    set->setHeader(block.cloneEmpty());
+    set->insertFromBlock(block, false);
+    return set;
+}
+
+void checkEvenSet(const Set & set, size_t num_rows, size_t probe_rows)
+{
+    std::vector<std::optional<Int64>> values(probe_rows);
+    for (size_t i = 0; i < probe_rows; ++i)
+        values[i] = i % 101 == 0 ? std::nullopt : std::optional<Int64>(i * 7 % (4 * num_rows));
+    Block block{createColumn<Nullable<Int64>>(values, "x")};
+
+    for (bool negative : {false, true})
+    {
+        auto res = set.execute(block, negative);
+        const auto & data = typeid_cast<const ColumnUInt8 &>(*res).getData();
+        ASSERT_EQ(data.size(), probe_rows);
+        for (size_t i = 0; i < probe_rows; ++i)
+        {
+            bool in_set = values[i] && *values[i] % 2 == 0 && static_cast<size_t>(*values[i]) < 2 * num_rows;
+            // NULL is not in the set, neither for NOT IN.
+            UInt8 expected = values[i] ? (negative ^ in_set) : negative;
+            ASSERT_EQ(data[i], expected) << "row: " << i << ", negative: " << negative;
+        }
+    }
+}
+} // namespace
+
+TEST(SetTest, SmallSet)
+try
+{
+    auto set = createEvenSet(1000);
+    checkEvenSet(*set, 1000, 5000);
+}
+CATCH
+
+TEST(SetTest, LargeSetWithBloomFilter)
+try
+{
+    // Large enough to check the bloom filter before the hash table, and half of the probes are not in the set.
+    const size_t num_rows = 200000;
+    auto set = createEvenSet(num_rows);
+    for (size_t i = 0; i < 3; ++i)
+        checkEvenSet(*set, num_rows, 100000);
+
+    // Inserting more rows rebuilds the bloom filter.
+    Block block{createColumn<Int64>({1, 3, 5}, "x")};
+    set->insertFromBlock(block, false);
+    auto res = set->execute(Block{createColumn<Int64>({1, 3, 5, 7, 8}, "x")}, false);
+    ASSERT_COLUMN_EQ(createColumn<UInt8>({1, 1, 1, 0, 1}).column, res);
+}
+CATCH
+
+} // namespace tests
+} // namespace DB
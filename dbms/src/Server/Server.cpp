@@ -14,6 +14,7 @@
 
 #include <AggregateFunctions/registerAggregateFunctions.h>
 #include <Common/CPUAffinityManager.h>
+#include <Common/CacheManager.h>
 #include <Common/ClickHouseRevision.h>
 #include <Common/Config/ConfigReloader.h>
 #include <Common/CurrentMetrics.h>
@@ -43,6 +44,7 @@
 #include <Functions/registerFunctions.h>
 #include <IO/HTTPCommon.h>
 #include <IO/ReadHelpers.h>
+#include <IO/UncompressedCache.h>
 #include <IO/createReadBufferFromFileBase.h>
 #include <Interpreters/AsynchronousMetrics.h>
 #include <Interpreters/IDAsPathUpgrader.h>
@@ -58,8 +60,13 @@
 #include <Server/ServerInfo.h>
 #include <Server/StorageConfigParser.h>
 #include <Server/UserConfigParser.h>
+#include <Storages/DeltaMerge/DeltaIndexManager.h>
+#include <Storages/DeltaMerge/File/DirectReadFile.h>
+#include <Storages/DeltaMerge/Index/MinMaxIndex.h>
+#include <Storages/DeltaMerge/SegmentResultCache.h>
 #include <Storages/FormatVersion.h>
 #include <Storages/IManageableStorage.h>
+#include <Storages/MarkCache.h>
 #include <Storages/PathCapacityMetrics.h>
 #include <Storages/System/attachSystemTables.h>
 #include <Storages/Transaction/FileEncryption.h>
@@ -1305,10 +1312,50 @@ int Server::main(const std::vector<std::string> & /*args*/)
     if (minmax_index_cache_size)
         global_context->setMinMaxIndexCache(minmax_index_cache_size);
 
+    /// Size of cache for the partial results of segments, used by the queries with dt_enable_segment_result_cache.
+    size_t segment_result_cache_size = config().getUInt64("segment_result_cache_size", DEFAULT_SEGMENT_RESULT_CACHE_SIZE);
+    if (segment_result_cache_size)
+        global_context->setSegmentResultCache(segment_result_cache_size);
+
     /// Size of max memory usage of DeltaIndex, used by DeltaMerge engine.
     size_t delta_index_cache_size = config().getUInt64("delta_index_cache_size", 0);
     global_context->setDeltaIndexManager(delta_index_cache_size);
 
+    /// The memory budget shared by the caches above. If it is set, the sizes of caches are adjusted dynamically
+    /// according to the recent loads and weights of caches, and the sizes above are only the initial sizes.
+    /// Note that the DeltaIndex is managed only if delta_index_cache_size is set.
+    if (size_t cache_memory_budget = config().getUInt64("cache_memory_budget", 0); cache_memory_budget)
+    {
+        global_context->setCacheManager(cache_memory_budget);
+        auto cache_manager = global_context->getCacheManager();
+        auto register_cache = [&](CacheManager::CacheType type, const ManagedCachePtr & cache, double default_weight) {
+            if (!cache)
+                return;
+            auto weight = config().getDouble(fmt::format("{}_cache_weight", CacheManager::typeToString(type)), default_weight);
+            cache_manager->registerCache(type, weight, cache);
+        };
+        register_cache(CacheManager::CacheType::Mark, global_context->getMarkCache(), 1);
+        register_cache(CacheManager::CacheType::MinMaxIndex, global_context->getMinMaxIndexCache(), 1);
+        register_cache(CacheManager::CacheType::Uncompressed, global_context->getUncompressedCache(), 1);
+        // A segment result saves reading and aggregating a whole segment.
+        register_cache(CacheManager::CacheType::SegmentResult, global_context->getSegmentResultCache(), 4);
+        // Rebuilding the DeltaIndex is much more expensive than reading the other caches from disk.
+        if (global_context->isDeltaIndexLimited())
+            register_cache(CacheManager::CacheType::DeltaIndex, global_context->getDeltaIndexManager(), 4);
+
+        bg_pool.addTask(
+            [cache_manager] {
+                cache_manager->rebalance();
+                return false;
+            },
+            /*multi*/ false,
+            /*interval_ms*/ 10000);
+    }
+
+    /// Size of max memory usage of prefetching when reading DMFiles with direct I/O, used by DeltaMerge engine.
+    size_t direct_read_buffer_pool_size = config().getUInt64("direct_read_buffer_pool_size", DM::DirectReadBufferPool::DEFAULT_CAPACITY);
+    DM::DirectReadBufferPool::instance().setCapacity(direct_read_buffer_pool_size);
+
     /// Set path for format schema files
     auto format_schema_path = Poco::File(config().getString("format_schema_path", path + "format_schemas/"));
     global_context->setFormatSchemaPath(format_schema_path.path() + "/");
@@ -0,0 +1,275 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Encryption/RateLimiter.h>
+#include <Interpreters/Settings.h>
+#include <Storages/DeltaMerge/BackgroundTaskScheduler.h>
+#include <common/logger_useful.h>
+
+#include <algorithm>
+#include <ext/scope_guard.h>
+
+namespace DB
+{
+namespace DM
+{
+namespace
+{
+/// The score of a queued task increases by this every second, so that the low scored tasks won't starve.
+constexpr double score_aging_per_second = 0.01;
+} // namespace
+
+BackgroundTaskScheduler::Limits::Limits(const Settings & settings)
+    : io_budget_seconds(settings.dt_bg_task_io_budget_seconds)
+{
+    max_concurrency["MergeDelta"] = settings.dt_bg_merge_delta_max_concurrency;
+    max_concurrency["Split"] = settings.dt_bg_split_max_concurrency;
+    max_concurrency["Merge"] = settings.dt_bg_merge_max_concurrency;
+}
+
+BackgroundTaskScheduler::BackgroundTaskScheduler(const Limits & limits_, IORateLimiter * io_rate_limiter_)
+    : limits(limits_)
+    , io_rate_limiter(io_rate_limiter_)
+    , start_time(std::chrono::steady_clock::now())
+    , log(Logger::get("BackgroundTaskScheduler"))
+{}
+
+void BackgroundTaskScheduler::StoreWaker::wake(bool is_heavy)
+{
+    std::lock_guard lock(mutex);
+    if (!unregistered)
+        waker(is_heavy);
+}
+
+UInt64 BackgroundTaskScheduler::registerStore(const String & store_name, Waker waker)
+{
+    auto store_waker = std::make_shared<StoreWaker>();
+    store_waker->waker = std::move(waker);
+    std::lock_guard lock(mutex);
+    auto store_id = next_store_id++;
+    stores.emplace(store_id, Store{store_name, std::move(store_waker)});
+    return store_id;
+}
+
+void BackgroundTaskScheduler::unregisterStore(UInt64 store_id)
+{
+    StoreWakerPtr store_waker;
+    WakeUps wake_ups;
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = stores.find(store_id); it != stores.end())
+        {
+            store_waker = std::move(it->second.waker);
+            stores.erase(it);
+        }
+        size_t dropped = 0;
+        for (auto it = queued_tasks.begin(); it != queued_tasks.end();)
+        {
+            if (it->second.info.store_id == store_id)
+            {
+                queued_index[it->second.info.is_heavy].erase(getPriorityKey(it->second));
+                it = queued_tasks.erase(it);
+                ++dropped;
+            }
+            else
+                ++it;
+        }
+        if (dropped > 0)
+            LOG_FMT_DEBUG(log, "Dropped {} queued tasks of store {}", dropped, store_id);
+        wake_ups = getWakeUps();
+    }
+    // Wait for the running waker of the store, which may be collected by other threads before.
+    if (store_waker)
+    {
+        std::lock_guard lock(store_waker->mutex);
+        store_waker->unregistered = true;
+    }
+    wakeUp(wake_ups);
+}
+
+UInt64 BackgroundTaskScheduler::addTask(const TaskInfo & info, size_t max_tasks_of_store)
+{
+    std::lock_guard lock(mutex);
+    auto store_it = stores.find(info.store_id);
+    if (store_it == stores.end())
+        return 0;
+    auto & store = store_it->second;
+    if (store.queued_light_tasks + store.queued_heavy_tasks >= max_tasks_of_store)
+        return 0;
+    // reserve some task space for the other kind of tasks
+    auto & queued_of_kind = info.is_heavy ? store.queued_heavy_tasks : store.queued_light_tasks;
+    if (max_tasks_of_store > 1 && queued_of_kind >= static_cast<size_t>(max_tasks_of_store * 0.9))
+        return 0;
+
+    auto task_id = next_task_id++;
+    auto & task = queued_tasks[task_id];
+    task.info = info;
+    task.info.task_id = task_id;
+    task.info.store_name = store.name;
+    task.enqueue_time = std::chrono::steady_clock::now();
+    queued_index[info.is_heavy].insert(getPriorityKey(task));
+    ++queued_of_kind;
+    return task_id;
+}
+
+UInt64 BackgroundTaskScheduler::tryTakeTask(UInt64 store_id, bool is_heavy)
+{
+    StoreWakerPtr owner_waker;
+    SCOPE_EXIT({
+        if (owner_waker)
+            owner_waker->wake(is_heavy);
+    });
+    std::lock_guard lock(mutex);
+    const auto * task = pickTask(is_heavy);
+    if (task == nullptr)
+        return 0;
+    if (task->info.store_id != store_id)
+    {
+        // Let the store owning the task run it, the waker is called after releasing the lock.
+        if (auto it = stores.find(task->info.store_id); it != stores.end())
+            owner_waker = it->second.waker;
+        return 0;
+    }
+
+    auto task_id = task->info.task_id;
+    queued_index[is_heavy].erase(getPriorityKey(*task));
+    auto node = queued_tasks.extract(task_id);
+    auto & info = node.mapped().info;
+    info.is_running = true;
+    if (auto it = stores.find(store_id); it != stores.end())
+        --(info.is_heavy ? it->second.queued_heavy_tasks : it->second.queued_light_tasks);
+    ++running_tasks_by_type[info.type];
+    if (info.is_heavy)
+        running_heavy_bytes += info.estimated_bytes;
+    running_tasks.insert(std::move(node));
+    return task_id;
+}
+
+void BackgroundTaskScheduler::finishTask(UInt64 task_id)
+{
+    WakeUps wake_ups;
+    {
+        std::lock_guard lock(mutex);
+        auto it = running_tasks.find(task_id);
+        if (it == running_tasks.end())
+            return;
+        const auto & info = it->second.info;
+        --running_tasks_by_type[info.type];
+        if (info.is_heavy)
+            running_heavy_bytes -= info.estimated_bytes;
+        running_tasks.erase(it);
+        wake_ups = getWakeUps();
+    }
+    wakeUp(wake_ups);
+}
+
+std::vector<BackgroundTaskScheduler::TaskInfo> BackgroundTaskScheduler::getTasks() const
+{
+    std::lock_guard lock(mutex);
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::pair<double, TaskInfo>> queued;
+    queued.reserve(queued_tasks.size());
+    for (const auto & [task_id, task] : queued_tasks)
+    {
+        auto & info = queued.emplace_back(getPriority(task, now), task.info).second;
+        info.queued_seconds = std::chrono::duration<double>(now - task.enqueue_time).count();
+    }
+    std::stable_sort(queued.begin(), queued.end(), [](const auto & lhs, const auto & rhs) { return lhs.first > rhs.first; });
+
+    std::vector<TaskInfo> tasks;
+    tasks.reserve(running_tasks.size() + queued.size());
+    for (const auto & [task_id, task] : running_tasks)
+    {
+        auto & info = tasks.emplace_back(task.info);
+        info.queued_seconds = std::chrono::duration<double>(now - task.enqueue_time).count();
+    }
+    for (auto & [priority, info] : queued)
+        tasks.emplace_back(std::move(info));
+    return tasks;
+}
+
+size_t BackgroundTaskScheduler::queuedTasks() const
+{
+    std::lock_guard lock(mutex);
+    return queued_tasks.size();
+}
+
+double BackgroundTaskScheduler::getPriority(const Task & task, std::chrono::steady_clock::time_point now) const
+{
+    return task.info.score + std::chrono::duration<double>(now - task.enqueue_time).count() * score_aging_per_second;
+}
+
+BackgroundTaskScheduler::PriorityKey BackgroundTaskScheduler::getPriorityKey(const Task & task) const
+{
+    return {getPriority(task, start_time), task.info.task_id};
+}
+
+bool BackgroundTaskScheduler::isRunnable(const TaskInfo & info) const
+{
+    if (auto limit_it = limits.max_concurrency.find(info.type); limit_it != limits.max_concurrency.end() && limit_it->second > 0)
+    {
+        auto running_it = running_tasks_by_type.find(info.type);
+        if (running_it != running_tasks_by_type.end() && running_it->second >= limit_it->second)
+            return false;
+    }
+    if (info.is_heavy && running_heavy_bytes > 0)
+    {
+        // Always allow one heavy task to run, otherwise a task larger than the budget can never run.
+        if (auto budget = getIOBudget(); budget > 0 && running_heavy_bytes + info.estimated_bytes > budget)
+            return false;
+    }
+    return true;
+}
+
+UInt64 BackgroundTaskScheduler::getIOBudget() const
+{
+    if (limits.io_budget_seconds == 0 || io_rate_limiter == nullptr)
+        return 0;
+    return io_rate_limiter->getBgWriteMaxBytesPerSec() * limits.io_budget_seconds;
+}
+
+const BackgroundTaskScheduler::Task * BackgroundTaskScheduler::pickTask(bool is_heavy) const
+{
+    // Only the tasks blocked by the limits are skipped.
+    for (const auto & key : queued_index[is_heavy])
+    {
+        const auto & task = queued_tasks.at(key.task_id);
+        if (isRunnable(task.info))
+            return &task;
+    }
+    return nullptr;
+}
+
+BackgroundTaskScheduler::WakeUps BackgroundTaskScheduler::getWakeUps() const
+{
+    WakeUps wake_ups;
+    for (bool is_heavy : {false, true})
+    {
+        if (const auto * task = pickTask(is_heavy); task != nullptr)
+        {
+            if (auto it = stores.find(task->info.store_id); it != stores.end())
+                wake_ups.emplace_back(it->second.waker, is_heavy);
+        }
+    }
+    return wake_ups;
+}
+
+void BackgroundTaskScheduler::wakeUp(const WakeUps & wake_ups)
+{
+    for (const auto & [waker, is_heavy] : wake_ups)
+        waker->wake(is_heavy);
+}
+
+} // namespace DM
+} // namespace DB
@@ -0,0 +1,185 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Common/Logger.h>
+#include <Core/Types.h>
+
+#include <array>
+#include <boost/noncopyable.hpp>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace DB
+{
+class IORateLimiter;
+struct Settings;
+
+namespace DM
+{
+/** A node-level scheduler of the DeltaMerge background tasks (merge delta, split, merge, flush, ...) across all the stores.
+  *
+  * Every DeltaMergeStore keeps its tasks in its own pool and registers them here with a score. The background threads
+  * of a store can only take the task of the store which is the highest scored runnable one among all the stores.
+  * Otherwise the store holding that task is woken up instead. So that the tasks of a table under heavy writes
+  * won't starve the tasks of other tables, and the tasks that help reads or prevent write stalls most run first.
+  *
+  * A task is runnable when:
+  *  - the number of running tasks of its type doesn't exceed the concurrency limit of the type;
+  *  - for heavy tasks, the estimated bytes written by the running heavy tasks fit in the I/O budget,
+  *    which is the background write rate of IORateLimiter multiplied by `io_budget_seconds`.
+  */
+class BackgroundTaskScheduler : private boost::noncopyable
+{
+public:
+    struct Limits
+    {
+        /// The max number of running tasks of each type. The types not listed or limited to 0 are unlimited.
+        std::unordered_map<String, size_t> max_concurrency;
+        /// The running heavy tasks are expected to finish writing in this many seconds under the background
+        /// write rate limit. 0 means no I/O budget.
+        UInt64 io_budget_seconds = 0;
+
+        Limits() = default;
+        explicit Limits(const Settings & settings);
+    };
+
+    struct TaskInfo
+    {
+        /// Assigned by the scheduler.
+        UInt64 task_id = 0;
+        UInt64 store_id = 0;
+        String store_name;
+        UInt64 segment_id = 0;
+        String type;
+        bool is_heavy = false;
+        /// The tasks with larger scores run earlier.
+        double score = 0;
+        /// The estimated bytes written by the task.
+        size_t estimated_bytes = 0;
+        /// The seconds since the task is queued.
+        double queued_seconds = 0;
+        bool is_running = false;
+    };
+
+    /// Called with the kind of task (heavy or not) to wake up the background thread of a store.
+    /// Wakers are called without holding the lock of the scheduler, but never after `unregisterStore` returns.
+    using Waker = std::function<void(bool is_heavy)>;
+
+    BackgroundTaskScheduler(const Limits & limits_, IORateLimiter * io_rate_limiter_);
+
+    /// Returns the id of the store.
+    UInt64 registerStore(const String & store_name, Waker waker);
+
+    /// Drop all the queued tasks of the store, and the store won't be woken up anymore.
+    /// The running tasks of the store still need to call `finishTask`.
+    void unregisterStore(UInt64 store_id);
+
+    /// Queue a task. Returns the task id, or 0 if the store has too many queued tasks.
+    /// Some space of `max_tasks_of_store` is reserved for each kind of tasks, so that they won't starve each other.
+    UInt64 addTask(const TaskInfo & info, size_t max_tasks_of_store);
+
+    /// Take the next task of the store to run. Returns 0 if the highest scored runnable task is not owned by the
+    /// store, or there is no runnable task.
+    UInt64 tryTakeTask(UInt64 store_id, bool is_heavy);
+
+    void finishTask(UInt64 task_id);
+
+    /// The queued and running tasks, queued tasks are sorted by the priority.
+    std::vector<TaskInfo> getTasks() const;
+
+    size_t queuedTasks() const;
+
+private:
+    struct Task
+    {
+        TaskInfo info;
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+    using Tasks = std::map<UInt64, Task>;
+
+    /// All the queued tasks age at the same rate, so the order of their priorities doesn't change with time,
+    /// and the queued tasks of each kind are indexed by `getPriority` at a fixed time point.
+    struct PriorityKey
+    {
+        double priority;
+        UInt64 task_id;
+        /// Higher priorities first, and then the earlier queued tasks.
+        bool operator<(const PriorityKey & rhs) const
+        {
+            return priority > rhs.priority || (priority == rhs.priority && task_id < rhs.task_id);
+        }
+    };
+    using PriorityIndex = std::set<PriorityKey>;
+
+    struct StoreWaker
+    {
+        std::mutex mutex;
+        Waker waker;
+        bool unregistered = false;
+
+        void wake(bool is_heavy);
+    };
+    using StoreWakerPtr = std::shared_ptr<StoreWaker>;
+    /// The wakers to call with the kind of tasks after releasing the lock.
+    using WakeUps = std::vector<std::pair<StoreWakerPtr, bool>>;
+
+    double getPriority(const Task & task, std::chrono::steady_clock::time_point now) const;
+    PriorityKey getPriorityKey(const Task & task) const;
+    bool isRunnable(const TaskInfo & info) const;
+    UInt64 getIOBudget() const;
+
+    /// Returns the highest scored runnable task, or nullptr.
+    const Task * pickTask(bool is_heavy) const;
+    /// Get the waker of the store owning the highest scored runnable task of each kind.
+    WakeUps getWakeUps() const;
+    static void wakeUp(const WakeUps & wake_ups);
+
+private:
+    const Limits limits;
+    IORateLimiter * io_rate_limiter;
+
+    mutable std::mutex mutex;
+    UInt64 next_store_id = 1;
+    UInt64 next_task_id = 1;
+    struct Store
+    {
+        String name;
+        StoreWakerPtr waker;
+        size_t queued_light_tasks = 0;
+        size_t queued_heavy_tasks = 0;
+    };
+    std::unordered_map<UInt64, Store> stores;
+    Tasks queued_tasks;
+    /// The index of `queued_tasks`, indexed by `is_heavy`.
+    std::array<PriorityIndex, 2> queued_index;
+    const std::chrono::steady_clock::time_point start_time;
+    Tasks running_tasks;
+    std::unordered_map<String, size_t> running_tasks_by_type;
+    size_t running_heavy_bytes = 0;
+
+    LoggerPtr log;
+};
+
+using BackgroundTaskSchedulerPtr = std::shared_ptr<BackgroundTaskScheduler>;
+
+} // namespace DM
+} // namespace DB
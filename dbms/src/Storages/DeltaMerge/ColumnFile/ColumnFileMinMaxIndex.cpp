@@ -0,0 +1,83 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <IO/ReadBufferFromString.h>
+#include <IO/ReadHelpers.h>
+#include <IO/WriteBufferFromString.h>
+#include <IO/WriteHelpers.h>
+#include <Storages/DeltaMerge/ColumnFile/ColumnFileMinMaxIndex.h>
+#include <Storages/DeltaMerge/DeltaMergeDefines.h>
+#include <Storages/DeltaMerge/Index/MinMaxIndex.h>
+
+namespace DB
+{
+namespace DM
+{
+ColumnFileMinMaxIndexPtr ColumnFileMinMaxIndex::build(const Block & block, size_t offset, size_t limit)
+{
+    auto index = std::make_shared<ColumnFileMinMaxIndex>();
+    for (const auto & col : block)
+    {
+        if (col.column_id != EXTRA_HANDLE_COLUMN_ID && col.column_id != VERSION_COLUMN_ID)
+            continue;
+
+        auto minmax = std::make_shared<MinMaxIndex>(*col.type);
+        // The deleted rows are indexed too, because they shadow the older versions as well.
+        if (offset == 0 && limit == col.column->size())
+            minmax->addPack(*col.column, nullptr);
+        else
+            minmax->addPack(*col.column->cut(offset, limit), nullptr);
+        index->param.indexes.emplace(col.column_id, RSIndex(col.type, minmax));
+    }
+    return index;
+}
+
+void ColumnFileMinMaxIndex::serialize(WriteBuffer & buf) const
+{
+    writeIntBinary(static_cast<UInt32>(param.indexes.size()), buf);
+    for (const auto & [col_id, rs_index] : param.indexes)
+    {
+        // The size of the index is written ahead, because `MinMaxIndex::read` needs it.
+        WriteBufferFromOwnString index_buf;
+        rs_index.minmax->write(*rs_index.type, index_buf);
+        writeIntBinary(col_id, buf);
+        writeStringBinary(index_buf.releaseStr(), buf);
+    }
+}
+
+ColumnFileMinMaxIndexPtr ColumnFileMinMaxIndex::deserialize(ReadBuffer & buf, const Block & schema)
+{
+    auto index = std::make_shared<ColumnFileMinMaxIndex>();
+    UInt32 count;
+    readIntBinary(count, buf);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ColId col_id;
+        String index_data;
+        readIntBinary(col_id, buf);
+        readStringBinary(index_data, buf);
+
+        auto col = std::find_if(schema.begin(), schema.end(), [&](const auto & c) { return c.column_id == col_id; });
+        if (unlikely(col == schema.end()))
+            throw Exception("The indexed column " + DB::toString(col_id) + " is not in the schema of column file", ErrorCodes::LOGICAL_ERROR);
+
+        ReadBufferFromString index_buf(index_data);
+        auto minmax = MinMaxIndex::read(*col->type, index_buf, index_data.size());
+        index->param.indexes.emplace(col_id, RSIndex(col->type, minmax));
+    }
+    return index;
+}
+
+} // namespace DM
+} // namespace DB
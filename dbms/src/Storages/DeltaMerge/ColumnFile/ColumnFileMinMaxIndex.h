@@ -0,0 +1,51 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Core/Block.h>
+#include <Storages/DeltaMerge/Filter/RSOperator.h>
+
+namespace DB
+{
+namespace DM
+{
+class ColumnFileMinMaxIndex;
+using ColumnFileMinMaxIndexPtr = std::shared_ptr<const ColumnFileMinMaxIndex>;
+
+/// The min-max index of a column file, which treats the whole column file as one pack.
+/// It is built when the column file is written and saved with the metadata of the column file since DeltaFormat::V4,
+/// so that a column file can be skipped by a rough set filter without reading its data.
+///
+/// Note that the rows in delta could shadow the older versions of the same handle, so a column file can not be
+/// skipped by the filter on other columns before MVCC filtering. Only the handle and version columns are indexed,
+/// which means that the filter on a time column, e.g. a time range in the query, does not skip any column file in delta.
+class ColumnFileMinMaxIndex
+{
+public:
+    /// Build the index of the rows in [offset, offset + limit) of `block`.
+    static ColumnFileMinMaxIndexPtr build(const Block & block, size_t offset, size_t limit);
+
+    void serialize(WriteBuffer & buf) const;
+    /// The types of the indexed columns are taken from `schema`, i.e. the schema of the column file.
+    static ColumnFileMinMaxIndexPtr deserialize(ReadBuffer & buf, const Block & schema);
+
+    RSResult roughCheck(const RSOperatorPtr & filter) const { return filter->roughCheck(0, param); }
+
+private:
+    RSCheckParam param;
+};
+
+} // namespace DM
+} // namespace DB
@@ -98,7 +98,8 @@ void serializeSavedColumnFiles(WriteBuffer & buf, const ColumnFilePersisteds & c
         serializeSavedColumnFilesInV2Format(buf, column_files);
         break;
     case DeltaFormat::V3:
-        serializeSavedColumnFilesInV3Format(buf, column_files);
+    case DeltaFormat::V4:
+        serializeSavedColumnFilesInV3Format(buf, column_files, STORAGE_FORMAT_CURRENT.delta);
         break;
     default:
         throw Exception("Unexpected delta value version: " + DB::toString(STORAGE_FORMAT_CURRENT.delta), ErrorCodes::LOGICAL_ERROR);
@@ -120,10 +121,11 @@ ColumnFilePersisteds deserializeSavedColumnFiles(DMContext & context, const RowK
         column_files = deserializeSavedColumnFilesInV2Format(buf, version);
         break;
     case DeltaFormat::V3:
+    case DeltaFormat::V4:
         column_files = deserializeSavedColumnFilesInV3Format(context, segment_range, buf, version);
         break;
     default:
-        throw Exception("Unexpected delta value version: " + DB::toString(version) + ", latest version: " + DB::toString(DeltaFormat::V3),
+        throw Exception("Unexpected delta value version: " + DB::toString(version) + ", latest version: " + DB::toString(DeltaFormat::V4),
                         ErrorCodes::LOGICAL_ERROR);
     }
     return column_files;
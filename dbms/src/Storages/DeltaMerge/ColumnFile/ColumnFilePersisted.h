@@ -49,7 +49,8 @@ ColumnFilePersisteds deserializeSavedColumnFiles(DMContext & context, const RowK
 void serializeSavedColumnFilesInV2Format(WriteBuffer & buf, const ColumnFilePersisteds & column_files);
 ColumnFilePersisteds deserializeSavedColumnFilesInV2Format(ReadBuffer & buf, UInt64 version);
 
-void serializeSavedColumnFilesInV3Format(WriteBuffer & buf, const ColumnFilePersisteds & column_files);
+/// V3 and V4 share the same serializer, V4 saves the min-max index of ColumnFileTiny additionally.
+void serializeSavedColumnFilesInV3Format(WriteBuffer & buf, const ColumnFilePersisteds & column_files, UInt64 version);
 ColumnFilePersisteds deserializeSavedColumnFilesInV3Format(DMContext & context, const RowKeyRange & segment_range, ReadBuffer & buf, UInt64 version);
 
 } // namespace DM
@@ -18,11 +18,29 @@
 #include <Storages/DeltaMerge/ColumnFile/ColumnFileSetReader.h>
 #include <Storages/DeltaMerge/ColumnFile/ColumnFileTiny.h>
 #include <Storages/DeltaMerge/DMContext.h>
+#include <Storages/DeltaMerge/Filter/FilterHelper.h>
 
 namespace DB
 {
 namespace DM
 {
+namespace
+{
+/// Whether the rows of the column file can be skipped according to its min-max index.
+/// Only the index of ColumnFileTiny is checked, because ColumnFileInMemory is small and ColumnFileBig is always placed.
+inline bool canSkipByMinMaxIndex(ColumnFile & column_file, const RSOperatorPtr & filter)
+{
+    if (!filter)
+        return false;
+    auto * t_file = column_file.tryToTinyFile();
+    if (!t_file)
+        return false;
+    // The index is absent before the column file restored from an older format is read once.
+    auto minmax_index = t_file->getMinMaxIndex();
+    return minmax_index && minmax_index->roughCheck(filter) == RSResult::None;
+}
+} // namespace
+
 std::pair<size_t, size_t> findColumnFile(const ColumnFiles & column_files, size_t rows_offset, size_t deletes_offset)
 {
     size_t rows_count = 0;
@@ -100,6 +118,8 @@ ColumnFileSetReaderPtr ColumnFileSetReader::createNewReader(const ColumnDefinesP
     new_reader->segment_range = segment_range;
     new_reader->column_file_rows = column_file_rows;
     new_reader->column_file_rows_end = column_file_rows_end;
+    new_reader->range_filter_range = range_filter_range;
+    new_reader->range_filter = range_filter;
 
     for (auto & fr : column_file_readers)
         new_reader->column_file_readers.push_back(fr->createNewReader(new_col_defs));
@@ -145,6 +165,13 @@ size_t ColumnFileSetReader::readRows(MutableColumns & output_columns, size_t off
     auto [start_file_index, rows_start_in_start_file] = locatePosByAccumulation(column_file_rows_end, start);
     auto [end_file_index, rows_end_in_end_file] = locatePosByAccumulation(column_file_rows_end, end);
 
+    // The filter of the range is built once, because the range is the same in most cases.
+    if (range && (!range_filter || !(*range_filter_range == *range)))
+    {
+        range_filter_range = *range;
+        range_filter = toFilter(*range_filter_range);
+    }
+
     size_t actual_read = 0;
     for (size_t file_index = start_file_index; file_index <= end_file_index; ++file_index)
     {
@@ -155,6 +182,9 @@ size_t ColumnFileSetReader::readRows(MutableColumns & output_columns, size_t off
         // Nothing to read.
         if (rows_in_file_limit == 0)
             continue;
+        // None of the rows in this column file are in range.
+        if (range && canSkipByMinMaxIndex(*snapshot->getColumnFiles()[file_index], range_filter))
+            continue;
 
         auto & column_file_reader = column_file_readers[file_index];
         actual_read += column_file_reader->readRows(output_columns, rows_start_in_file, rows_in_file_limit, range);
@@ -230,6 +260,9 @@ bool ColumnFileSetReader::shouldPlace(const DMContext & context,
     auto & column_files = snapshot->getColumnFiles();
     auto [start_file_index, rows_start_in_start_file] = locatePosByAccumulation(column_file_rows_end, placed_rows);
 
+    // Used to skip the column files which contain no rows in `relevant_range` with version <= `max_version`.
+    RSOperatorPtr place_filter;
+
     for (size_t file_index = start_file_index; file_index < snapshot->getColumnFileCount(); ++file_index)
     {
         auto & column_file = column_files[file_index];
@@ -261,6 +294,15 @@ bool ColumnFileSetReader::shouldPlace(const DMContext & context,
         }
         else if (column_file->isTinyFile())
         {
+            if (!place_filter)
+            {
+                auto range = relevant_range;
+                Attr version_attr = {VERSION_COLUMN_NAME, VERSION_COLUMN_ID, VERSION_COLUMN_TYPE};
+                place_filter = createAnd({toFilter(range), createLessEqual(version_attr, Field(max_version), -1)});
+            }
+            if (canSkipByMinMaxIndex(*column_file, place_filter))
+                continue;
+
             auto & dpb_reader = typeid_cast<ColumnFileTinyReader &>(*column_file_reader);
             auto pk_column = dpb_reader.getPKColumn();
             auto version_column = dpb_reader.getVersionColumn();
@@ -15,6 +15,9 @@
 #pragma once
 
 #include <Storages/DeltaMerge/ColumnFile/ColumnFileSetSnapshot.h>
+#include <Storages/DeltaMerge/Filter/RSOperator.h>
+
+#include <optional>
 
 namespace DB
 {
@@ -38,6 +41,10 @@ private:
 
     std::vector<ColumnFileReaderPtr> column_file_readers;
 
+    // The rough set filter of the range passed to `readRows`, which is used to skip column files by min-max index.
+    std::optional<RowKeyRange> range_filter_range;
+    RSOperatorPtr range_filter;
+
 private:
     ColumnFileSetReader() = default;
 
@@ -150,6 +150,22 @@ std::tuple<ColumnFilePersistedPtr, BlockPtr> ColumnFileTiny::deserializeMetadata
     return {std::make_shared<ColumnFileTiny>(schema, rows, bytes, data_page_id), std::move(schema)};
 }
 
+void ColumnFileTiny::serializeMinMaxIndex(WriteBuffer & buf) const
+{
+    auto index = getMinMaxIndex();
+    writeIntBinary(static_cast<UInt8>(index != nullptr), buf);
+    if (index)
+        index->serialize(buf);
+}
+
+void ColumnFileTiny::deserializeMinMaxIndex(ReadBuffer & buf)
+{
+    UInt8 has_index;
+    readIntBinary(has_index, buf);
+    if (has_index)
+        setMinMaxIndex(ColumnFileMinMaxIndex::deserialize(buf, *schema));
+}
+
 Block ColumnFileTiny::readBlockForMinorCompaction(const PageReader & page_reader) const
 {
     if (cache)
@@ -196,7 +212,8 @@ ColumnTinyFilePtr ColumnFileTiny::writeColumnFile(DMContext & context, const Blo
     auto page_id = writeColumnFileData(context, block, offset, limit, wbs);
     auto new_column_file_schema = schema ? schema : std::make_shared<Block>(block.cloneEmpty());
     auto bytes = block.bytes(offset, limit);
-    return std::make_shared<ColumnFileTiny>(new_column_file_schema, limit, bytes, page_id, cache);
+    auto minmax_index = ColumnFileMinMaxIndex::build(block, offset, limit);
+    return std::make_shared<ColumnFileTiny>(new_column_file_schema, limit, bytes, page_id, cache, minmax_index);
 }
 
 PageId ColumnFileTiny::writeColumnFileData(DMContext & context, const Block & block, size_t offset, size_t limit, WriteBatches & wbs)
@@ -229,12 +246,30 @@ ColumnPtr ColumnFileTinyReader::getPKColumn()
 ColumnPtr ColumnFileTinyReader::getVersionColumn()
 {
     tiny_file.fillColumns(storage_snap->log_reader, *col_defs, 2, cols_data_cache);
+    buildMinMaxIndexIfNeed();
     return cols_data_cache[1];
 }
 
+void ColumnFileTinyReader::buildMinMaxIndexIfNeed()
+{
+    if (tiny_file.getMinMaxIndex() || cols_data_cache.size() < 2)
+        return;
+    const auto & pk_cd = (*col_defs)[0];
+    const auto & version_cd = (*col_defs)[1];
+    if (pk_cd.id != EXTRA_HANDLE_COLUMN_ID || version_cd.id != VERSION_COLUMN_ID)
+        return;
+
+    Block block{
+        ColumnWithTypeAndName(cols_data_cache[0], pk_cd.type, pk_cd.name, pk_cd.id),
+        ColumnWithTypeAndName(cols_data_cache[1], version_cd.type, version_cd.name, version_cd.id),
+    };
+    tiny_file.setMinMaxIndex(ColumnFileMinMaxIndex::build(block, 0, tiny_file.getRows()));
+}
+
 size_t ColumnFileTinyReader::readRows(MutableColumns & output_cols, size_t rows_offset, size_t rows_limit, const RowKeyRange * range)
 {
     tiny_file.fillColumns(storage_snap->log_reader, *col_defs, output_cols.size(), cols_data_cache);
+    buildMinMaxIndexIfNeed();
 
     auto & pk_col = cols_data_cache[0];
     return copyColumnsData(cols_data_cache, pk_col, output_cols, rows_offset, rows_limit, range);
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <Storages/DeltaMerge/ColumnFile/ColumnFileMinMaxIndex.h>
 #include <Storages/DeltaMerge/ColumnFile/ColumnFilePersisted.h>
 
 namespace DB
@@ -40,6 +41,11 @@ private:
     /// The id of data page which stores the data of this pack.
     PageId data_page_id;
 
+    /// The min-max index of handle and version. It is serialized since DeltaFormat::V4. For the column files
+    /// restored from an older format, it is built on the first read of the handle and version columns.
+    /// Use `std::atomic_load` and `std::atomic_store` to access it, because it could be set by concurrent readers.
+    mutable ColumnFileMinMaxIndexPtr minmax_index;
+
     /// The members below are not serialized.
 
     /// The cache data in memory.
@@ -64,11 +70,17 @@ private:
     }
 
 public:
-    ColumnFileTiny(const BlockPtr & schema_, UInt64 rows_, UInt64 bytes_, PageId data_page_id_, const CachePtr & cache_ = nullptr)
+    ColumnFileTiny(const BlockPtr & schema_,
+                   UInt64 rows_,
+                   UInt64 bytes_,
+                   PageId data_page_id_,
+                   const CachePtr & cache_ = nullptr,
+                   const ColumnFileMinMaxIndexPtr & minmax_index_ = nullptr)
         : schema(schema_)
         , rows(rows_)
         , bytes(bytes_)
         , data_page_id(data_page_id_)
+        , minmax_index(minmax_index_)
         , cache(cache_)
     {
         for (size_t i = 0; i < schema->columns(); ++i)
@@ -83,6 +95,9 @@ public:
     auto getCache() const { return cache; }
     void clearCache() { cache = {}; }
 
+    ColumnFileMinMaxIndexPtr getMinMaxIndex() const { return std::atomic_load(&minmax_index); }
+    void setMinMaxIndex(const ColumnFileMinMaxIndexPtr & minmax_index_) const { std::atomic_store(&minmax_index, minmax_index_); }
+
     /// The schema of this pack. Could be empty, i.e. a DeleteRange does not have a schema.
     BlockPtr getSchema() const { return schema; }
     /// Replace the schema with a new schema, and the new schema instance should be exactly the same as the previous one.
@@ -104,6 +119,9 @@ public:
     }
 
     void serializeMetadata(WriteBuffer & buf, bool save_schema) const override;
+    /// Serialize the min-max index after the metadata, since DeltaFormat::V4.
+    void serializeMinMaxIndex(WriteBuffer & buf) const;
+    void deserializeMinMaxIndex(ReadBuffer & buf);
 
     PageId getDataPageId() const { return data_page_id; }
 
@@ -159,6 +177,10 @@ public:
     ColumnPtr getPKColumn();
     ColumnPtr getVersionColumn();
 
+    /// Build the min-max index of the column file by the PK & Version column if it is absent.
+    /// They must be the first two columns of `col_defs` and have been read already.
+    void buildMinMaxIndexIfNeed();
+
     size_t readRows(MutableColumns & output_cols, size_t rows_offset, size_t rows_limit, const RowKeyRange * range) override;
 
     Block readNextBlock() override;
@@ -21,7 +21,7 @@ namespace DB
 {
 namespace DM
 {
-void serializeSavedColumnFilesInV3Format(WriteBuffer & buf, const ColumnFilePersisteds & column_files)
+void serializeSavedColumnFilesInV3Format(WriteBuffer & buf, const ColumnFilePersisteds & column_files, UInt64 version)
 {
     writeIntBinary(column_files.size(), buf);
     BlockPtr last_schema;
@@ -52,6 +52,8 @@ void serializeSavedColumnFilesInV3Format(WriteBuffer & buf, const ColumnFilePers
 
             bool save_schema = cur_schema != last_schema;
             column_file->serializeMetadata(buf, save_schema);
+            if (version >= DeltaFormat::V4)
+                tiny_file->serializeMinMaxIndex(buf);
             break;
         }
         default:
@@ -60,7 +62,7 @@ void serializeSavedColumnFilesInV3Format(WriteBuffer & buf, const ColumnFilePers
     }
 }
 
-ColumnFilePersisteds deserializeSavedColumnFilesInV3Format(DMContext & context, const RowKeyRange & segment_range, ReadBuffer & buf, UInt64 /*version*/)
+ColumnFilePersisteds deserializeSavedColumnFilesInV3Format(DMContext & context, const RowKeyRange & segment_range, ReadBuffer & buf, UInt64 version)
 {
     size_t column_file_count;
     readIntBinary(column_file_count, buf);
@@ -79,6 +81,8 @@ ColumnFilePersisteds deserializeSavedColumnFilesInV3Format(DMContext & context,
         case ColumnFile::Type::TINY_FILE:
         {
             std::tie(column_file, last_schema) = ColumnFileTiny::deserializeMetadata(buf, last_schema);
+            if (version >= DeltaFormat::V4)
+                column_file->tryToTinyFile()->deserializeMinMaxIndex(buf);
             break;
         }
         case ColumnFile::Type::BIG_FILE:
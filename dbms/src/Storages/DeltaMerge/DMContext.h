@@ -20,6 +20,7 @@
 #include <Interpreters/Settings.h>
 #include <Storages/DeltaMerge/DMChecksumConfig.h>
 #include <Storages/DeltaMerge/DeltaMergeDefines.h>
+#include <Storages/DeltaMerge/File/DirectReadFile.h>
 
 namespace DB
 {
@@ -32,6 +33,8 @@ class StoragePool;
 using NotCompress = std::unordered_set<ColId>;
 struct DMContext;
 using DMContextPtr = std::shared_ptr<DMContext>;
+class TopNThreshold;
+using TopNThresholdPtr = std::shared_ptr<TopNThreshold>;
 
 /**
  * This context object carries table infos. And those infos are only meaningful to current context.
@@ -82,6 +85,16 @@ struct DMContext : private boost::noncopyable
     const bool read_stable_only;
     const bool enable_relevant_place;
     const bool enable_skippable_place;
+    const bool enable_sorted_mem_table_read;
+    // Rewrite only the stable packs overlapping delta in merge delta when they are less than this ratio of stable.
+    const double partial_merge_delta_max_ratio;
+    // Rewrite the whole stable in merge delta when it contains this many files.
+    const size_t partial_merge_delta_max_stable_files;
+    // The memory of prefetching shared by all the DMFiles read with direct I/O under this context.
+    const ReadPrefetchQuotaPtr read_prefetch_quota;
+    // The threshold of the TopN on the result of this read. The stable packs which can not enter the result
+    // are skipped by the read, but never by placing delta, which is also done under this context.
+    TopNThresholdPtr topn_threshold;
 
     String tracing_id;
 
@@ -119,6 +132,10 @@ public:
         , read_stable_only(settings.dt_read_stable_only)
         , enable_relevant_place(settings.dt_enable_relevant_place)
         , enable_skippable_place(settings.dt_enable_skippable_place)
+        , enable_sorted_mem_table_read(settings.dt_enable_sorted_mem_table_read)
+        , partial_merge_delta_max_ratio(settings.dt_partial_merge_delta_max_ratio)
+        , partial_merge_delta_max_stable_files(settings.dt_partial_merge_delta_max_stable_files)
+        , read_prefetch_quota(std::make_shared<ReadPrefetchQuota>(settings.dt_direct_read_prefetch_max_bytes))
         , tracing_id(tracing_id_)
     {
     }
@@ -15,14 +15,22 @@
 #pragma once
 
 #include <Common/FailPoint.h>
+#include <DataStreams/BlocksListBlockInputStream.h>
 #include <DataStreams/IProfilingBlockInputStream.h>
+#include <DataStreams/NullBlockInputStream.h>
 #include <Interpreters/Context.h>
 #include <Storages/DeltaMerge/DMContext.h>
 #include <Storages/DeltaMerge/Segment.h>
 #include <Storages/DeltaMerge/SegmentReadTaskPool.h>
+#include <Storages/DeltaMerge/SegmentResultCache.h>
 
 namespace DB
 {
+namespace ErrorCodes
+{
+extern const int LOGICAL_ERROR;
+} // namespace ErrorCodes
+
 namespace FailPoints
 {
 extern const char pause_when_reading_from_dt_stream[];
@@ -78,6 +86,20 @@ public:
 
     Block getHeader() const override { return header; }
 
+    bool supportSegmentTransform() const { return !is_raw && extra_table_id_index == InvalidColumnID; }
+
+    /// Transform the stream of every segment by `transform_`, e.g. into the partial aggregation states of segments.
+    /// The header of this stream is changed to the header of transformed streams, so it must be called before reading.
+    void setSegmentTransform(const SegmentStreamTransformPtr & transform_)
+    {
+        if (unlikely(!supportSegmentTransform()))
+            throw Exception("Segment transform is not supported by raw read or reading extra table id", ErrorCodes::LOGICAL_ERROR);
+        transform = transform_;
+        header = transform->transform(std::make_shared<NullBlockInputStream>(header))->getHeader();
+        if (!transform->cache_key.empty())
+            result_cache = dm_context->db_context.getGlobalContext().getSegmentResultCache();
+    }
+
 protected:
     Block readImpl() override
     {
@@ -106,22 +128,20 @@ protected:
                 {
                     cur_stream = cur_segment->getInputStreamRaw(*dm_context, columns_to_read, task->read_snapshot, do_range_filter_for_raw);
                 }
+                else if (transform)
+                {
+                    cur_stream = getTransformedStream(*task);
+                }
                 else
                 {
-                    cur_stream = cur_segment->getInputStream(
-                        *dm_context,
-                        columns_to_read,
-                        task->read_snapshot,
-                        task->ranges,
-                        filter,
-                        max_version,
-                        std::max(expected_block_size, static_cast<size_t>(dm_context->db_context.getSettingsRef().dt_segment_stable_pack_rows)));
+                    cur_stream = getSegmentStream(*task);
                 }
                 LOG_FMT_TRACE(log, "Start to read segment [{}]", cur_segment->segmentId());
             }
             FAIL_POINT_PAUSE(FailPoints::pause_when_reading_from_dt_stream);
 
-            Block res = cur_stream->read(res_filter, return_filter);
+            // The filter is only returned by the streams of segments.
+            Block res = transform ? cur_stream->read() : cur_stream->read(res_filter, return_filter);
 
             if (res)
             {
@@ -138,12 +158,16 @@ protected:
                     continue;
                 else
                 {
+                    if (caching_result)
+                        addToCachingResult(res);
                     total_rows += res.rows();
                     return res;
                 }
             }
             else
             {
+                if (caching_result)
+                    finishCachingResult();
                 after_segment_read(dm_context, cur_segment);
                 LOG_FMT_TRACE(log, "Finish reading segment [{}]", cur_segment->segmentId());
                 cur_segment = {};
@@ -157,6 +181,67 @@ protected:
         LOG_FMT_DEBUG(log, "finish read {} rows from storage", total_rows);
     }
 
+private:
+    BlockInputStreamPtr getSegmentStream(const SegmentReadTask & task)
+    {
+        return task.segment->getInputStream(
+            *dm_context,
+            columns_to_read,
+            task.read_snapshot,
+            task.ranges,
+            filter,
+            max_version,
+            std::max(expected_block_size, static_cast<size_t>(dm_context->db_context.getSettingsRef().dt_segment_stable_pack_rows)));
+    }
+
+    BlockInputStreamPtr getTransformedStream(const SegmentReadTask & task)
+    {
+        if (result_cache)
+        {
+            auto key = SegmentResultCache::getKey(*transform, physical_table_id, *task.segment, *task.read_snapshot, task.ranges, columns_to_read);
+            if (auto result = result_cache->get(key); result && result->data_max_version <= max_version)
+            {
+                LOG_FMT_TRACE(log, "Hit the result cache of segment [{}]", task.segment->segmentId());
+                return std::make_shared<BlocksListBlockInputStream>(BlocksList(result->blocks));
+            }
+            caching_key = std::move(key);
+            caching_result = std::make_shared<SegmentResult>();
+            caching_snapshot = task.read_snapshot;
+            // Don't let a big result flush the cache.
+            max_caching_bytes = result_cache->getCacheStats().max_bytes / 16;
+        }
+        return transform->transform(getSegmentStream(task));
+    }
+
+    void addToCachingResult(const Block & block)
+    {
+        caching_result->bytes += block.allocatedBytes();
+        if (caching_result->bytes > max_caching_bytes)
+            resetCachingResult();
+        else
+            caching_result->blocks.push_back(block);
+    }
+
+    void finishCachingResult()
+    {
+        // A cancelled transform could end before reading all the data.
+        if (!isCancelled())
+        {
+            // Only cache the result that all the rows are visible, so that it doesn't depend on max_version.
+            caching_result->data_max_version = cur_segment->getMaxVersion(*dm_context, caching_snapshot);
+            if (caching_result->data_max_version <= max_version)
+                result_cache->set(caching_key, caching_result);
+        }
+        resetCachingResult();
+    }
+
+    void resetCachingResult()
+    {
+        caching_key.clear();
+        caching_result.reset();
+        caching_snapshot.reset();
+    }
+
 private:
     DMContextPtr dm_context;
     SegmentReadTaskPoolPtr task_pool;
@@ -178,6 +263,14 @@ private:
     SegmentPtr cur_segment;
     TableID physical_table_id;
 
+    SegmentStreamTransformPtr transform;
+    SegmentResultCachePtr result_cache;
+    /// The result of current segment which is going to be cached.
+    String caching_key;
+    std::shared_ptr<SegmentResult> caching_result;
+    SegmentSnapshotPtr caching_snapshot;
+    size_t max_caching_bytes = 0;
+
     LoggerPtr log;
     size_t total_rows = 0;
 };
@@ -53,6 +53,7 @@ DeltaIndex::Updates ColumnFileFlushTask::prepare(WriteBatches & wbs)
             delta_index_updates.emplace_back(task.deletes_offset, task.rows_offset, perm);
 
         task.data_page = ColumnFileTiny::writeColumnFileData(context, task.block_data, 0, task.block_data.rows(), wbs);
+        task.minmax_index = ColumnFileMinMaxIndex::build(task.block_data, 0, task.block_data.rows());
     }
 
     wbs.writeLogAndData();
@@ -74,7 +75,9 @@ bool ColumnFileFlushTask::commit(ColumnFilePersistedSetPtr & persisted_file_set,
             new_column_file = std::make_shared<ColumnFileTiny>(m_file->getSchema(),
                                                                m_file->getRows(),
                                                                m_file->getBytes(),
-                                                               task.data_page);
+                                                               task.data_page,
+                                                               /*cache*/ nullptr,
+                                                               task.minmax_index);
         }
         else if (auto * t_file = task.column_file->tryToTinyFile(); t_file)
         {
@@ -17,6 +17,7 @@
 #include <Core/Block.h>
 #include <IO/WriteHelpers.h>
 #include <Storages/DeltaMerge/ColumnFile/ColumnFile.h>
+#include <Storages/DeltaMerge/ColumnFile/ColumnFileMinMaxIndex.h>
 #include <Storages/DeltaMerge/DeltaIndex.h>
 #include <Storages/DeltaMerge/File/DMFile.h>
 #include <Storages/DeltaMerge/RowKeyRange.h>
@@ -48,6 +49,7 @@ public:
 
         Block block_data;
         PageId data_page = 0;
+        ColumnFileMinMaxIndexPtr minmax_index;
 
         bool sorted = false;
         size_t rows_offset = 0;
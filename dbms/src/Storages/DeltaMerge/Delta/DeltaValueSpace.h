@@ -258,6 +258,8 @@ private:
     DeltaIndexPtr shared_delta_index;
 
     ColumnFileSetSnapshotPtr mem_table_snap;
+    // The sorted rows of `mem_table_snap`, nullptr if the MemTableSet doesn't have an available sorted index.
+    MemTableIndex::SortedRowsPtr mem_table_sorted_rows;
 
     ColumnFileSetSnapshotPtr persisted_files_snap;
 
@@ -276,6 +278,7 @@ public:
         c->is_update = is_update;
         c->shared_delta_index = shared_delta_index;
         c->mem_table_snap = mem_table_snap->clone();
+        c->mem_table_sorted_rows = mem_table_sorted_rows;
         c->persisted_files_snap = persisted_files_snap->clone();
 
         c->_delta = _delta;
@@ -308,6 +311,7 @@ public:
 
     ColumnFileSetSnapshotPtr getMemTableSetSnapshot() const { return mem_table_snap; }
     ColumnFileSetSnapshotPtr getPersistedFileSetSnapshot() const { return persisted_files_snap; }
+    const MemTableIndex::SortedRowsPtr & getMemTableSortedRows() const { return mem_table_sorted_rows; }
 
     size_t getColumnFileCount() const { return (mem_table_snap ? mem_table_snap->getColumnFileCount() : 0) + persisted_files_snap->getColumnFileCount(); }
     size_t getRows() const { return (mem_table_snap ? mem_table_snap->getRows() : 0) + persisted_files_snap->getRows(); }
@@ -371,6 +375,15 @@ public:
                      const RowKeyRange & segment_range,
                      const RowKeyRange & relevant_range,
                      UInt64 max_version);
+
+    // Only the rows in [0, rows_end) and the deletes in [0, deletes_end) of delta are going to be placed.
+    bool shouldPlace(const DMContext & context,
+                     DeltaIndexPtr my_delta_index,
+                     const RowKeyRange & segment_range,
+                     const RowKeyRange & relevant_range,
+                     UInt64 max_version,
+                     size_t rows_end,
+                     size_t deletes_end);
 };
 
 class DeltaValueInputStream : public IBlockInputStream
@@ -0,0 +1,94 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnString.h>
+#include <Columns/ColumnsNumber.h>
+#include <Common/typeid_cast.h>
+#include <Storages/DeltaMerge/Delta/MemTableIndex.h>
+#include <Storages/DeltaMerge/RowKeyRange.h>
+
+#include <algorithm>
+#include <numeric>
+
+namespace DB
+{
+namespace DM
+{
+namespace
+{
+inline int compareHandle(const ColumnInt64 & handles, size_t a, size_t b)
+{
+    const auto & data = handles.getData();
+    return data[a] == data[b] ? 0 : (data[a] < data[b] ? -1 : 1);
+}
+
+inline int compareHandle(const ColumnString & handles, size_t a, size_t b)
+{
+    auto lhs = handles.getDataAt(a);
+    auto rhs = handles.getDataAt(b);
+    return compare(lhs.data, lhs.size, rhs.data, rhs.size);
+}
+} // namespace
+
+MemTableIndex::MemTableIndex()
+    : sorted_rows(std::make_shared<SortedRows>())
+{}
+
+void MemTableIndex::append(const IColumn & handle, const IColumn & version, size_t offset, size_t limit)
+{
+    if (limit == 0)
+        return;
+
+    if (!handles)
+    {
+        is_common_handle = typeid_cast<const ColumnString *>(&handle) != nullptr;
+        handles = handle.cloneEmpty();
+    }
+
+    size_t begin = versions.size();
+    handles->insertRangeFrom(handle, offset, limit);
+    const auto & version_data = typeid_cast<const ColumnUInt64 &>(version).getData();
+    versions.insert(version_data.begin() + offset, version_data.begin() + offset + limit);
+
+    if (is_common_handle)
+        sortAndMerge(typeid_cast<const ColumnString &>(*handles), begin, versions.size());
+    else
+        sortAndMerge(typeid_cast<const ColumnInt64 &>(*handles), begin, versions.size());
+}
+
+template <typename HandleColumn>
+void MemTableIndex::sortAndMerge(const HandleColumn & handle_column, size_t begin, size_t end)
+{
+    auto less = [&](size_t a, size_t b) {
+        if (int res = compareHandle(handle_column, a, b); res != 0)
+            return res < 0;
+        if (versions[a] != versions[b])
+            return versions[a] < versions[b];
+        return a < b;
+    };
+
+    SortedRows new_rows(end - begin);
+    std::iota(new_rows.begin(), new_rows.end(), begin);
+    // The blocks written into delta are sorted by handle usually, so sorting is skipped mostly.
+    if (!std::is_sorted(new_rows.begin(), new_rows.end(), less))
+        std::sort(new_rows.begin(), new_rows.end(), less);
+
+    // Merge into a new instance, because the old one could be hold by some snapshots.
+    auto merged = std::make_shared<SortedRows>(end);
+    std::merge(sorted_rows->begin(), sorted_rows->end(), new_rows.begin(), new_rows.end(), merged->begin(), less);
+    sorted_rows = std::move(merged);
+}
+
+} // namespace DM
+} // namespace DB
@@ -0,0 +1,66 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Columns/IColumn.h>
+#include <Common/PODArray.h>
+
+#include <boost/noncopyable.hpp>
+#include <memory>
+
+namespace DB
+{
+namespace DM
+{
+class MemTableIndex;
+using MemTableIndexPtr = std::unique_ptr<MemTableIndex>;
+
+/// A handle-sorted, version-ordered index of the rows in MemTableSet, which is updated incrementally on every append.
+/// A row is identified by its offset in MemTableSet. With this index, reads can merge the rows in memory with
+/// the stable and the persisted delta in one ordered pass, instead of placing them into the DeltaTree.
+///
+/// This class is not thread safe, it is protected by the lock of DeltaValueSpace just like MemTableSet.
+class MemTableIndex : private boost::noncopyable
+{
+public:
+    /// The offsets of rows sorted by (handle, version, offset).
+    using SortedRows = IColumn::Permutation;
+    using SortedRowsPtr = std::shared_ptr<const SortedRows>;
+
+    MemTableIndex();
+
+    /// Append the rows [offset, offset + limit) of `handle` and `version` columns to the end of MemTableSet.
+    void append(const IColumn & handle, const IColumn & version, size_t offset, size_t limit);
+
+    size_t getRows() const { return versions.size(); }
+
+    /// The returned instance is never modified after created, so that it can be hold by snapshots.
+    const SortedRowsPtr & getSortedRows() const { return sorted_rows; }
+
+private:
+    template <typename HandleColumn>
+    void sortAndMerge(const HandleColumn & handles, size_t begin, size_t end);
+
+private:
+    bool is_common_handle = false;
+    /// The copies of handle and version columns of all rows.
+    MutableColumnPtr handles;
+    PaddedPODArray<UInt64> versions;
+
+    SortedRowsPtr sorted_rows;
+};
+
+} // namespace DM
+} // namespace DB
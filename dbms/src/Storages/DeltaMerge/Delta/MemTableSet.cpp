@@ -31,6 +31,59 @@ namespace DB
 {
 namespace DM
 {
+namespace
+{
+const IColumn * getColumnById(const Block & block, ColId column_id)
+{
+    for (const auto & c : block)
+    {
+        if (c.column_id == column_id)
+            return c.column.get();
+    }
+    return nullptr;
+}
+} // namespace
+
+void MemTableSet::appendToSortedIndex(const Block & block, size_t offset, size_t limit)
+{
+    const auto * handle = getColumnById(block, EXTRA_HANDLE_COLUMN_ID);
+    const auto * version = getColumnById(block, VERSION_COLUMN_ID);
+    if (handle && version)
+        sorted_index->append(*handle, *version, offset, limit);
+    else
+        sorted_index.reset();
+}
+
+void MemTableSet::appendToSortedIndex(const ColumnFilePtr & column_file)
+{
+    if (!sorted_index)
+        return;
+    if (auto * m_file = column_file->tryToInMemoryFile(); m_file)
+    {
+        if (m_file->getRows() == 0)
+            return;
+        auto block = m_file->readDataForFlush();
+        appendToSortedIndex(block, 0, block.rows());
+    }
+    else
+    {
+        // The data of other column files is not in memory, or it is a delete range which can not be merged by the sorted index.
+        sorted_index.reset();
+    }
+}
+
+void MemTableSet::rebuildSortedIndex()
+{
+    sorted_index = std::make_unique<MemTableIndex>();
+    for (const auto & file : column_files)
+        appendToSortedIndex(file);
+}
+
+MemTableIndex::SortedRowsPtr MemTableSet::getSortedRows() const
+{
+    return sorted_index ? sorted_index->getSortedRows() : nullptr;
+}
+
 void MemTableSet::appendColumnFileInner(const ColumnFilePtr & column_file)
 {
     // If this column file's schema is identical to last_schema, then use the last_schema instance (instead of the one in `column_file`),
@@ -63,6 +116,7 @@ void MemTableSet::appendColumnFileInner(const ColumnFilePtr & column_file)
 
     column_files.push_back(column_file);
     column_files_count = column_files.size();
+    appendToSortedIndex(column_file);
 
     rows += column_file->getRows();
     bytes += column_file->getBytes();
@@ -150,6 +204,8 @@ void MemTableSet::appendToCache(DMContext & context, const Block & block, size_t
         if (unlikely(!success))
             throw Exception("Write to MemTableSet failed", ErrorCodes::LOGICAL_ERROR);
     }
+    if (sorted_index)
+        appendToSortedIndex(block, offset, limit);
     rows += limit;
     bytes += append_bytes;
 }
@@ -208,6 +264,11 @@ ColumnFileSetSnapshotPtr MemTableSet::createSnapshot(const StorageSnapshotPtr &
         LOG_FMT_ERROR(log, "Rows and deletes check failed. Actual: rows[{}], deletes[{}]. Expected: rows[{}], deletes[{}].", total_rows, total_deletes, rows.load(), deletes.load());
         throw Exception("Rows and deletes check failed.", ErrorCodes::LOGICAL_ERROR);
     }
+    if (unlikely(sorted_index && sorted_index->getRows() != rows))
+    {
+        LOG_FMT_ERROR(log, "Sorted index rows check failed. Actual: rows[{}]. Expected: rows[{}].", sorted_index->getRows(), rows.load());
+        throw Exception("Sorted index rows check failed.", ErrorCodes::LOGICAL_ERROR);
+    }
 
     return snap;
 }
@@ -281,6 +342,7 @@ void MemTableSet::removeColumnFilesInFlushTask(const ColumnFileFlushTask & flush
     rows = new_rows;
     bytes = new_bytes;
     deletes = new_deletes;
+    rebuildSortedIndex();
 
     ProfileEvents::increment(ProfileEvents::DMWriteBytes, flush_bytes);
 }
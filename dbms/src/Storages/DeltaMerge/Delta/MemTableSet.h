@@ -17,6 +17,7 @@
 #include <Storages/DeltaMerge/ColumnFile/ColumnFile.h>
 #include <Storages/DeltaMerge/ColumnFile/ColumnFileSetSnapshot.h>
 #include <Storages/DeltaMerge/Delta/ColumnFileFlushTask.h>
+#include <Storages/DeltaMerge/Delta/MemTableIndex.h>
 
 namespace DB
 {
@@ -46,11 +47,19 @@ private:
     std::atomic<size_t> bytes = 0;
     std::atomic<size_t> deletes = 0;
 
+    // The sorted index of rows in `column_files`. It is only available when all column files are ColumnFileInMemory,
+    // otherwise it is nullptr until the column files are flushed.
+    MemTableIndexPtr sorted_index;
+
     Poco::Logger * log;
 
 private:
     void appendColumnFileInner(const ColumnFilePtr & column_file);
 
+    void appendToSortedIndex(const Block & block, size_t offset, size_t limit);
+    void appendToSortedIndex(const ColumnFilePtr & column_file);
+    void rebuildSortedIndex();
+
 public:
     explicit MemTableSet(const BlockPtr & last_schema_, const ColumnFiles & in_memory_files = {})
         : last_schema(last_schema_)
@@ -64,6 +73,7 @@ public:
             bytes += file->getBytes();
             deletes += file->getDeletes();
         }
+        rebuildSortedIndex();
     }
 
     /// Thread safe part start
@@ -105,6 +115,9 @@ public:
     /// Create a constant snapshot for read.
     ColumnFileSetSnapshotPtr createSnapshot(const StorageSnapshotPtr & storage_snap);
 
+    /// The offsets of all rows sorted by (handle, version), or nullptr if the sorted index is not available.
+    MemTableIndex::SortedRowsPtr getSortedRows() const;
+
     /// Build a flush task which will try to flush all column files in this MemTableSet at this moment.
     ColumnFileFlushTaskPtr buildFlushTask(DMContext & context, size_t rows_offset, size_t deletes_offset, size_t flush_version);
 
@@ -43,7 +43,10 @@ DeltaSnapshotPtr DeltaValueSpace::createSnapshot(const DMContext & context, bool
     snap->shared_delta_index = delta_index;
 
     if (!for_update)
+    {
         snap->mem_table_snap = mem_table_set->createSnapshot(storage_snap);
+        snap->mem_table_sorted_rows = mem_table_set->getSortedRows();
+    }
 
     return snap;
 }
@@ -153,21 +156,32 @@ bool DeltaValueReader::shouldPlace(const DMContext & context,
                                    const RowKeyRange & segment_range_,
                                    const RowKeyRange & relevant_range,
                                    UInt64 max_version)
+{
+    return shouldPlace(context, my_delta_index, segment_range_, relevant_range, max_version, delta_snap->getRows(), delta_snap->getDeletes());
+}
+
+bool DeltaValueReader::shouldPlace(const DMContext & context,
+                                   DeltaIndexPtr my_delta_index,
+                                   const RowKeyRange & segment_range_,
+                                   const RowKeyRange & relevant_range,
+                                   UInt64 max_version,
+                                   size_t rows_end,
+                                   size_t deletes_end)
 {
     auto [placed_rows, placed_delete_ranges] = my_delta_index->getPlacedStatus();
 
     // Already placed.
-    if (placed_rows >= delta_snap->getRows() && placed_delete_ranges == delta_snap->getDeletes())
+    if (placed_rows >= rows_end && placed_delete_ranges == deletes_end)
         return false;
 
     if (relevant_range.all() || relevant_range == segment_range_ //
-        || delta_snap->getRows() - placed_rows > context.delta_cache_limit_rows //
-        || placed_delete_ranges != delta_snap->getDeletes())
+        || rows_end - placed_rows > context.delta_cache_limit_rows //
+        || placed_delete_ranges != deletes_end)
         return true;
 
     size_t rows_in_persisted_file_snap = delta_snap->getMemTableSetRowsOffset();
     return persisted_files_reader->shouldPlace(context, relevant_range, max_version, placed_rows)
-        || (mem_table_reader && mem_table_reader->shouldPlace(context, relevant_range, max_version, placed_rows <= rows_in_persisted_file_snap ? 0 : placed_rows - rows_in_persisted_file_snap));
+        || (rows_end > rows_in_persisted_file_snap && mem_table_reader && mem_table_reader->shouldPlace(context, relevant_range, max_version, placed_rows <= rows_in_persisted_file_snap ? 0 : placed_rows - rows_in_persisted_file_snap));
 }
 
 } // namespace DB::DM
@@ -24,7 +24,7 @@ namespace DB
 {
 namespace DM
 {
-void DeltaIndexManager::removeOverflow(std::vector<DeltaIndexPtr> & removed)
+void DeltaIndexManager::removeOverflow(std::vector<DeltaIndexPtr> & removed, bool is_resize)
 {
     size_t queue_size = index_map.size();
     while ((current_size > max_size) && (queue_size > 1))
@@ -47,6 +47,10 @@ void DeltaIndexManager::removeOverflow(std::vector<DeltaIndexPtr> & removed)
         }
 
         current_size -= holder.size;
+        if (is_resize)
+            evicted_size_by_resize += holder.size;
+        else
+            evicted_size_by_capacity += holder.size;
         --queue_size;
         lru_queue.pop_front();
         // Remove it later
@@ -77,12 +81,16 @@ void DeltaIndexManager::refreshRef(const DeltaIndexPtr & index)
         Holder & holder = res.first->second;
         bool inserted = res.second;
 
+        size_t old_size = 0;
         if (inserted)
         {
+            ++misses;
             holder.queue_it = lru_queue.insert(lru_queue.end(), id);
         }
         else
         {
+            ++hits;
+            old_size = holder.size;
             current_size -= holder.size;
             lru_queue.splice(lru_queue.end(), lru_queue, holder.queue_it);
         }
@@ -90,8 +98,11 @@ void DeltaIndexManager::refreshRef(const DeltaIndexPtr & index)
         holder.index = index;
         holder.size = index->getBytes();
         current_size += holder.size;
+        // The growth of index is the cost of placing the new delta rows.
+        if (holder.size > old_size)
+            inserted_size += holder.size - old_size;
 
-        removeOverflow(removed);
+        removeOverflow(removed, /*is_resize*/ false);
         CurrentMetrics::set(CurrentMetrics::DT_DeltaIndexCacheSize, current_size);
     }
 }
@@ -127,6 +138,35 @@ void DeltaIndexManager::deleteRef(const DeltaIndexPtr & index)
     }
 }
 
+void DeltaIndexManager::setMaxBytes(size_t max_bytes)
+{
+    if (max_size == 0)
+        return;
+
+    std::vector<DeltaIndexPtr> removed;
+    {
+        std::lock_guard lock(mutex);
+        max_size = std::max(static_cast<size_t>(1), max_bytes);
+        removeOverflow(removed, /*is_resize*/ true);
+        CurrentMetrics::set(CurrentMetrics::DT_DeltaIndexCacheSize, current_size);
+    }
+}
+
+CacheStats DeltaIndexManager::getCacheStats() const
+{
+    std::lock_guard lock(mutex);
+    CacheStats stats;
+    stats.bytes = current_size;
+    stats.max_bytes = max_size;
+    stats.count = index_map.size();
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.inserted_bytes = inserted_size;
+    stats.evicted_bytes_by_capacity = evicted_size_by_capacity;
+    stats.evicted_bytes_by_resize = evicted_size_by_resize;
+    return stats;
+}
+
 DeltaIndexPtr DeltaIndexManager::getRef(UInt64 index_id)
 {
     if (max_size == 0)
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <Common/CacheManager.h>
 #include <Storages/DeltaMerge/DeltaIndex.h>
 #include <common/logger_useful.h>
 
@@ -23,7 +24,7 @@ namespace DM
 {
 /// This class mange the life time of DeltaIndies in memory.
 /// It will free the most rarely used DeltaIndex when the total memory usage exceeds the threshold.
-class DeltaIndexManager
+class DeltaIndexManager : public IManagedCache
 {
 private:
     // Note that we don't use Common/LRUCache.h here. Because by using it, we cannot implement the correct logic of
@@ -48,14 +49,20 @@ private:
     LRUQueue lru_queue;
 
     size_t current_size = 0;
-    const size_t max_size;
+    size_t max_size;
+
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t inserted_size = 0;
+    size_t evicted_size_by_capacity = 0;
+    size_t evicted_size_by_resize = 0;
 
     Poco::Logger * log;
 
-    std::mutex mutex;
+    mutable std::mutex mutex;
 
 private:
-    void removeOverflow(std::vector<DeltaIndexPtr> & removed);
+    void removeOverflow(std::vector<DeltaIndexPtr> & removed, bool is_resize);
 
 public:
     explicit DeltaIndexManager(size_t max_size_)
@@ -78,6 +85,11 @@ public:
     /// Try to get the DeltaIndex from this manager. Return empty if not found.
     /// Used by test cases.
     DeltaIndexPtr getRef(UInt64 index_id);
+
+    /// Note that it does nothing if isLimit() is false.
+    void setMaxBytes(size_t max_bytes) override;
+
+    CacheStats getCacheStats() const override;
 };
 
 using DeltaIndexManagerPtr = std::shared_ptr<DeltaIndexManager>;
@@ -37,6 +37,7 @@
 #include <common/logger_useful.h>
 
 #include <atomic>
+#include <cmath>
 #include <ext/scope_guard.h>
 
 #if USE_TCMALLOC
@@ -104,12 +105,26 @@ namespace DM
 //   MergeDeltaTaskPool
 // ================================================
 
-std::pair<bool, bool> DeltaMergeStore::MergeDeltaTaskPool::tryAddTask(const BackgroundTask & task, const ThreadType & whom, const size_t max_task_num, const LoggerPtr & log_)
+void DeltaMergeStore::MergeDeltaTaskPool::registerToScheduler(const BackgroundTaskSchedulerPtr & scheduler_, const String & store_name, BackgroundTaskScheduler::Waker waker)
 {
     std::scoped_lock lock(mutex);
-    if (light_tasks.size() + heavy_tasks.size() >= max_task_num)
-        return std::make_pair(false, false);
+    scheduler = scheduler_;
+    store_id = scheduler->registerStore(store_name, std::move(waker));
+    registered = true;
+}
 
+void DeltaMergeStore::MergeDeltaTaskPool::unregisterFromScheduler()
+{
+    std::scoped_lock lock(mutex);
+    if (!registered)
+        return;
+    scheduler->unregisterStore(store_id);
+    tasks.clear();
+    registered = false;
+}
+
+std::pair<bool, bool> DeltaMergeStore::MergeDeltaTaskPool::tryAddTask(const BackgroundTask & task, double score, size_t estimated_bytes, const ThreadType & whom, const size_t max_task_num, const LoggerPtr & log_)
+{
     bool is_heavy = false;
     switch (task.type)
     {
@@ -117,48 +132,73 @@ std::pair<bool, bool> DeltaMergeStore::MergeDeltaTaskPool::tryAddTask(const Back
     case TaskType::Merge:
     case TaskType::MergeDelta:
         is_heavy = true;
-        // reserve some task space for light tasks
-        if (max_task_num > 1 && heavy_tasks.size() >= static_cast<size_t>(max_task_num * 0.9))
-            return std::make_pair(false, is_heavy);
-        heavy_tasks.push(task);
         break;
     case TaskType::Compact:
     case TaskType::Flush:
     case TaskType::PlaceIndex:
         is_heavy = false;
-        // reserve some task space for heavy tasks
-        if (max_task_num > 1 && light_tasks.size() >= static_cast<size_t>(max_task_num * 0.9))
-            return std::make_pair(false, is_heavy);
-        light_tasks.push(task);
         break;
     default:
         throw Exception(fmt::format("Unsupported task type: {}", toString(task.type)));
     }
 
+    std::scoped_lock lock(mutex);
+    if (!registered)
+        return std::make_pair(false, is_heavy);
+
+    BackgroundTaskScheduler::TaskInfo info;
+    info.store_id = store_id;
+    info.segment_id = task.segment->segmentId();
+    info.type = toString(task.type);
+    info.is_heavy = is_heavy;
+    info.score = score;
+    info.estimated_bytes = estimated_bytes;
+    auto task_id = scheduler->addTask(info, max_task_num);
+    if (task_id == 0)
+        return std::make_pair(false, is_heavy);
+    auto & added = tasks.emplace(task_id, task).first->second;
+    added.task_id = task_id;
+
     LOG_FMT_DEBUG(
         log_,
-        "Segment [{}] task [{}] add to background task pool by [{}]",
+        "Segment [{}] task [{}] add to background task pool by [{}], score {:.3f}",
         task.segment->segmentId(),
         toString(task.type),
-        toString(whom));
+        toString(whom),
+        score);
     return std::make_pair(true, is_heavy);
 }
 
 DeltaMergeStore::BackgroundTask DeltaMergeStore::MergeDeltaTaskPool::nextTask(bool is_heavy, const LoggerPtr & log_)
 {
     std::scoped_lock lock(mutex);
+    if (!registered)
+        return {};
 
-    auto & tasks = is_heavy ? heavy_tasks : light_tasks;
-    if (tasks.empty())
+    auto task_id = scheduler->tryTakeTask(store_id, is_heavy);
+    if (task_id == 0)
+        return {};
+    auto it = tasks.find(task_id);
+    if (unlikely(it == tasks.end()))
+    {
+        scheduler->finishTask(task_id);
         return {};
-    auto task = tasks.front();
-    tasks.pop();
+    }
+    auto task = std::move(it->second);
+    tasks.erase(it);
 
     LOG_FMT_DEBUG(log_, "Segment [{}] task [{}] pop from background task pool", task.segment->segmentId(), toString(task.type));
 
     return task;
 }
 
+void DeltaMergeStore::MergeDeltaTaskPool::finishTask(const BackgroundTask & task)
+{
+    std::scoped_lock lock(mutex);
+    if (scheduler)
+        scheduler->finishTask(task.task_id);
+}
+
 // ================================================
 //   DeltaMergeStore
 // ================================================
@@ -345,6 +385,17 @@ void DeltaMergeStore::setUpBackgroundTask(const DMContextPtr & dm_context)
 
     blockable_background_pool_handle = blockable_background_pool.addTask([this] { return handleBackgroundTask(true); });
 
+    // The scheduler wakes up this store when its tasks are the most valuable ones among all the stores.
+    background_tasks.registerToScheduler(
+        global_context.getDMBackgroundTaskScheduler(),
+        fmt::format("{}.{}", db_name, table_name),
+        [light_handle = background_task_handle, heavy_handle = blockable_background_pool_handle](bool is_heavy) {
+            if (is_heavy)
+                heavy_handle->wake();
+            else
+                light_handle->wake();
+        });
+
     // Do place delta index.
     for (auto & [end, segment] : segments)
     {
@@ -488,6 +539,7 @@ void DeltaMergeStore::shutdown()
     storage_pool->shutdown();
     storage_pool->dataUnregisterExternalPagesCallbacks(storage_pool->getNamespaceId());
 
+    background_tasks.unregisterFromScheduler();
     background_pool.removeTask(background_task_handle);
     blockable_background_pool.removeTask(blockable_background_pool_handle);
     background_task_handle = nullptr;
@@ -1187,12 +1239,18 @@ BlockInputStreams DeltaMergeStore::read(const Context & db_context,
                                         const String & tracing_id,
                                         size_t expected_block_size,
                                         const SegmentIdSet & read_segments,
-                                        size_t extra_table_id_index)
+                                        size_t extra_table_id_index,
+                                        const TopNThresholdPtr & topn_threshold)
 {
     // Use the id from MPP/Coprocessor level as tracing_id
     auto dm_context = newDMContext(db_context, db_settings, tracing_id);
+    dm_context->topn_threshold = topn_threshold;
 
     SegmentReadTasks tasks = getReadTasksByRanges(*dm_context, sorted_ranges, num_streams, read_segments);
+    // The tasks are in the order of handle. Read the segments with larger handles first for TopN ordered by handle
+    // descending, so that the threshold is tightened soon and more packs of the rest segments are skipped.
+    if (topn_threshold && topn_threshold->getColumnId() == EXTRA_HANDLE_COLUMN_ID && topn_threshold->isDesc())
+        tasks.reverse();
 
     auto tracing_logger = Logger::get(log->name(), dm_context->tracing_id);
     LOG_FMT_DEBUG(tracing_logger, "Read create segment snapshot done");
@@ -1378,11 +1436,42 @@ void DeltaMergeStore::checkSegmentUpdate(const DMContextPtr & dm_context, const
     fiu_do_on(FailPoints::force_triggle_background_merge_delta, { should_background_merge_delta = true; });
     fiu_do_on(FailPoints::force_triggle_foreground_flush, { should_foreground_flush = true; });
 
+    // The score of a task decides the order to run background tasks across all the stores on this node.
+    // Merging the delta of a segment which is read frequently or is close to a write stall is more valuable.
+    auto get_task_score = [&](const BackgroundTask & task) -> std::pair<double, size_t> {
+        double write_stall_risk = std::min(1.0,
+                                           std::max(static_cast<double>(delta_check_rows) / std::max(forceMergeDeltaRows(dm_context), 1UL),
+                                                    static_cast<double>(delta_check_bytes) / std::max(forceMergeDeltaBytes(dm_context), 1UL)));
+        double delta_ratio = static_cast<double>(delta_bytes) / std::max(segment_bytes, 1UL);
+        double read_hotness = std::min(1.0, std::log2(1.0 + task.segment->getReadCount()) / 10);
+        switch (task.type)
+        {
+        case TaskType::Flush:
+            return {1.0 + std::min(1.0, static_cast<double>(unsaved_bytes) / std::max(delta_cache_limit_bytes * 3, 1UL)), delta_bytes};
+        case TaskType::MergeDelta:
+            return {delta_ratio + 2 * write_stall_risk + read_hotness, segment_bytes};
+        case TaskType::Split:
+        {
+            auto bytes = task.segment->getEstimatedBytes();
+            return {0.5 + std::min(1.0, static_cast<double>(bytes) / std::max(segment_limit_bytes * 3, 1UL)), bytes};
+        }
+        case TaskType::Merge:
+            return {0.2, segment_bytes + task.next_segment->getEstimatedBytes()};
+        case TaskType::Compact:
+            return {0.3 + read_hotness / 2, delta_bytes};
+        case TaskType::PlaceIndex:
+            return {0.5 + read_hotness, 0};
+        default:
+            return {0, 0};
+        }
+    };
+
     auto try_add_background_task = [&](const BackgroundTask & task) {
         if (shutdown_called.load(std::memory_order_relaxed))
             return;
 
-        auto [added, heavy] = background_tasks.tryAddTask(task, thread_type, std::max(id_to_segment.size() * 2, background_pool.getNumberOfThreads() * 3), log);
+        auto [score, estimated_bytes] = get_task_score(task);
+        auto [added, heavy] = background_tasks.tryAddTask(task, score, estimated_bytes, thread_type, std::max(id_to_segment.size() * 2, background_pool.getNumberOfThreads() * 3), log);
         // Prevent too many tasks.
         if (!added)
             return;
@@ -1573,6 +1662,7 @@ bool DeltaMergeStore::handleBackgroundTask(bool heavy)
     auto task = background_tasks.nextTask(heavy, log);
     if (!task)
         return false;
+    SCOPE_EXIT({ background_tasks.finishTask(task); });
 
     // Update GC safe point before background task
     // Foreground task don't get GC safe point from remote, but we better make it as up to date as possible.
@@ -2178,7 +2268,10 @@ SegmentPtr DeltaMergeStore::segmentMergeDelta(
 
     WriteBatches wbs(*storage_pool, dm_context.getWriteLimiter());
 
-    auto new_stable = segment->prepareMergeDelta(dm_context, schema_snap, segment_snap, wbs);
+    // Only the merge delta triggered by writes could rewrite the stable partially, the others are expected to
+    // compact the whole segment.
+    bool allow_partial = run_thread == TaskRunThread::BackgroundThreadPool;
+    auto new_stable = segment->prepareMergeDelta(dm_context, schema_snap, segment_snap, wbs, allow_partial);
     wbs.writeLogAndData();
     new_stable->enableDMFilesGC();
 
@@ -2616,6 +2709,7 @@ SegmentReadTasks DeltaMergeStore::getReadTasksByRanges(
                 auto segment_snap = segment->createSnapshot(dm_context, false, CurrentMetrics::DT_SnapshotOfRead);
                 if (unlikely(!segment_snap))
                     throw Exception("Failed to get segment snap", ErrorCodes::LOGICAL_ERROR);
+                segment->increaseReadCount();
                 tasks.push_back(std::make_shared<SegmentReadTask>(segment, segment_snap));
             }
 
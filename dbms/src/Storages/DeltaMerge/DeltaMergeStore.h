@@ -20,6 +20,7 @@
 #include <Interpreters/Context.h>
 #include <Storages/AlterCommands.h>
 #include <Storages/BackgroundProcessingPool.h>
+#include <Storages/DeltaMerge/BackgroundTaskScheduler.h>
 #include <Storages/DeltaMerge/DeltaMergeDefines.h>
 #include <Storages/DeltaMerge/RowKeyRange.h>
 #include <Storages/DeltaMerge/SegmentReadTaskPool.h>
@@ -42,6 +43,8 @@ using SegmentPtr = std::shared_ptr<Segment>;
 using SegmentPair = std::pair<SegmentPtr, SegmentPtr>;
 class RSOperator;
 using RSOperatorPtr = std::shared_ptr<RSOperator>;
+class TopNThreshold;
+using TopNThresholdPtr = std::shared_ptr<TopNThreshold>;
 struct DMContext;
 using DMContextPtr = std::shared_ptr<DMContext>;
 using NotCompress = std::unordered_set<ColId>;
@@ -263,6 +266,9 @@ public:
         SegmentPtr segment;
         SegmentPtr next_segment;
 
+        /// Assigned by the BackgroundTaskScheduler when the task is queued.
+        UInt64 task_id = 0;
+
         explicit operator bool() const { return segment != nullptr; }
     };
 
@@ -274,9 +280,12 @@ public:
     public:
 #endif
 
-        using TaskQueue = std::queue<BackgroundTask, std::list<BackgroundTask>>;
-        TaskQueue light_tasks;
-        TaskQueue heavy_tasks;
+        /// The queued tasks by task id. The order to run them is decided by the node-level scheduler.
+        std::unordered_map<UInt64, BackgroundTask> tasks;
+
+        BackgroundTaskSchedulerPtr scheduler;
+        UInt64 store_id = 0;
+        bool registered = false;
 
         std::mutex mutex;
 
@@ -284,14 +293,20 @@ public:
         size_t length()
         {
             std::scoped_lock lock(mutex);
-            return light_tasks.size() + heavy_tasks.size();
+            return tasks.size();
         }
 
+        void registerToScheduler(const BackgroundTaskSchedulerPtr & scheduler_, const String & store_name, BackgroundTaskScheduler::Waker waker);
+        /// Drop all the queued tasks, the running tasks are not affected.
+        void unregisterFromScheduler();
+
         // first element of return value means whether task is added or not
         // second element of return value means whether task is heavy or not
-        std::pair<bool, bool> tryAddTask(const BackgroundTask & task, const ThreadType & whom, size_t max_task_num, const LoggerPtr & log_);
+        std::pair<bool, bool> tryAddTask(const BackgroundTask & task, double score, size_t estimated_bytes, const ThreadType & whom, size_t max_task_num, const LoggerPtr & log_);
 
         BackgroundTask nextTask(bool is_heavy, const LoggerPtr & log_);
+
+        void finishTask(const BackgroundTask & task);
     };
 
     DeltaMergeStore(Context & db_context, //
@@ -355,6 +370,7 @@ public:
 
     /// Read rows with MVCC filtering
     /// `sorted_ranges` should be already sorted and merged
+    /// `topn_threshold` is published by the TopN on the result, the stable packs which can not enter it are skipped.
     BlockInputStreams read(const Context & db_context,
                            const DB::Settings & db_settings,
                            const ColumnDefines & columns_to_read,
@@ -365,7 +381,8 @@ public:
                            const String & tracing_id,
                            size_t expected_block_size = DEFAULT_BLOCK_SIZE,
                            const SegmentIdSet & read_segments = {},
-                           size_t extra_table_id_index = InvalidColumnID);
+                           size_t extra_table_id_index = InvalidColumnID,
+                           const TopNThresholdPtr & topn_threshold = nullptr);
 
     /// Force flush all data to disk.
     void flushCache(const Context & context, const RowKeyRange & range)
@@ -55,6 +55,7 @@ DMFileBlockInputStreamPtr DMFileBlockInputStreamBuilder::build(const DMFilePtr &
         file_provider,
         read_limiter,
         tracing_id);
+    pack_filter.setTopNThreshold(topn_threshold);
 
     DMFileReader reader(
         dmfile,
@@ -67,6 +68,7 @@ DMFileBlockInputStreamPtr DMFileBlockInputStreamBuilder::build(const DMFilePtr &
         enable_column_cache,
         column_cache,
         aio_threshold,
+        read_prefetch_quota,
         max_read_buffer_size,
         file_provider,
         read_limiter,
@@ -93,6 +93,13 @@ public:
         return *this;
     }
 
+    // Skip the packs which can not enter the result of TopN while reading, see `DMFilePackFilter::tryToSkipByTopN`.
+    DMFileBlockInputStreamBuilder & setTopNThreshold(const TopNThresholdPtr & topn_threshold_)
+    {
+        topn_threshold = topn_threshold_;
+        return *this;
+    }
+
     DMFileBlockInputStreamBuilder & setColumnCache(const ColumnCachePtr & column_cache_)
     {
         // note that `enable_column_cache` is controlled by Settings (see `setFromSettings`)
@@ -111,6 +118,14 @@ public:
         return *this;
     }
 
+    // The memory that can be used to prefetch the data when reading with direct I/O.
+    // Prefetching is disabled if it is not set.
+    DMFileBlockInputStreamBuilder & setReadPrefetchQuota(const ReadPrefetchQuotaPtr & read_prefetch_quota_)
+    {
+        read_prefetch_quota = read_prefetch_quota_;
+        return *this;
+    }
+
     DMFileBlockInputStreamBuilder & setTracingID(const String & tracing_id_)
     {
         tracing_id = tracing_id_;
@@ -144,6 +159,7 @@ private:
     RSOperatorPtr rs_filter;
     // packs filter (filter by pack index)
     IdSetPtr read_packs;
+    TopNThresholdPtr topn_threshold;
     MarkCachePtr mark_cache;
     MinMaxIndexCachePtr index_cache;
     // column cache
@@ -151,6 +167,7 @@ private:
     ColumnCachePtr column_cache;
     ReadLimiterPtr read_limiter;
     size_t aio_threshold;
+    ReadPrefetchQuotaPtr read_prefetch_quota;
     size_t max_read_buffer_size;
     size_t rows_threshold_per_read = DMFILE_READ_ROWS_THRESHOLD;
     bool read_one_pack_every_time = false;
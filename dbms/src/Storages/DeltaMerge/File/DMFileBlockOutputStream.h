@@ -47,7 +47,8 @@ public:
                 CompressionSettings(context.getSettingsRef().dt_compression_method, context.getSettingsRef().dt_compression_level),
                 context.getSettingsRef().min_compress_block_size,
                 context.getSettingsRef().max_compress_block_size,
-                flags})
+                flags,
+                context.getSettingsRef().dt_dmfile_write_threads})
     {
     }
 
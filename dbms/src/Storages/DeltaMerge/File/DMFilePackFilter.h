@@ -22,6 +22,7 @@
 #include <Storages/DeltaMerge/File/DMFile.h>
 #include <Storages/DeltaMerge/Filter/FilterHelper.h>
 #include <Storages/DeltaMerge/Filter/RSOperator.h>
+#include <Storages/DeltaMerge/Filter/TopNThreshold.h>
 #include <Storages/DeltaMerge/RowKeyRange.h>
 
 namespace ProfileEvents
@@ -29,6 +30,7 @@ namespace ProfileEvents
 extern const Event DMFileFilterNoFilter;
 extern const Event DMFileFilterAftPKAndPackSet;
 extern const Event DMFileFilterAftRoughSet;
+extern const Event DMFileFilterSkippedByTopN;
 } // namespace ProfileEvents
 
 namespace DB
@@ -76,6 +78,22 @@ public:
         return minmax_index->getStringMinMax(pack_id).first;
     }
 
+    Handle getMaxHandle(size_t pack_id)
+    {
+        if (!param.indexes.count(EXTRA_HANDLE_COLUMN_ID))
+            tryLoadIndex(EXTRA_HANDLE_COLUMN_ID);
+        auto & minmax_index = param.indexes.find(EXTRA_HANDLE_COLUMN_ID)->second.minmax;
+        return minmax_index->getIntMinMax(pack_id).second;
+    }
+
+    StringRef getMaxStringHandle(size_t pack_id)
+    {
+        if (!param.indexes.count(EXTRA_HANDLE_COLUMN_ID))
+            tryLoadIndex(EXTRA_HANDLE_COLUMN_ID);
+        auto & minmax_index = param.indexes.find(EXTRA_HANDLE_COLUMN_ID)->second.minmax;
+        return minmax_index->getStringMinMax(pack_id).second;
+    }
+
     UInt64 getMaxVersion(size_t pack_id)
     {
         if (!param.indexes.count(VERSION_COLUMN_ID))
@@ -84,6 +102,35 @@ public:
         return minmax_index->getUInt64MinMax(pack_id).second;
     }
 
+    void setTopNThreshold(const TopNThresholdPtr & topn_threshold_) { topn_threshold = topn_threshold_; }
+
+    /// Skip the pack if the values of the column of `topn_threshold` in it are all ordered after the threshold.
+    /// It is checked right before reading the pack, so that the threshold tightened during the read takes effect.
+    /// Every pack is checked only once, because the skipped rows could have been reported to the readers already.
+    /// The pack is not skipped if the previous pack holds some old versions of rows, which could be overwritten
+    /// by the versions in this pack, or the old versions would be visible after this pack is skipped.
+    void tryToSkipByTopN(size_t pack_id)
+    {
+        if (!topn_threshold || pack_id < topn_checked_packs)
+            return;
+        topn_checked_packs = pack_id + 1;
+
+        const auto & pack_stats = dmfile->getPackStats();
+        if (!use_packs[pack_id] || pack_id == 0 || pack_stats[pack_id - 1].not_clean > 0)
+            return;
+
+        tryLoadIndex(topn_threshold->getColumnId());
+        auto iter = param.indexes.find(topn_threshold->getColumnId());
+        if (iter == param.indexes.end() || !iter->second.minmax->hasValue(pack_id))
+            return;
+        auto [min, max] = iter->second.minmax->getIntMinMax(pack_id);
+        if (topn_threshold->canSkip(min, max))
+        {
+            use_packs[pack_id] = 0;
+            ProfileEvents::increment(ProfileEvents::DMFileFilterSkippedByTopN);
+        }
+    }
+
     // Get valid rows and bytes after filter invalid packs by handle_range and filter
     std::pair<size_t, size_t> validRowsAndBytes()
     {
@@ -300,6 +347,10 @@ private:
     std::vector<RSResult> handle_res;
     std::vector<UInt8> use_packs;
 
+    TopNThresholdPtr topn_threshold;
+    // The packs before it have been checked by `topn_threshold`.
+    size_t topn_checked_packs = 0;
+
     LoggerPtr log;
     ReadLimiterPtr read_limiter;
 };
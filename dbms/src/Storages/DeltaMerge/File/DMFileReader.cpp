@@ -16,6 +16,7 @@
 #include <Common/escapeForFileName.h>
 #include <DataTypes/IDataType.h>
 #include <Encryption/FileProvider.h>
+#include <Encryption/ReadBufferFromFileProvider.h>
 #include <Encryption/createReadBufferFromFileBaseByFileProvider.h>
 #include <Poco/File.h>
 #include <Storages/DeltaMerge/File/DMFileBlockInputStream.h>
@@ -38,6 +39,12 @@ extern const int LOGICAL_ERROR;
 }
 namespace DM
 {
+namespace
+{
+/// The max number of chunks prefetched by a column stream when reading with direct I/O.
+constexpr size_t DIRECT_READ_PREFETCH_CHUNKS = 4;
+} // namespace
+
 DMFileReader::Stream::Stream(
     DMFileReader & reader,
     ColId col_id,
@@ -129,37 +136,10 @@ DMFileReader::Stream::Stream(
     }
     else if (!reader.dmfile->configuration)
     {
-        for (size_t i = 0; i < packs;)
+        for (const auto & range : getRangesToRead(reader, data_file_size))
         {
-            if (!use_packs[i])
-            {
-                ++i;
-                continue;
-            }
-            size_t cur_offset_in_file = getOffsetInFile(i);
-            size_t end = i + 1;
-            // First find the end of current available range.
-            while (end < packs && use_packs[end])
-                ++end;
-
-            // Second If the end of range is inside the block, we will need to read it too.
-            if (end < packs)
-            {
-                size_t last_offset_in_file = getOffsetInFile(end);
-                if (getOffsetInDecompressedBlock(end) > 0)
-                {
-                    while (end < packs && getOffsetInFile(end) == last_offset_in_file)
-                        ++end;
-                }
-            }
-
-            size_t range_end_in_file = (end == packs) ? data_file_size : getOffsetInFile(end);
-
-            size_t range = range_end_in_file - cur_offset_in_file;
-            buffer_size = std::max(buffer_size, range);
-
-            estimated_size += range;
-            i = end;
+            buffer_size = std::max(buffer_size, range.size);
+            estimated_size += range.size;
         }
     }
     else
@@ -181,13 +161,37 @@ DMFileReader::Stream::Stream(
                   aio_threshold,
                   max_read_buffer_size);
 
-    if (!reader.dmfile->configuration)
+    // Read the large columns with direct I/O to avoid polluting the page cache of OS, and prefetch the
+    // ranges to read because there is no readahead of OS then. Single file mode reads one pack every time,
+    // it is not worth doing so.
+    if (!reader.single_file_mode && aio_threshold != 0 && estimated_size >= aio_threshold)
+    {
+        RandomAccessFilePtr file = DirectReadFile::openFile([&](int flags) {
+            return reader.file_provider->newRandomAccessFile(data_path, reader.dmfile->encryptionDataPath(file_name_base), read_limiter, flags);
+        });
+        file = std::make_shared<DirectReadFile>(file, getRangesToRead(reader, data_file_size), reader.read_prefetch_quota, DIRECT_READ_PREFETCH_CHUNKS);
+
+        if (!reader.dmfile->configuration)
+        {
+            buf = std::make_unique<CompressedReadBufferFromFileProvider<true>>(
+                std::make_unique<ReadBufferFromFileProvider>(file, buffer_size));
+        }
+        else
+        {
+            buf = std::make_unique<CompressedReadBufferFromFileProvider<false>>(
+                createReadBufferFromFileBaseByFileProvider(file,
+                                                           estimated_size,
+                                                           reader.dmfile->configuration->getChecksumAlgorithm(),
+                                                           reader.dmfile->configuration->getChecksumFrameLength()));
+        }
+    }
+    else if (!reader.dmfile->configuration)
     {
         buf = std::make_unique<CompressedReadBufferFromFileProvider<true>>(reader.file_provider,
                                                                            reader.dmfile->colDataPath(file_name_base),
                                                                            reader.dmfile->encryptionDataPath(file_name_base),
                                                                            estimated_size,
-                                                                           aio_threshold,
+                                                                           /*aio_threshold*/ 0,
                                                                            read_limiter,
                                                                            buffer_size);
     }
@@ -204,6 +208,59 @@ DMFileReader::Stream::Stream(
     }
 }
 
+std::vector<DirectReadFile::Range> DMFileReader::Stream::getRangesToRead(const DMFileReader & reader, size_t data_file_size) const
+{
+    // The offsets in marks of checksum framed files don't count the frame headers,
+    // the ranges are extended to the whole frames.
+    size_t frame_size = 0;
+    size_t physical_frame_size = 0;
+    if (reader.dmfile->configuration)
+    {
+        frame_size = reader.dmfile->configuration->getChecksumFrameLength();
+        physical_frame_size = frame_size + reader.dmfile->configuration->createUnifiedDigest()->headerSize();
+    }
+    auto to_physical_begin = [&](size_t offset) {
+        return frame_size ? offset / frame_size * physical_frame_size : offset;
+    };
+    auto to_physical_end = [&](size_t offset) {
+        return frame_size ? std::min(data_file_size, (offset + frame_size - 1) / frame_size * physical_frame_size) : offset;
+    };
+
+    std::vector<DirectReadFile::Range> ranges;
+    const auto & use_packs = reader.pack_filter.getUsePacks();
+    size_t packs = use_packs.size();
+    for (size_t i = 0; i < packs;)
+    {
+        if (!use_packs[i])
+        {
+            ++i;
+            continue;
+        }
+        size_t cur_offset_in_file = to_physical_begin(getOffsetInFile(i));
+        size_t end = i + 1;
+        // First find the end of current available range.
+        while (end < packs && use_packs[end])
+            ++end;
+
+        // Second If the end of range is inside the block, we will need to read it too.
+        if (end < packs)
+        {
+            size_t last_offset_in_file = getOffsetInFile(end);
+            if (getOffsetInDecompressedBlock(end) > 0)
+            {
+                while (end < packs && getOffsetInFile(end) == last_offset_in_file)
+                    ++end;
+            }
+        }
+
+        size_t range_end_in_file = (end == packs) ? data_file_size : to_physical_end(getOffsetInFile(end));
+
+        ranges.push_back(DirectReadFile::Range{cur_offset_in_file, range_end_in_file - cur_offset_in_file});
+        i = end;
+    }
+    return ranges;
+}
+
 DMFileReader::DMFileReader(
     const DMFilePtr & dmfile_,
     const ColumnDefines & read_columns_,
@@ -218,6 +275,7 @@ DMFileReader::DMFileReader(
     bool enable_column_cache_,
     const ColumnCachePtr & column_cache_,
     size_t aio_threshold,
+    const ReadPrefetchQuotaPtr & read_prefetch_quota_,
     size_t max_read_buffer_size,
     const FileProviderPtr & file_provider_,
     const ReadLimiterPtr & read_limiter,
@@ -238,6 +296,7 @@ DMFileReader::DMFileReader(
     , column_cache(column_cache_)
     , rows_threshold_per_read(rows_threshold_per_read_)
     , file_provider(file_provider_)
+    , read_prefetch_quota(read_prefetch_quota_)
     , log(Logger::get("DMFileReader", tracing_id_))
 {
     for (const auto & cd : read_columns)
@@ -275,8 +334,11 @@ bool DMFileReader::getSkippedRows(size_t & skip_rows)
     skip_rows = 0;
     const auto & use_packs = pack_filter.getUsePacks();
     const auto & pack_stats = dmfile->getPackStats();
-    for (; next_pack_id < use_packs.size() && !use_packs[next_pack_id]; ++next_pack_id)
+    for (; next_pack_id < use_packs.size(); ++next_pack_id)
     {
+        pack_filter.tryToSkipByTopN(next_pack_id);
+        if (use_packs[next_pack_id])
+            break;
         skip_rows += pack_stats[next_pack_id].rows;
     }
     return next_pack_id < use_packs.size();
@@ -314,10 +376,13 @@ Block DMFileReader::read()
 
     const std::vector<RSResult> & handle_res = pack_filter.getHandleRes(); // alias of handle_res in pack_filter
     RSResult expected_handle_res = handle_res[next_pack_id];
-    for (; next_pack_id < use_packs.size() && use_packs[next_pack_id] && read_rows < rows_threshold_per_read; ++next_pack_id)
+    for (; next_pack_id < use_packs.size() && read_rows < rows_threshold_per_read; ++next_pack_id)
     {
         if (read_pack_limit != 0 && next_pack_id - start_pack_id >= read_pack_limit)
             break;
+        pack_filter.tryToSkipByTopN(next_pack_id);
+        if (!use_packs[next_pack_id])
+            break;
         if (enable_clean_read && handle_res[next_pack_id] != expected_handle_res)
             break;
 
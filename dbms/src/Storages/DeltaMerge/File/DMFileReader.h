@@ -16,6 +16,7 @@
 
 #include <DataStreams/MarkInCompressedFile.h>
 #include <Encryption/CompressedReadBufferFromFileProvider.h>
+#include <Storages/DeltaMerge/File/DirectReadFile.h>
 #include <Storages/DeltaMerge/DeltaMergeDefines.h>
 #include <Storages/DeltaMerge/DeltaMergeHelpers.h>
 #include <Storages/DeltaMerge/File/ColumnCache.h>
@@ -47,6 +48,9 @@ public:
                const LoggerPtr & log,
                const ReadLimiterPtr & read_limiter);
 
+        /// The ranges of data file to read, which are prefetched when reading with direct I/O.
+        std::vector<DirectReadFile::Range> getRangesToRead(const DMFileReader & reader, size_t data_file_size) const;
+
         const bool single_file_mode;
         double avg_size_hint;
         MarksInCompressedFilePtr marks;
@@ -84,7 +88,9 @@ public:
         const MarkCachePtr & mark_cache_,
         bool enable_column_cache_,
         const ColumnCachePtr & column_cache_,
+        // Read with direct I/O when the estimated read size of a column is not less than aio_threshold.
         size_t aio_threshold,
+        const ReadPrefetchQuotaPtr & read_prefetch_quota_,
         size_t max_read_buffer_size,
         const FileProviderPtr & file_provider_,
         const ReadLimiterPtr & read_limiter,
@@ -141,6 +147,7 @@ private:
     size_t next_pack_id = 0;
 
     FileProviderPtr file_provider;
+    ReadPrefetchQuotaPtr read_prefetch_quota;
 
     LoggerPtr log;
 };
@@ -12,7 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <Common/DynamicThreadPool.h>
 #include <Common/TiFlashException.h>
+#include <Common/typeid_cast.h>
+#include <DataTypes/DataTypeNullable.h>
 #include <Storages/DeltaMerge/DeltaMergeHelpers.h>
 #include <Storages/DeltaMerge/File/DMFileWriter.h>
 
@@ -27,6 +30,58 @@ namespace DB
 {
 namespace DM
 {
+namespace
+{
+/// Don't write in parallel if the columns of every thread are less than this, the scheduling cost is not worth it.
+constexpr size_t MIN_COLUMNS_PER_WRITE_TASK = 4;
+
+/// The element type of the substream for lightweight compression. Returns Unknown if the substream is not made up of
+/// fixed-width numbers, and the data will be compressed by LZ4 instead.
+LightweightDataType getLightweightDataType(const IDataType & type, const IDataType::SubstreamPath & substream_path)
+{
+    if (IDataType::isNullMap(substream_path))
+        return LightweightDataType::UInt8;
+    if (!substream_path.empty() && substream_path.back().type == IDataType::Substream::ArraySizes)
+        return LightweightDataType::UInt64;
+
+    const auto & data_type = type.isNullable() ? *typeid_cast<const DataTypeNullable &>(type).getNestedType() : type;
+    switch (data_type.getTypeId())
+    {
+    case TypeIndex::UInt8:
+        return LightweightDataType::UInt8;
+    case TypeIndex::UInt16:
+    case TypeIndex::Date:
+        return LightweightDataType::UInt16;
+    case TypeIndex::UInt32:
+    case TypeIndex::DateTime:
+        return LightweightDataType::UInt32;
+    case TypeIndex::UInt64:
+    case TypeIndex::MyDate:
+    case TypeIndex::MyDateTime:
+        return LightweightDataType::UInt64;
+    case TypeIndex::Int8:
+    case TypeIndex::Enum8:
+        return LightweightDataType::Int8;
+    case TypeIndex::Int16:
+    case TypeIndex::Enum16:
+        return LightweightDataType::Int16;
+    case TypeIndex::Int32:
+    case TypeIndex::Decimal32:
+        return LightweightDataType::Int32;
+    case TypeIndex::Int64:
+    case TypeIndex::Decimal64:
+    case TypeIndex::MyTime:
+        return LightweightDataType::Int64;
+    case TypeIndex::Float32:
+        return LightweightDataType::Float32;
+    case TypeIndex::Float64:
+        return LightweightDataType::Float64;
+    default:
+        return LightweightDataType::Unknown;
+    }
+}
+} // namespace
+
 DMFileWriter::DMFileWriter(const DMFilePtr & dmfile_,
                            const ColumnDefines & write_columns_,
                            const FileProviderPtr & file_provider_,
@@ -103,11 +158,14 @@ void DMFileWriter::addStreams(ColId col_id, DataTypePtr type, bool do_index)
 {
     auto callback = [&](const IDataType::SubstreamPath & substream_path) {
         const auto stream_name = DMFile::getFileNameBase(col_id, substream_path);
+        auto compression_settings = options.compression_settings;
+        if (compression_settings.method == CompressionMethod::LIGHTWEIGHT)
+            compression_settings.data_type = getLightweightDataType(*type, substream_path);
         auto stream = std::make_unique<Stream>(
             dmfile,
             stream_name,
             type,
-            options.compression_settings,
+            compression_settings,
             options.max_compress_block_size,
             file_provider,
             write_limiter,
@@ -131,15 +189,16 @@ void DMFileWriter::write(const Block & block, const BlockProperty & block_proper
 
     const ColumnVector<UInt8> * del_mark = !del_mark_column ? nullptr : static_cast<const ColumnVector<UInt8> *>(del_mark_column.get());
 
-    for (auto & cd : write_columns)
-    {
-        const auto & col = getByColumnId(block, cd.id).column;
-        writeColumn(cd.id, *cd.type, *col, del_mark);
+    forEachColumn([&](const ColumnDefine & cd) {
+        writeColumn(cd.id, *cd.type, *getByColumnId(block, cd.id).column, del_mark);
+    });
 
+    for (const auto & cd : write_columns)
+    {
         if (cd.id == VERSION_COLUMN_ID)
-            stat.first_version = col->get64(0);
+            stat.first_version = getByColumnId(block, cd.id).column->get64(0);
         else if (cd.id == TAG_COLUMN_ID)
-            stat.first_tag = static_cast<UInt8>(col->get64(0));
+            stat.first_tag = static_cast<UInt8>(getByColumnId(block, cd.id).column->get64(0));
     }
 
     if (!options.flags.isSingleFile())
@@ -162,10 +221,7 @@ void DMFileWriter::finalize()
         pack_stat_file->sync();
     }
 
-    for (auto & cd : write_columns)
-    {
-        finalizeColumn(cd.id, cd.type);
-    }
+    forEachColumn([&](const ColumnDefine & cd) { finalizeColumn(cd.id, cd.type); });
 
     if (options.flags.isSingleFile())
     {
@@ -178,6 +234,53 @@ void DMFileWriter::finalize()
     }
 }
 
+void DMFileWriter::forEachColumn(const std::function<void(const ColumnDefine &)> & func)
+{
+    size_t tasks = std::min(options.write_threads, write_columns.size() / MIN_COLUMNS_PER_WRITE_TASK);
+    if (options.flags.isSingleFile() || tasks <= 1 || !DynamicThreadPool::global_instance)
+    {
+        for (const auto & cd : write_columns)
+            func(cd);
+        return;
+    }
+
+    // The columns are assigned by round robin, so that the wide columns next to each other are spread.
+    auto run_task = [&](size_t task_id) {
+        for (size_t i = task_id; i < write_columns.size(); i += tasks)
+            func(write_columns[i]);
+    };
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(tasks - 1);
+    for (size_t task_id = 1; task_id < tasks; ++task_id)
+        futures.push_back(DynamicThreadPool::global_instance->schedule(true, run_task, task_id));
+
+    // Wait for all the tasks even if some of them fail, because they are referring to the data of this thread.
+    std::exception_ptr exception;
+    try
+    {
+        run_task(0);
+    }
+    catch (...)
+    {
+        exception = std::current_exception();
+    }
+    for (auto & future : futures)
+    {
+        try
+        {
+            future.get();
+        }
+        catch (...)
+        {
+            if (!exception)
+                exception = std::current_exception();
+        }
+    }
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
 void DMFileWriter::writeColumn(ColId col_id, const IDataType & type, const IColumn & column, const ColumnVector<UInt8> * del_mark)
 {
     size_t rows = column.size();
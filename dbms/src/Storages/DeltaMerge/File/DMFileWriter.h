@@ -190,14 +190,21 @@ public:
         size_t min_compress_block_size;
         size_t max_compress_block_size;
         Flags flags;
+        // The max threads to compress and write the column streams in parallel. Only works in folder mode.
+        size_t write_threads = 1;
 
         Options() = default;
 
-        Options(CompressionSettings compression_settings_, size_t min_compress_block_size_, size_t max_compress_block_size_, Flags flags_)
+        Options(CompressionSettings compression_settings_,
+                size_t min_compress_block_size_,
+                size_t max_compress_block_size_,
+                Flags flags_,
+                size_t write_threads_ = 1)
             : compression_settings(compression_settings_)
             , min_compress_block_size(min_compress_block_size_)
             , max_compress_block_size(max_compress_block_size_)
             , flags(flags_)
+            , write_threads(write_threads_)
         {
         }
 
@@ -206,6 +213,7 @@ public:
             , min_compress_block_size(from.min_compress_block_size)
             , max_compress_block_size(from.max_compress_block_size)
             , flags(from.flags)
+            , write_threads(from.write_threads)
         {
             flags.setSingleFile(file->isSingleFileMode());
         }
@@ -228,6 +236,12 @@ public:
     }
 
 private:
+    /// Call `func` for every column in `write_columns`.
+    /// In folder mode, the streams of different columns are independent, so the columns are split into groups
+    /// and the groups are processed in parallel. The memory of every stream is bounded by max_compress_block_size,
+    /// and every stream is still written by one thread in order.
+    void forEachColumn(const std::function<void(const ColumnDefine &)> & func);
+
     void finalizeColumn(ColId col_id, DataTypePtr type);
     void writeColumn(ColId col_id, const IDataType & type, const IColumn & column, const ColumnVector<UInt8> * del_mark);
 
@@ -0,0 +1,328 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/DynamicThreadPool.h>
+#include <Common/Exception.h>
+#include <Storages/DeltaMerge/File/DirectReadFile.h>
+#include <common/likely.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+extern const int CANNOT_OPEN_FILE;
+extern const int CANNOT_READ_FROM_FILE_DESCRIPTOR;
+extern const int LOGICAL_ERROR;
+} // namespace ErrorCodes
+
+namespace DM
+{
+bool ReadPrefetchQuota::tryAcquire(size_t bytes)
+{
+    size_t used = used_bytes.load(std::memory_order_relaxed);
+    do
+    {
+        if (used + bytes > max_bytes)
+            return false;
+    } while (!used_bytes.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+DirectReadBufferPool::Buffer::~Buffer()
+{
+    pool.freeMemory(data, is_prefetch);
+    if (quota)
+        quota->release(BUFFER_SIZE);
+}
+
+DirectReadBufferPool & DirectReadBufferPool::instance()
+{
+    static DirectReadBufferPool pool;
+    return pool;
+}
+
+DirectReadBufferPool::~DirectReadBufferPool()
+{
+    for (auto * data : free_buffers)
+        ::free(data);
+}
+
+DirectReadBufferPool::BufferPtr DirectReadBufferPool::tryAllocateForPrefetch(const ReadPrefetchQuotaPtr & quota)
+{
+    if (!quota || !quota->tryAcquire(BUFFER_SIZE))
+        return {};
+
+    {
+        std::lock_guard lock(mutex);
+        if (prefetch_bytes + BUFFER_SIZE > capacity)
+        {
+            quota->release(BUFFER_SIZE);
+            return {};
+        }
+        prefetch_bytes += BUFFER_SIZE;
+    }
+
+    char * data = nullptr;
+    try
+    {
+        data = allocMemory();
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard lock(mutex);
+            prefetch_bytes -= BUFFER_SIZE;
+        }
+        quota->release(BUFFER_SIZE);
+        throw;
+    }
+    return std::make_unique<Buffer>(*this, data, /*is_prefetch*/ true, quota);
+}
+
+DirectReadBufferPool::BufferPtr DirectReadBufferPool::allocate()
+{
+    return std::make_unique<Buffer>(*this, allocMemory(), /*is_prefetch*/ false, nullptr);
+}
+
+void DirectReadBufferPool::setCapacity(size_t capacity_)
+{
+    std::lock_guard lock(mutex);
+    capacity = capacity_;
+    while (!free_buffers.empty() && free_buffers.size() * BUFFER_SIZE > capacity)
+    {
+        ::free(free_buffers.back());
+        free_buffers.pop_back();
+        allocated_bytes -= BUFFER_SIZE;
+    }
+}
+
+size_t DirectReadBufferPool::getPrefetchBytes() const
+{
+    std::lock_guard lock(mutex);
+    return prefetch_bytes;
+}
+
+size_t DirectReadBufferPool::getAllocatedBytes() const
+{
+    std::lock_guard lock(mutex);
+    return allocated_bytes;
+}
+
+char * DirectReadBufferPool::allocMemory()
+{
+    {
+        std::lock_guard lock(mutex);
+        if (!free_buffers.empty())
+        {
+            auto * data = free_buffers.back();
+            free_buffers.pop_back();
+            return data;
+        }
+        allocated_bytes += BUFFER_SIZE;
+    }
+
+    auto * data = static_cast<char *>(::aligned_alloc(ALIGNMENT, BUFFER_SIZE));
+    if (unlikely(!data))
+    {
+        std::lock_guard lock(mutex);
+        allocated_bytes -= BUFFER_SIZE;
+        throw std::bad_alloc();
+    }
+    return data;
+}
+
+void DirectReadBufferPool::freeMemory(char * data, bool is_prefetch)
+{
+    std::lock_guard lock(mutex);
+    if (is_prefetch)
+        prefetch_bytes -= BUFFER_SIZE;
+    // Keep the free buffers for reusing, but no more than the capacity.
+    if ((free_buffers.size() + 1) * BUFFER_SIZE <= capacity)
+    {
+        free_buffers.push_back(data);
+    }
+    else
+    {
+        ::free(data);
+        allocated_bytes -= BUFFER_SIZE;
+    }
+}
+
+DirectReadFile::DirectReadFile(const RandomAccessFilePtr & file_, std::vector<Range> ranges, const ReadPrefetchQuotaPtr & quota_, size_t max_prefetch_chunks_)
+    : file(file_)
+    , quota(quota_)
+    , max_prefetch_chunks(max_prefetch_chunks_)
+{
+    std::sort(ranges.begin(), ranges.end(), [](const Range & a, const Range & b) { return a.offset < b.offset; });
+    for (const auto & range : ranges)
+    {
+        if (range.size == 0)
+            continue;
+        size_t begin = range.offset / DirectReadBufferPool::BUFFER_SIZE;
+        size_t end = (range.offset + range.size - 1) / DirectReadBufferPool::BUFFER_SIZE + 1;
+        if (!chunks_to_read.empty())
+            begin = std::max(begin, chunks_to_read.back() + 1);
+        for (size_t index = begin; index < end; ++index)
+            chunks_to_read.push_back(index);
+    }
+}
+
+off_t DirectReadFile::seek(off_t offset_, int whence)
+{
+    if (whence == SEEK_SET)
+        offset = offset_;
+    else if (whence == SEEK_CUR)
+        offset += offset_;
+    else
+        throw Exception("DirectReadFile::seek expects SEEK_SET or SEEK_CUR as whence", ErrorCodes::LOGICAL_ERROR);
+    return offset;
+}
+
+ssize_t DirectReadFile::read(char * buf, size_t size)
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        size_t index = offset / DirectReadBufferPool::BUFFER_SIZE;
+        const auto & chunk = getChunk(index);
+        size_t offset_in_chunk = offset - index * DirectReadBufferPool::BUFFER_SIZE;
+        // End of file.
+        if (offset_in_chunk >= chunk.size)
+            break;
+
+        size_t n = std::min(size - done, chunk.size - offset_in_chunk);
+        std::memcpy(buf + done, chunk.buffer->get() + offset_in_chunk, n);
+        done += n;
+        offset += n;
+        if (chunk.size < DirectReadBufferPool::BUFFER_SIZE && offset_in_chunk + n == chunk.size)
+            break;
+    }
+    return done;
+}
+
+ssize_t DirectReadFile::pread(char * buf, size_t size, off_t offset_) const
+{
+    size_t done = 0;
+    while (done < size)
+    {
+        size_t pos = offset_ + done;
+        Chunk chunk;
+        chunk.index = pos / DirectReadBufferPool::BUFFER_SIZE;
+        chunk.buffer = DirectReadBufferPool::instance().allocate();
+        loadChunk(*file, chunk);
+        size_t offset_in_chunk = pos - chunk.index * DirectReadBufferPool::BUFFER_SIZE;
+        if (offset_in_chunk >= chunk.size)
+            break;
+
+        size_t n = std::min(size - done, chunk.size - offset_in_chunk);
+        std::memcpy(buf + done, chunk.buffer->get() + offset_in_chunk, n);
+        done += n;
+        if (chunk.size < DirectReadBufferPool::BUFFER_SIZE)
+            break;
+    }
+    return done;
+}
+
+RandomAccessFilePtr DirectReadFile::openFile(const std::function<RandomAccessFilePtr(int flags)> & open)
+{
+    try
+    {
+        return open(O_RDONLY | O_DIRECT);
+    }
+    catch (const Exception & e)
+    {
+        // Some file systems, like tmpfs, don't support O_DIRECT.
+        if (e.code() != ErrorCodes::CANNOT_OPEN_FILE)
+            throw;
+    }
+    return open(-1);
+}
+
+const DirectReadFile::Chunk & DirectReadFile::getChunk(size_t index)
+{
+    // Release the chunks before the read position.
+    while (!chunks.empty() && chunks.front()->index < index)
+        chunks.pop_front();
+
+    if (chunks.empty() || chunks.front()->index != index)
+    {
+        // The chunk is not prefetched, read it synchronously.
+        auto chunk = std::make_shared<Chunk>();
+        chunk->index = index;
+        chunk->buffer = DirectReadBufferPool::instance().allocate();
+        loadChunk(*file, *chunk);
+        chunks.push_front(chunk);
+    }
+    else if (chunks.front()->loaded.valid())
+    {
+        // Wait for the prefetching, the exception of prefetching is rethrown here.
+        chunks.front()->loaded.get();
+    }
+
+    prefetch();
+    return *chunks.front();
+}
+
+void DirectReadFile::prefetch()
+{
+    size_t begin = chunks.back()->index + 1;
+    while (next_prefetch < chunks_to_read.size() && chunks_to_read[next_prefetch] < begin)
+        ++next_prefetch;
+
+    // The first chunk is the one being read.
+    while (chunks.size() <= max_prefetch_chunks && next_prefetch < chunks_to_read.size())
+    {
+        auto buffer = DirectReadBufferPool::instance().tryAllocateForPrefetch(quota);
+        if (!buffer)
+            break;
+
+        auto chunk = std::make_shared<Chunk>();
+        chunk->index = chunks_to_read[next_prefetch];
+        chunk->buffer = std::move(buffer);
+        if (DynamicThreadPool::global_instance)
+            chunk->loaded = DynamicThreadPool::global_instance->schedule(false, [f = file, chunk] { loadChunk(*f, *chunk); });
+        else
+            loadChunk(*file, *chunk);
+        chunks.push_back(chunk);
+        ++next_prefetch;
+    }
+}
+
+void DirectReadFile::loadChunk(const RandomAccessFile & file, Chunk & chunk)
+{
+    // Both the offset and the size are aligned, as required by O_DIRECT.
+    size_t offset = chunk.index * DirectReadBufferPool::BUFFER_SIZE;
+    size_t done = 0;
+    while (done < DirectReadBufferPool::BUFFER_SIZE)
+    {
+        ssize_t n = file.pread(chunk.buffer->get() + done, DirectReadBufferPool::BUFFER_SIZE - done, offset + done);
+        if (n == 0)
+            break;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throwFromErrno("Cannot read from file " + file.getFileName(), ErrorCodes::CANNOT_READ_FROM_FILE_DESCRIPTOR);
+        }
+        done += n;
+    }
+    chunk.size = done;
+}
+
+} // namespace DM
+} // namespace DB
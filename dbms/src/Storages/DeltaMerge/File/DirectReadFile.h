@@ -0,0 +1,175 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <Encryption/RandomAccessFile.h>
+#include <common/types.h>
+
+#include <atomic>
+#include <boost/noncopyable.hpp>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace DB
+{
+namespace DM
+{
+/// The memory that a query can use to prefetch the data of DMFiles.
+class ReadPrefetchQuota
+{
+public:
+    explicit ReadPrefetchQuota(size_t max_bytes_)
+        : max_bytes(max_bytes_)
+    {}
+
+    bool tryAcquire(size_t bytes);
+    void release(size_t bytes) { used_bytes.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    size_t getUsedBytes() const { return used_bytes.load(std::memory_order_relaxed); }
+
+private:
+    const size_t max_bytes;
+    std::atomic<size_t> used_bytes{0};
+};
+using ReadPrefetchQuotaPtr = std::shared_ptr<ReadPrefetchQuota>;
+
+/// A node-level pool of the aligned buffers used by the direct reads of DMFiles.
+/// The buffers are reused to avoid allocating large aligned memory frequently. The buffers used by
+/// prefetching are bounded by the capacity of pool, while the buffers of synchronous reads are not.
+class DirectReadBufferPool : private boost::noncopyable
+{
+public:
+    static constexpr size_t BUFFER_SIZE = 1024 * 1024;
+    static constexpr size_t ALIGNMENT = 4096;
+    static constexpr size_t DEFAULT_CAPACITY = 1024 * BUFFER_SIZE;
+
+    class Buffer : private boost::noncopyable
+    {
+    public:
+        Buffer(DirectReadBufferPool & pool_, char * data_, bool is_prefetch_, const ReadPrefetchQuotaPtr & quota_)
+            : pool(pool_)
+            , data(data_)
+            , is_prefetch(is_prefetch_)
+            , quota(quota_)
+        {}
+        ~Buffer();
+
+        char * get() const { return data; }
+
+    private:
+        DirectReadBufferPool & pool;
+        char * data;
+        const bool is_prefetch;
+        ReadPrefetchQuotaPtr quota;
+    };
+    using BufferPtr = std::unique_ptr<Buffer>;
+
+    static DirectReadBufferPool & instance();
+
+    ~DirectReadBufferPool();
+
+    /// Allocate a buffer for prefetching. Return nullptr if the capacity of pool or the quota is used up.
+    BufferPtr tryAllocateForPrefetch(const ReadPrefetchQuotaPtr & quota);
+    /// Allocate a buffer for the synchronous reading.
+    BufferPtr allocate();
+
+    void setCapacity(size_t capacity_);
+
+    size_t getPrefetchBytes() const;
+    size_t getAllocatedBytes() const;
+
+private:
+    DirectReadBufferPool() = default;
+
+    char * allocMemory();
+    void freeMemory(char * data, bool is_prefetch);
+
+private:
+    mutable std::mutex mutex;
+    std::vector<char *> free_buffers;
+    size_t capacity = DEFAULT_CAPACITY;
+    size_t prefetch_bytes = 0;
+    size_t allocated_bytes = 0;
+};
+
+/// A RandomAccessFile which reads the underlying file by aligned chunks, so that the underlying file can be opened
+/// with O_DIRECT to bypass the page cache of OS. Because there is no readahead of OS then, the chunks in `ranges`
+/// are prefetched asynchronously before they are read.
+///
+/// The read position should move forward mostly, the prefetched chunks before the read position are released.
+class DirectReadFile : public RandomAccessFile
+{
+public:
+    struct Range
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    /// `ranges` are the ranges of the underlying file which are expected to be read.
+    DirectReadFile(const RandomAccessFilePtr & file_, std::vector<Range> ranges, const ReadPrefetchQuotaPtr & quota_, size_t max_prefetch_chunks_);
+
+    off_t seek(off_t offset, int whence) override;
+
+    ssize_t read(char * buf, size_t size) override;
+
+    ssize_t pread(char * buf, size_t size, off_t offset) const override;
+
+    std::string getFileName() const override { return file->getFileName(); }
+
+    int getFd() const override { return file->getFd(); }
+
+    bool isClosed() const override { return file->isClosed(); }
+
+    void close() override { file->close(); }
+
+    /// Open the file for direct reading. Fall back to the normal reading if O_DIRECT is not supported by the file system.
+    static RandomAccessFilePtr openFile(const std::function<RandomAccessFilePtr(int flags)> & open);
+
+private:
+    struct Chunk
+    {
+        size_t index = 0;
+        DirectReadBufferPool::BufferPtr buffer;
+        size_t size = 0;
+        std::future<void> loaded;
+    };
+    using ChunkPtr = std::shared_ptr<Chunk>;
+
+    const Chunk & getChunk(size_t index);
+    void prefetch();
+
+    static void loadChunk(const RandomAccessFile & file, Chunk & chunk);
+
+private:
+    RandomAccessFilePtr file;
+    ReadPrefetchQuotaPtr quota;
+    const size_t max_prefetch_chunks;
+
+    /// The sorted indexes of the chunks in ranges.
+    std::vector<size_t> chunks_to_read;
+    size_t next_prefetch = 0;
+    /// The loaded or loading chunks, sorted by index.
+    std::deque<ChunkPtr> chunks;
+
+    size_t offset = 0;
+};
+
+} // namespace DM
+} // namespace DB
@@ -51,9 +51,9 @@ public:
     RSResult roughCheck(size_t pack_id, const RSCheckParam & param) override
     {
         GET_RSINDEX_FROM_PARAM_NOT_FOUND_RETURN_SOME(param, attr, rsindex);
-        // TODO optimize for IN
         RSResult res = rsindex.minmax->checkEqual(pack_id, values[0], rsindex.type);
-        for (size_t i = 1; i < values.size(); ++i)
+        // The result can't be changed once it is All, stop checking the rest values of a large set.
+        for (size_t i = 1; i < values.size() && res != All; ++i)
             res = res || rsindex.minmax->checkEqual(pack_id, values[i], rsindex.type);
         return res;
     }
@@ -0,0 +1,92 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <Storages/DeltaMerge/DeltaMergeDefines.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace DB
+{
+namespace DM
+{
+/// The threshold of a running TopN ordered by an integer column of the table first. It is published by the TopN
+/// operators reading from the table and consulted by the table scan to skip the packs that can not enter the result.
+///
+/// Once a TopN operator holds `limit` rows, no row ordered after its last row can be in the result, so the value
+/// of the column in its last row is published. Several operators share one threshold, the tightest one is kept.
+/// The values are stored as Int64, and compared as UInt64 for the unsigned columns.
+class TopNThreshold
+{
+public:
+    TopNThreshold(ColId col_id_, bool is_desc_, bool is_unsigned_)
+        : col_id(col_id_)
+        , is_desc(is_desc_)
+        , is_unsigned(is_unsigned_)
+    {}
+
+    ColId getColumnId() const { return col_id; }
+    bool isDesc() const { return is_desc; }
+    bool isUnsigned() const { return is_unsigned; }
+
+    /// Return false if no threshold is published yet.
+    bool get(Int64 & value) const
+    {
+        if (!has_value.load(std::memory_order_acquire))
+            return false;
+        value = threshold.load(std::memory_order_relaxed);
+        return true;
+    }
+
+    void publish(Int64 value)
+    {
+        std::lock_guard lock(mutex);
+        if (has_value.load(std::memory_order_relaxed) && !isOrderedBefore(value, threshold.load(std::memory_order_relaxed)))
+            return;
+        threshold.store(value, std::memory_order_relaxed);
+        has_value.store(true, std::memory_order_release);
+    }
+
+    /// Whether all the values in [min, max] are ordered after the threshold, so that none of them can enter the result.
+    bool canSkip(Int64 min, Int64 max) const
+    {
+        Int64 value;
+        if (!get(value))
+            return false;
+        return isOrderedBefore(value, is_desc ? max : min);
+    }
+
+private:
+    bool isOrderedBefore(Int64 lhs, Int64 rhs) const
+    {
+        bool less = is_unsigned ? static_cast<UInt64>(lhs) < static_cast<UInt64>(rhs) : lhs < rhs;
+        bool greater = is_unsigned ? static_cast<UInt64>(lhs) > static_cast<UInt64>(rhs) : lhs > rhs;
+        return is_desc ? greater : less;
+    }
+
+private:
+    const ColId col_id;
+    const bool is_desc;
+    const bool is_unsigned;
+
+    std::mutex mutex;
+    std::atomic<bool> has_value = false;
+    std::atomic<Int64> threshold = 0;
+};
+
+using TopNThresholdPtr = std::shared_ptr<TopNThreshold>;
+
+} // namespace DM
+} // namespace DB
@@ -243,6 +243,50 @@ inline RSOperatorPtr parseTiCompareExpr( //
     return op;
 }
 
+/// Only support `column` in (`literal`, ...) now, the values of the set are checked with the min-max index of every pack.
+inline RSOperatorPtr parseTiInExpr( //
+    const tipb::Expr & expr,
+    const ColumnDefines & columns_to_read,
+    const FilterParser::AttrCreatorByColumnID & creator,
+    const LoggerPtr & /*log*/)
+{
+    if (unlikely(expr.children_size() < 2))
+        return createUnsupported(expr.ShortDebugString(),
+                                 tipb::ScalarFuncSig_Name(expr.sig()) + " with " + DB::toString(expr.children_size())
+                                     + " children is not supported",
+                                 false);
+
+    const auto & column_expr = expr.children(0);
+    if (!isColumnExpr(column_expr))
+        return createUnsupported(expr.ShortDebugString(), "The first child of in is not a column", false);
+    if (unlikely(!column_expr.has_field_type()))
+        return createUnsupported(expr.ShortDebugString(), "ColumnRef with no field type is not supported", false);
+
+    auto field_type = column_expr.field_type().tp();
+    // The literals compared with timestamp column should be converted to UTC, which is not supported for in yet.
+    if (!isRoughSetFilterSupportType(field_type) || field_type == TiDB::TypeTimestamp)
+        return createUnsupported(
+            expr.ShortDebugString(),
+            "ColumnRef with field type(" + DB::toString(field_type) + ") is not supported",
+            false);
+
+    Fields values;
+    for (Int32 i = 1; i < expr.children_size(); ++i)
+    {
+        const auto & child = expr.children(i);
+        if (!isLiteralExpr(child))
+            return createUnsupported(expr.ShortDebugString(), "The values of in are not all literals", false);
+        // NULL never equals to any value.
+        Field value = decodeLiteral(child);
+        if (!value.isNull())
+            values.push_back(std::move(value));
+    }
+    if (values.empty())
+        return createUnsupported(expr.ShortDebugString(), "The values of in are all NULL", false);
+
+    return createIn(creator(getColumnIDForColumnExpr(column_expr, columns_to_read)), values);
+}
+
 RSOperatorPtr parseTiExpr(const tipb::Expr & expr,
                           const ColumnDefines & columns_to_read,
                           const FilterParser::AttrCreatorByColumnID & creator,
@@ -311,6 +355,9 @@ RSOperatorPtr parseTiExpr(const tipb::Expr & expr,
             break;
 
         case FilterParser::RSFilterType::In:
+            op = parseTiInExpr(expr, columns_to_read, creator, log);
+            break;
+
         case FilterParser::RSFilterType::NotIn:
         case FilterParser::RSFilterType::Like:
         case FilterParser::RSFilterType::NotLike:
@@ -630,12 +677,12 @@ std::unordered_map<tipb::ScalarFuncSig, FilterParser::RSFilterType> FilterParser
     //{tipb::ScalarFuncSig::ValuesString, "cast"},
     //{tipb::ScalarFuncSig::ValuesTime, "cast"},
 
-    // {tipb::ScalarFuncSig::InInt, "in"},
-    // {tipb::ScalarFuncSig::InReal, "in"},
-    // {tipb::ScalarFuncSig::InString, "in"},
-    // {tipb::ScalarFuncSig::InDecimal, "in"},
-    // {tipb::ScalarFuncSig::InTime, "in"},
-    // {tipb::ScalarFuncSig::InDuration, "in"},
+    {tipb::ScalarFuncSig::InInt, FilterParser::RSFilterType::In},
+    {tipb::ScalarFuncSig::InReal, FilterParser::RSFilterType::In},
+    {tipb::ScalarFuncSig::InString, FilterParser::RSFilterType::In},
+    {tipb::ScalarFuncSig::InDecimal, FilterParser::RSFilterType::In},
+    {tipb::ScalarFuncSig::InTime, FilterParser::RSFilterType::In},
+    {tipb::ScalarFuncSig::InDuration, FilterParser::RSFilterType::In},
     // {tipb::ScalarFuncSig::InJson, "in"},
 
     // {tipb::ScalarFuncSig::IfNullInt, "ifNull"},
@@ -17,7 +17,7 @@
 #include <AggregateFunctions/Helpers.h>
 #include <Columns/ColumnNullable.h>
 #include <Columns/ColumnsCommon.h>
-#include <Common/LRUCache.h>
+#include <Common/ManagedLRUCache.h>
 #include <DataTypes/DataTypeEnum.h>
 #include <DataTypes/DataTypeString.h>
 #include <DataTypes/DataTypesNumber.h>
@@ -68,6 +68,9 @@ public:
 
     static MinMaxIndexPtr read(const IDataType & type, ReadBuffer & buf, size_t bytes_limit);
 
+    /// Whether the pack has any value not null and not deleted, the min and max values are meaningless otherwise.
+    bool hasValue(size_t pack_index) const { return (*has_value_marks)[pack_index]; }
+
     std::pair<Int64, Int64> getIntMinMax(size_t pack_index);
 
     std::pair<StringRef, StringRef> getStringMinMax(size_t pack_index);
@@ -90,14 +93,14 @@ struct MinMaxIndexWeightFunction
 };
 
 
-class MinMaxIndexCache : public LRUCache<String, MinMaxIndex, std::hash<String>, MinMaxIndexWeightFunction>
+class MinMaxIndexCache : public ManagedLRUCache<String, MinMaxIndex, std::hash<String>, MinMaxIndexWeightFunction>
 {
 private:
-    using Base = LRUCache<String, MinMaxIndex, std::hash<String>, MinMaxIndexWeightFunction>;
+    using Base = ManagedLRUCache<String, MinMaxIndex, std::hash<String>, MinMaxIndexWeightFunction>;
 
 public:
     MinMaxIndexCache(size_t max_size_in_bytes, const Delay & expiration_delay)
-        : Base(max_size_in_bytes, expiration_delay)
+        : Base(max_size_in_bytes, expiration_delay, /*segmented*/ true)
     {}
 
     template <typename LoadFunc>
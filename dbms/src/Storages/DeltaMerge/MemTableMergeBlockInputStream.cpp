@@ -0,0 +1,167 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Storages/DeltaMerge/DeltaMergeHelpers.h>
+#include <Storages/DeltaMerge/MemTableMergeBlockInputStream.h>
+#include <Storages/DeltaMerge/RowKeyFilter.h>
+
+namespace DB
+{
+namespace ErrorCodes
+{
+extern const int LOGICAL_ERROR;
+} // namespace ErrorCodes
+
+namespace DM
+{
+namespace
+{
+/// Compare the row `lhs` of (lhs_handles, lhs_versions) with the row `rhs` of (rhs_handles, rhs_versions).
+inline int compareRow(const RowKeyColumnContainer & lhs_handles,
+                      const PaddedPODArray<UInt64> & lhs_versions,
+                      size_t lhs,
+                      const RowKeyColumnContainer & rhs_handles,
+                      const PaddedPODArray<UInt64> & rhs_versions,
+                      size_t rhs)
+{
+    if (int res = compare(lhs_handles.getRowKeyValue(lhs), rhs_handles.getRowKeyValue(rhs)); res != 0)
+        return res;
+    if (lhs_versions[lhs] != rhs_versions[rhs])
+        return lhs_versions[lhs] < rhs_versions[rhs] ? -1 : 1;
+    return 0;
+}
+} // namespace
+
+MemTableMergeBlockInputStream::MemTableMergeBlockInputStream(const BlockInputStreamPtr & input,
+                                                             const DeltaValueReaderPtr & delta_reader_,
+                                                             const MemTableIndex::SortedRowsPtr & sorted_rows_,
+                                                             const RowKeyRange & rowkey_range_,
+                                                             size_t expected_block_size_)
+    : delta_reader(delta_reader_)
+    , sorted_rows(sorted_rows_)
+    , rowkey_range(rowkey_range_)
+    , expected_block_size(expected_block_size_)
+    , header(input->getHeader())
+{
+    children.push_back(input);
+    handle_col_pos = header.getPositionByName(EXTRA_HANDLE_COLUMN_NAME);
+    version_col_pos = header.getPositionByName(VERSION_COLUMN_NAME);
+}
+
+void MemTableMergeBlockInputStream::readMemTableBlock()
+{
+    mem_table_read = true;
+
+    const auto & delta_snap = delta_reader->getDeltaSnap();
+    size_t mem_table_offset = delta_snap->getMemTableSetRowsOffset();
+    size_t mem_table_rows = delta_snap->getRows() - mem_table_offset;
+    if (unlikely(mem_table_rows != sorted_rows->size()))
+        throw Exception(fmt::format("Rows of MemTableSet not match, rows: {}, sorted rows: {}", mem_table_rows, sorted_rows->size()),
+                        ErrorCodes::LOGICAL_ERROR);
+
+    auto columns = header.cloneEmptyColumns();
+    size_t read_rows = delta_reader->readRows(columns, mem_table_offset, mem_table_rows, nullptr);
+    if (unlikely(read_rows != mem_table_rows))
+        throw Exception(fmt::format("Read rows of MemTableSet not match, expected: {}, actual: {}", mem_table_rows, read_rows),
+                        ErrorCodes::LOGICAL_ERROR);
+
+    mem_table_block = header.cloneEmpty();
+    for (size_t i = 0; i < columns.size(); ++i)
+        mem_table_block.getByPosition(i).column = columns[i]->permute(*sorted_rows, 0);
+
+    if (mem_table_rows == 0)
+        return;
+    // The rows are sorted, so the rows in range are continuous.
+    std::tie(mem_table_pos, mem_table_end)
+        = RowKeyFilter::getPosRangeOfSorted(rowkey_range, mem_table_block.getByPosition(handle_col_pos).column, 0, mem_table_rows);
+    mem_table_end += mem_table_pos;
+}
+
+Block MemTableMergeBlockInputStream::read()
+{
+    if (!mem_table_read)
+        readMemTableBlock();
+
+    while (true)
+    {
+        Block block = children.back()->read();
+        if (!block)
+        {
+            if (mem_table_pos >= mem_table_end)
+                return {};
+
+            // Output the rest rows of MemTableSet.
+            size_t limit = std::min(expected_block_size, mem_table_end - mem_table_pos);
+            auto columns = header.cloneEmptyColumns();
+            for (size_t i = 0; i < columns.size(); ++i)
+                columns[i]->insertRangeFrom(*mem_table_block.getByPosition(i).column, mem_table_pos, limit);
+            mem_table_pos += limit;
+            return header.cloneWithColumns(std::move(columns));
+        }
+        if (!block.rows())
+            continue;
+
+        if (mem_table_pos >= mem_table_end)
+            return block;
+        return mergeBlock(block);
+    }
+}
+
+Block MemTableMergeBlockInputStream::mergeBlock(const Block & block)
+{
+    size_t rows = block.rows();
+    RowKeyColumnContainer handles(block.getByPosition(handle_col_pos).column, rowkey_range.is_common_handle);
+    const auto & versions = toColumnVectorData<UInt64>(block.getByPosition(version_col_pos).column);
+    RowKeyColumnContainer mem_table_handles(mem_table_block.getByPosition(handle_col_pos).column, rowkey_range.is_common_handle);
+    const auto & mem_table_versions = toColumnVectorData<UInt64>(mem_table_block.getByPosition(version_col_pos).column);
+
+    auto mem_table_row_is_less = [&](size_t pos) {
+        return compareRow(mem_table_handles, mem_table_versions, mem_table_pos, handles, versions, pos) < 0;
+    };
+
+    // All the rest rows of MemTableSet are ordered after this block.
+    if (!mem_table_row_is_less(rows - 1))
+        return block;
+
+    auto columns = header.cloneEmptyColumns();
+    auto copy_rows = [&](const Block & from, size_t begin, size_t end) {
+        if (begin == end)
+            return;
+        for (size_t i = 0; i < columns.size(); ++i)
+            columns[i]->insertRangeFrom(*from.getByPosition(i).column, begin, end - begin);
+    };
+
+    size_t pos = 0;
+    while (pos < rows)
+    {
+        size_t mem_table_begin = mem_table_pos;
+        while (mem_table_pos < mem_table_end && mem_table_row_is_less(pos))
+            ++mem_table_pos;
+        copy_rows(mem_table_block, mem_table_begin, mem_table_pos);
+
+        size_t begin = pos;
+        if (mem_table_pos >= mem_table_end)
+            pos = rows;
+        else
+        {
+            while (pos < rows && !mem_table_row_is_less(pos))
+                ++pos;
+        }
+        copy_rows(block, begin, pos);
+    }
+    return header.cloneWithColumns(std::move(columns));
+}
+
+} // namespace DM
+} // namespace DB
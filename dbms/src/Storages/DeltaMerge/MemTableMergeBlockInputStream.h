@@ -0,0 +1,69 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <DataStreams/IBlockInputStream.h>
+#include <Storages/DeltaMerge/Delta/DeltaValueSpace.h>
+#include <Storages/DeltaMerge/RowKeyRange.h>
+
+namespace DB
+{
+namespace DM
+{
+/// Merge the rows of MemTableSet into the sorted stream of stable and persisted delta, in increasing pk && version order.
+/// The rows of MemTableSet are sorted by MemTableIndex already, so that they don't need to be placed into the DeltaTree.
+/// The rows of MemTableSet with the same pk && version as some rows of input stream are output after them,
+/// because they are written later.
+///
+/// Note that the `input` must be sorted with increasing pk && version and must not be a clean read stream.
+class MemTableMergeBlockInputStream final : public IBlockInputStream
+{
+public:
+    MemTableMergeBlockInputStream(const BlockInputStreamPtr & input,
+                                  const DeltaValueReaderPtr & delta_reader_,
+                                  const MemTableIndex::SortedRowsPtr & sorted_rows_,
+                                  const RowKeyRange & rowkey_range_,
+                                  size_t expected_block_size_);
+
+    String getName() const override { return "MemTableMerge"; }
+    Block getHeader() const override { return header; }
+
+    Block read() override;
+
+private:
+    /// Read the rows of MemTableSet in `rowkey_range`, sorted by `sorted_rows`.
+    void readMemTableBlock();
+
+    Block mergeBlock(const Block & block);
+
+private:
+    DeltaValueReaderPtr delta_reader;
+    MemTableIndex::SortedRowsPtr sorted_rows;
+    RowKeyRange rowkey_range;
+    size_t expected_block_size;
+
+    Block header;
+    size_t handle_col_pos;
+    size_t version_col_pos;
+
+    bool mem_table_read = false;
+    Block mem_table_block;
+    /// The rows in [mem_table_pos, mem_table_end) of `mem_table_block` are not output yet.
+    size_t mem_table_pos = 0;
+    size_t mem_table_end = 0;
+};
+
+} // namespace DM
+} // namespace DB
@@ -30,6 +30,7 @@
 #include <Storages/DeltaMerge/File/DMFileBlockInputStream.h>
 #include <Storages/DeltaMerge/File/DMFileBlockOutputStream.h>
 #include <Storages/DeltaMerge/Filter/FilterHelper.h>
+#include <Storages/DeltaMerge/MemTableMergeBlockInputStream.h>
 #include <Storages/DeltaMerge/PKSquashingBlockInputStream.h>
 #include <Storages/DeltaMerge/Segment.h>
 #include <Storages/DeltaMerge/StoragePool.h>
@@ -148,11 +149,10 @@ DMFilePtr writeIntoNewDMFile(DMContext & dm_context, //
     return dmfile;
 }
 
-StableValueSpacePtr createNewStable(DMContext & context,
-                                    const ColumnDefinesPtr & schema_snap,
-                                    const BlockInputStreamPtr & input_stream,
-                                    PageId stable_id,
-                                    WriteBatches & wbs)
+DMFilePtr writeIntoNewStableFile(DMContext & context,
+                                 const ColumnDefinesPtr & schema_snap,
+                                 const BlockInputStreamPtr & input_stream,
+                                 WriteBatches & wbs)
 {
     auto delegator = context.path_pool.getStableDiskDelegator();
     auto store_path = delegator.choosePath();
@@ -162,11 +162,21 @@ StableValueSpacePtr createNewStable(DMContext & context,
 
     PageId dtfile_id = context.storage_pool.newDataPageIdForDTFile(delegator, __PRETTY_FUNCTION__);
     auto dtfile = writeIntoNewDMFile(context, schema_snap, input_stream, dtfile_id, store_path, flags);
+    wbs.data.putExternal(dtfile_id, 0);
+    delegator.addDTFile(dtfile_id, dtfile->getBytesOnDisk(), store_path);
+    return dtfile;
+}
+
+StableValueSpacePtr createNewStable(DMContext & context,
+                                    const ColumnDefinesPtr & schema_snap,
+                                    const BlockInputStreamPtr & input_stream,
+                                    PageId stable_id,
+                                    WriteBatches & wbs)
+{
+    auto dtfile = writeIntoNewStableFile(context, schema_snap, input_stream, wbs);
     auto stable = std::make_shared<StableValueSpace>(stable_id);
     stable->setFiles({dtfile}, RowKeyRange::newAll(context.is_common_handle, context.rowkey_column_size));
     stable->saveMeta(wbs.meta);
-    wbs.data.putExternal(dtfile_id, 0);
-    delegator.addDTFile(dtfile_id, dtfile->getBytesOnDisk(), store_path);
 
     return stable;
 }
@@ -374,7 +384,7 @@ BlockInputStreamPtr Segment::getInputStream(const DMContext & dm_context,
 {
     LOG_FMT_TRACE(log, "Segment [{}] [epoch={}] create InputStream", segment_id, epoch);
 
-    auto read_info = getReadInfo(dm_context, columns_to_read, segment_snap, read_ranges, max_version);
+    auto read_info = getReadInfo(dm_context, columns_to_read, segment_snap, read_ranges, max_version, /*merge_mem_table*/ true);
 
     RowKeyRanges real_ranges;
     for (const auto & read_range : read_ranges)
@@ -400,7 +410,10 @@ BlockInputStreamPtr Segment::getInputStream(const DMContext & dm_context,
             filter,
             max_version,
             expected_block_size,
-            false);
+            false,
+            0,
+            std::numeric_limits<size_t>::max(),
+            dm_context.topn_threshold);
     }
     else if (segment_snap->delta->getRows() == 0 && segment_snap->delta->getDeletes() == 0 //
              && !hasColumn(columns_to_read, EXTRA_HANDLE_COLUMN_ID) //
@@ -415,7 +428,10 @@ BlockInputStreamPtr Segment::getInputStream(const DMContext & dm_context,
             filter,
             max_version,
             expected_block_size,
-            true);
+            true,
+            0,
+            std::numeric_limits<size_t>::max(),
+            dm_context.topn_threshold);
     }
     else
     {
@@ -428,7 +444,17 @@ BlockInputStreamPtr Segment::getInputStream(const DMContext & dm_context,
                                  read_info.index_begin,
                                  read_info.index_end,
                                  expected_block_size,
-                                 max_version);
+                                 max_version,
+                                 dm_context.topn_threshold);
+        if (read_info.mem_table_sorted_rows)
+        {
+            stream = std::make_shared<MemTableMergeBlockInputStream>(
+                stream,
+                read_info.getDeltaReader(),
+                read_info.mem_table_sorted_rows,
+                mergeRanges(real_ranges, is_common_handle, rowkey_column_size),
+                expected_block_size);
+        }
     }
 
     stream = std::make_shared<DMRowKeyFilterBlockInputStream<true>>(stream, real_ranges, 0);
@@ -571,14 +597,48 @@ BlockInputStreamPtr Segment::getInputStreamRaw(const DMContext & dm_context, con
     return getInputStreamRaw(dm_context, columns_to_read, segment_snap, true);
 }
 
-SegmentPtr Segment::mergeDelta(DMContext & dm_context, const ColumnDefinesPtr & schema_snap) const
+UInt64 Segment::getMaxVersion(const DMContext & dm_context, const SegmentSnapshotPtr & segment_snap) const
+{
+    UInt64 max_version = 0;
+    for (const auto & file : segment_snap->stable->getDMFiles())
+    {
+        if (file->getPacks() == 0)
+            continue;
+        // The max version is unknown without the min-max index.
+        if (!file->isColIndexExist(VERSION_COLUMN_ID))
+            return std::numeric_limits<UInt64>::max();
+        auto pack_filter = DMFilePackFilter::loadFrom(
+            file,
+            dm_context.db_context.getGlobalContext().getMinMaxIndexCache(),
+            /*set_cache_if_miss*/ true,
+            {},
+            EMPTY_FILTER,
+            {},
+            dm_context.db_context.getFileProvider(),
+            dm_context.getReadLimiter(),
+            dm_context.tracing_id);
+        for (size_t pack_id = 0; pack_id < file->getPacks(); ++pack_id)
+            max_version = std::max(max_version, pack_filter.getMaxVersion(pack_id));
+    }
+
+    auto version_col_defs = std::make_shared<ColumnDefines>(ColumnDefines{getVersionColumnDefine()});
+    DeltaValueInputStream delta_stream(dm_context, segment_snap->delta, version_col_defs, rowkey_range);
+    while (Block block = delta_stream.read())
+    {
+        for (auto version : toColumnVectorData<UInt64>(block.getByPosition(0).column))
+            max_version = std::max(max_version, version);
+    }
+    return max_version;
+}
+
+SegmentPtr Segment::mergeDelta(DMContext & dm_context, const ColumnDefinesPtr & schema_snap, bool allow_partial) const
 {
     WriteBatches wbs(dm_context.storage_pool, dm_context.getWriteLimiter());
     auto segment_snap = createSnapshot(dm_context, true, CurrentMetrics::DT_SnapshotOfDeltaMerge);
     if (!segment_snap)
         return {};
 
-    auto new_stable = prepareMergeDelta(dm_context, schema_snap, segment_snap, wbs);
+    auto new_stable = prepareMergeDelta(dm_context, schema_snap, segment_snap, wbs, allow_partial);
 
     wbs.writeLogAndData();
     new_stable->enableDMFilesGC();
@@ -593,7 +653,8 @@ SegmentPtr Segment::mergeDelta(DMContext & dm_context, const ColumnDefinesPtr &
 StableValueSpacePtr Segment::prepareMergeDelta(DMContext & dm_context,
                                                const ColumnDefinesPtr & schema_snap,
                                                const SegmentSnapshotPtr & segment_snap,
-                                               WriteBatches & wbs) const
+                                               WriteBatches & wbs,
+                                               bool allow_partial) const
 {
     LOG_FMT_INFO(log,
                  "Segment [{}] prepare merge delta start. delta column files: {}, delta total rows: {}, delta total size: {}",
@@ -604,6 +665,15 @@ StableValueSpacePtr Segment::prepareMergeDelta(DMContext & dm_context,
 
     EventRecorder recorder(ProfileEvents::DMDeltaMerge, ProfileEvents::DMDeltaMergeNS);
 
+    if (allow_partial)
+    {
+        if (auto new_stable = preparePartialMergeDelta(dm_context, schema_snap, segment_snap, wbs); new_stable)
+        {
+            LOG_FMT_INFO(log, "Segment [{}] prepare partial merge delta done.", segment_id);
+            return new_stable;
+        }
+    }
+
     auto data_stream = getInputStreamForDataExport(
         dm_context,
         *schema_snap,
@@ -619,6 +689,233 @@ StableValueSpacePtr Segment::prepareMergeDelta(DMContext & dm_context,
     return new_stable;
 }
 
+std::optional<RowKeyRange> Segment::getDeltaKeyRange(const DMContext & dm_context, const SegmentSnapshotPtr & segment_snap) const
+{
+    auto pk_col_defs = std::make_shared<ColumnDefines>(ColumnDefines{getExtraHandleColumnDefine(is_common_handle)});
+    DeltaValueInputStream stream(dm_context, segment_snap->delta, pk_col_defs, rowkey_range);
+
+    std::optional<RowKeyValue> min_key;
+    std::optional<RowKeyValue> max_key;
+    stream.readPrefix();
+    while (Block block = stream.read())
+    {
+        RowKeyColumnContainer rowkey_column(block.getByPosition(0).column, is_common_handle);
+        for (size_t i = 0; i < block.rows(); ++i)
+        {
+            auto key = rowkey_column.getRowKeyValue(i);
+            if (!min_key || compare(key, min_key->toRowKeyValueRef()) < 0)
+                min_key = RowKeyValue(key);
+            if (!max_key || compare(key, max_key->toRowKeyValueRef()) > 0)
+                max_key = RowKeyValue(key);
+        }
+    }
+    stream.readSuffix();
+
+    std::optional<RowKeyRange> key_range;
+    if (min_key)
+        key_range = RowKeyRange(*min_key, max_key->toPrefixNext(), is_common_handle, rowkey_column_size);
+    if (auto delete_range = segment_snap->delta->getSquashDeleteRange(); !delete_range.none())
+        key_range = key_range ? key_range->merge(delete_range) : delete_range;
+    if (!key_range)
+        return {};
+
+    auto res = key_range->shrink(rowkey_range);
+    if (res.none())
+        return {};
+    return res;
+}
+
+namespace
+{
+/// The packs of a stable file in its valid range, and the packs overlapping the key range of delta.
+struct StableFilePacks
+{
+    std::vector<size_t> valid_packs;
+    std::vector<size_t> affected_packs;
+};
+
+StableFilePacks getStableFilePacks(const DMContext & dm_context,
+                                   const DMFilePtr & file,
+                                   const RowKeyRange & file_range,
+                                   const RowKeyRange & delta_range)
+{
+    auto load_use_packs = [&](const RowKeyRange & range) {
+        std::vector<size_t> packs;
+        auto pack_filter = DMFilePackFilter::loadFrom(
+            file,
+            dm_context.db_context.getGlobalContext().getMinMaxIndexCache(),
+            /*set_cache_if_miss*/ true,
+            {range},
+            EMPTY_FILTER,
+            {},
+            dm_context.db_context.getFileProvider(),
+            dm_context.getReadLimiter(),
+            dm_context.tracing_id);
+        const auto & use_packs = pack_filter.getUsePacks();
+        for (size_t pack_id = 0; pack_id < use_packs.size(); ++pack_id)
+        {
+            if (use_packs[pack_id])
+                packs.push_back(pack_id);
+        }
+        return packs;
+    };
+    return StableFilePacks{load_use_packs(file_range), load_use_packs(file_range.shrink(delta_range))};
+}
+
+std::pair<RowKeyValue, RowKeyValue> getPackKeyRange(const DMContext & dm_context, const DMFilePtr & file, size_t pack_id)
+{
+    auto pack_filter = DMFilePackFilter::loadFrom(
+        file,
+        dm_context.db_context.getGlobalContext().getMinMaxIndexCache(),
+        /*set_cache_if_miss*/ true,
+        {},
+        EMPTY_FILTER,
+        {},
+        dm_context.db_context.getFileProvider(),
+        dm_context.getReadLimiter(),
+        dm_context.tracing_id);
+    if (dm_context.is_common_handle)
+    {
+        auto min_handle = pack_filter.getMinStringHandle(pack_id);
+        auto max_handle = pack_filter.getMaxStringHandle(pack_id);
+        return {RowKeyValue(true, std::make_shared<String>(min_handle.data, min_handle.size), 0),
+                RowKeyValue(true, std::make_shared<String>(max_handle.data, max_handle.size), 0)};
+    }
+    else
+    {
+        return {RowKeyValue::fromHandle(pack_filter.getMinHandle(pack_id)),
+                RowKeyValue::fromHandle(pack_filter.getMaxHandle(pack_id))};
+    }
+}
+} // namespace
+
+StableValueSpacePtr Segment::preparePartialMergeDelta(DMContext & dm_context,
+                                                      const ColumnDefinesPtr & schema_snap,
+                                                      const SegmentSnapshotPtr & segment_snap,
+                                                      WriteBatches & wbs) const
+{
+    const auto & stable_snap = segment_snap->stable;
+    const auto & files = stable_snap->getDMFiles();
+    // The file ranges are stored since StableFormat::V2, which can not be read by the older versions.
+    if (STORAGE_FORMAT_CURRENT.stable < StableFormat::V2)
+        return {};
+    // Every partial merge delta adds a file to stable, and the files are not merged until the whole stable is
+    // rewritten, so the files are limited to bound the fragments on reading.
+    if (dm_context.partial_merge_delta_max_ratio <= 0 || files.empty() || files.size() >= dm_context.partial_merge_delta_max_stable_files
+        || stable_snap->getRows() == 0)
+        return {};
+
+    // The files without ranges overlap with each other, only a single file can be split by key range.
+    RowKeyRanges file_ranges = stable_snap->stable->getFileRanges();
+    if (file_ranges.empty())
+    {
+        if (files.size() != 1)
+            return {};
+        file_ranges.push_back(rowkey_range);
+    }
+
+    auto delta_range = getDeltaKeyRange(dm_context, segment_snap);
+    if (!delta_range)
+        return {};
+
+    size_t begin_file = 0;
+    while (begin_file < files.size() && file_ranges[begin_file].shrink(*delta_range).none())
+        ++begin_file;
+    if (begin_file == files.size())
+        return {};
+    size_t end_file = files.size() - 1;
+    while (end_file > begin_file && file_ranges[end_file].shrink(*delta_range).none())
+        --end_file;
+
+    // Rewrite the rows in [rewrite_start, rewrite_end). Every pack of the reused parts must be totally out of
+    // this range, so that the rows of the reused parts and the new file don't overlap.
+    RowKeyValue rewrite_start = file_ranges[begin_file].start;
+    {
+        auto packs = getStableFilePacks(dm_context, files[begin_file], file_ranges[begin_file], *delta_range);
+        if (!packs.affected_packs.empty() && packs.affected_packs.front() != packs.valid_packs.front())
+        {
+            size_t first_affected = packs.affected_packs.front();
+            auto affected_min = getPackKeyRange(dm_context, files[begin_file], first_affected).first;
+            auto prev_max = getPackKeyRange(dm_context, files[begin_file], first_affected - 1).second;
+            auto start = min(affected_min, delta_range->start);
+            if (compare(prev_max.toRowKeyValueRef(), start.toRowKeyValueRef()) < 0
+                && compare(start.toRowKeyValueRef(), rewrite_start.toRowKeyValueRef()) > 0)
+                rewrite_start = start;
+        }
+    }
+    RowKeyValue rewrite_end = file_ranges[end_file].end;
+    {
+        auto packs = getStableFilePacks(dm_context, files[end_file], file_ranges[end_file], *delta_range);
+        if (!packs.affected_packs.empty() && packs.affected_packs.back() != packs.valid_packs.back())
+        {
+            size_t last_affected = packs.affected_packs.back();
+            auto affected_max = getPackKeyRange(dm_context, files[end_file], last_affected).second;
+            auto next_min = getPackKeyRange(dm_context, files[end_file], last_affected + 1).first;
+            auto end = max(affected_max.toPrefixNext(), delta_range->end);
+            if (compare(end.toRowKeyValueRef(), next_min.toRowKeyValueRef()) <= 0
+                && compare(end.toRowKeyValueRef(), rewrite_end.toRowKeyValueRef()) < 0)
+                rewrite_end = end;
+        }
+    }
+
+    RowKeyRange rewrite_range(rewrite_start, rewrite_end, is_common_handle, rowkey_column_size);
+    // Nothing to reuse.
+    if (compare(rewrite_range.getStart(), rowkey_range.getStart()) <= 0 && compare(rewrite_range.getEnd(), rowkey_range.getEnd()) >= 0)
+        return {};
+    auto [rewrite_rows, rewrite_bytes] = stable_snap->getApproxRowsAndBytes(dm_context, rewrite_range);
+    if (rewrite_rows > stable_snap->getRows() * dm_context.partial_merge_delta_max_ratio)
+        return {};
+
+    LOG_FMT_INFO(log,
+                 "Segment [{}] partial merge delta, rewrite range: {}, approx rewrite rows: {}, stable rows: {}",
+                 segment_id,
+                 rewrite_range.toDebugString(),
+                 rewrite_rows,
+                 stable_snap->getRows());
+
+    auto data_stream = getInputStreamForDataExport(
+        dm_context,
+        *schema_snap,
+        segment_snap,
+        rewrite_range,
+        dm_context.stable_pack_rows,
+        /*reorginize_block*/ true);
+    auto new_file = writeIntoNewStableFile(dm_context, schema_snap, data_stream, wbs);
+
+    DMFiles new_files;
+    RowKeyRanges new_file_ranges;
+    auto delegate = dm_context.path_pool.getStableDiskDelegator();
+    auto reuse_file = [&](const DMFilePtr & file, const RowKeyRange & range) {
+        // Create a reference to the page id of the old file, like logical split does.
+        // The page id of the old file is removed when the old stable is removed.
+        auto new_page_id = dm_context.storage_pool.newDataPageIdForDTFile(delegate, __PRETTY_FUNCTION__);
+        wbs.data.putRefPage(new_page_id, file->pageId());
+        new_files.push_back(DMFile::restore(
+            dm_context.db_context.getFileProvider(),
+            file->fileId(),
+            /* page_id= */ new_page_id,
+            delegate.getDTFilePath(file->fileId()),
+            DMFile::ReadMetaMode::all()));
+        new_file_ranges.push_back(range);
+    };
+
+    for (size_t i = 0; i < begin_file; ++i)
+        reuse_file(files[i], file_ranges[i]);
+    if (compare(rewrite_start.toRowKeyValueRef(), file_ranges[begin_file].getStart()) > 0)
+        reuse_file(files[begin_file], RowKeyRange(file_ranges[begin_file].start, rewrite_start, is_common_handle, rowkey_column_size));
+    new_files.push_back(new_file);
+    new_file_ranges.push_back(rewrite_range);
+    if (compare(rewrite_end.toRowKeyValueRef(), file_ranges[end_file].getEnd()) < 0)
+        reuse_file(files[end_file], RowKeyRange(rewrite_end, file_ranges[end_file].end, is_common_handle, rowkey_column_size));
+    for (size_t i = end_file + 1; i < files.size(); ++i)
+        reuse_file(files[i], file_ranges[i]);
+
+    auto new_stable = std::make_shared<StableValueSpace>(stable_snap->getId());
+    new_stable->setFiles(new_files, new_file_ranges, dm_context);
+    new_stable->saveMeta(wbs.meta);
+    return new_stable;
+}
+
 SegmentPtr Segment::applyMergeDelta(DMContext & context,
                                     const SegmentSnapshotPtr & segment_snap,
                                     WriteBatches & wbs,
@@ -865,7 +1162,10 @@ std::optional<Segment::SplitInfo> Segment::prepareSplit(DMContext & dm_context,
                                                         const SegmentSnapshotPtr & segment_snap,
                                                         WriteBatches & wbs) const
 {
+    // The stable with file ranges can not be split logically, because the same file could be referenced more than
+    // once, and the split point by pack stats is not accurate. Rewrite it by split physical instead.
     if (!dm_context.enable_logical_split //
+        || segment_snap->stable->stable->hasFileRanges() //
         || segment_snap->stable->getPacks() <= 3 //
         || segment_snap->delta->getRows() > segment_snap->stable->getRows())
     {
@@ -1386,7 +1686,8 @@ Segment::ReadInfo Segment::getReadInfo(const DMContext & dm_context,
                                        const ColumnDefines & read_columns,
                                        const SegmentSnapshotPtr & segment_snap,
                                        const RowKeyRanges & read_ranges,
-                                       UInt64 max_version) const
+                                       UInt64 max_version,
+                                       bool merge_mem_table) const
 {
     auto tracing_logger = Logger::get(log, dm_context.tracing_id);
     LOG_FMT_DEBUG(tracing_logger, "Segment[{}] [epoch={}] getReadInfo start", segment_id, epoch);
@@ -1397,7 +1698,12 @@ Segment::ReadInfo Segment::getReadInfo(const DMContext & dm_context,
     // Create a reader only for pk and version columns.
     auto delta_reader = std::make_shared<DeltaValueReader>(dm_context, segment_snap->delta, pk_ver_col_defs, this->rowkey_range);
 
-    auto [my_delta_index, fully_indexed] = ensurePlace(dm_context, segment_snap->stable, delta_reader, read_ranges, max_version);
+    // The rows of MemTableSet are kept sorted by MemTableIndex, they can be merged with stable and persisted delta
+    // in one ordered pass without placing them into the delta index.
+    const auto & mem_table_sorted_rows = segment_snap->delta->getMemTableSortedRows();
+    bool skip_mem_table = merge_mem_table && dm_context.enable_sorted_mem_table_read && mem_table_sorted_rows && !mem_table_sorted_rows->empty();
+
+    auto [my_delta_index, fully_indexed] = ensurePlace(dm_context, segment_snap->stable, delta_reader, read_ranges, max_version, skip_mem_table);
     auto compacted_index = my_delta_index->getDeltaTree()->getCompactedEntries();
 
 
@@ -1418,7 +1724,11 @@ Segment::ReadInfo Segment::getReadInfo(const DMContext & dm_context,
     if (auto manager = dm_context.db_context.getDeltaIndexManager(); manager)
         manager->refreshRef(segment_snap->delta->getSharedDeltaIndex());
 
-    return ReadInfo(delta_reader->createNewReader(new_read_columns), compacted_index->begin(), compacted_index->end(), new_read_columns);
+    return ReadInfo(delta_reader->createNewReader(new_read_columns),
+                    compacted_index->begin(),
+                    compacted_index->end(),
+                    new_read_columns,
+                    skip_mem_table ? mem_table_sorted_rows : nullptr);
 }
 
 ColumnDefinesPtr Segment::arrangeReadColumns(const ColumnDefine & handle, const ColumnDefines & columns_to_read)
@@ -1439,6 +1749,37 @@ ColumnDefinesPtr Segment::arrangeReadColumns(const ColumnDefine & handle, const
     return std::make_shared<ColumnDefines>(std::move(new_columns_to_read));
 }
 
+template <class IndexIterator>
+std::pair<size_t, size_t> Segment::getPacksAffectedByDelta(const StableSnapshotPtr & stable_snap,
+                                                           const IndexIterator & delta_index_begin,
+                                                           const IndexIterator & delta_index_end)
+{
+    // The delta index entries are sorted by the stable row id. The inserts of an entry are placed before the stable row `sid`,
+    // and the deletes remove the stable rows in [sid, sid + count).
+    size_t rows_begin = delta_index_begin.getSid();
+    size_t rows_end = rows_begin;
+    for (auto it = delta_index_begin; it != delta_index_end; ++it)
+        rows_end = it.isDelete() ? it.getSid() + it.getCount() : it.getSid();
+
+    // Find the packs which are totally before `rows_begin` or totally after `rows_end`.
+    size_t pack_begin = 0;
+    size_t pack_end = 0;
+    size_t pack_rows_begin = 0;
+    for (const auto & file : stable_snap->getDMFiles())
+    {
+        for (const auto & pack_stat : file->getPackStats())
+        {
+            size_t pack_rows_end = pack_rows_begin + pack_stat.rows;
+            if (pack_rows_end <= rows_begin)
+                ++pack_begin;
+            if (pack_rows_begin < rows_end)
+                ++pack_end;
+            pack_rows_begin = pack_rows_end;
+        }
+    }
+    return {pack_begin, std::max(pack_begin, pack_end)};
+}
+
 template <bool skippable_place, class IndexIterator>
 SkippableBlockInputStreamPtr Segment::getPlacedStream(const DMContext & dm_context,
                                                       const ColumnDefines & read_columns,
@@ -1449,28 +1790,61 @@ SkippableBlockInputStreamPtr Segment::getPlacedStream(const DMContext & dm_conte
                                                       const IndexIterator & delta_index_begin,
                                                       const IndexIterator & delta_index_end,
                                                       size_t expected_block_size,
-                                                      UInt64 max_version)
+                                                      UInt64 max_version,
+                                                      const TopNThresholdPtr & topn_threshold)
 {
     if (unlikely(rowkey_ranges.empty()))
         throw Exception("rowkey ranges shouldn't be empty", ErrorCodes::LOGICAL_ERROR);
 
-    SkippableBlockInputStreamPtr stable_input_stream
-        = stable_snap->getInputStream(dm_context, read_columns, rowkey_ranges, filter, max_version, expected_block_size, false);
     RowKeyRange rowkey_range = rowkey_ranges.size() == 1 ? rowkey_ranges[0] : mergeRanges(rowkey_ranges, rowkey_ranges[0].is_common_handle, rowkey_ranges[0].rowkey_column_size);
-    return std::make_shared<DeltaMergeBlockInputStream<DeltaValueReader, IndexIterator, skippable_place>>( //
+
+    // The stable packs before the first delta index entry and after the last one are not affected by delta,
+    // they are read directly, and only the packs in between go through DeltaMergeBlockInputStream.
+    // Note that the rows of the direct parts are not filtered by `rowkey_range`, which is done by the callers.
+    size_t merge_pack_begin = 0;
+    size_t merge_pack_end = std::numeric_limits<size_t>::max();
+    if constexpr (!skippable_place)
+    {
+        if (delta_index_begin != delta_index_end)
+            std::tie(merge_pack_begin, merge_pack_end) = getPacksAffectedByDelta(stable_snap, delta_index_begin, delta_index_end);
+    }
+
+    SkippableBlockInputStreamPtr stable_input_stream = stable_snap->getInputStream(
+        dm_context,
+        read_columns,
+        rowkey_ranges,
+        filter,
+        max_version,
+        expected_block_size,
+        false,
+        merge_pack_begin,
+        merge_pack_end,
+        topn_threshold);
+    SkippableBlockInputStreamPtr merged_stream = std::make_shared<DeltaMergeBlockInputStream<DeltaValueReader, IndexIterator, skippable_place>>( //
         stable_input_stream,
         delta_reader,
         delta_index_begin,
         delta_index_end,
         rowkey_range,
         expected_block_size);
+    if (merge_pack_begin == 0 && merge_pack_end >= stable_snap->getPacks())
+        return merged_stream;
+
+    SkippableBlockInputStreams streams;
+    if (merge_pack_begin > 0)
+        streams.push_back(stable_snap->getInputStream(dm_context, read_columns, rowkey_ranges, filter, max_version, expected_block_size, false, 0, merge_pack_begin, topn_threshold));
+    streams.push_back(merged_stream);
+    if (merge_pack_end < stable_snap->getPacks())
+        streams.push_back(stable_snap->getInputStream(dm_context, read_columns, rowkey_ranges, filter, max_version, expected_block_size, false, merge_pack_end, std::numeric_limits<size_t>::max(), topn_threshold));
+    return std::make_shared<ConcatSkippableBlockInputStream>(streams);
 }
 
 std::pair<DeltaIndexPtr, bool> Segment::ensurePlace(const DMContext & dm_context,
                                                     const StableSnapshotPtr & stable_snap,
                                                     const DeltaValueReaderPtr & delta_reader,
                                                     const RowKeyRanges & read_ranges,
-                                                    UInt64 max_version) const
+                                                    UInt64 max_version,
+                                                    bool & skip_mem_table) const
 {
     auto delta_snap = delta_reader->getDeltaSnap();
     // Clone a new delta index.
@@ -1488,8 +1862,22 @@ std::pair<DeltaIndexPtr, bool> Segment::ensurePlace(const DMContext & dm_context
 
     auto [my_placed_rows, my_placed_deletes] = my_delta_index->getPlacedStatus();
 
+    size_t rows_end = delta_snap->getRows();
+    size_t deletes_end = delta_snap->getDeletes();
+    if (skip_mem_table)
+    {
+        // Some rows of MemTableSet have been placed by other threads, they can not be merged again.
+        if (my_placed_rows <= delta_snap->getMemTableSetRowsOffset() && my_placed_deletes <= delta_snap->getMemTableSetDeletesOffset())
+        {
+            rows_end = delta_snap->getMemTableSetRowsOffset();
+            deletes_end = delta_snap->getMemTableSetDeletesOffset();
+        }
+        else
+            skip_mem_table = false;
+    }
+
     // Let's do a fast check, determine whether we need to do place or not.
-    if (!delta_reader->shouldPlace(dm_context, my_delta_index, rowkey_range, relevant_range, max_version))
+    if (!delta_reader->shouldPlace(dm_context, my_delta_index, rowkey_range, relevant_range, max_version, rows_end, deletes_end))
         return {my_delta_index, false};
 
     CurrentMetrics::Increment cur_dm_segments{CurrentMetrics::DT_PlaceIndexUpdate};
@@ -1499,7 +1887,7 @@ std::pair<DeltaIndexPtr, bool> Segment::ensurePlace(const DMContext & dm_context
 
     EventRecorder recorder(ProfileEvents::DMPlace, ProfileEvents::DMPlaceNS);
 
-    auto items = delta_reader->getPlaceItems(my_placed_rows, my_placed_deletes, delta_snap->getRows(), delta_snap->getDeletes());
+    auto items = delta_reader->getPlaceItems(my_placed_rows, my_placed_deletes, rows_end, deletes_end);
 
     bool fully_indexed = true;
     for (auto & v : items)
@@ -1561,12 +1949,12 @@ std::pair<DeltaIndexPtr, bool> Segment::ensurePlace(const DMContext & dm_context
         }
     }
 
-    if (unlikely(my_placed_rows != delta_snap->getRows() || my_placed_deletes != delta_snap->getDeletes()))
+    if (unlikely(my_placed_rows != rows_end || my_placed_deletes != deletes_end))
     {
         throw Exception(
             fmt::format("Placed status not match! Expected place rows:{}, deletes:{}, but actually placed rows:{}, deletes:{}",
-                        delta_snap->getRows(),
-                        delta_snap->getDeletes(),
+                        rows_end,
+                        deletes_end,
                         my_placed_rows,
                         my_placed_deletes));
     }
@@ -81,15 +81,21 @@ public:
 
         ColumnDefinesPtr read_columns;
 
+        /// The sorted rows of MemTableSet which are not placed into the delta index, and need to be merged
+        /// by MemTableMergeBlockInputStream. nullptr if all rows of delta are placed.
+        MemTableIndex::SortedRowsPtr mem_table_sorted_rows;
+
         ReadInfo(
             DeltaValueReaderPtr delta_reader_,
             DeltaIndexIterator index_begin_,
             DeltaIndexIterator index_end_,
-            ColumnDefinesPtr read_columns_)
+            ColumnDefinesPtr read_columns_,
+            MemTableIndex::SortedRowsPtr mem_table_sorted_rows_ = nullptr)
             : delta_reader(delta_reader_)
             , index_begin(index_begin_)
             , index_end(index_end_)
             , read_columns(read_columns_)
+            , mem_table_sorted_rows(std::move(mem_table_sorted_rows_))
         {
         }
 
@@ -189,6 +195,10 @@ public:
         const DMContext & dm_context,
         const ColumnDefines & columns_to_read);
 
+    /// Get the max version of the rows in the snapshot. The max versions of stable are taken from the min-max index
+    /// of packs, while the version column of delta is read.
+    UInt64 getMaxVersion(const DMContext & dm_context, const SegmentSnapshotPtr & segment_snap) const;
+
     /// For those split, merge and mergeDelta methods, we should use prepareXXX/applyXXX combo in real production.
     /// split(), merge() and mergeDelta() are only used in test cases.
 
@@ -231,13 +241,16 @@ public:
     ///
     /// Note: This is only a shortcut function used in tests.
     /// Normally you should call `prepareMergeDelta`, `applyMergeDelta` instead.
-    SegmentPtr mergeDelta(DMContext & dm_context, const ColumnDefinesPtr & schema_snap) const;
+    SegmentPtr mergeDelta(DMContext & dm_context, const ColumnDefinesPtr & schema_snap, bool allow_partial = false) const;
 
+    /// If `allow_partial` is true, only the stable packs overlapping the delta could be rewritten, and the
+    /// other packs of the old DMFiles are reused. It doesn't compact the reused packs, so it should not be used by GC.
     StableValueSpacePtr prepareMergeDelta(
         DMContext & dm_context,
         const ColumnDefinesPtr & schema_snap,
         const SegmentSnapshotPtr & segment_snap,
-        WriteBatches & wbs) const;
+        WriteBatches & wbs,
+        bool allow_partial = false) const;
     SegmentPtr applyMergeDelta(
         DMContext & dm_context,
         const SegmentSnapshotPtr & segment_snap,
@@ -258,6 +271,7 @@ public:
     size_t getEstimatedBytes() const { return delta->getBytes() + stable->getBytes(); }
 
     PageId segmentId() const { return segment_id; }
+    UInt64 segmentEpoch() const { return epoch; }
     PageId nextSegmentId() const { return next_segment_id; }
 
     void check(DMContext & dm_context, const String & when) const;
@@ -296,6 +310,10 @@ public:
     bool hasAbandoned() { return delta->hasAbandoned(); }
 
     bool isSplitForbidden() { return split_forbidden; }
+
+    /// The times this segment is read. It is used to decide the priority of background tasks.
+    void increaseReadCount() { read_count.fetch_add(1, std::memory_order_relaxed); }
+    size_t getReadCount() const { return read_count.load(std::memory_order_relaxed); }
     void forbidSplit() { split_forbidden = true; }
 
     void drop(const FileProviderPtr & file_provider, WriteBatches & wbs);
@@ -311,12 +329,15 @@ public:
     void setLastCheckGCSafePoint(DB::Timestamp gc_safe_point) { last_check_gc_safe_point.store(gc_safe_point, std::memory_order_relaxed); }
 
 private:
+    /// If `merge_mem_table` is true, the rows of MemTableSet could be left unplaced, and the caller must merge
+    /// them by `ReadInfo::mem_table_sorted_rows`.
     ReadInfo getReadInfo(
         const DMContext & dm_context,
         const ColumnDefines & read_columns,
         const SegmentSnapshotPtr & segment_snap,
         const RowKeyRanges & read_ranges,
-        UInt64 max_version = std::numeric_limits<UInt64>::max()) const;
+        UInt64 max_version = std::numeric_limits<UInt64>::max(),
+        bool merge_mem_table = false) const;
 
     static ColumnDefinesPtr arrangeReadColumns(
         const ColumnDefine & handle,
@@ -334,7 +355,16 @@ private:
         const IndexIterator & delta_index_begin,
         const IndexIterator & delta_index_end,
         size_t expected_block_size,
-        UInt64 max_version = std::numeric_limits<UInt64>::max());
+        UInt64 max_version = std::numeric_limits<UInt64>::max(),
+        const TopNThresholdPtr & topn_threshold = nullptr);
+
+    /// Return the stable packs [begin, end) which could be affected by the delta index entries in [delta_index_begin, delta_index_end).
+    /// The packs are counted in order through all stable files.
+    template <class IndexIterator>
+    static std::pair<size_t, size_t> getPacksAffectedByDelta(
+        const StableSnapshotPtr & stable_snap,
+        const IndexIterator & delta_index_begin,
+        const IndexIterator & delta_index_end);
 
     /// Merge delta & stable, and then take the middle one.
     std::optional<RowKeyValue> getSplitPointSlow(
@@ -358,16 +388,30 @@ private:
         const SegmentSnapshotPtr & segment_snap,
         WriteBatches & wbs) const;
 
+    /// The key range of the rows and delete ranges in delta. Returns nothing if delta is empty.
+    std::optional<RowKeyRange> getDeltaKeyRange(
+        const DMContext & dm_context,
+        const SegmentSnapshotPtr & segment_snap) const;
+    /// Rewrite the stable packs overlapping the delta into a new DMFile, and reuse the other packs.
+    /// Returns nullptr if it is not worth doing, and the caller should rewrite the whole stable instead.
+    StableValueSpacePtr preparePartialMergeDelta(
+        DMContext & dm_context,
+        const ColumnDefinesPtr & schema_snap,
+        const SegmentSnapshotPtr & segment_snap,
+        WriteBatches & wbs) const;
 
     /// Make sure that all delta packs have been placed.
     /// Note that the index returned could be partial index, and cannot be updated to shared index.
+    /// If `skip_mem_table` is true, only the persisted part of delta is placed. And it is set to false if
+    /// the delta index has placed some rows of MemTableSet already, then all rows are placed.
     /// Returns <placed index, this index is fully indexed or not>
     std::pair<DeltaIndexPtr, bool> ensurePlace(
         const DMContext & dm_context,
         const StableSnapshotPtr & stable_snap,
         const DeltaValueReaderPtr & delta_reader,
         const RowKeyRanges & read_ranges,
-        UInt64 max_version) const;
+        UInt64 max_version,
+        bool & skip_mem_table) const;
 
     /// Reference the inserts/updates by delta tree.
     /// Returns fully placed or not. Some rows not match relevant_range are not placed.
@@ -404,6 +448,7 @@ private:
     const PageId next_segment_id;
 
     std::atomic<DB::Timestamp> last_check_gc_safe_point = 0;
+    std::atomic<size_t> read_count = 0;
 
     const DeltaValueSpacePtr delta;
     const StableValueSpacePtr stable;
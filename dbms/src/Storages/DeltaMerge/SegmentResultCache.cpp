@@ -0,0 +1,55 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <IO/WriteBufferFromString.h>
+#include <IO/WriteHelpers.h>
+#include <Storages/DeltaMerge/Segment.h>
+#include <Storages/DeltaMerge/SegmentResultCache.h>
+
+namespace DB
+{
+namespace DM
+{
+String SegmentResultCache::getKey(
+    const SegmentStreamTransform & transform,
+    TableID physical_table_id,
+    const Segment & segment,
+    const SegmentSnapshot & segment_snap,
+    const RowKeyRanges & read_ranges,
+    const ColumnDefines & columns_to_read)
+{
+    WriteBufferFromOwnString buf;
+    writeStringBinary(transform.cache_key, buf);
+    writeIntBinary(physical_table_id, buf);
+    writeIntBinary(segment.segmentId(), buf);
+    writeIntBinary(segment.segmentEpoch(), buf);
+    writeIntBinary(static_cast<UInt64>(segment_snap.delta->getRows()), buf);
+    writeIntBinary(static_cast<UInt64>(segment_snap.delta->getDeletes()), buf);
+    // The read ranges have been shrunk by the segment range.
+    writeIntBinary(static_cast<UInt64>(read_ranges.size()), buf);
+    for (const auto & range : read_ranges)
+    {
+        writeStringBinary(*range.start.value, buf);
+        writeStringBinary(*range.end.value, buf);
+    }
+    // The types of columns could be changed by DDL.
+    for (const auto & cd : columns_to_read)
+    {
+        writeIntBinary(cd.id, buf);
+        writeStringBinary(cd.type->getName(), buf);
+    }
+    return buf.releaseStr();
+}
+
+} // namespace DM
+} // namespace DB
@@ -0,0 +1,83 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <Common/ManagedLRUCache.h>
+#include <DataStreams/IBlockInputStream.h>
+#include <Storages/DeltaMerge/DeltaMergeDefines.h>
+#include <Storages/DeltaMerge/RowKeyRange.h>
+
+#include <functional>
+
+namespace DB
+{
+namespace DM
+{
+class Segment;
+struct SegmentSnapshot;
+
+/// Transform the stream of every segment separately, e.g. into the partial aggregation states of the segment.
+struct SegmentStreamTransform
+{
+    /// Identify `transform`, e.g. by the pushed down filter and the aggregation.
+    /// The results of the transform on segments are cached only if it is not empty.
+    String cache_key;
+    std::function<BlockInputStreamPtr(const BlockInputStreamPtr &)> transform;
+};
+using SegmentStreamTransformPtr = std::shared_ptr<const SegmentStreamTransform>;
+
+/// The output blocks of a SegmentStreamTransform on a segment snapshot.
+struct SegmentResult
+{
+    BlocksList blocks;
+    /// The max version of the rows in the segment snapshot. The result can only be reused by the reads with
+    /// max_version not less than it, otherwise some of the rows should be invisible to them.
+    UInt64 data_max_version = 0;
+    size_t bytes = 0;
+};
+
+struct SegmentResultWeightFunction
+{
+    size_t operator()(const SegmentResult & result) const { return result.bytes; }
+};
+
+/// Cache the results of SegmentStreamTransform on segments, so that the repeated queries on unchanged data,
+/// e.g. the aggregations of dashboards, only read the segments changed since last time.
+///
+/// The key contains the id and epoch of the segment, and the rows and deletes of the delta. The epoch is increased
+/// after split / merge / merge delta, and the delta is only appended by writes between them, so they identify the
+/// content of a segment snapshot. The entries of replaced segments are never hit again and evicted by LRU.
+class SegmentResultCache : public ManagedLRUCache<String, SegmentResult, std::hash<String>, SegmentResultWeightFunction>
+{
+private:
+    using Base = ManagedLRUCache<String, SegmentResult, std::hash<String>, SegmentResultWeightFunction>;
+
+public:
+    explicit SegmentResultCache(size_t max_size_in_bytes)
+        : Base(max_size_in_bytes)
+    {}
+
+    static String getKey(
+        const SegmentStreamTransform & transform,
+        TableID physical_table_id,
+        const Segment & segment,
+        const SegmentSnapshot & segment_snap,
+        const RowKeyRanges & read_ranges,
+        const ColumnDefines & columns_to_read);
+};
+
+using SegmentResultCachePtr = std::shared_ptr<SegmentResultCache>;
+
+} // namespace DM
+} // namespace DB
@@ -33,6 +33,43 @@ extern const int LOGICAL_ERROR;
 
 namespace DM
 {
+namespace
+{
+std::pair<size_t, size_t> getValidRowsAndBytes(const DMFilePtr & file, const RowKeyRange & range, DMContext & dm_context)
+{
+    if (range.all())
+        return {file->getRows(), file->getBytes()};
+
+    auto pack_filter = DMFilePackFilter::loadFrom(
+        file,
+        dm_context.db_context.getGlobalContext().getMinMaxIndexCache(),
+        /*set_cache_if_miss*/ true,
+        {range},
+        EMPTY_FILTER,
+        {},
+        dm_context.db_context.getFileProvider(),
+        dm_context.getReadLimiter(),
+        dm_context.tracing_id);
+    return pack_filter.validRowsAndBytes();
+}
+
+/// Restrict the read ranges to the valid range of a file.
+RowKeyRanges shrinkRanges(const RowKeyRanges & rowkey_ranges, const RowKeyRange & file_range)
+{
+    RowKeyRanges res;
+    for (const auto & range : rowkey_ranges)
+    {
+        auto shrunk = range.shrink(file_range);
+        if (!shrunk.none())
+            res.push_back(std::move(shrunk));
+    }
+    // Note that empty ranges means reading all packs, so a none range is used to skip all packs.
+    if (res.empty())
+        res.push_back(RowKeyRange::newNone(file_range.is_common_handle, file_range.rowkey_column_size));
+    return res;
+}
+} // namespace
+
 void StableValueSpace::setFiles(const DMFiles & files_, const RowKeyRange & range, DMContext * dm_context)
 {
     UInt64 rows = 0;
@@ -48,20 +85,9 @@ void StableValueSpace::setFiles(const DMFiles & files_, const RowKeyRange & rang
     }
     else
     {
-        auto index_cache = dm_context->db_context.getGlobalContext().getMinMaxIndexCache();
         for (const auto & file : files_)
         {
-            auto pack_filter = DMFilePackFilter::loadFrom(
-                file,
-                index_cache,
-                /*set_cache_if_miss*/ true,
-                {range},
-                EMPTY_FILTER,
-                {},
-                dm_context->db_context.getFileProvider(),
-                dm_context->getReadLimiter(),
-                dm_context->tracing_id);
-            auto [file_valid_rows, file_valid_bytes] = pack_filter.validRowsAndBytes();
+            auto [file_valid_rows, file_valid_bytes] = getValidRowsAndBytes(file, range, *dm_context);
             rows += file_valid_rows;
             bytes += file_valid_bytes;
         }
@@ -70,17 +96,45 @@ void StableValueSpace::setFiles(const DMFiles & files_, const RowKeyRange & rang
     this->valid_rows = rows;
     this->valid_bytes = bytes;
     this->files = files_;
+    this->file_ranges.clear();
+}
+
+void StableValueSpace::setFiles(const DMFiles & files_, const RowKeyRanges & file_ranges_, DMContext & dm_context)
+{
+    if (unlikely(files_.size() != file_ranges_.size()))
+        throw Exception(fmt::format("Size of files and ranges not match, files: {}, ranges: {}", files_.size(), file_ranges_.size()),
+                        ErrorCodes::LOGICAL_ERROR);
+
+    UInt64 rows = 0;
+    UInt64 bytes = 0;
+    for (size_t i = 0; i < files_.size(); ++i)
+    {
+        auto [file_valid_rows, file_valid_bytes] = getValidRowsAndBytes(files_[i], file_ranges_[i], dm_context);
+        rows += file_valid_rows;
+        bytes += file_valid_bytes;
+    }
+
+    this->valid_rows = rows;
+    this->valid_bytes = bytes;
+    this->files = files_;
+    this->file_ranges = file_ranges_;
 }
 
 void StableValueSpace::saveMeta(WriteBatch & meta_wb)
 {
     MemoryWriteBuffer buf(0, 8192);
-    writeIntBinary(STORAGE_FORMAT_CURRENT.stable, buf);
+    // The files restricted by ranges are only created by partial merge delta, which is enabled since StableFormat::V2.
+    if (unlikely(!file_ranges.empty() && STORAGE_FORMAT_CURRENT.stable < StableFormat::V2))
+        throw Exception(fmt::format("Stable {} with file ranges can not be saved in version {}", id, STORAGE_FORMAT_CURRENT.stable),
+                        ErrorCodes::LOGICAL_ERROR);
+    writeIntBinary(file_ranges.empty() ? StableFormat::V1 : StableFormat::V2, buf);
     writeIntBinary(valid_rows, buf);
     writeIntBinary(valid_bytes, buf);
     writeIntBinary(static_cast<UInt64>(files.size()), buf);
     for (auto & f : files)
         writeIntBinary(f->pageId(), buf);
+    for (const auto & range : file_ranges)
+        range.serialize(buf);
 
     auto data_size = buf.count(); // Must be called before tryGetReadBuffer.
     meta_wb.putPage(id, 0, buf.tryGetReadBuffer(), data_size);
@@ -94,7 +148,7 @@ StableValueSpacePtr StableValueSpace::restore(DMContext & context, PageId id)
     ReadBufferFromMemory buf(page.data.begin(), page.data.size());
     UInt64 version, valid_rows, valid_bytes, size;
     readIntBinary(version, buf);
-    if (version != StableFormat::V1)
+    if (version != StableFormat::V1 && version != StableFormat::V2)
         throw Exception("Unexpected version: " + DB::toString(version));
 
     readIntBinary(valid_rows, buf);
@@ -111,6 +165,11 @@ StableValueSpacePtr StableValueSpace::restore(DMContext & context, PageId id)
         auto dmfile = DMFile::restore(context.db_context.getFileProvider(), file_id, page_id, file_parent_path, DMFile::ReadMetaMode::all());
         stable->files.push_back(dmfile);
     }
+    if (version == StableFormat::V2)
+    {
+        for (size_t i = 0; i < size; ++i)
+            stable->file_ranges.push_back(RowKeyRange::deserialize(buf));
+    }
 
     stable->valid_rows = valid_rows;
     stable->valid_bytes = valid_bytes;
@@ -178,8 +237,10 @@ void StableValueSpace::calculateStableProperty(const DMContext & context, const
     property.num_versions = 0;
     property.num_puts = 0;
     property.num_rows = 0;
-    for (auto & file : files)
+    for (size_t i = 0; i < files.size(); ++i)
     {
+        const auto & file = files[i];
+        const auto file_range = file_ranges.empty() ? rowkey_range : rowkey_range.shrink(file_ranges[i]);
         const auto & pack_stats = file->getPackStats();
         const auto & pack_properties = file->getPackProperties();
         if (pack_stats.empty())
@@ -210,7 +271,7 @@ void StableValueSpace::calculateStableProperty(const DMContext & context, const
                                                   .setRowsThreshold(std::numeric_limits<UInt64>::max()) // because we just read one pack at a time
                                                   .onlyReadOnePackEveryTime()
                                                   .setTracingID(fmt::format("{}-calculateStableProperty", context.tracing_id))
-                                                  .build(file, read_columns, RowKeyRanges{rowkey_range});
+                                                  .build(file, read_columns, RowKeyRanges{file_range});
             auto mvcc_stream = std::make_shared<DMVersionFilterBlockInputStream<DM_VERSION_FILTER_MODE_COMPACT>>(
                 data_stream,
                 read_columns,
@@ -239,7 +300,7 @@ void StableValueSpace::calculateStableProperty(const DMContext & context, const
             file,
             context.db_context.getGlobalContext().getMinMaxIndexCache(),
             /*set_cache_if_miss*/ false,
-            {rowkey_range},
+            {file_range},
             EMPTY_FILTER,
             {},
             context.db_context.getFileProvider(),
@@ -328,21 +389,41 @@ StableValueSpace::Snapshot::getInputStream(
     const RSOperatorPtr & filter,
     UInt64 max_data_version,
     size_t expected_block_size,
-    bool enable_clean_read)
+    bool enable_clean_read,
+    size_t pack_begin,
+    size_t pack_end,
+    const TopNThresholdPtr & topn_threshold)
 {
     LOG_FMT_DEBUG(log, "max_data_version: {}, enable_clean_read: {}", max_data_version, enable_clean_read);
     SkippableBlockInputStreams streams;
 
+    size_t file_pack_begin = 0;
     for (size_t i = 0; i < stable->files.size(); i++)
     {
         DMFileBlockInputStreamBuilder builder(context.db_context);
         builder
             .enableCleanRead(enable_clean_read, max_data_version)
             .setRSOperator(filter)
+            .setTopNThreshold(topn_threshold)
             .setColumnCache(column_caches[i])
+            .setReadPrefetchQuota(context.read_prefetch_quota)
             .setTracingID(context.tracing_id)
             .setRowsThreshold(expected_block_size);
-        streams.push_back(builder.build(stable->files[i], read_columns, rowkey_ranges));
+
+        size_t file_packs = stable->files[i]->getPacks();
+        if (pack_begin > file_pack_begin || pack_end < file_pack_begin + file_packs)
+        {
+            auto read_packs = std::make_shared<IdSet>();
+            for (size_t pack_id = std::max(pack_begin, file_pack_begin); pack_id < std::min(pack_end, file_pack_begin + file_packs); ++pack_id)
+                read_packs->insert(pack_id - file_pack_begin);
+            builder.setReadPacks(read_packs);
+        }
+        file_pack_begin += file_packs;
+
+        if (stable->file_ranges.empty())
+            streams.push_back(builder.build(stable->files[i], read_columns, rowkey_ranges));
+        else
+            streams.push_back(builder.build(stable->files[i], read_columns, shrinkRanges(rowkey_ranges, stable->file_ranges[i])));
     }
     return std::make_shared<ConcatSkippableBlockInputStream>(streams);
 }
@@ -359,13 +440,17 @@ RowsAndBytes StableValueSpace::Snapshot::getApproxRowsAndBytes(const DMContext &
     // Usually, this method will be called for some "cold" key ranges.
     // Loading the index into cache may pollute the cache and make the hot index cache invalid.
     // So don't refill the cache if the index does not exist.
-    for (auto & f : stable->files)
+    for (size_t file_idx = 0; file_idx < stable->files.size(); ++file_idx)
     {
+        const auto & f = stable->files[file_idx];
+        auto file_range = stable->file_ranges.empty() ? range : range.shrink(stable->file_ranges[file_idx]);
+        if (file_range.none())
+            continue;
         auto filter = DMFilePackFilter::loadFrom(
             f,
             context.db_context.getGlobalContext().getMinMaxIndexCache(),
             /*set_cache_if_miss*/ false,
-            {range},
+            {file_range},
             RSOperatorPtr{},
             IdSetPtr{},
             context.db_context.getFileProvider(),
@@ -30,6 +30,8 @@ struct WriteBatches;
 struct DMContext;
 class RSOperator;
 using RSOperatorPtr = std::shared_ptr<RSOperator>;
+class TopNThreshold;
+using TopNThresholdPtr = std::shared_ptr<TopNThreshold>;
 
 class StableValueSpace;
 using StableValueSpacePtr = std::shared_ptr<StableValueSpace>;
@@ -47,6 +49,14 @@ public:
     // bytes and rows.
     void setFiles(const DMFiles & files_, const RowKeyRange & range, DMContext * dm_context = nullptr);
 
+    // Set DMFiles for this value space, and only the rows of `files_[i]` in `file_ranges_[i]` are valid.
+    // The ranges must be sorted and not overlapped with each other, so that the concatenated rows are still sorted.
+    // It is used by partial merge delta, which reuses the unchanged packs of the old DMFiles.
+    void setFiles(const DMFiles & files_, const RowKeyRanges & file_ranges_, DMContext & dm_context);
+
+    bool hasFileRanges() const { return !file_ranges.empty(); }
+    const RowKeyRanges & getFileRanges() const { return file_ranges; }
+
     PageId getId() { return id; }
     void saveMeta(WriteBatch & meta_wb);
     const DMFiles & getDMFiles() { return files; }
@@ -144,13 +154,19 @@ public:
 
         ColumnCachePtrs & getColumnCaches() { return column_caches; }
 
+        /// Only the packs in [pack_begin, pack_end) of all files are read, the packs of all files are counted in order.
+        /// The rows of other packs are returned as skipped rows, so the row ids of stable are not changed.
+        /// If `topn_threshold` is set, the packs which can not enter the result of TopN are skipped while reading.
         SkippableBlockInputStreamPtr getInputStream(const DMContext & context, //
                                                     const ColumnDefines & read_columns,
                                                     const RowKeyRanges & rowkey_ranges,
                                                     const RSOperatorPtr & filter,
                                                     UInt64 max_data_version,
                                                     size_t expected_block_size,
-                                                    bool enable_clean_read);
+                                                    bool enable_clean_read,
+                                                    size_t pack_begin = 0,
+                                                    size_t pack_end = std::numeric_limits<size_t>::max(),
+                                                    const TopNThresholdPtr & topn_threshold = nullptr);
 
         RowsAndBytes getApproxRowsAndBytes(const DMContext & context, const RowKeyRange & range) const;
 
@@ -170,6 +186,8 @@ private:
     UInt64 valid_rows;
     UInt64 valid_bytes;
     DMFiles files;
+    // The valid range of each file. Empty means that the files are not restricted by ranges.
+    RowKeyRanges file_ranges;
 
     StableProperty property;
     std::atomic<bool> is_property_cached = false;
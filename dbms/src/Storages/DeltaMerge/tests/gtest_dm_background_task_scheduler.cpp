@@ -0,0 +1,156 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Storages/DeltaMerge/BackgroundTaskScheduler.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+namespace DB
+{
+namespace DM
+{
+namespace tests
+{
+namespace
+{
+BackgroundTaskScheduler::TaskInfo makeTask(UInt64 store_id, UInt64 segment_id, const String & type, bool is_heavy, double score)
+{
+    BackgroundTaskScheduler::TaskInfo info;
+    info.store_id = store_id;
+    info.segment_id = segment_id;
+    info.type = type;
+    info.is_heavy = is_heavy;
+    info.score = score;
+    return info;
+}
+} // namespace
+
+TEST(BackgroundTaskSchedulerTest, PickHighestScoreAcrossStores)
+{
+    BackgroundTaskScheduler scheduler(BackgroundTaskScheduler::Limits{}, nullptr);
+
+    std::vector<UInt64> woken;
+    auto store_a = scheduler.registerStore("db.a", [&](bool) { woken.push_back(1); });
+    auto store_b = scheduler.registerStore("db.b", [&](bool) { woken.push_back(2); });
+
+    auto task_a = scheduler.addTask(makeTask(store_a, 1, "MergeDelta", true, 0.5), 100);
+    auto task_b = scheduler.addTask(makeTask(store_b, 2, "MergeDelta", true, 2.0), 100);
+    ASSERT_NE(task_a, 0UL);
+    ASSERT_NE(task_b, 0UL);
+
+    // The task of store b is more valuable, store a can not take its task and store b is woken up.
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, true), 0UL);
+    ASSERT_EQ(woken, std::vector<UInt64>{2});
+    ASSERT_EQ(scheduler.tryTakeTask(store_b, true), task_b);
+    // Light tasks are scheduled separately.
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, false), 0UL);
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, true), task_a);
+
+    auto tasks = scheduler.getTasks();
+    ASSERT_EQ(tasks.size(), 2UL);
+    ASSERT_TRUE(tasks[0].is_running && tasks[1].is_running);
+    ASSERT_EQ(tasks[0].store_name, "db.a");
+    ASSERT_EQ(tasks[1].store_name, "db.b");
+
+    woken.clear();
+    scheduler.finishTask(task_b);
+    scheduler.finishTask(task_a);
+    ASSERT_TRUE(scheduler.getTasks().empty());
+    ASSERT_TRUE(woken.empty());
+}
+
+TEST(BackgroundTaskSchedulerTest, ConcurrencyLimit)
+{
+    BackgroundTaskScheduler::Limits limits;
+    limits.max_concurrency["MergeDelta"] = 1;
+    BackgroundTaskScheduler scheduler(limits, nullptr);
+
+    size_t woken = 0;
+    auto store = scheduler.registerStore("db.t", [&](bool) { ++woken; });
+    auto merge_delta_1 = scheduler.addTask(makeTask(store, 1, "MergeDelta", true, 3.0), 100);
+    auto merge_delta_2 = scheduler.addTask(makeTask(store, 2, "MergeDelta", true, 2.0), 100);
+    auto split = scheduler.addTask(makeTask(store, 3, "Split", true, 1.0), 100);
+
+    ASSERT_EQ(scheduler.tryTakeTask(store, true), merge_delta_1);
+    // The second merge delta is blocked by the limit, the split task can run.
+    ASSERT_EQ(scheduler.tryTakeTask(store, true), split);
+    ASSERT_EQ(scheduler.tryTakeTask(store, true), 0UL);
+
+    scheduler.finishTask(merge_delta_1);
+    ASSERT_GT(woken, 0UL);
+    ASSERT_EQ(scheduler.tryTakeTask(store, true), merge_delta_2);
+    scheduler.finishTask(merge_delta_2);
+    scheduler.finishTask(split);
+}
+
+TEST(BackgroundTaskSchedulerTest, QueueLimitAndUnregister)
+{
+    BackgroundTaskScheduler scheduler(BackgroundTaskScheduler::Limits{}, nullptr);
+
+    auto store = scheduler.registerStore("db.t", [](bool) {});
+    // 10% of the space is reserved for light tasks.
+    size_t added = 0;
+    for (size_t i = 0; i < 20; ++i)
+        added += scheduler.addTask(makeTask(store, i, "Split", true, 1.0), 20) != 0;
+    ASSERT_EQ(added, 18UL);
+    ASSERT_NE(scheduler.addTask(makeTask(store, 100, "Flush", false, 1.0), 20), 0UL);
+    ASSERT_EQ(scheduler.queuedTasks(), 19UL);
+
+    auto running = scheduler.tryTakeTask(store, false);
+    ASSERT_NE(running, 0UL);
+    scheduler.unregisterStore(store);
+    ASSERT_EQ(scheduler.queuedTasks(), 0UL);
+    ASSERT_EQ(scheduler.addTask(makeTask(store, 101, "Flush", false, 1.0), 20), 0UL);
+    // The running task is still tracked until it is finished.
+    ASSERT_EQ(scheduler.getTasks().size(), 1UL);
+    scheduler.finishTask(running);
+    ASSERT_TRUE(scheduler.getTasks().empty());
+}
+
+TEST(BackgroundTaskSchedulerTest, WakerCallsBackIntoScheduler)
+{
+    BackgroundTaskScheduler scheduler(BackgroundTaskScheduler::Limits{}, nullptr);
+
+    // The wakers are called without holding the lock of the scheduler, so they can take the tasks directly.
+    UInt64 store_b = 0;
+    std::vector<UInt64> taken;
+    auto store_a = scheduler.registerStore("db.a", [](bool) {});
+    store_b = scheduler.registerStore("db.b", [&](bool is_heavy) {
+        if (auto task_id = scheduler.tryTakeTask(store_b, is_heavy); task_id != 0)
+            taken.push_back(task_id);
+    });
+
+    auto task_a = scheduler.addTask(makeTask(store_a, 1, "MergeDelta", true, 1.0), 100);
+    auto task_b1 = scheduler.addTask(makeTask(store_b, 2, "MergeDelta", true, 3.0), 100);
+    auto task_b2 = scheduler.addTask(makeTask(store_b, 3, "MergeDelta", true, 2.0), 100);
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, true), 0UL);
+    ASSERT_EQ(taken, std::vector<UInt64>{task_b1});
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, true), 0UL);
+    ASSERT_EQ(taken, (std::vector<UInt64>{task_b1, task_b2}));
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, true), task_a);
+
+    // No waker is called after the store is unregistered.
+    scheduler.unregisterStore(store_b);
+    auto task_a2 = scheduler.addTask(makeTask(store_a, 4, "MergeDelta", true, 1.0), 100);
+    taken.clear();
+    for (auto task_id : {task_b1, task_b2, task_a})
+        scheduler.finishTask(task_id);
+    ASSERT_TRUE(taken.empty());
+    ASSERT_EQ(scheduler.tryTakeTask(store_a, true), task_a2);
+    scheduler.finishTask(task_a2);
+    ASSERT_TRUE(scheduler.getTasks().empty());
+}
+
+} // namespace tests
+} // namespace DM
+} // namespace DB
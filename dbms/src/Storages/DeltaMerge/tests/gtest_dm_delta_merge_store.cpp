@@ -22,11 +22,13 @@
 #include <Parsers/ASTLiteral.h>
 #include <Poco/File.h>
 #include <Storages/DeltaMerge/DMContext.h>
+#include <Storages/DeltaMerge/DMSegmentThreadInputStream.h>
 #include <Storages/DeltaMerge/DeltaMergeStore.h>
 #include <Storages/DeltaMerge/File/DMFileBlockOutputStream.h>
 #include <Storages/DeltaMerge/Filter/RSOperator.h>
 #include <Storages/DeltaMerge/PKSquashingBlockInputStream.h>
 #include <Storages/DeltaMerge/Segment.h>
+#include <Storages/DeltaMerge/SegmentResultCache.h>
 #include <Storages/DeltaMerge/tests/DMTestEnv.h>
 #include <Storages/DeltaMerge/tests/MultiSegmentTestUtil.h>
 #include <Storages/tests/TiFlashStorageTestBasic.h>
@@ -34,6 +36,7 @@
 #include <TestUtils/TiFlashTestBasic.h>
 #include <fmt/format.h>
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <vector>
@@ -1195,6 +1198,84 @@ try
 }
 CATCH
 
+TEST_P(DeltaMergeStoreRWTest, ReadWithSegmentResultCache)
+try
+{
+    auto & global_context = db_context->getGlobalContext();
+    if (!global_context.getSegmentResultCache())
+        global_context.setSegmentResultCache(DEFAULT_SEGMENT_RESULT_CACHE_SIZE);
+
+    // Don't share the cached results between the test cases.
+    static std::atomic<size_t> test_round = 0;
+    size_t transform_times = 0;
+    auto transform = std::make_shared<SegmentStreamTransform>();
+    transform->cache_key = fmt::format("count_rows_{}", test_round++);
+    // Count the rows of every segment.
+    transform->transform = [&](const BlockInputStreamPtr & stream) -> BlockInputStreamPtr {
+        ++transform_times;
+        UInt64 rows = 0;
+        stream->readPrefix();
+        while (Block block = stream->read())
+            rows += block.rows();
+        stream->readSuffix();
+        return std::make_shared<OneBlockInputStream>(Block{DB::tests::createColumn<UInt64>({rows}, "rows")});
+    };
+
+    auto read_rows = [&](UInt64 max_version) {
+        BlockInputStreams ins = store->read(*db_context,
+                                            db_context->getSettingsRef(),
+                                            store->getTableColumns(),
+                                            {RowKeyRange::newAll(store->isCommonHandle(), store->getRowKeyColumnSize())},
+                                            /* num_streams= */ 1,
+                                            max_version,
+                                            EMPTY_FILTER,
+                                            TRACING_NAME,
+                                            /* expected_block_size= */ 1024);
+        auto in = std::dynamic_pointer_cast<DMSegmentThreadInputStream>(ins.at(0));
+        in->setSegmentTransform(transform);
+        // The transform is applied on an empty stream to get the header.
+        --transform_times;
+
+        UInt64 rows = 0;
+        in->readPrefix();
+        while (Block block = in->read())
+            rows += block.getByName("rows").column->getUInt(0);
+        in->readSuffix();
+        return rows;
+    };
+
+    store->write(*db_context, db_context->getSettingsRef(), DMTestEnv::prepareSimpleWriteBlock(0, 128, false, /* tso= */ 2));
+    ASSERT_EQ(read_rows(std::numeric_limits<UInt64>::max()), 128UL);
+    ASSERT_EQ(transform_times, 1UL);
+    // The segment is not changed, hit the cache.
+    ASSERT_EQ(read_rows(std::numeric_limits<UInt64>::max()), 128UL);
+    ASSERT_EQ(transform_times, 1UL);
+
+    // Some rows are invisible, neither use nor fill the cache.
+    ASSERT_EQ(read_rows(1), 0UL);
+    ASSERT_EQ(transform_times, 2UL);
+    ASSERT_EQ(read_rows(1), 0UL);
+    ASSERT_EQ(transform_times, 3UL);
+
+    // The segment is changed by writing.
+    store->write(*db_context, db_context->getSettingsRef(), DMTestEnv::prepareSimpleWriteBlock(128, 192, false, /* tso= */ 3));
+    ASSERT_EQ(read_rows(std::numeric_limits<UInt64>::max()), 192UL);
+    ASSERT_EQ(transform_times, 4UL);
+    ASSERT_EQ(read_rows(std::numeric_limits<UInt64>::max()), 192UL);
+    ASSERT_EQ(transform_times, 4UL);
+    // The cached result contains the rows of tso 3, which are invisible to the reading of tso 2.
+    ASSERT_EQ(read_rows(2), 128UL);
+    ASSERT_EQ(transform_times, 5UL);
+
+    // The segment is changed by merging delta.
+    store->mergeDeltaAll(*db_context);
+    ASSERT_EQ(read_rows(std::numeric_limits<UInt64>::max()), 192UL);
+    ASSERT_EQ(transform_times, 6UL);
+    ASSERT_EQ(read_rows(std::numeric_limits<UInt64>::max()), 192UL);
+    ASSERT_EQ(transform_times, 6UL);
+}
+CATCH
+
 TEST_P(DeltaMergeStoreRWTest, Ingest)
 try
 {
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <Common/DynamicThreadPool.h>
 #include <Common/FailPoint.h>
 #include <Interpreters/Context.h>
 #include <Storages/DeltaMerge/DMContext.h>
@@ -19,10 +20,12 @@
 #include <Storages/DeltaMerge/File/DMFileBlockInputStream.h>
 #include <Storages/DeltaMerge/File/DMFileBlockOutputStream.h>
 #include <Storages/DeltaMerge/File/DMFileWriter.h>
+#include <Storages/DeltaMerge/Filter/TopNThreshold.h>
 #include <Storages/DeltaMerge/RowKeyRange.h>
 #include <Storages/DeltaMerge/tests/DMTestEnv.h>
 #include <Storages/tests/TiFlashStorageTestBasic.h>
 #include <TestUtils/FunctionTestUtils.h>
+#include <ext/scope_guard.h>
 
 #include <vector>
 
@@ -537,6 +540,82 @@ try
 }
 CATCH
 
+TEST_P(DMFile_Test, ReadWithDirectIO)
+try
+{
+    auto cols = DMTestEnv::getDefaultColumns();
+    const size_t num_rows_write = 100000;
+    const size_t nparts = 10;
+    const size_t span_per_part = num_rows_write / nparts;
+    {
+        auto stream = std::make_shared<DMFileBlockOutputStream>(dbContext(), dm_file, *cols);
+        stream->writePrefix();
+        DMFileBlockOutputStream::BlockProperty block_property;
+        for (size_t i = 0; i < nparts; ++i)
+        {
+            Block block = DMTestEnv::prepareSimpleWriteBlock(i * span_per_part, (i + 1) * span_per_part, false);
+            stream->write(block, block_property);
+        }
+        stream->writeSuffix();
+    }
+
+    auto & settings = dbContext().getSettingsRef();
+    auto old_threshold = settings.min_bytes_to_use_direct_io;
+    SCOPE_EXIT({ settings.min_bytes_to_use_direct_io = old_threshold; });
+    settings.min_bytes_to_use_direct_io = 1;
+
+    // Read all packs, and the packs filtered by handle which are not continuous.
+    for (const auto & read_packs : std::vector<IdSetPtr>{nullptr, std::make_shared<IdSet>(IdSet{1, 2, 5, 9})})
+    {
+        // A small quota so that only part of the chunks are prefetched.
+        auto quota = std::make_shared<ReadPrefetchQuota>(2 * DirectReadBufferPool::BUFFER_SIZE);
+        DMFileBlockInputStreamBuilder builder(dbContext());
+        auto stream = builder
+                          .setReadPacks(read_packs)
+                          .setReadPrefetchQuota(quota)
+                          .build(dm_file, *cols, RowKeyRanges{RowKeyRange::newAll(false, 1)});
+
+        size_t expected_rows = 0;
+        for (size_t pack_id = 0; pack_id < dm_file->getPacks(); ++pack_id)
+        {
+            if (!read_packs || read_packs->count(pack_id))
+                expected_rows += dm_file->getPackStats()[pack_id].rows;
+        }
+
+        size_t pack_id = 0;
+        size_t row_in_pack = 0;
+        Int64 pack_first_pk = 0;
+        size_t num_rows_read = 0;
+        stream->readPrefix();
+        while (Block in = stream->read())
+        {
+            const auto & c = in.getByName(DMTestEnv::pk_name).column;
+            for (size_t i = 0; i < c->size(); ++i)
+            {
+                while (read_packs && !read_packs->count(pack_id))
+                {
+                    pack_first_pk += dm_file->getPackStats()[pack_id].rows;
+                    ++pack_id;
+                }
+                ASSERT_EQ(c->getInt(i), pack_first_pk + static_cast<Int64>(row_in_pack));
+                if (++row_in_pack == dm_file->getPackStats()[pack_id].rows)
+                {
+                    pack_first_pk += row_in_pack;
+                    row_in_pack = 0;
+                    ++pack_id;
+                }
+            }
+            num_rows_read += in.rows();
+        }
+        stream->readSuffix();
+        ASSERT_EQ(num_rows_read, expected_rows);
+        stream.reset();
+        // All the prefetched memory is released.
+        ASSERT_EQ(quota->getUsedBytes(), 0UL);
+    }
+}
+CATCH
+
 namespace
 {
 RSOperatorPtr toRSFilter(const ColumnDefine & cd, const HandleRange & range)
@@ -641,6 +720,85 @@ try
 }
 CATCH
 
+TEST_P(DMFile_Test, ReadSkippedByTopNThreshold)
+try
+{
+    auto cols = DMTestEnv::getDefaultColumns();
+    // Prepare columns
+    ColumnDefine i64_cd(2, "i64", typeFromString("Int64"));
+    cols->push_back(i64_cd);
+
+    reload(cols);
+
+    const size_t pack_rows = 128;
+    const size_t num_packs = 8;
+    {
+        // Prepare 8 packs, the rows of pack 3 are not clean
+        auto stream = std::make_shared<DMFileBlockOutputStream>(dbContext(), dm_file, *cols);
+        stream->writePrefix();
+        for (size_t i = 0; i < num_packs; ++i)
+        {
+            Block block = DMTestEnv::prepareSimpleWriteBlock(i * pack_rows, (i + 1) * pack_rows, false);
+            block.insert(DB::tests::createColumn<Int64>(
+                createNumbers<Int64>(i * pack_rows, (i + 1) * pack_rows),
+                i64_cd.name,
+                i64_cd.id));
+            DMFileBlockOutputStream::BlockProperty block_property{};
+            block_property.not_clean_rows = i == 3 ? 1 : 0;
+            block_property.effective_num_rows = pack_rows;
+            stream->write(block, block_property);
+        }
+        stream->writeSuffix();
+    }
+
+    // Return the first value of i64 of every block read.
+    auto read_packs = [&](const TopNThresholdPtr & threshold, std::function<void()> after_first_block) {
+        DMFileBlockInputStreamBuilder builder(dbContext());
+        auto stream = builder
+                          .setColumnCache(column_cache_)
+                          .setTopNThreshold(threshold)
+                          .onlyReadOnePackEveryTime()
+                          .build(dm_file, *cols, RowKeyRanges{RowKeyRange::newAll(false, 1)});
+        std::vector<Int64> pack_starts;
+        stream->readPrefix();
+        while (Block in = stream->read())
+        {
+            EXPECT_EQ(in.rows(), pack_rows);
+            pack_starts.push_back(in.getByName(i64_cd.name).column->getInt(0));
+            if (after_first_block && pack_starts.size() == 1)
+                after_first_block();
+        }
+        stream->readSuffix();
+        return pack_starts;
+    };
+
+    {
+        // Packs with min value > 300 are skipped, except pack 4, because the older versions of
+        // its rows could be in pack 3. Pack 0 is never skipped.
+        auto threshold = std::make_shared<TopNThreshold>(i64_cd.id, false, false);
+        threshold->publish(300);
+        ASSERT_EQ(read_packs(threshold, {}), (std::vector<Int64>{0, 128, 256, 512}));
+    }
+    {
+        // Packs with max value < 700 are skipped.
+        auto threshold = std::make_shared<TopNThreshold>(i64_cd.id, true, false);
+        threshold->publish(700);
+        ASSERT_EQ(read_packs(threshold, {}), (std::vector<Int64>{0, 512, 640, 768, 896}));
+    }
+    {
+        // The threshold published while reading is used for the rest packs.
+        auto threshold = std::make_shared<TopNThreshold>(i64_cd.id, false, false);
+        ASSERT_EQ(read_packs(threshold, [&] { threshold->publish(200); }), (std::vector<Int64>{0, 128, 512}));
+    }
+    {
+        // Threshold of other column is ignored.
+        auto threshold = std::make_shared<TopNThreshold>(i64_cd.id + 100, false, false);
+        threshold->publish(0);
+        ASSERT_EQ(read_packs(threshold, {}).size(), num_packs);
+    }
+}
+CATCH
+
 // Test rough filter with some unsupported operations
 TEST_P(DMFile_Test, ReadFilteredByRoughSetFilterWithUnsupportedOperation)
 try
@@ -895,6 +1053,74 @@ try
 }
 CATCH
 
+TEST_P(DMFile_Test, WriteWideTableInParallel)
+try
+{
+    // The columns are written on the calling thread if there is no global thread pool.
+    const bool create_thread_pool = !DynamicThreadPool::global_instance;
+    if (create_thread_pool)
+        DynamicThreadPool::global_instance = std::make_unique<DynamicThreadPool>(4, std::chrono::milliseconds(60000));
+    SCOPE_EXIT({
+        if (create_thread_pool)
+            DynamicThreadPool::global_instance.reset();
+    });
+
+    auto & settings = dbContext().getSettingsRef();
+    auto old_write_threads = settings.dt_dmfile_write_threads;
+    SCOPE_EXIT({ settings.dt_dmfile_write_threads = old_write_threads; });
+    settings.dt_dmfile_write_threads = 4;
+
+    const size_t num_extra_cols = 24;
+    auto cols = DMTestEnv::getDefaultColumns();
+    for (size_t i = 0; i < num_extra_cols; ++i)
+        cols->emplace_back(ColumnDefine(100 + i, fmt::format("i64_{}", i), typeFromString("Int64")));
+    reload(cols);
+
+    const size_t num_rows_per_block = 1000;
+    const size_t num_blocks = 5;
+    {
+        auto stream = std::make_shared<DMFileBlockOutputStream>(dbContext(), dm_file, *cols);
+        stream->writePrefix();
+        for (size_t b = 0; b < num_blocks; ++b)
+        {
+            const size_t start = b * num_rows_per_block;
+            Block block = DMTestEnv::prepareSimpleWriteBlock(start, start + num_rows_per_block, false);
+            for (size_t i = 0; i < num_extra_cols; ++i)
+            {
+                std::vector<Int64> values(num_rows_per_block);
+                for (size_t r = 0; r < num_rows_per_block; ++r)
+                    values[r] = (start + r) * (i + 1);
+                block.insert(DB::tests::createColumn<Int64>(values, fmt::format("i64_{}", i), 100 + i));
+            }
+            DMFileBlockOutputStream::BlockProperty block_property;
+            stream->write(block, block_property);
+        }
+        stream->writeSuffix();
+    }
+
+    {
+        DMFileBlockInputStreamBuilder builder(dbContext());
+        auto stream = builder
+                          .setColumnCache(column_cache_)
+                          .build(dm_file, *cols, RowKeyRanges{RowKeyRange::newAll(false, 1)});
+        size_t num_rows_read = 0;
+        stream->readPrefix();
+        while (Block in = stream->read())
+        {
+            for (size_t i = 0; i < num_extra_cols; ++i)
+            {
+                const auto & col = in.getByName(fmt::format("i64_{}", i)).column;
+                for (size_t r = 0; r < col->size(); ++r)
+                    ASSERT_EQ(col->getInt(r), static_cast<Int64>((num_rows_read + r) * (i + 1)));
+            }
+            num_rows_read += in.rows();
+        }
+        stream->readSuffix();
+        ASSERT_EQ(num_rows_read, num_rows_per_block * num_blocks);
+    }
+}
+CATCH
+
 TEST_P(DMFile_Test, StringType)
 try
 {
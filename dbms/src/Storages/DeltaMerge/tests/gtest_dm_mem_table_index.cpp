@@ -0,0 +1,202 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnString.h>
+#include <Columns/ColumnsNumber.h>
+#include <Common/CurrentMetrics.h>
+#include <Storages/DeltaMerge/DMContext.h>
+#include <Storages/DeltaMerge/Delta/MemTableIndex.h>
+#include <Storages/DeltaMerge/DeltaMergeStore.h>
+#include <Storages/DeltaMerge/Segment.h>
+#include <Storages/DeltaMerge/StoragePool.h>
+#include <Storages/DeltaMerge/tests/DMTestEnv.h>
+#include <Storages/tests/TiFlashStorageTestBasic.h>
+#include <TestUtils/FunctionTestUtils.h>
+#include <TestUtils/TiFlashTestBasic.h>
+
+namespace CurrentMetrics
+{
+extern const Metric DT_SnapshotOfRead;
+} // namespace CurrentMetrics
+
+namespace DB
+{
+namespace DM
+{
+namespace tests
+{
+namespace
+{
+std::vector<size_t> toVector(const MemTableIndex::SortedRows & rows)
+{
+    return std::vector<size_t>(rows.begin(), rows.end());
+}
+} // namespace
+
+TEST(MemTableIndexTest, IntHandle)
+{
+    MemTableIndex index;
+    auto append = [&](const std::vector<Int64> & handles, const std::vector<UInt64> & versions) {
+        auto handle_col = ColumnInt64::create();
+        auto version_col = ColumnUInt64::create();
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            handle_col->insert(handles[i]);
+            version_col->insert(versions[i]);
+        }
+        // Only append the rows after the first one.
+        index.append(*handle_col, *version_col, 1, handles.size() - 1);
+    };
+
+    ASSERT_TRUE(index.getSortedRows()->empty());
+
+    // rows: 0:(5,1) 1:(7,1) 2:(9,1)
+    append({100, 5, 7, 9}, {0, 1, 1, 1});
+    auto snapshot = index.getSortedRows();
+    ASSERT_EQ(toVector(*snapshot), (std::vector<size_t>{0, 1, 2}));
+
+    // rows: 3:(7,2) 4:(1,2) 5:(7,1)
+    append({100, 7, 1, 7}, {0, 2, 2, 1});
+    ASSERT_EQ(index.getRows(), 6UL);
+    // (1,2) (5,1) (7,1) (7,1) (7,2) (9,1), the rows with the same handle and version are sorted by offset.
+    ASSERT_EQ(toVector(*index.getSortedRows()), (std::vector<size_t>{4, 0, 1, 5, 3, 2}));
+    // The old snapshot is not changed.
+    ASSERT_EQ(toVector(*snapshot), (std::vector<size_t>{0, 1, 2}));
+}
+
+TEST(MemTableIndexTest, CommonHandle)
+{
+    MemTableIndex index;
+    auto handle_col = ColumnString::create();
+    auto version_col = ColumnUInt64::create();
+    for (const auto * handle : {"b", "ab", "a", "b"})
+        handle_col->insertData(handle, strlen(handle));
+    for (UInt64 version : {3, 1, 1, 2})
+        version_col->insert(version);
+    index.append(*handle_col, *version_col, 0, 4);
+    ASSERT_EQ(toVector(*index.getSortedRows()), (std::vector<size_t>{2, 1, 3, 0}));
+}
+
+class MemTableSegmentReadTest : public DB::base::TiFlashStorageTestBasic
+{
+public:
+    void SetUp() override
+    {
+        TiFlashStorageTestBasic::SetUp();
+        storage_path_pool = std::make_unique<StoragePathPool>(db_context->getPathPool().withTable("test", "t1", false));
+        storage_pool = std::make_unique<StoragePool>(*db_context, /*ns_id*/ 100, *storage_path_pool, "test.t1");
+        storage_pool->restore();
+        table_columns = DMTestEnv::getDefaultColumns();
+        dm_context = createDMContext(true);
+        segment = Segment::newSegment(*dm_context, table_columns, RowKeyRange::newAll(false, 1), storage_pool->newMetaPageId(), 0);
+    }
+
+protected:
+    std::unique_ptr<DMContext> createDMContext(bool enable_sorted_mem_table_read)
+    {
+        DB::Settings db_settings = db_context->getSettingsRef();
+        db_settings.dt_enable_sorted_mem_table_read = enable_sorted_mem_table_read;
+        return std::make_unique<DMContext>(*db_context,
+                                           *storage_path_pool,
+                                           *storage_pool,
+                                           0,
+                                           /*min_version_*/ 0,
+                                           settings.not_compress_columns,
+                                           false,
+                                           1,
+                                           db_settings);
+    }
+
+    const ColumnDefinesPtr & tableColumns() const { return table_columns; }
+
+    DMContext & dmContext() { return *dm_context; }
+
+protected:
+    std::unique_ptr<StoragePathPool> storage_path_pool;
+    std::unique_ptr<StoragePool> storage_pool;
+    ColumnDefinesPtr table_columns;
+    DM::DeltaMergeStore::Settings settings;
+    std::unique_ptr<DMContext> dm_context;
+    SegmentPtr segment;
+};
+
+TEST_F(MemTableSegmentReadTest, ReadWithSortedMemTable)
+try
+{
+    // handle -> the latest version
+    std::map<Int64, UInt64> expected;
+    auto write = [&](size_t beg, size_t end, UInt64 tso, bool to_cache) {
+        Block block = DMTestEnv::prepareSimpleWriteBlock(beg, end, false, tso);
+        if (to_cache)
+            segment->writeToCache(dmContext(), block, 0, block.rows());
+        else
+            segment->write(dmContext(), block);
+        for (size_t i = beg; i < end; ++i)
+            expected[i] = tso;
+    };
+    auto check_read = [&](const DMContext & context) {
+        auto in = segment->getInputStream(context, *tableColumns(), {RowKeyRange::newAll(false, 1)});
+        std::map<Int64, UInt64> actual;
+        std::optional<Int64> last_handle;
+        in->readPrefix();
+        while (Block block = in->read())
+        {
+            const auto & handles = toColumnVectorData<Int64>(block.getByName(DMTestEnv::pk_name).column);
+            const auto & versions = toColumnVectorData<UInt64>(block.getByName(VERSION_COLUMN_NAME).column);
+            for (size_t i = 0; i < block.rows(); ++i)
+            {
+                // The output is sorted by handle.
+                ASSERT_TRUE(!last_handle || *last_handle < handles[i]);
+                last_handle = handles[i];
+                actual[handles[i]] = versions[i];
+            }
+        }
+        in->readSuffix();
+        ASSERT_EQ(actual, expected);
+    };
+
+    write(0, 100, 2, false);
+    segment = segment->mergeDelta(dmContext(), tableColumns());
+    write(50, 150, 3, false);
+    // Unsorted and overlapped writes in memory.
+    write(20, 80, 4, true);
+    write(120, 200, 5, true);
+    write(0, 30, 6, true);
+    write(60, 61, 7, true);
+
+    check_read(dmContext());
+    {
+        // Only the persisted part is placed.
+        auto snap = segment->createSnapshot(dmContext(), false, CurrentMetrics::DT_SnapshotOfRead);
+        ASSERT_EQ(snap->delta->getMemTableSortedRows()->size(), 60 + 80 + 30 + 1UL);
+        auto [placed_rows, placed_deletes] = snap->delta->getSharedDeltaIndex()->getPlacedStatus();
+        ASSERT_EQ(placed_rows, 100UL);
+        ASSERT_EQ(placed_deletes, 0UL);
+    }
+
+    // Read by placing all rows into the delta index, and then read again with the advanced delta index.
+    auto place_all_context = createDMContext(false);
+    check_read(*place_all_context);
+    check_read(dmContext());
+
+    // After flush, the sorted index is rebuilt.
+    segment->flushCache(dmContext());
+    write(150, 160, 8, true);
+    check_read(dmContext());
+}
+CATCH
+
+} // namespace tests
+} // namespace DM
+} // namespace DB
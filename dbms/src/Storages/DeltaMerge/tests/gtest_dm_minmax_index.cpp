@@ -15,9 +15,14 @@
 #include <Common/Logger.h>
 #include <Core/BlockGen.h>
 #include <DataTypes/DataTypeEnum.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <IO/ReadBufferFromString.h>
+#include <IO/WriteBufferFromString.h>
 #include <Interpreters/convertFieldToType.h>
+#include <Storages/DeltaMerge/ColumnFile/ColumnFileMinMaxIndex.h>
 #include <Storages/DeltaMerge/DMContext.h>
 #include <Storages/DeltaMerge/DeltaMergeStore.h>
+#include <Storages/DeltaMerge/Filter/FilterHelper.h>
 #include <Storages/DeltaMerge/Filter/RSOperator.h>
 #include <Storages/DeltaMerge/Index/RoughCheck.h>
 #include <Storages/DeltaMerge/Index/ValueComparison.h>
@@ -322,6 +327,53 @@ try
     ASSERT_EQ(RoughCheck::Cmp<LessOrEqualsOp>::compare(Field((String) "test_2"), enum16_type, (Int16)101), ValueCompareResult::True);
 }
 CATCH
+
+TEST(ColumnFileMinMaxIndexTest, HandleAndVersion)
+try
+{
+    // handle: [0, 100), version: 10
+    Block block = DMTestEnv::prepareSimpleWriteBlock(0, 100, false, 10);
+
+    auto check_range = [](const ColumnFileMinMaxIndexPtr & index, Int64 start, Int64 end) {
+        auto range = RowKeyRange::fromHandleRange(HandleRange(start, end));
+        return index->roughCheck(toFilter(range));
+    };
+    auto check_version = [](const ColumnFileMinMaxIndexPtr & index, UInt64 max_version) {
+        Attr version_attr = {VERSION_COLUMN_NAME, VERSION_COLUMN_ID, VERSION_COLUMN_TYPE};
+        return index->roughCheck(createLessEqual(version_attr, Field(max_version), -1));
+    };
+
+    auto index = ColumnFileMinMaxIndex::build(block, 0, block.rows());
+    ASSERT_EQ(check_range(index, 0, 100), RSResult::All);
+    ASSERT_EQ(check_range(index, 50, 200), RSResult::Some);
+    ASSERT_EQ(check_range(index, 100, 200), RSResult::None);
+    ASSERT_EQ(check_version(index, 10), RSResult::All);
+    ASSERT_EQ(check_version(index, 9), RSResult::None);
+
+    // Only index the rows in [20, 30).
+    auto part_index = ColumnFileMinMaxIndex::build(block, 20, 10);
+    ASSERT_EQ(check_range(part_index, 0, 20), RSResult::None);
+    ASSERT_EQ(check_range(part_index, 25, 40), RSResult::Some);
+    ASSERT_EQ(check_range(part_index, 30, 100), RSResult::None);
+
+    // The other columns are not indexed.
+    Attr value_attr = {DMTestEnv::pk_name, 1, std::make_shared<DataTypeInt64>()};
+    ASSERT_EQ(part_index->roughCheck(createEqual(value_attr, Field(static_cast<Int64>(1000)))), RSResult::Some);
+
+    // The index is the same after a round trip of serialization.
+    WriteBufferFromOwnString write_buf;
+    part_index->serialize(write_buf);
+    ReadBufferFromString read_buf(write_buf.releaseStr());
+    auto restored_index = ColumnFileMinMaxIndex::deserialize(read_buf, block.cloneEmpty());
+    ASSERT_TRUE(read_buf.eof());
+    ASSERT_EQ(check_range(restored_index, 0, 20), RSResult::None);
+    ASSERT_EQ(check_range(restored_index, 25, 40), RSResult::Some);
+    ASSERT_EQ(check_range(restored_index, 20, 30), RSResult::All);
+    ASSERT_EQ(check_version(restored_index, 10), RSResult::All);
+    ASSERT_EQ(check_version(restored_index, 9), RSResult::None);
+}
+CATCH
+
 } // namespace tests
 } // namespace DM
 } // namespace DB
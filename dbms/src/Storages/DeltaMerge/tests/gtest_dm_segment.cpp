@@ -27,6 +27,7 @@
 #include <common/logger_useful.h>
 
 #include <ctime>
+#include <ext/scope_guard.h>
 #include <memory>
 
 namespace CurrentMetrics
@@ -420,6 +421,201 @@ try
 }
 CATCH
 
+TEST_F(SegmentTest, PartialMergeDelta)
+try
+{
+    DB::Settings my_settings;
+    my_settings.dt_segment_stable_pack_rows = 100;
+    segment = reload({}, std::move(my_settings));
+
+    // handle -> the latest version
+    std::map<Int64, UInt64> expected;
+    auto write = [&](size_t beg, size_t end, UInt64 tso) {
+        Block block = DMTestEnv::prepareSimpleWriteBlock(beg, end, false, tso);
+        segment->write(dmContext(), block);
+        for (size_t i = beg; i < end; ++i)
+            expected[i] = tso;
+    };
+    auto check_read = [&]() {
+        auto in = segment->getInputStream(dmContext(), *tableColumns(), {RowKeyRange::newAll(false, 1)});
+        std::map<Int64, UInt64> actual;
+        std::optional<Int64> last_handle;
+        in->readPrefix();
+        while (Block block = in->read())
+        {
+            const auto & handles = toColumnVectorData<Int64>(block.getByName(DMTestEnv::pk_name).column);
+            const auto & versions = toColumnVectorData<UInt64>(block.getByName(VERSION_COLUMN_NAME).column);
+            for (size_t i = 0; i < block.rows(); ++i)
+            {
+                ASSERT_TRUE(!last_handle || *last_handle < handles[i]);
+                last_handle = handles[i];
+                actual[handles[i]] = versions[i];
+            }
+        }
+        in->readSuffix();
+        ASSERT_EQ(actual, expected);
+    };
+
+    // 10 packs in stable.
+    write(0, 1000, 2);
+    segment = segment->mergeDelta(dmContext(), tableColumns(), /*allow_partial*/ true);
+    ASSERT_EQ(segment->getStable()->getDMFiles().size(), 1UL);
+    ASSERT_FALSE(segment->getStable()->hasFileRanges());
+
+    // The file ranges can not be stored before StableFormat::V2, the whole stable is rewritten.
+    write(420, 430, 3);
+    segment = segment->mergeDelta(dmContext(), tableColumns(), /*allow_partial*/ true);
+    ASSERT_EQ(segment->getStable()->getDMFiles().size(), 1UL);
+    ASSERT_FALSE(segment->getStable()->hasFileRanges());
+
+    auto old_format = STORAGE_FORMAT_CURRENT;
+    SCOPE_EXIT({ setStorageFormat(old_format); });
+    setStorageFormat(STORAGE_FORMAT_V5);
+
+    // Only the pack [400, 500) is rewritten, the packs before and after it are reused.
+    write(420, 450, 3);
+    segment = segment->mergeDelta(dmContext(), tableColumns(), /*allow_partial*/ true);
+    ASSERT_EQ(segment->getStable()->getDMFiles().size(), 3UL);
+    ASSERT_EQ(segment->getStable()->getFileRanges()[1], RowKeyRange::fromHandleRange(HandleRange(400, 500)));
+    check_read();
+
+    // Only the packs after 900 are rewritten.
+    write(950, 960, 4);
+    // Delete ranges are rewritten too.
+    segment->write(dmContext(), /*delete_range*/ {RowKeyRange::fromHandleRange(HandleRange(990, 1000))});
+    for (Int64 i = 990; i < 1000; ++i)
+        expected.erase(i);
+    segment = segment->mergeDelta(dmContext(), tableColumns(), /*allow_partial*/ true);
+    ASSERT_EQ(segment->getStable()->getDMFiles().size(), 4UL);
+    check_read();
+
+    // The file ranges are restored.
+    segment = Segment::restoreSegment(dmContext(), segment->segmentId());
+    ASSERT_EQ(segment->getStable()->getFileRanges().size(), 4UL);
+    check_read();
+
+    // Rewrite the whole stable if the delta overlaps too many packs.
+    write(100, 800, 5);
+    segment = segment->mergeDelta(dmContext(), tableColumns(), /*allow_partial*/ true);
+    ASSERT_EQ(segment->getStable()->getDMFiles().size(), 1UL);
+    ASSERT_FALSE(segment->getStable()->hasFileRanges());
+    check_read();
+}
+CATCH
+
+TEST_F(SegmentTest, ReadDeltaFreePacksDirectly)
+try
+{
+    DB::Settings my_settings;
+    my_settings.dt_segment_stable_pack_rows = 100;
+    segment = reload({}, std::move(my_settings));
+
+    // handle -> the latest version
+    std::map<Int64, UInt64> expected;
+    auto write = [&](size_t beg, size_t end, UInt64 tso) {
+        Block block = DMTestEnv::prepareSimpleWriteBlock(beg, end, false, tso);
+        segment->write(dmContext(), block);
+        for (size_t i = beg; i < end; ++i)
+            expected[i] = tso;
+    };
+    auto check_read = [&](const RowKeyRange & read_range) {
+        auto in = segment->getInputStream(dmContext(), *tableColumns(), {read_range});
+        std::map<Int64, UInt64> actual;
+        std::optional<Int64> last_handle;
+        in->readPrefix();
+        while (Block block = in->read())
+        {
+            const auto & handles = toColumnVectorData<Int64>(block.getByName(DMTestEnv::pk_name).column);
+            const auto & versions = toColumnVectorData<UInt64>(block.getByName(VERSION_COLUMN_NAME).column);
+            for (size_t i = 0; i < block.rows(); ++i)
+            {
+                ASSERT_TRUE(!last_handle || *last_handle < handles[i]);
+                last_handle = handles[i];
+                actual[handles[i]] = versions[i];
+            }
+        }
+        in->readSuffix();
+
+        std::map<Int64, UInt64> expected_in_range;
+        for (const auto & [handle, version] : expected)
+        {
+            if (read_range.check(RowKeyValue::fromHandle(handle).toRowKeyValueRef()))
+                expected_in_range.emplace(handle, version);
+        }
+        ASSERT_EQ(actual, expected_in_range);
+    };
+
+    // 10 packs in stable: [10, 110), [110, 210), ..., [910, 1010).
+    write(10, 1010, 2);
+    segment = segment->mergeDelta(dmContext(), tableColumns());
+
+    // The delta only affects the packs [410, 510) and [510, 610), other packs are read without merging.
+    write(420, 450, 3);
+    segment->write(dmContext(), /*delete_range*/ {RowKeyRange::fromHandleRange(HandleRange(600, 610))});
+    for (Int64 i = 600; i < 610; ++i)
+        expected.erase(i);
+    segment->flushCache(dmContext());
+    check_read(RowKeyRange::newAll(false, 1));
+    check_read(RowKeyRange::fromHandleRange(HandleRange(350, 650)));
+    check_read(RowKeyRange::fromHandleRange(HandleRange(0, 420)));
+    check_read(RowKeyRange::fromHandleRange(HandleRange(700, 1010)));
+
+    // The rows inserted before and after all rows of stable.
+    write(0, 10, 4);
+    write(1010, 1020, 4);
+    segment->flushCache(dmContext());
+    check_read(RowKeyRange::newAll(false, 1));
+    check_read(RowKeyRange::fromHandleRange(HandleRange(500, 1015)));
+}
+CATCH
+
+TEST_F(SegmentTest, RestoreTinyFileMinMaxIndex)
+try
+{
+    auto write = [&](size_t beg, size_t end, UInt64 tso) {
+        Block block = DMTestEnv::prepareSimpleWriteBlock(beg, end, false, tso);
+        segment->write(dmContext(), block);
+        segment->flushCache(dmContext());
+    };
+    auto get_minmax_index = [&](size_t file_index) {
+        auto snap = segment->createSnapshot(dmContext(), /*for_update*/ false, CurrentMetrics::DT_SnapshotOfRead);
+        const auto & column_files = snap->delta->getPersistedFileSetSnapshot()->getColumnFiles();
+        auto * tiny_file = column_files.at(file_index)->tryToTinyFile();
+        EXPECT_NE(tiny_file, nullptr);
+        return tiny_file->getMinMaxIndex();
+    };
+    auto read_rows = [&]() {
+        auto in = segment->getInputStream(dmContext(), *tableColumns(), {RowKeyRange::newAll(false, 1)});
+        size_t num_rows_read = 0;
+        in->readPrefix();
+        while (Block block = in->read())
+            num_rows_read += block.rows();
+        in->readSuffix();
+        return num_rows_read;
+    };
+
+    write(0, 100, 2);
+    ASSERT_NE(get_minmax_index(0), nullptr);
+
+    // The index is not saved before DeltaFormat::V4, it is built on the first read after restored.
+    segment = Segment::restoreSegment(dmContext(), segment->segmentId());
+    ASSERT_EQ(get_minmax_index(0), nullptr);
+    ASSERT_EQ(read_rows(), 100UL);
+    ASSERT_NE(get_minmax_index(0), nullptr);
+
+    auto old_format = STORAGE_FORMAT_CURRENT;
+    SCOPE_EXIT({ setStorageFormat(old_format); });
+    setStorageFormat(STORAGE_FORMAT_V5);
+
+    // The index is saved with the metadata of delta, including the one built on read.
+    write(100, 200, 3);
+    segment = Segment::restoreSegment(dmContext(), segment->segmentId());
+    ASSERT_NE(get_minmax_index(0), nullptr);
+    ASSERT_NE(get_minmax_index(1), nullptr);
+    ASSERT_EQ(read_rows(), 200UL);
+}
+CATCH
+
 class SegmentDeletionRelevantPlaceTest
     : public SegmentTest
     , public testing::WithParamInterface<bool>
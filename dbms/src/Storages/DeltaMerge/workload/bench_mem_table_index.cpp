@@ -0,0 +1,114 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Columns/ColumnsNumber.h>
+#include <Storages/DeltaMerge/Delta/MemTableIndex.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace DB
+{
+namespace DM
+{
+namespace bench
+{
+namespace
+{
+struct Batch
+{
+    MutableColumnPtr handles;
+    MutableColumnPtr versions;
+};
+
+/// Every batch is sorted by handle, just like the blocks written into delta.
+std::vector<Batch> prepareBatches(size_t batch_rows, size_t total_rows)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<Int64> dist(0, total_rows * 4);
+    std::vector<Batch> batches;
+    for (size_t written = 0, version = 1; written < total_rows; written += batch_rows, ++version)
+    {
+        std::vector<Int64> handles(std::min(batch_rows, total_rows - written));
+        for (auto & h : handles)
+            h = dist(rng);
+        std::sort(handles.begin(), handles.end());
+
+        auto handle_col = ColumnInt64::create();
+        auto version_col = ColumnUInt64::create();
+        for (auto h : handles)
+        {
+            handle_col->insert(h);
+            version_col->insert(version);
+        }
+        batches.push_back(Batch{std::move(handle_col), std::move(version_col)});
+    }
+    return batches;
+}
+} // namespace
+
+/// Maintain the sorted index of MemTableSet on every append.
+static void MemTableIndexAppend(benchmark::State & state)
+{
+    const size_t batch_rows = state.range(0);
+    const size_t total_rows = state.range(1);
+    auto batches = prepareBatches(batch_rows, total_rows);
+    for (auto _ : state)
+    {
+        MemTableIndex index;
+        for (const auto & batch : batches)
+            index.append(*batch.handles, *batch.versions, 0, batch.handles->size());
+        benchmark::DoNotOptimize(index.getSortedRows());
+    }
+    state.SetItemsProcessed(state.iterations() * total_rows);
+}
+
+/// Sort all rows of MemTableSet by handle and version, which is done by placing the rows in memory for every read.
+static void MemTableSortOnRead(benchmark::State & state)
+{
+    const size_t batch_rows = state.range(0);
+    const size_t total_rows = state.range(1);
+    auto batches = prepareBatches(batch_rows, total_rows);
+    auto handles = ColumnInt64::create();
+    auto versions = ColumnUInt64::create();
+    for (const auto & batch : batches)
+    {
+        handles->insertRangeFrom(*batch.handles, 0, batch.handles->size());
+        versions->insertRangeFrom(*batch.versions, 0, batch.versions->size());
+    }
+    const auto & handle_data = handles->getData();
+    const auto & version_data = versions->getData();
+
+    for (auto _ : state)
+    {
+        IColumn::Permutation perm(total_rows);
+        std::iota(perm.begin(), perm.end(), 0);
+        std::sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
+            if (handle_data[a] != handle_data[b])
+                return handle_data[a] < handle_data[b];
+            return version_data[a] < version_data[b];
+        });
+        benchmark::DoNotOptimize(perm.data());
+    }
+    state.SetItemsProcessed(state.iterations() * total_rows);
+}
+
+BENCHMARK(MemTableIndexAppend)->Args({16, 4096})->Args({256, 4096})->Args({1024, 16384});
+BENCHMARK(MemTableSortOnRead)->Args({16, 4096})->Args({256, 4096})->Args({1024, 16384});
+
+} // namespace bench
+} // namespace DM
+} // namespace DB
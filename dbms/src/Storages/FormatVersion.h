@@ -46,6 +46,8 @@ namespace StableFormat
 using Version = Int64;
 
 inline static constexpr Version V1 = 1;
+// Store the valid key range of each DMFile, used by partial merge delta.
+inline static constexpr Version V2 = 2;
 } // namespace StableFormat
 
 namespace DeltaFormat
@@ -55,6 +57,7 @@ using Version = UInt64;
 inline static constexpr Version V1 = 1;
 inline static constexpr Version V2 = 2; // Support clustered index
 inline static constexpr Version V3 = 3; // Support DeltaPackFile
+inline static constexpr Version V4 = 4; // Support the min-max index of ColumnFileTiny
 } // namespace DeltaFormat
 
 namespace PageFormat
@@ -118,6 +121,15 @@ inline static const StorageFormatVersion STORAGE_FORMAT_V4 = StorageFormatVersio
     .identifier = 4,
 };
 
+inline static const StorageFormatVersion STORAGE_FORMAT_V5 = StorageFormatVersion{
+    .segment = SegmentFormat::V2,
+    .dm_file = DMFileFormat::V2,
+    .stable = StableFormat::V2, // diff
+    .delta = DeltaFormat::V4, // diff
+    .page = PageFormat::V3,
+    .identifier = 5,
+};
+
 inline StorageFormatVersion STORAGE_FORMAT_CURRENT = STORAGE_FORMAT_V4;
 
 inline const StorageFormatVersion & toStorageFormat(UInt64 setting)
@@ -132,6 +144,8 @@ inline const StorageFormatVersion & toStorageFormat(UInt64 setting)
         return STORAGE_FORMAT_V3;
     case 4:
         return STORAGE_FORMAT_V4;
+    case 5:
+        return STORAGE_FORMAT_V5;
     default:
         throw Exception("Illegal setting value: " + DB::toString(setting));
     }
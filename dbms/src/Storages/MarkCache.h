@@ -16,7 +16,7 @@
 
 #include <memory>
 
-#include <Common/LRUCache.h>
+#include <Common/ManagedLRUCache.h>
 #include <Common/ProfileEvents.h>
 #include <Common/SipHash.h>
 #include <Interpreters/AggregationCommon.h>
@@ -46,14 +46,14 @@ struct MarksWeightFunction
 /** Cache of 'marks' for StorageMergeTree.
   * Marks is an index structure that addresses ranges in column file, corresponding to ranges of primary key.
   */
-class MarkCache : public LRUCache<String, MarksInCompressedFile, std::hash<String>, MarksWeightFunction>
+class MarkCache : public ManagedLRUCache<String, MarksInCompressedFile, std::hash<String>, MarksWeightFunction>
 {
 private:
-    using Base = LRUCache<String, MarksInCompressedFile, std::hash<String>, MarksWeightFunction>;
+    using Base = ManagedLRUCache<String, MarksInCompressedFile, std::hash<String>, MarksWeightFunction>;
 
 public:
     MarkCache(size_t max_size_in_bytes, const Delay & expiration_delay)
-        : Base(max_size_in_bytes, expiration_delay) {}
+        : Base(max_size_in_bytes, expiration_delay, /*segmented*/ true) {}
 
     template <typename LoadFunc>
     MappedPtr getOrSet(const Key & key, LoadFunc && load)
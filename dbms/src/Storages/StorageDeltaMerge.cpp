@@ -38,6 +38,7 @@
 #include <Storages/DeltaMerge/DeltaMergeHelpers.h>
 #include <Storages/DeltaMerge/DeltaMergeStore.h>
 #include <Storages/DeltaMerge/Filter/RSOperator.h>
+#include <Storages/DeltaMerge/Filter/TopNThreshold.h>
 #include <Storages/DeltaMerge/FilterParser/FilterParser.h>
 #include <Storages/MutableSupport.h>
 #include <Storages/PrimaryKeyNotMatchException.h>
@@ -747,6 +748,22 @@ BlockInputStreams StorageDeltaMerge::read(
     else
         LOG_FMT_DEBUG(tracing_logger, "Rough set filter is disabled.");
 
+    /// Skip the packs by the TopN threshold only if the values in storage are just the integers published by TopN.
+    DM::TopNThresholdPtr topn_threshold;
+    if (query_info.dag_query && query_info.dag_query->topn_threshold && context.getSettingsRef().dt_enable_topn_threshold_pushdown)
+    {
+        const auto & threshold = query_info.dag_query->topn_threshold;
+        auto iter = std::find_if(columns_to_read.begin(), columns_to_read.end(), [&](const ColumnDefine & cd) {
+            return cd.id == threshold->getColumnId();
+        });
+        if (iter != columns_to_read.end() && (iter->type->isInteger() || iter->type->isMyDateOrMyDateTime())
+            && (iter->type->isUnsignedInteger() || iter->type->isMyDateOrMyDateTime()) == threshold->isUnsigned())
+        {
+            topn_threshold = threshold;
+            LOG_FMT_DEBUG(tracing_logger, "TopN threshold on column {}, desc: {}", iter->name, threshold->isDesc());
+        }
+    }
+
     auto streams = store->read(
         context,
         context.getSettingsRef(),
@@ -758,7 +775,8 @@ BlockInputStreams StorageDeltaMerge::read(
         query_info.req_id,
         max_block_size,
         parseSegmentSet(select_query.segment_expression_list),
-        extra_table_id_index);
+        extra_table_id_index,
+        topn_threshold);
 
     /// Ensure read_tso info after read.
     check_read_tso(mvcc_query_info.read_tso);
@@ -0,0 +1,104 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <Common/CacheManager.h>
+#include <DataStreams/OneBlockInputStream.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <IO/UncompressedCache.h>
+#include <Interpreters/Context.h>
+#include <Storages/DeltaMerge/DeltaIndexManager.h>
+#include <Storages/DeltaMerge/Index/MinMaxIndex.h>
+#include <Storages/DeltaMerge/SegmentResultCache.h>
+#include <Storages/MarkCache.h>
+#include <Storages/System/StorageSystemCaches.h>
+
+namespace DB
+{
+StorageSystemCaches::StorageSystemCaches(const std::string & name_)
+    : name(name_)
+{
+    setColumns(ColumnsDescription({
+        {"name", std::make_shared<DataTypeString>()},
+        {"managed", std::make_shared<DataTypeUInt8>()},
+        {"weight", std::make_shared<DataTypeFloat64>()},
+
+        {"bytes", std::make_shared<DataTypeUInt64>()},
+        {"max_bytes", std::make_shared<DataTypeUInt64>()},
+        {"count", std::make_shared<DataTypeUInt64>()},
+        {"hits", std::make_shared<DataTypeUInt64>()},
+        {"misses", std::make_shared<DataTypeUInt64>()},
+        {"hit_rate", std::make_shared<DataTypeFloat64>()},
+        {"inserted_bytes", std::make_shared<DataTypeUInt64>()},
+        {"evicted_bytes_by_capacity", std::make_shared<DataTypeUInt64>()},
+        {"evicted_bytes_by_resize", std::make_shared<DataTypeUInt64>()},
+    }));
+}
+
+BlockInputStreams StorageSystemCaches::read(
+    const Names & column_names,
+    const SelectQueryInfo &,
+    const Context & context,
+    QueryProcessingStage::Enum & processed_stage,
+    const size_t /*max_block_size*/,
+    const unsigned /*num_streams*/)
+{
+    check(column_names);
+    processed_stage = QueryProcessingStage::FetchColumns;
+
+    MutableColumns res_columns = getSampleBlock().cloneEmptyColumns();
+
+    std::vector<CacheManager::CacheInfo> infos;
+    if (auto cache_manager = context.getCacheManager(); cache_manager)
+        infos = cache_manager->getCacheInfos();
+    // Also list the caches not managed by CacheManager, whose weights are 0.
+    auto add_unmanaged = [&](CacheManager::CacheType type, const ManagedCachePtr & cache) {
+        if (!cache)
+            return;
+        for (const auto & info : infos)
+        {
+            if (info.type == type)
+                return;
+        }
+        infos.push_back(CacheManager::CacheInfo{type, 0, cache->getCacheStats()});
+    };
+    add_unmanaged(CacheManager::CacheType::Mark, context.getMarkCache());
+    add_unmanaged(CacheManager::CacheType::MinMaxIndex, context.getMinMaxIndexCache());
+    add_unmanaged(CacheManager::CacheType::Uncompressed, context.getUncompressedCache());
+    add_unmanaged(CacheManager::CacheType::DeltaIndex, context.getDeltaIndexManager());
+    add_unmanaged(CacheManager::CacheType::SegmentResult, context.getSegmentResultCache());
+
+    for (const auto & info : infos)
+    {
+        const auto & stats = info.stats;
+        size_t j = 0;
+        res_columns[j++]->insert(String(CacheManager::typeToString(info.type)));
+        res_columns[j++]->insert(static_cast<UInt64>(info.weight > 0));
+        res_columns[j++]->insert(info.weight);
+
+        res_columns[j++]->insert(static_cast<UInt64>(stats.bytes));
+        res_columns[j++]->insert(static_cast<UInt64>(stats.max_bytes));
+        res_columns[j++]->insert(static_cast<UInt64>(stats.count));
+        res_columns[j++]->insert(static_cast<UInt64>(stats.hits));
+        res_columns[j++]->insert(static_cast<UInt64>(stats.misses));
+        res_columns[j++]->insert(stats.hits + stats.misses > 0 ? static_cast<Float64>(stats.hits) / (stats.hits + stats.misses) : 0.0);
+        res_columns[j++]->insert(static_cast<UInt64>(stats.inserted_bytes));
+        res_columns[j++]->insert(static_cast<UInt64>(stats.evicted_bytes_by_capacity));
+        res_columns[j++]->insert(static_cast<UInt64>(stats.evicted_bytes_by_resize));
+    }
+
+    return BlockInputStreams(1, std::make_shared<OneBlockInputStream>(getSampleBlock().cloneWithColumns(std::move(res_columns))));
+}
+
+} // namespace DB
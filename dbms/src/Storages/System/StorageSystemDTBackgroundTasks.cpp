@@ -0,0 +1,73 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <DataStreams/OneBlockInputStream.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Interpreters/Context.h>
+#include <Storages/DeltaMerge/BackgroundTaskScheduler.h>
+#include <Storages/System/StorageSystemDTBackgroundTasks.h>
+
+namespace DB
+{
+StorageSystemDTBackgroundTasks::StorageSystemDTBackgroundTasks(const std::string & name_)
+    : name(name_)
+{
+    setColumns(ColumnsDescription({
+        {"task_id", std::make_shared<DataTypeUInt64>()},
+        {"table", std::make_shared<DataTypeString>()},
+        {"segment_id", std::make_shared<DataTypeUInt64>()},
+        {"type", std::make_shared<DataTypeString>()},
+        {"is_heavy", std::make_shared<DataTypeUInt8>()},
+        {"state", std::make_shared<DataTypeString>()},
+
+        {"score", std::make_shared<DataTypeFloat64>()},
+        {"estimated_bytes", std::make_shared<DataTypeUInt64>()},
+        {"queued_seconds", std::make_shared<DataTypeFloat64>()},
+    }));
+}
+
+BlockInputStreams StorageSystemDTBackgroundTasks::read(
+    const Names & column_names,
+    const SelectQueryInfo &,
+    const Context & context,
+    QueryProcessingStage::Enum & processed_stage,
+    const size_t /*max_block_size*/,
+    const unsigned /*num_streams*/)
+{
+    check(column_names);
+    processed_stage = QueryProcessingStage::FetchColumns;
+
+    MutableColumns res_columns = getSampleBlock().cloneEmptyColumns();
+
+    auto tasks = context.getDMBackgroundTaskScheduler()->getTasks();
+    for (const auto & task : tasks)
+    {
+        size_t j = 0;
+        res_columns[j++]->insert(task.task_id);
+        res_columns[j++]->insert(task.store_name);
+        res_columns[j++]->insert(task.segment_id);
+        res_columns[j++]->insert(task.type);
+        res_columns[j++]->insert(static_cast<UInt64>(task.is_heavy));
+        res_columns[j++]->insert(String(task.is_running ? "running" : "queued"));
+
+        res_columns[j++]->insert(task.score);
+        res_columns[j++]->insert(static_cast<UInt64>(task.estimated_bytes));
+        res_columns[j++]->insert(task.queued_seconds);
+    }
+
+    return BlockInputStreams(1, std::make_shared<OneBlockInputStream>(getSampleBlock().cloneWithColumns(std::move(res_columns))));
+}
+
+} // namespace DB
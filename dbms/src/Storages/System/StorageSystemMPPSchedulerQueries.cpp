@@ -0,0 +1,74 @@
+// Copyright 2022 PingCAP, Ltd.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <DataStreams/OneBlockInputStream.h>
+#include <DataTypes/DataTypeString.h>
+#include <DataTypes/DataTypesNumber.h>
+#include <Flash/Mpp/MPPTaskManager.h>
+#include <Interpreters/Context.h>
+#include <Storages/System/StorageSystemMPPSchedulerQueries.h>
+#include <Storages/Transaction/TMTContext.h>
+
+namespace DB
+{
+StorageSystemMPPSchedulerQueries::StorageSystemMPPSchedulerQueries(const std::string & name_)
+    : name(name_)
+{
+    setColumns(ColumnsDescription({
+        {"query_tso", std::make_shared<DataTypeUInt64>()},
+        {"state", std::make_shared<DataTypeString>()},
+        {"is_min_tso", std::make_shared<DataTypeUInt8>()},
+        {"priority", std::make_shared<DataTypeInt64>()},
+
+        {"active_tasks", std::make_shared<DataTypeUInt64>()},
+        {"waiting_tasks", std::make_shared<DataTypeUInt64>()},
+
+        {"reserved_threads", std::make_shared<DataTypeUInt64>()},
+        {"reserved_memory", std::make_shared<DataTypeUInt64>()},
+    }));
+}
+
+BlockInputStreams StorageSystemMPPSchedulerQueries::read(
+    const Names & column_names,
+    const SelectQueryInfo &,
+    const Context & context,
+    QueryProcessingStage::Enum & processed_stage,
+    const size_t /*max_block_size*/,
+    const unsigned /*num_streams*/)
+{
+    check(column_names);
+    processed_stage = QueryProcessingStage::FetchColumns;
+
+    MutableColumns res_columns = getSampleBlock().cloneEmptyColumns();
+
+    auto statuses = context.getTMTContext().getMPPTaskManager()->getSchedulerQueryStatuses();
+    for (const auto & status : statuses)
+    {
+        size_t j = 0;
+        res_columns[j++]->insert(status.tso);
+        res_columns[j++]->insert(String(status.is_waiting ? "waiting" : "active"));
+        res_columns[j++]->insert(static_cast<UInt64>(status.is_min_tso));
+        res_columns[j++]->insert(status.priority);
+
+        res_columns[j++]->insert(status.active_tasks);
+        res_columns[j++]->insert(status.waiting_tasks);
+
+        res_columns[j++]->insert(status.reserved_threads);
+        res_columns[j++]->insert(status.reserved_memory);
+    }
+
+    return BlockInputStreams(1, std::make_shared<OneBlockInputStream>(getSampleBlock().cloneWithColumns(std::move(res_columns))));
+}
+
+} // namespace DB
@@ -15,7 +15,9 @@
 #include <Databases/IDatabase.h>
 #include <Storages/System/StorageSystemAsynchronousMetrics.h>
 #include <Storages/System/StorageSystemBuildOptions.h>
+#include <Storages/System/StorageSystemCaches.h>
 #include <Storages/System/StorageSystemColumns.h>
+#include <Storages/System/StorageSystemDTBackgroundTasks.h>
 #include <Storages/System/StorageSystemDTSegments.h>
 #include <Storages/System/StorageSystemDTTables.h>
 #include <Storages/System/StorageSystemDatabases.h>
@@ -23,6 +25,7 @@
 #include <Storages/System/StorageSystemEvents.h>
 #include <Storages/System/StorageSystemFunctions.h>
 #include <Storages/System/StorageSystemGraphite.h>
+#include <Storages/System/StorageSystemMPPSchedulerQueries.h>
 #include <Storages/System/StorageSystemMacros.h>
 #include <Storages/System/StorageSystemMetrics.h>
 #include <Storages/System/StorageSystemModels.h>
@@ -44,6 +47,8 @@ void attachSystemTablesLocal(IDatabase & system_database)
     system_database.attachTable("databases", StorageSystemDatabases::create("databases"));
     system_database.attachTable("dt_tables", StorageSystemDTTables::create("dt_tables"));
     system_database.attachTable("dt_segments", StorageSystemDTSegments::create("dt_segments"));
+    system_database.attachTable("dt_background_tasks", StorageSystemDTBackgroundTasks::create("dt_background_tasks"));
+    system_database.attachTable("caches", StorageSystemCaches::create("caches"));
     system_database.attachTable("tables", StorageSystemTables::create("tables"));
     system_database.attachTable("columns", StorageSystemColumns::create("columns"));
     system_database.attachTable("functions", StorageSystemFunctions::create("functions"));
@@ -61,6 +66,7 @@ void attachSystemTablesServer(IDatabase & system_database)
     system_database.attachTable("models", StorageSystemModels::create("models"));
     system_database.attachTable("graphite_retentions", StorageSystemGraphite::create("graphite_retentions"));
     system_database.attachTable("macros", StorageSystemMacros::create("macros"));
+    system_database.attachTable("mpp_scheduler_queries", StorageSystemMPPSchedulerQueries::create("mpp_scheduler_queries"));
 }
 
 void attachSystemTablesAsync(IDatabase & system_database, AsynchronousMetrics & async_metrics)
@@ -13,16 +13,25 @@
 // limitations under the License.
 
 #include <Common/Exception.h>
+#include <Common/FailPoint.h>
 #include <Poco/String.h>
 #include <Storages/Transaction/Collator.h>
 
+#include <algorithm>
 #include <array>
+#include <cstring>
+#include <string_view>
 
 namespace DB::ErrorCodes
 {
 extern const int LOGICAL_ERROR;
 }
 
+namespace DB::FailPoints
+{
+extern const char force_generic_like_pattern_match[];
+} // namespace DB::FailPoints
+
 namespace TiDB
 {
 TiDBCollators dummy_collators;
@@ -76,6 +85,47 @@ inline Rune decodeUtf8Char(const char * s, size_t & offset)
     return c;
 }
 
+inline void encodeUtf8Char(Rune c, std::string & s)
+{
+    if (c < 0x80)
+    {
+        s.push_back(static_cast<char>(c));
+    }
+    else if (c < 0x800)
+    {
+        s.push_back(static_cast<char>(0xC0 | (c >> 6)));
+        s.push_back(static_cast<char>(0x80 | (c & mb_mask)));
+    }
+    else if (c < 0x10000)
+    {
+        s.push_back(static_cast<char>(0xE0 | (c >> 12)));
+        s.push_back(static_cast<char>(0x80 | ((c >> 6) & mb_mask)));
+        s.push_back(static_cast<char>(0x80 | (c & mb_mask)));
+    }
+    else
+    {
+        s.push_back(static_cast<char>(0xF0 | (c >> 18)));
+        s.push_back(static_cast<char>(0x80 | ((c >> 12) & mb_mask)));
+        s.push_back(static_cast<char>(0x80 | ((c >> 6) & mb_mask)));
+        s.push_back(static_cast<char>(0x80 | (c & mb_mask)));
+    }
+}
+
+inline bool isASCII(const char * s, size_t length)
+{
+    uint64_t bits = 0;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, s + i, sizeof(uint64_t));
+        bits |= word;
+    }
+    for (; i < length; ++i)
+        bits |= static_cast<uint8_t>(s[i]);
+    return (bits & 0x8080808080808080ULL) == 0;
+}
+
 template <typename Collator>
 class Pattern : public ITiDBCollator::IPattern
 {
@@ -124,9 +174,32 @@ public:
             chars.push_back(c);
             match_types.push_back(tp);
         }
+        analyzeLiteral();
+        // Used by tests to compare the literal matching with the backtracking matching.
+        fiu_do_on(DB::FailPoints::force_generic_like_pattern_match, { literal_type = LiteralType::None; });
     }
 
     bool match(const char * s, size_t length) const override
+    {
+        if (literal_type == LiteralType::None)
+            return matchGeneric(s, length);
+
+        if constexpr (Collator::match_by_bytes)
+            return matchLiteralBytes(s, length);
+        else
+        {
+            if (literal_type == LiteralType::Equal || literal_type == LiteralType::Prefix)
+                return matchLiteralPrefix(s, length);
+            // Most strings are pure ASCII, in which every char could be compared by the folded ASCII char.
+            if (!isASCII(s, length))
+                return matchGeneric(s, length);
+            return literal_ascii_foldable && matchFoldedASCII(s, length);
+        }
+    }
+
+private:
+    /// Match with backtracking, which supports all kinds of patterns.
+    bool matchGeneric(const char * s, size_t length) const
     {
         size_t s_offset = 0, next_s_offset = 0, tmp_s_offset = 0;
         size_t p_idx = 0, next_p_idx = 0;
@@ -170,6 +243,159 @@ public:
         return true;
     }
 
+    /// Find out whether the pattern is a literal with `%` only at the ends, i.e. `abc`, `abc%`, `%abc` or `%abc%`,
+    /// which could be matched without backtracking.
+    void analyzeLiteral()
+    {
+        literal_type = LiteralType::None;
+        size_t begin = 0, end = chars.size();
+        while (begin < end && match_types[begin] == Any)
+            ++begin;
+        while (end > begin && match_types[end - 1] == Any)
+            --end;
+        if (begin == end)
+            return;
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (match_types[i] != Match)
+                return;
+        }
+
+        literal.assign(chars.begin() + begin, chars.begin() + end);
+        if constexpr (!std::is_same_v<typename Collator::CharType, char>)
+        {
+            // The escape char out of ASCII is not a valid code point, leave it to the generic matching.
+            if (std::any_of(literal.begin(), literal.end(), [](auto c) { return c < 0; }))
+                return;
+        }
+
+        if constexpr (Collator::match_by_bytes)
+        {
+            literal_bytes.clear();
+            for (auto c : literal)
+            {
+                if constexpr (std::is_same_v<typename Collator::CharType, char>)
+                    literal_bytes.push_back(c);
+                else
+                    encodeUtf8Char(c, literal_bytes);
+            }
+        }
+        else
+        {
+            folded_literal.clear();
+            literal_ascii_foldable = true;
+            for (auto c : literal)
+            {
+                int folded = foldToASCII(c);
+                if (folded < 0)
+                {
+                    // No ASCII char equals to `c`, so the pure ASCII strings never match.
+                    literal_ascii_foldable = false;
+                    break;
+                }
+                folded_literal.push_back(static_cast<char>(folded));
+            }
+        }
+
+        bool any_at_begin = begin > 0;
+        bool any_at_end = end < chars.size();
+        if (any_at_begin)
+            literal_type = any_at_end ? LiteralType::Substring : LiteralType::Suffix;
+        else
+            literal_type = any_at_end ? LiteralType::Prefix : LiteralType::Equal;
+    }
+
+    /// The chars are equal if and only if their bytes are equal.
+    bool matchLiteralBytes(const char * s, size_t length) const
+    {
+        const size_t n = literal_bytes.size();
+        switch (literal_type)
+        {
+        case LiteralType::Equal:
+            return length == n && memcmp(s, literal_bytes.data(), n) == 0;
+        case LiteralType::Prefix:
+            return length >= n && memcmp(s, literal_bytes.data(), n) == 0;
+        case LiteralType::Suffix:
+            return length >= n && memcmp(s + length - n, literal_bytes.data(), n) == 0;
+        case LiteralType::Substring:
+            return std::string_view(s, length).find(literal_bytes) != std::string_view::npos;
+        default:
+            return matchGeneric(s, length);
+        }
+    }
+
+    /// Compare the first chars with the literal, the rest chars are not decoded at all.
+    bool matchLiteralPrefix(const char * s, size_t length) const
+    {
+        size_t offset = 0;
+        for (auto c : literal)
+        {
+            if (offset >= length || !Collator::regexEq(Collator::decodeChar(s, offset), c))
+                return false;
+        }
+        return literal_type == LiteralType::Prefix || offset == length;
+    }
+
+    /// `s` must be pure ASCII.
+    bool matchFoldedASCII(const char * s, size_t length) const
+    {
+        const auto & fold_table = asciiFoldTable();
+        const size_t n = folded_literal.size();
+        if (length < n)
+            return false;
+        auto equal_at = [&](size_t pos) {
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (fold_table[static_cast<uint8_t>(s[pos + i])] != folded_literal[i])
+                    return false;
+            }
+            return true;
+        };
+        if (literal_type == LiteralType::Suffix)
+            return equal_at(length - n);
+        // Substring
+        const char first = folded_literal[0];
+        for (size_t pos = 0; pos + n <= length; ++pos)
+        {
+            if (fold_table[static_cast<uint8_t>(s[pos])] == first && equal_at(pos))
+                return true;
+        }
+        return false;
+    }
+
+    /// Every ASCII char is mapped to the smallest ASCII char equal to it in pattern matching, e.g. 'a' -> 'A' in CI collations.
+    static const std::array<char, 128> & asciiFoldTable()
+    {
+        static const auto table = [] {
+            std::array<char, 128> res{};
+            for (int c = 0; c < 128; ++c)
+            {
+                res[c] = static_cast<char>(c);
+                for (int r = 0; r < c; ++r)
+                {
+                    if (Collator::regexEq(static_cast<typename Collator::CharType>(r), static_cast<typename Collator::CharType>(c)))
+                    {
+                        res[c] = static_cast<char>(r);
+                        break;
+                    }
+                }
+            }
+            return res;
+        }();
+        return table;
+    }
+
+    /// Return the folded ASCII char equal to `c` in pattern matching, or -1 if there is none.
+    static int foldToASCII(typename Collator::CharType c)
+    {
+        for (int r = 0; r < 128; ++r)
+        {
+            if (Collator::regexEq(static_cast<typename Collator::CharType>(r), c))
+                return asciiFoldTable()[r];
+        }
+        return -1;
+    }
+
 private:
     std::vector<typename Collator::CharType> chars;
 
@@ -180,6 +406,22 @@ private:
         Any,
     };
     std::vector<MatchType> match_types;
+
+    enum class LiteralType
+    {
+        None,
+        Equal, // abc
+        Prefix, // abc%
+        Suffix, // %abc
+        Substring, // %abc%
+    };
+    LiteralType literal_type = LiteralType::None;
+    std::vector<typename Collator::CharType> literal;
+    /// The UTF-8 bytes of `literal`, used by the collations comparing chars by code point.
+    std::string literal_bytes;
+    /// `literal` folded by `asciiFoldTable`, used by the other collations to match the pure ASCII strings.
+    std::string folded_literal;
+    bool literal_ascii_foldable = false;
 };
 
 template <typename T, bool padding = false>
@@ -220,6 +462,8 @@ private:
 private:
     using WeightType = T;
     using CharType = T;
+    /// Chars are equal in pattern matching only if they are the same code point.
+    static constexpr bool match_by_bytes = true;
 
     static inline CharType decodeChar(const char * s, size_t & offset)
     {
@@ -305,6 +549,7 @@ private:
 private:
     using WeightType = GeneralCI::WeightType;
     using CharType = Rune;
+    static constexpr bool match_by_bytes = false;
 
     static inline CharType decodeChar(const char * s, size_t & offset)
     {
@@ -457,6 +702,7 @@ private:
 
 private:
     using CharType = Rune;
+    static constexpr bool match_by_bytes = false;
 
     static inline CharType decodeChar(const char * s, size_t & offset)
     {
@@ -12,9 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <Common/FailPoint.h>
 #include <Storages/Transaction/Collator.h>
 #include <gtest/gtest.h>
 
+#include <ext/scope_guard.h>
+#include <random>
+
+namespace DB
+{
+namespace FailPoints
+{
+extern const char force_generic_like_pattern_match[];
+} // namespace FailPoints
+} // namespace DB
+
 namespace DB::tests
 {
 
@@ -121,6 +133,19 @@ const typename CollatorCases::PatternCase CollatorCases::pattern_cases[] = {
             {"aÀÀÀ", {false, false, true, false, true}}}},
     {"___a", {{"中a", {true, true, false, false, false}}, {"中文字a", {false, false, true, true, true}}}},
     {"𐐭", {{"𐐨", {false, false, true, false, false}}}},
+    // The literal patterns matched without backtracking.
+    {"%bC%",
+        {{"abcd", {false, false, true, false, true}}, {"xbCx", {true, true, true, true, true}}, {"ÀbÇ", {false, false, true, false, true}},
+            {"b", {false, false, false, false, false}}}},
+    {"Ab%",
+        {{"abc", {false, false, true, false, true}}, {"Ab", {true, true, true, true, true}}, {"ÀB", {false, false, true, false, true}},
+            {"xAb", {false, false, false, false, false}}}},
+    {"%bC",
+        {{"aBc", {false, false, true, false, true}}, {"abC", {true, true, true, true, true}}, {"bÇ", {false, false, true, false, true}},
+            {"bCx", {false, false, false, false, false}}}},
+    {"%%a%%", {{"BAB", {false, false, true, false, true}}, {"bab", {true, true, true, true, true}}}},
+    {"%\\%%", {{"50%", {true, true, true, true, true}}, {"50", {false, false, false, false, false}}}},
+    {"%À%", {{"BAB", {false, false, true, false, true}}, {"bÀb", {true, true, true, true, true}}}},
 };
 
 template <typename Collator>
@@ -199,4 +224,67 @@ TEST(CollatorSuite, GeneralCICollator) { testCollator<GeneralCICollator>(); }
 
 TEST(CollatorSuite, UnicodeCICollator) { testCollator<UnicodeCICollator>(); }
 
+/// The literal patterns are matched without backtracking, compare them with the backtracking matching on random patterns and strings.
+TEST(CollatorSuite, RandomLiteralPatterns)
+{
+    // The chars equal to each other in some collations, and the special chars in patterns.
+    const std::vector<std::string> chars = {"a", "A", "à", "À", "b", "B", "s", "S", "ß", "😃", "😜", "𐐭", "𐐨", " ", "\t", "%", "_", "\\"};
+    const std::vector<std::string> wildcards = {"%", "%", "%", "_"};
+
+    std::random_device rd;
+    const auto seed = rd();
+    SCOPED_TRACE("seed=" + std::to_string(seed));
+    std::mt19937 gen(seed);
+    auto rand_chars = [&](size_t max_length) {
+        std::string res;
+        size_t length = std::uniform_int_distribution<size_t>(0, max_length)(gen);
+        for (size_t i = 0; i < length; ++i)
+            res += chars[std::uniform_int_distribution<size_t>(0, chars.size() - 1)(gen)];
+        return res;
+    };
+    auto rand_wildcards = [&]() {
+        std::string res;
+        size_t length = std::uniform_int_distribution<size_t>(0, 2)(gen);
+        for (size_t i = 0; i < length; ++i)
+            res += wildcards[std::uniform_int_distribution<size_t>(0, wildcards.size() - 1)(gen)];
+        return res;
+    };
+
+    const std::vector<int32_t> collations = {
+        ITiDBCollator::BINARY,
+        ITiDBCollator::ASCII_BIN,
+        ITiDBCollator::LATIN1_BIN,
+        ITiDBCollator::UTF8MB4_BIN,
+        ITiDBCollator::UTF8_BIN,
+        ITiDBCollator::UTF8_GENERAL_CI,
+        ITiDBCollator::UTF8MB4_GENERAL_CI,
+        ITiDBCollator::UTF8_UNICODE_CI,
+        ITiDBCollator::UTF8MB4_UNICODE_CI,
+    };
+    for (auto collation : collations)
+    {
+        auto collator = ITiDBCollator::getCollator(collation);
+        auto pattern = collator->pattern();
+        auto generic_pattern = collator->pattern();
+        for (size_t round = 0; round < 2000; ++round)
+        {
+            // Most of the patterns are in the literal shapes, i.e. `abc`, `abc%`, `%abc` and `%abc%`.
+            std::string p = rand_wildcards() + rand_chars(3) + rand_wildcards();
+            pattern->compile(p, '\\');
+            {
+                FailPointHelper::enableFailPoint(FailPoints::force_generic_like_pattern_match);
+                SCOPE_EXIT({ FailPointHelper::disableFailPoint(FailPoints::force_generic_like_pattern_match); });
+                generic_pattern->compile(p, '\\');
+            }
+            for (size_t i = 0; i < 20; ++i)
+            {
+                // Make the strings contain the literal of the pattern sometimes.
+                std::string s = i % 2 == 0 ? rand_chars(6) : rand_chars(2) + p + rand_chars(2);
+                ASSERT_EQ(pattern->match(s.data(), s.length()), generic_pattern->match(s.data(), s.length()))
+                    << "collation: " << collation << ", pattern: " << p << ", string: " << s;
+            }
+        }
+    }
+}
+
 } // namespace DB::tests
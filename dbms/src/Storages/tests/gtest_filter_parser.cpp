@@ -187,6 +187,37 @@ try
 }
 CATCH
 
+TEST_F(FilterParserTest, ColInLiterals)
+try
+{
+    const String table_info_json = R"json({
+    "cols":[
+        {"comment":"","default":null,"default_bit":null,"id":1,"name":{"L":"col_1","O":"col_1"},"offset":-1,"origin_default":null,"state":0,"type":{"Charset":null,"Collate":null,"Decimal":0,"Elems":null,"Flag":4097,"Flen":0,"Tp":254}},
+        {"comment":"","default":null,"default_bit":null,"id":2,"name":{"L":"col_2","O":"col_2"},"offset":-1,"origin_default":null,"state":0,"type":{"Charset":null,"Collate":null,"Decimal":0,"Elems":null,"Flag":4097,"Flen":0,"Tp":8}}
+    ],
+    "pk_is_handle":false,"index_info":[],"is_common_handle":false,
+    "name":{"L":"t_111","O":"t_111"},"partition":null,
+    "comment":"Mocked.","id":30,"schema_version":-1,"state":0,"tiflash_replica":{"Count":0},"update_timestamp":1636471547239654
+})json";
+
+    {
+        // In between col and literals
+        auto rs_operator = generateRsOperator(table_info_json, "select * from default.t_111 where col_2 in (666, 777, 888)");
+        EXPECT_EQ(rs_operator->name(), "in");
+        EXPECT_EQ(rs_operator->getAttrs().size(), 1);
+        EXPECT_EQ(rs_operator->getAttrs()[0].col_name, "col_2");
+        EXPECT_EQ(rs_operator->getAttrs()[0].col_id, 2);
+        EXPECT_EQ(rs_operator->toDebugString(), "{\"op\":\"in\",\"col\":\"col_2\",\"value\":\"[\"666\",\"777\",\"888\"]}");
+    }
+
+    {
+        // In of string column is not supported, just like the compare
+        auto rs_operator = generateRsOperator(table_info_json, "select * from default.t_111 where col_1 in ('a', 'b')");
+        EXPECT_EQ(rs_operator->name(), "unsupported");
+    }
+}
+CATCH
+
 TEST_F(FilterParserTest, LiteralAndCol)
 try
 {